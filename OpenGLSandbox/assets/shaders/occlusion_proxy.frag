@@ -0,0 +1,9 @@
+#version 460 core
+layout(location = 0) out vec4 FragColor;
+/**
+ * Color writes are masked off while proxies draw, we only care whether any samples pass
+ */
+void main()
+{
+    FragColor = vec4(1.0);
+}
@@ -0,0 +1,23 @@
+#version 460 core
+
+/**
+ This attribute gives us unit cube corner positions, and we specify here that it should
+ show up at location 0 so we don't have to lookup attribute location at runtime.
+ */
+layout (location = 0) in vec3 aPos;
+/**
+ * Minimum corner of the bounds being tested, passed in from CPU code
+ */
+uniform vec3 boundsMin;
+/**
+ * Maximum corner of the bounds being tested, passed in from CPU code
+ */
+uniform vec3 boundsMax;
+
+/**
+ * Stretches the unit cube over the bounds being tested
+ */
+void main()
+{
+    gl_Position = vec4(mix(boundsMin, boundsMax, aPos), 1.0);
+}
@@ -0,0 +1,65 @@
+#version 460 core
+
+/**
+ * Every pulled mesh's vertices, as raw 32 bit words decoded according to the mesh's record
+ */
+layout (std430, binding = 0) readonly buffer VertexWords
+{
+    uint vertexWords[];
+};
+/**
+ * Per mesh PulledMeshRecord: where its vertices start, how many words each takes and how its position is
+ * encoded, 0 for three floats or 1 for four half floats (PulledVertexFormat)
+ */
+struct MeshRecord
+{
+    uint firstWord;
+    uint strideWords;
+    uint format;
+    uint padding;
+};
+layout (std430, binding = 1) readonly buffer MeshRecords
+{
+    MeshRecord meshRecords[];
+};
+
+/**
+ * Index of the pulled mesh faded by age, passed in from CPU code, and where its vertex pairs sit, as in
+ * ribbontrail_fade.vert
+ */
+uniform int fadedMesh = -1;
+uniform uint trailNewestPair;
+uniform uint trailPairSlots;
+uniform uint trailPairCount;
+/**
+ * Age of this vertex's pair along the faded mesh, from 0 at its head to 1 at its tail; 0 for other meshes
+ */
+out float vAge;
+
+/**
+ * Fetches this vertex's position itself rather than through vertex attributes; each draw's baseInstance
+ * is the index of the mesh it draws, and gl_VertexID the vertex within it
+ */
+void main()
+{
+    MeshRecord mesh = meshRecords[gl_BaseInstance];
+    uint first = mesh.firstWord + uint(gl_VertexID) * mesh.strideWords;
+    vec3 position;
+    if(mesh.format == 1u)
+    {
+        vec2 xy = unpackHalf2x16(vertexWords[first]);
+        position = vec3(xy, unpackHalf2x16(vertexWords[first + 1u]).x);
+    }
+    else
+    {
+        position = vec3(uintBitsToFloat(vertexWords[first]), uintBitsToFloat(vertexWords[first + 1u]),
+                uintBitsToFloat(vertexWords[first + 2u]));
+    }
+    vAge = 0.0;
+    if(int(gl_BaseInstance) == fadedMesh)
+    {
+        uint pairsBehindHead = (trailNewestPair + trailPairSlots - uint(gl_VertexID) / 2u) % trailPairSlots;
+        vAge = float(pairsBehindHead) / float(max(trailPairCount, 2u) - 1u);
+    }
+    gl_Position = vec4(position, 1.0);
+}
@@ -0,0 +1,25 @@
+#version 460 core
+layout(location = 0) out vec4 FragColor;
+/**
+ * The easing curve tables made by createEasingTexture(), one curve per layer
+ */
+layout (binding = 0) uniform sampler1DArray easingTables;
+/**
+ * Layer of easingTables, i.e. the EasingCurve, taking a pair's age to how far it has faded out
+ */
+uniform float fadeCurve;
+/**
+ * Age along the trail, passed in from vertex shader
+ */
+in float vAge;
+
+/**
+ * Assigns the trail's color, fading it out with age along the chosen easing curve
+ */
+void main()
+{
+    // scaled so that ages 0 and 1 land on the centers of the first and last texels
+    float samples = float(textureSize(easingTables, 0).x);
+    float fade = texture(easingTables, vec2((vAge * (samples - 1.0) + 0.5) / samples, fadeCurve)).r;
+    FragColor = vec4(1.0, 0.5, 0.2, 0.5 * (1.0 - fade));
+}
@@ -0,0 +1,30 @@
+#version 460 core
+
+/**
+ This attribute gives us ribbon vertex position data, and we specify here that it should
+ show up at location 0 so we don't have to lookup attribute location at runtime.
+ */
+layout (location = 0) in vec3 aPos;
+/**
+ * Where the trail's vertex pairs sit, passed in from CPU code: pair slot p holds vertices 2p and 2p + 1,
+ * the slots form a ring of trailPairSlots with the newest pair in slot trailNewestPair, and trailPairCount
+ * of them are in use.  A trail stored oldest first is just a ring that never wraps
+ */
+uniform uint trailNewestPair;
+uniform uint trailPairSlots;
+uniform uint trailPairCount;
+/**
+ * Age of this vertex's pair, from 0 at the trail's head to 1 at its tail
+ */
+out float vAge;
+
+/**
+ * Assigns the X, Y, and Z components of attribute aPos to gl_Position, and works out how far back
+ * along the trail this vertex is
+ */
+void main()
+{
+    uint pairsBehindHead = (trailNewestPair + trailPairSlots - uint(gl_VertexID) / 2u) % trailPairSlots;
+    vAge = float(pairsBehindHead) / float(max(trailPairCount, 2u) - 1u);
+    gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);
+}
@@ -0,0 +1,22 @@
+#version 460 core
+
+/**
+ This attribute gives us raw ribbon vertex position data, and we specify here that it should
+ show up at location 0 so we don't have to lookup attribute location at runtime.
+ */
+layout (location = 0) in vec3 aPos;
+/**
+ * Processed vertex position, captured via transform feedback into the ribbon trail's vertex cache
+ * and then fed back in as aPos of the render program
+ */
+out vec3 vProcessedPos;
+
+/**
+ * Per-vertex ribbon processing that only depends on a vertex's own history (e.g. spline evaluation,
+ * billboarding against a fixed axis); runs once per vertex when it enters the trail rather than every
+ * frame, so nothing time-dependent may go in here.  For now it simply forwards the raw position.
+ */
+void main()
+{
+    vProcessedPos = aPos;
+}
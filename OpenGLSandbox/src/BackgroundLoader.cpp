@@ -0,0 +1,259 @@
+#include "BackgroundLoader.h"
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <GLFW/glfw3.h>
+#include "GLResources.h"
+
+namespace
+{
+    /**
+     * @return the compiled shader's ID, or 0 if compilation failed
+     */
+    unsigned int compileShader(GLenum shaderType, const std::string& source, const std::string& shaderName)
+    {
+        unsigned int shaderId = glCreateShader(shaderType);
+        const char* sourceCString = source.c_str();
+        glShaderSource(shaderId, 1, &sourceCString, nullptr);
+        glCompileShader(shaderId);
+        int compileSuccessStatus;
+        char infoLog[512];
+        glGetShaderiv(shaderId, GL_COMPILE_STATUS, &compileSuccessStatus);
+        if(!compileSuccessStatus)
+        {
+            glGetShaderInfoLog(shaderId, 512, nullptr, infoLog);
+            std::cerr << "shader " << shaderName << " compilation failed:\n" << infoLog << std::endl;
+            glDeleteShader(shaderId);
+            return 0;
+        }
+        return shaderId;
+    }
+}
+
+BackgroundLoader::BackgroundLoader(GLFWwindow* mainWindow)
+{
+    // the loader's window only exists to own a context, so keep it hidden; other hints, like the context
+    // version, carry over from the main window's creation
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    mContextWindow = glfwCreateWindow(1, 1, "OpenGL Sandbox loader", nullptr, mainWindow);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if(mContextWindow == nullptr)
+    {
+        std::cerr << "failed to create a shared GL context for background loading; loading synchronously" << std::endl;
+        return;
+    }
+    mThread = std::thread([this](){ threadLoop(); });
+}
+
+BackgroundLoader::~BackgroundLoader()
+{
+    if(mContextWindow == nullptr)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mWorkAvailable.notify_all();
+    mThread.join();
+    // fences are shared between the contexts, so the ones left over can go from this one
+    for(const Job& job : mQueue)
+    {
+        glDeleteSync(job.renderFence);
+    }
+    for(const CompletedJob& completed : mCompleted)
+    {
+        glDeleteSync(completed.loaderFence);
+    }
+    glfwDestroyWindow(mContextWindow);
+}
+
+void BackgroundLoader::threadLoop()
+{
+    glfwMakeContextCurrent(mContextWindow);
+    while(true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWorkAvailable.wait(lock, [this](){ return mStopping || !mQueue.empty(); });
+            if(mStopping)
+            {
+                break;
+            }
+            job = std::move(mQueue.front());
+            mQueue.pop_front();
+        }
+
+        // Load Step 1: order the work after the render thread's commands from before submit(); the wait
+        // is queued on the GPU, this thread carries straight on
+        glWaitSync(job.renderFence, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(job.renderFence);
+        // Load Step 2: do the work
+        job.work();
+        // Load Step 3: fence it for the render thread; the flush makes sure the fence actually reaches the
+        // GPU, or the render thread could be polling it forever
+        CompletedJob completed;
+        completed.loaderFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        completed.onReady = std::move(job.onReady);
+        glFlush();
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCompleted.push_back(std::move(completed));
+    }
+    glfwMakeContextCurrent(nullptr);
+}
+
+bool BackgroundLoader::isAsynchronous() const
+{
+    return mContextWindow != nullptr;
+}
+
+void BackgroundLoader::submit(std::function<void()> work, std::function<void()> onReady)
+{
+    if(mContextWindow == nullptr)
+    {
+        work();
+        onReady();
+        return;
+    }
+    Job job;
+    job.renderFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // the loader's context can only wait on a fence that's been flushed to the GPU
+    glFlush();
+    job.work = std::move(work);
+    job.onReady = std::move(onReady);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueue.push_back(std::move(job));
+    }
+    mPendingJobCount++;
+    mWorkAvailable.notify_one();
+}
+
+void BackgroundLoader::uploadBuffer(std::vector<uint8_t> data, GLbitfield storageFlags,
+        std::function<void(unsigned int)> onReady)
+{
+    // the ID is written by the work and read by onReady, which never run at the same time
+    std::shared_ptr<unsigned int> buffer = std::make_shared<unsigned int>(0);
+    std::shared_ptr<std::vector<uint8_t>> ownedData = std::make_shared<std::vector<uint8_t>>(std::move(data));
+    submit([buffer, ownedData, storageFlags](){
+        *buffer = createBuffer(static_cast<GLsizeiptr>(ownedData->size()), ownedData->data(), storageFlags);
+        // let the data go as soon as it's uploaded rather than when the job is handed over
+        std::vector<uint8_t>().swap(*ownedData);
+    }, [buffer, onReady](){
+        onReady(*buffer);
+    });
+}
+
+void BackgroundLoader::uploadTexture(const TextureDescription& description, std::vector<uint8_t> pixels,
+        std::function<void(unsigned int)> onReady)
+{
+    size_t rowSize = getPixelSize(description.format, description.type) * static_cast<size_t>(description.width);
+    if(rowSize == 0 || description.height <= 0 || pixels.size() < rowSize * static_cast<size_t>(description.height))
+    {
+        std::cerr << "can't upload a " << description.width << "x" << description.height << " texture from "
+        << pixels.size() << " bytes of pixel format " << description.format << " and type " << description.type
+        << std::endl;
+        onReady(0);
+        return;
+    }
+    std::shared_ptr<unsigned int> texture = std::make_shared<unsigned int>(0);
+    std::shared_ptr<std::vector<uint8_t>> ownedPixels = std::make_shared<std::vector<uint8_t>>(std::move(pixels));
+    submit([texture, ownedPixels, description](){
+        GLsizei levels = description.levels > 0 ? description.levels
+                                                : getFullMipChainLevels(description.width, description.height);
+        glCreateTextures(GL_TEXTURE_2D, 1, texture.get());
+        glTextureStorage2D(*texture, levels, description.internalFormat, description.width, description.height);
+        glTextureParameteri(*texture, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTextureParameteri(*texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        // rows are tightly packed, and unpack state is per context, so this can't disturb the render thread's
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTextureSubImage2D(*texture, 0, 0, 0, description.width, description.height, description.format,
+                description.type, ownedPixels->data());
+        if(levels > 1)
+        {
+            glGenerateTextureMipmap(*texture);
+        }
+        std::vector<uint8_t>().swap(*ownedPixels);
+    }, [texture, onReady](){
+        onReady(*texture);
+    });
+}
+
+void BackgroundLoader::compileProgram(const std::string& programName, std::string vertexSource,
+        std::string fragmentSource, std::function<void(unsigned int)> onReady)
+{
+    std::shared_ptr<unsigned int> program = std::make_shared<unsigned int>(0);
+    std::shared_ptr<std::string> ownedVertexSource = std::make_shared<std::string>(std::move(vertexSource));
+    std::shared_ptr<std::string> ownedFragmentSource = std::make_shared<std::string>(std::move(fragmentSource));
+    submit([program, programName, ownedVertexSource, ownedFragmentSource](){
+        unsigned int vertexShaderId = compileShader(GL_VERTEX_SHADER, *ownedVertexSource, programName + ".vert");
+        unsigned int fragmentShaderId = compileShader(GL_FRAGMENT_SHADER, *ownedFragmentSource, programName + ".frag");
+        if(!vertexShaderId || !fragmentShaderId)
+        {
+            glDeleteShader(vertexShaderId);
+            glDeleteShader(fragmentShaderId);
+            return;
+        }
+        unsigned int programId = glCreateProgram();
+        glAttachShader(programId, vertexShaderId);
+        glAttachShader(programId, fragmentShaderId);
+        glLinkProgram(programId);
+        glDeleteShader(vertexShaderId);
+        glDeleteShader(fragmentShaderId);
+
+        int linkSuccessStatus;
+        char infoLog[512];
+        glGetProgramiv(programId, GL_LINK_STATUS, &linkSuccessStatus);
+        if(!linkSuccessStatus)
+        {
+            glGetProgramInfoLog(programId, 512, nullptr, infoLog);
+            std::cerr << "error linking " << programName << ":\n" << infoLog << std::endl;
+            glDeleteProgram(programId);
+            return;
+        }
+        *program = programId;
+    }, [program, onReady](){
+        onReady(*program);
+    });
+}
+
+size_t BackgroundLoader::processCompleted()
+{
+    size_t handedOver = 0;
+    while(true)
+    {
+        // only this thread pops, so the front stays put while we poll its fence outside the lock
+        GLsync loaderFence;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if(mCompleted.empty())
+            {
+                break;
+            }
+            loaderFence = mCompleted.front().loaderFence;
+        }
+        GLenum status = glClientWaitSync(loaderFence, 0, 0);
+        if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        {
+            break;
+        }
+        std::function<void()> onReady;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            onReady = std::move(mCompleted.front().onReady);
+            mCompleted.pop_front();
+        }
+        glDeleteSync(loaderFence);
+        mPendingJobCount--;
+        handedOver++;
+        onReady();
+    }
+    return handedOver;
+}
+
+size_t BackgroundLoader::getPendingJobCount() const
+{
+    return mPendingJobCount;
+}
@@ -0,0 +1,121 @@
+#ifndef OPENGLSANDBOX_BACKGROUNDLOADER_H
+#define OPENGLSANDBOX_BACKGROUNDLOADER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glad/glad.h>
+#include "TextureStreamer.h"
+
+struct GLFWwindow;
+
+/**
+ * A loader thread with its own GL context, shared with the render thread's, that buffer and texture uploads
+ * and shader compiles are handed to so they never stall a frame.
+ *
+ * Jobs are submitted from the render thread as a pair of functions: work, run on the loader thread with its
+ * context current, and onReady, run back on the render thread once the GPU has finished the work.  Both
+ * directions are fenced: submit() fences the render thread's commands so far and the loader waits on that
+ * fence (on the GPU, not on the CPU) before running the work, so a job can safely overwrite a buffer the
+ * render thread was drawing from; and after the work the loader fences again, which processCompleted()
+ * polls once a frame and only hands the job over once it's signalled.
+ *
+ * Buffers, textures, shaders and programs are shared between the contexts, but container objects like
+ * VAOs and framebuffers aren't, so those have to be created in onReady, on the render thread.  If the
+ * second context can't be created, jobs just run synchronously inside submit().
+ */
+class BackgroundLoader
+{
+private:
+    struct Job
+    {
+        /**
+         * Fence after the render thread's commands issued before submit(); the loader waits on it
+         */
+        GLsync renderFence;
+        std::function<void()> work;
+        std::function<void()> onReady;
+    };
+    struct CompletedJob
+    {
+        /**
+         * Fence after the job's work, polled by processCompleted()
+         */
+        GLsync loaderFence;
+        std::function<void()> onReady;
+    };
+    GLFWwindow* mContextWindow = nullptr;
+    std::thread mThread;
+    std::mutex mMutex;
+    std::condition_variable mWorkAvailable;
+    std::deque<Job> mQueue;
+    std::deque<CompletedJob> mCompleted;
+    bool mStopping = false;
+    /**
+     * Jobs submitted but not yet handed over; only touched on the render thread
+     */
+    size_t mPendingJobCount = 0;
+
+    void threadLoop();
+public:
+    /**
+     * Creates the loader's hidden window and context, sharing objects with mainWindow's, and starts the
+     * loader thread.  Must be called on the main thread, since GLFW only creates windows there, with
+     * mainWindow's context current
+     */
+    explicit BackgroundLoader(GLFWwindow* mainWindow);
+    /**
+     * Stops the loader thread, dropping jobs it hasn't finished or handed over, and destroys its context;
+     * must be called on the main thread with the main context still current
+     */
+    ~BackgroundLoader();
+    BackgroundLoader(const BackgroundLoader&) = delete;
+    BackgroundLoader& operator=(const BackgroundLoader&) = delete;
+    /**
+     * @return false if the loader fell back to running jobs synchronously
+     */
+    bool isAsynchronous() const;
+    /**
+     * Queues a job; call from the render thread
+     * @param work run on the loader thread; it must only share data with the render thread that neither
+     *        touches until onReady
+     * @param onReady run on the render thread from processCompleted(), once the GPU has finished the work
+     */
+    void submit(std::function<void()> work, std::function<void()> onReady);
+    /**
+     * Creates and fills a buffer with immutable storage on the loader thread
+     * @param storageFlags see createBuffer()
+     * @param onReady receives the buffer's ID
+     */
+    void uploadBuffer(std::vector<uint8_t> data, GLbitfield storageFlags, std::function<void(unsigned int)> onReady);
+    /**
+     * Creates a texture with immutable storage, uploads its level 0 and generates its mips on the loader thread
+     * @param pixels the whole of level 0, tightly packed rows
+     * @param onReady receives the texture's ID, or 0 if the description or pixels were invalid
+     */
+    void uploadTexture(const TextureDescription& description, std::vector<uint8_t> pixels,
+            std::function<void(unsigned int)> onReady);
+    /**
+     * Compiles and links a vertex and fragment shader program on the loader thread
+     * @param programName used in error messages
+     * @param onReady receives the program's ID, or 0 if compiling or linking failed (see std::cerr)
+     */
+    void compileProgram(const std::string& programName, std::string vertexSource, std::string fragmentSource,
+            std::function<void(unsigned int)> onReady);
+    /**
+     * Runs onReady for every job, in submission order, whose work the GPU has finished; never waits.
+     * Call once per frame on the render thread
+     * @return the number of jobs handed over
+     */
+    size_t processCompleted();
+    size_t getPendingJobCount() const;
+};
+
+
+#endif //OPENGLSANDBOX_BACKGROUNDLOADER_H
@@ -0,0 +1,1382 @@
+/*
+ * Standalone CPU benchmarks for the sandbox's batch kernels, built as the OpenGLSandboxBench target so they
+ * run without a window or GL context.  Usage:
+ *
+ *   OpenGLSandboxBench [benchmark name filter] [element count...]
+ *
+ * e.g. "OpenGLSandboxBench pack 1000000 100000000"; element counts default to 1M and 10M.
+ */
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+// every glm/gtx header, including those our own headers pull in, needs this defined before the first of them
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include "VertexPacking.h"
+#include "Vec3SoA.h"
+#include "QuaternionBatch.h"
+#include "EasingTables.h"
+#include "RibbonTrail.h"
+#include "TrailPool.h"
+#include "SpatialHashGrid.h"
+#include "RibbonIntersection.h"
+#include "InputTransform.h"
+#include "ProceduralTexture.h"
+#include "ThreadPool.h"
+#include "MeshImporter.h"
+#include "MeshCache.h"
+#include "MeshOptimization.h"
+#include "MeshClusters.h"
+#include "ViewFrustum.h"
+#include "GpuFrustumCuller.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/easing.hpp>
+#include <glm/gtx/intersect.hpp>
+#include <glm/gtx/hash.hpp>
+
+namespace
+{
+    /**
+     * A named benchmark run once per requested element count
+     */
+    struct Benchmark
+    {
+        const char* name;
+        std::function<void(size_t)> run;
+    };
+
+    /**
+     * Raised by any cross-check that finds a kernel disagreeing with its reference, so the run exits nonzero
+     */
+    bool g_checkFailed = false;
+
+    /**
+     * Reports a failed cross-check; the benchmarks carry on, but main() will return failure
+     */
+    void reportMismatch(const std::string& what)
+    {
+        std::cerr << "  MISMATCH: " << what << std::endl;
+        g_checkFailed = true;
+    }
+
+    /**
+     * Times a callable, keeping the best of a few runs to shave off warm-up and scheduling noise
+     * @return best wall time in seconds
+     */
+    double timeBest(const std::function<void()>& work, int runs = 5)
+    {
+        double best = 0.0;
+        for(int runIdx = 0; runIdx < runs; runIdx++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            work();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            if(runIdx == 0 || elapsed.count() < best)
+            {
+                best = elapsed.count();
+            }
+        }
+        return best;
+    }
+
+    void printResult(const std::string& label, size_t count, size_t bytesTouched, double seconds)
+    {
+        std::cout << "  " << std::left << std::setw(44) << label << std::right
+        << std::setw(12) << count << " elements  "
+        << std::fixed << std::setprecision(3) << std::setw(9) << seconds * 1e3 << " ms  "
+        << std::setw(7) << seconds * 1e9 / static_cast<double>(count) << " ns/elem  "
+        << std::setw(7) << static_cast<double>(bytesTouched) / seconds / 1e9 << " GB/s" << std::endl;
+    }
+
+    template<typename Vector>
+    std::vector<Vector> makeRandomVectors(size_t count, float lower, float upper)
+    {
+        std::mt19937 generator(1234);
+        std::uniform_real_distribution<float> distribution(lower, upper);
+        std::vector<Vector> vectors(count);
+        for(Vector& vector : vectors)
+        {
+            for(glm::length_t component = 0; component < Vector::length(); component++)
+            {
+                vector[component] = distribution(generator);
+            }
+        }
+        return vectors;
+    }
+
+    /**
+     * Runs one packing kernel through the scalar path and the runtime-dispatched path, and checks that
+     * both produced bit-identical output
+     */
+    template<typename Source, typename Packed>
+    void benchmarkPacking(
+            const std::string& label,
+            const std::vector<Source>& source,
+            const std::function<void(const Source*, Packed*, size_t)>& pack
+    )
+    {
+        size_t count = source.size();
+        std::vector<Packed> scalarOutput(count);
+        std::vector<Packed> dispatchedOutput(count);
+        size_t bytesTouched = count * (sizeof(Source) + sizeof(Packed));
+
+        setVertexPackingScalarOnly(true);
+        double scalarSeconds = timeBest([&](){ pack(source.data(), scalarOutput.data(), count); });
+        setVertexPackingScalarOnly(false);
+        double dispatchedSeconds = timeBest([&](){ pack(source.data(), dispatchedOutput.data(), count); });
+
+        printResult(label + " [scalar]", count, bytesTouched, scalarSeconds);
+        printResult(label + " [" + getVertexPackingKernelName() + "]", count, bytesTouched, dispatchedSeconds);
+        if(std::memcmp(scalarOutput.data(), dispatchedOutput.data(), sizeof(Packed) * count) != 0)
+        {
+            reportMismatch(label + " kernels disagree with the scalar reference");
+        }
+    }
+
+    void benchmarkVertexPacking(size_t count)
+    {
+        std::vector<glm::vec3> positions = makeRandomVectors<glm::vec3>(count, -100.0F, 100.0F);
+        std::vector<glm::vec4> colors = makeRandomVectors<glm::vec4>(count, -0.1F, 1.1F);
+        std::vector<glm::vec3> normals = makeRandomVectors<glm::vec3>(count, -1.0F, 1.0F);
+        for(glm::vec3& normal : normals)
+        {
+            normal = glm::normalize(normal);
+        }
+
+        benchmarkPacking<glm::vec3, PackedHalf4>("half, vec3 positions", positions,
+                [](const glm::vec3* source, PackedHalf4* destination, size_t n){ packHalf4(source, 1.0F, destination, n); });
+        benchmarkPacking<glm::vec4, PackedHalf4>("half, vec4", colors,
+                [](const glm::vec4* source, PackedHalf4* destination, size_t n){ packHalf4(source, destination, n); });
+        benchmarkPacking<glm::vec3, glm::i16vec4>("snorm16, vec3 normals", normals,
+                [](const glm::vec3* source, glm::i16vec4* destination, size_t n){ packSnorm16x4(source, 0.0F, destination, n); });
+        benchmarkPacking<glm::vec4, glm::u8vec4>("unorm8, vec4 colors", colors,
+                [](const glm::vec4* source, glm::u8vec4* destination, size_t n){ packUnorm8x4(source, destination, n); });
+        benchmarkPacking<glm::vec3, PackedSnorm1010102>("snorm 10_10_10_2, vec3 normals", normals,
+                [](const glm::vec3* source, PackedSnorm1010102* destination, size_t n){ packSnorm1010102(source, 0.0F, destination, n); });
+        benchmarkPacking<glm::vec4, PackedUnorm1010102>("unorm 10_10_10_2, vec4 colors", colors,
+                [](const glm::vec4* source, PackedUnorm1010102* destination, size_t n){ packUnorm1010102(source, destination, n); });
+    }
+
+    /**
+     * Lerp, normalize and bounds over glm::vec3 arrays versus the same work on Vec3SoA
+     */
+    void benchmarkSoAMath(size_t count)
+    {
+        std::vector<glm::vec3> a = makeRandomVectors<glm::vec3>(count, -1.0F, 1.0F);
+        std::vector<glm::vec3> b = makeRandomVectors<glm::vec3>(count, -1.0F, 1.0F);
+        std::vector<glm::vec3> aosOut(count);
+        Vec3SoA soaA(a.data(), count);
+        Vec3SoA soaB(b.data(), count);
+        Vec3SoA soaOut;
+        size_t bytesTouched = count * sizeof(glm::vec3) * 3;
+
+        double aosSeconds = timeBest([&](){
+            for(size_t idx = 0; idx < count; idx++)
+            {
+                aosOut[idx] = glm::mix(a[idx], b[idx], 0.25F);
+            }
+        });
+        double soaSeconds = timeBest([&](){ batchLerp(soaA, soaB, 0.25F, soaOut); });
+        printResult("lerp [glm::vec3]", count, bytesTouched, aosSeconds);
+        printResult("lerp [Vec3SoA]", count, bytesTouched, soaSeconds);
+
+        bytesTouched = count * sizeof(glm::vec3) * 2;
+        aosSeconds = timeBest([&](){
+            for(size_t idx = 0; idx < count; idx++)
+            {
+                aosOut[idx] = glm::normalize(a[idx]);
+            }
+        });
+        soaSeconds = timeBest([&](){ batchNormalize(soaA, soaOut); });
+        printResult("normalize [glm::vec3]", count, bytesTouched, aosSeconds);
+        printResult("normalize [Vec3SoA]", count, bytesTouched, soaSeconds);
+
+        bytesTouched = count * sizeof(glm::vec3);
+        glm::vec3 aosMin;
+        glm::vec3 aosMax;
+        aosSeconds = timeBest([&](){
+            aosMin = a[0];
+            aosMax = a[0];
+            for(size_t idx = 1; idx < count; idx++)
+            {
+                aosMin = glm::min(aosMin, a[idx]);
+                aosMax = glm::max(aosMax, a[idx]);
+            }
+        });
+        glm::vec3 soaMin;
+        glm::vec3 soaMax;
+        soaSeconds = timeBest([&](){ batchBounds(soaA, soaMin, soaMax); });
+        printResult("bounds [glm::vec3]", count, bytesTouched, aosSeconds);
+        printResult("bounds [Vec3SoA]", count, bytesTouched, soaSeconds);
+        if(aosMin != soaMin || aosMax != soaMax)
+        {
+            reportMismatch("Vec3SoA bounds disagree with glm");
+        }
+
+        std::vector<glm::vec4> interleaved(count);
+        soaSeconds = timeBest([&](){ soaA.interleave(interleaved.data(), 1.0F); });
+        printResult("interleave to vec4 [Vec3SoA]", count, count * (sizeof(glm::vec3) + sizeof(glm::vec4)), soaSeconds);
+    }
+
+    std::vector<glm::quat> makeRandomRotations(size_t count, unsigned int seed)
+    {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<float> distribution(-1.0F, 1.0F);
+        std::vector<glm::quat> rotations(count);
+        for(glm::quat& rotation : rotations)
+        {
+            rotation = glm::normalize(glm::quat(distribution(generator), distribution(generator),
+                    distribution(generator), distribution(generator)));
+        }
+        return rotations;
+    }
+
+    /**
+     * glm's scalar slerp and dualquat point transform versus the batch kernels, reporting the largest
+     * difference
+     */
+    void benchmarkQuaternionBatch(size_t count)
+    {
+        std::vector<glm::quat> from = makeRandomRotations(count, 1);
+        std::vector<glm::quat> to = makeRandomRotations(count, 2);
+        std::vector<glm::quat> glmOut(count);
+        QuatSoA soaFrom(from.data(), count);
+        QuatSoA soaTo(to.data(), count);
+        QuatSoA soaOut;
+        size_t bytesTouched = count * sizeof(glm::quat) * 3;
+        const float alpha = 0.37F;
+
+        double glmSeconds = timeBest([&](){
+            for(size_t idx = 0; idx < count; idx++)
+            {
+                glmOut[idx] = glm::slerp(from[idx], to[idx], alpha);
+            }
+        });
+        double batchSeconds = timeBest([&](){ batchSlerp(soaFrom, soaTo, alpha, soaOut); });
+        float maxError = 0.0F;
+        for(size_t idx = 0; idx < count; idx++)
+        {
+            glm::quat difference = glmOut[idx] - soaOut.get(idx);
+            maxError = std::max(maxError, glm::length(difference));
+        }
+        printResult("slerp [glm]", count, bytesTouched, glmSeconds);
+        printResult("slerp [batch]", count, bytesTouched, batchSeconds);
+        std::cout << "    max slerp error " << std::scientific << maxError << std::fixed << std::endl;
+
+        batchSeconds = timeBest([&](){ batchNlerp(soaFrom, soaTo, alpha, soaOut); });
+        printResult("nlerp [batch]", count, bytesTouched, batchSeconds);
+
+        std::vector<glm::dualquat> poses(count);
+        std::vector<glm::vec3> offsets = makeRandomVectors<glm::vec3>(count, -10.0F, 10.0F);
+        for(size_t idx = 0; idx < count; idx++)
+        {
+            poses[idx] = glm::dualquat(from[idx], offsets[idx]);
+        }
+        std::vector<glm::vec3> points = makeRandomVectors<glm::vec3>(count, -1.0F, 1.0F);
+        std::vector<glm::vec3> glmPoints(count);
+        DualQuatSoA soaPoses(poses.data(), count);
+        Vec3SoA soaPoints(points.data(), count);
+        Vec3SoA soaTransformed;
+        bytesTouched = count * (sizeof(glm::dualquat) + sizeof(glm::vec3) * 2);
+        glmSeconds = timeBest([&](){
+            for(size_t idx = 0; idx < count; idx++)
+            {
+                glmPoints[idx] = poses[idx] * points[idx];
+            }
+        });
+        batchSeconds = timeBest([&](){ batchTransformPoints(soaPoses, soaPoints, soaTransformed); });
+        maxError = 0.0F;
+        for(size_t idx = 0; idx < count; idx++)
+        {
+            maxError = std::max(maxError, glm::length(glmPoints[idx] - soaTransformed.get(idx)));
+        }
+        printResult("dualquat transform [glm]", count, bytesTouched, glmSeconds);
+        printResult("dualquat transform [batch]", count, bytesTouched, batchSeconds);
+        std::cout << "    max transform error " << std::scientific << maxError << std::fixed << std::endl;
+
+        DualQuatSoA blended;
+        batchSeconds = timeBest([&](){ batchDualQuatLerp(soaPoses, soaPoses, alpha, blended); });
+        printResult("dualquat blend [batch]", count, count * sizeof(glm::dualquat) * 3, batchSeconds);
+    }
+
+    /**
+     * Evaluating glm's easing functions directly versus sampling the lookup tables, per curve, with the
+     * largest difference between the two
+     */
+    void benchmarkEasing(size_t count)
+    {
+        struct CurveReference
+        {
+            const char* name;
+            EasingCurve curve;
+            float (*evaluate)(float const&);
+        };
+        const CurveReference curves[] = {
+                {"sineIn", EasingCurve::sineIn, glm::sineEaseIn<float>},
+                {"sineInOut", EasingCurve::sineInOut, glm::sineEaseInOut<float>},
+                {"exponentialOut", EasingCurve::exponentialOut, glm::exponentialEaseOut<float>},
+                {"elasticOut", EasingCurve::elasticOut, glm::elasticEaseOut<float>},
+                {"bounceOut", EasingCurve::bounceOut, glm::bounceEaseOut<float>}
+        };
+        std::vector<float> ages(count);
+        std::mt19937 generator(99);
+        std::uniform_real_distribution<float> distribution(0.0F, 1.0F);
+        for(float& age : ages)
+        {
+            age = distribution(generator);
+        }
+        std::vector<float> exact(count);
+        std::vector<float> tabulated(count);
+        size_t bytesTouched = count * sizeof(float) * 2;
+        for(const CurveReference& reference : curves)
+        {
+            double glmSeconds = timeBest([&](){
+                for(size_t idx = 0; idx < count; idx++)
+                {
+                    exact[idx] = reference.evaluate(ages[idx]);
+                }
+            });
+            double tableSeconds = timeBest([&](){ sampleEasing(reference.curve, ages.data(), tabulated.data(), count); });
+            float maxError = 0.0F;
+            for(size_t idx = 0; idx < count; idx++)
+            {
+                maxError = std::max(maxError, std::abs(exact[idx] - tabulated[idx]));
+            }
+            printResult(std::string(reference.name) + " [glm]", count, bytesTouched, glmSeconds);
+            printResult(std::string(reference.name) + " [table]", count, bytesTouched, tableSeconds);
+            std::cout << "    max table error " << std::scientific << maxError << std::fixed << std::endl;
+        }
+    }
+
+    /**
+     * One simulated frame over many trails: a tenth of them emit a pair, then every trail's bounds are brought
+     * up to date and the changed ones collected for upload.  The element count is the total vertex pair
+     * budget, split into trails of kPoolTrailSegments segments, so 1M pairs is ~59k trails
+     */
+    void benchmarkTrailPool(size_t count)
+    {
+        const size_t kPoolTrailSegments = 16;
+        const size_t pairsPerTrail = kPoolTrailSegments + 1;
+        size_t trailCount = std::max<size_t>(count / pairsPerTrail, 1);
+        std::vector<glm::vec3> positions = makeRandomVectors<glm::vec3>(trailCount, -1.0F, 1.0F);
+        glm::vec3 offset(0.01F, 0.0F, 0.0F);
+
+        // per-object trails, each filled to capacity so every emission also drops a tail pair
+        std::vector<RibbonTrail> trails;
+        trails.reserve(trailCount);
+        std::vector<char> trailDirty(trailCount, 0);
+        TrailPool pool(pairsPerTrail, trailCount);
+        std::vector<TrailHandle> handles(trailCount);
+        for(size_t trailIdx = 0; trailIdx < trailCount; trailIdx++)
+        {
+            trails.emplace_back(kPoolTrailSegments);
+            handles[trailIdx] = pool.create();
+            for(size_t pairIdx = 0; pairIdx < pairsPerTrail; pairIdx++)
+            {
+                glm::vec3 position = positions[trailIdx] + offset * static_cast<float>(pairIdx);
+                trails[trailIdx].addVertexPair(position, position + offset);
+                pool.addVertexPair(handles[trailIdx], position, position + offset);
+            }
+        }
+        pool.updateBounds();
+        pool.clearDirty();
+
+        std::vector<glm::vec3> boundsMin(trailCount);
+        std::vector<glm::vec3> boundsMax(trailCount);
+        std::vector<uint32_t> dirtySlots;
+        dirtySlots.reserve(trailCount);
+        size_t frame = 0;
+        size_t objectDirtyCount = 0;
+        double objectSeconds = timeBest([&](){
+            frame++;
+            for(size_t trailIdx = frame % 10; trailIdx < trailCount; trailIdx += 10)
+            {
+                trails[trailIdx].addVertexPair(positions[trailIdx], positions[trailIdx] + offset);
+                trailDirty[trailIdx] = 1;
+            }
+            objectDirtyCount = 0;
+            for(size_t trailIdx = 0; trailIdx < trailCount; trailIdx++)
+            {
+                trails[trailIdx].calculateBounds(boundsMin[trailIdx], boundsMax[trailIdx]);
+                objectDirtyCount += static_cast<size_t>(trailDirty[trailIdx]);
+                trailDirty[trailIdx] = 0;
+            }
+        });
+        // replay the same emission schedule, so both runs end having dirtied and emitted into the same trails
+        frame = 0;
+        double poolSeconds = timeBest([&](){
+            frame++;
+            for(size_t trailIdx = frame % 10; trailIdx < trailCount; trailIdx += 10)
+            {
+                pool.addVertexPair(handles[trailIdx], positions[trailIdx], positions[trailIdx] + offset);
+            }
+            pool.updateBounds();
+            dirtySlots.clear();
+            pool.collectDirty(dirtySlots);
+            pool.clearDirty();
+        });
+
+        // the pool only recomputes the bounds of trails that changed, so compare the same emitted trails
+        float maxError = 0.0F;
+        for(uint32_t slot : dirtySlots)
+        {
+            glm::vec3 referenceMin;
+            glm::vec3 referenceMax;
+            trails[slot].calculateBounds(referenceMin, referenceMax);
+            maxError = std::max(maxError, glm::length(referenceMin - pool.getBoundsMin().get(slot)));
+            maxError = std::max(maxError, glm::length(referenceMax - pool.getBoundsMax().get(slot)));
+        }
+
+        size_t pairsTouched = trailCount * pairsPerTrail * 2 * sizeof(glm::vec3);
+        printResult("bounds + dirty scan [RibbonTrail objects]", trailCount, pairsTouched, objectSeconds);
+        printResult("bounds + dirty scan [TrailPool]", trailCount, pairsTouched, poolSeconds);
+        std::cout << "    " << objectDirtyCount << " vs " << dirtySlots.size() << " dirty trails, max bounds difference "
+        << std::scientific << maxError << std::fixed << std::endl;
+        if(objectDirtyCount != dirtySlots.size())
+        {
+            reportMismatch("TrailPool's dirty trails disagree with the RibbonTrail objects'");
+        }
+    }
+
+    /**
+     * Per-frame rebuild of a spatial hash over count small boxes at about one per cell, then radius queries
+     * against it, checked against and timed relative to a linear scan
+     */
+    void benchmarkSpatialHash(size_t count)
+    {
+        const size_t kQueryCount = 10000;
+        const size_t kLinearQueryCount = 100;
+        const float kQueryRadius = 1.5F;
+        float extent = 0.5F * std::cbrt(static_cast<float>(count));
+        std::vector<glm::vec3> centers = makeRandomVectors<glm::vec3>(count, -extent, extent);
+        std::vector<glm::vec3> sizes = makeRandomVectors<glm::vec3>(count, 0.0F, 0.5F);
+        std::vector<glm::vec3> queries = makeRandomVectors<glm::vec3>(kQueryCount, -extent, extent);
+
+        SpatialHashGrid grid(1.0F);
+        double buildSeconds = timeBest([&](){
+            grid.clear();
+            for(size_t entryIdx = 0; entryIdx < count; entryIdx++)
+            {
+                grid.insertBox(static_cast<uint32_t>(entryIdx), centers[entryIdx], centers[entryIdx] + sizes[entryIdx]);
+            }
+            grid.build();
+        });
+
+        std::vector<uint32_t> results;
+        results.reserve(count);
+        size_t gridHits = 0;
+        double querySeconds = timeBest([&](){
+            gridHits = 0;
+            for(const glm::vec3& query : queries)
+            {
+                results.clear();
+                grid.queryRadius(query, kQueryRadius, results);
+                gridHits += results.size();
+            }
+        });
+
+        // the linear scan is far too slow for every query, so compare on the first few
+        size_t gridSampleHits = 0;
+        for(size_t queryIdx = 0; queryIdx < kLinearQueryCount; queryIdx++)
+        {
+            results.clear();
+            grid.queryRadius(queries[queryIdx], kQueryRadius, results);
+            gridSampleHits += results.size();
+        }
+        size_t linearHits = 0;
+        double linearSeconds = timeBest([&](){
+            linearHits = 0;
+            for(size_t queryIdx = 0; queryIdx < kLinearQueryCount; queryIdx++)
+            {
+                for(size_t entryIdx = 0; entryIdx < count; entryIdx++)
+                {
+                    glm::vec3 closest = glm::clamp(queries[queryIdx], centers[entryIdx], centers[entryIdx] + sizes[entryIdx]);
+                    glm::vec3 offset = closest - queries[queryIdx];
+                    linearHits += glm::dot(offset, offset) <= kQueryRadius * kQueryRadius ? 1 : 0;
+                }
+            }
+        }, 1);
+
+        printResult("rebuild (insert + counting sort)", count, count * sizeof(glm::vec3) * 2, buildSeconds);
+        printResult("radius queries [grid]", kQueryCount, gridHits * sizeof(uint32_t), querySeconds);
+        printResult("radius queries [linear scan]", kLinearQueryCount, kLinearQueryCount * count * sizeof(glm::vec3) * 2,
+                linearSeconds);
+        std::cout << "    " << static_cast<double>(gridHits) / kQueryCount << " hits per query, "
+        << grid.getOversizedCount() << " oversized; grid and linear scan agree on "
+        << gridSampleHits << " vs " << linearHits << " hits" << std::endl;
+    }
+
+    /**
+     * Ray queries against count ribbon vertices, i.e. about count / 2 quads: first as one long ribbon whose
+     * bounds every ray enters, measuring the SIMD triangle test itself against glm::intersectRayTriangle(),
+     * then split into 64-segment trails scattered through space, where per-trail bounds cull most of them
+     */
+    void benchmarkRibbonIntersection(size_t count)
+    {
+        const size_t kSegmentsPerTrail = 64;
+        const size_t kRayCount = 16;
+        size_t pairCount = std::max<size_t>(count / 2, 2);
+        std::vector<glm::vec3> steps = makeRandomVectors<glm::vec3>(pairCount, -0.05F, 0.05F);
+        std::vector<glm::vec3> sides = makeRandomVectors<glm::vec3>(pairCount, -0.02F, 0.02F);
+        std::vector<glm::vec3> starts = makeRandomVectors<glm::vec3>(pairCount / (kSegmentsPerTrail + 1) + 1, -20.0F, 20.0F);
+        std::vector<glm::vec3> rayOrigins = makeRandomVectors<glm::vec3>(kRayCount, -20.0F, 20.0F);
+        std::vector<glm::vec3> rayTargets = makeRandomVectors<glm::vec3>(kRayCount, -20.0F, 20.0F);
+        // the long ribbon random walks around the origin, the short ones around their own start points
+        std::vector<glm::vec3> longRibbon(pairCount * 2);
+        std::vector<glm::vec3> scattered(pairCount * 2);
+        glm::vec3 walk(0.0F);
+        glm::vec3 trailWalk(0.0F);
+        for(size_t pairIdx = 0; pairIdx < pairCount; pairIdx++)
+        {
+            walk = glm::clamp(walk + steps[pairIdx], glm::vec3(-2.0F), glm::vec3(2.0F));
+            trailWalk = pairIdx % (kSegmentsPerTrail + 1) == 0 ? starts[pairIdx / (kSegmentsPerTrail + 1)]
+                                                               : trailWalk + steps[pairIdx];
+            longRibbon[pairIdx * 2] = walk - sides[pairIdx];
+            longRibbon[pairIdx * 2 + 1] = walk + sides[pairIdx];
+            scattered[pairIdx * 2] = trailWalk - sides[pairIdx];
+            scattered[pairIdx * 2 + 1] = trailWalk + sides[pairIdx];
+        }
+        // aim half the rays through the long ribbon's neighbourhood so they actually hit things
+        for(size_t rayIdx = 0; rayIdx < kRayCount; rayIdx += 2)
+        {
+            rayTargets[rayIdx] = longRibbon[(rayIdx * 7919) % longRibbon.size()];
+        }
+
+        RibbonIntersector longIntersector;
+        longIntersector.addTrail(0, longRibbon.data(), longRibbon.size());
+        size_t segmentCount = pairCount - 1;
+        size_t glmHits = 0;
+        double glmSeconds = timeBest([&](){
+            glmHits = 0;
+            for(size_t rayIdx = 0; rayIdx < kRayCount; rayIdx++)
+            {
+                glm::vec3 direction = rayTargets[rayIdx] - rayOrigins[rayIdx];
+                for(size_t vertIdx = 0; vertIdx + 2 < longRibbon.size(); vertIdx++)
+                {
+                    glm::vec2 baryPosition;
+                    float distance;
+                    if(glm::intersectRayTriangle(rayOrigins[rayIdx], direction, longRibbon[vertIdx], longRibbon[vertIdx + 1],
+                                                 longRibbon[vertIdx + 2], baryPosition, distance) && distance >= 0.0F)
+                    {
+                        glmHits++;
+                    }
+                }
+            }
+        }, 3);
+        std::vector<RibbonHit> hits;
+        double simdSeconds = timeBest([&](){
+            hits.clear();
+            for(size_t rayIdx = 0; rayIdx < kRayCount; rayIdx++)
+            {
+                longIntersector.intersectAll(rayOrigins[rayIdx], rayTargets[rayIdx] - rayOrigins[rayIdx],
+                        std::numeric_limits<float>::max(), hits);
+            }
+        }, 3);
+        size_t rayTriangleBytes = kRayCount * segmentCount * 2 * sizeof(glm::vec3) * 3;
+        printResult("ray vs one long ribbon, all hits [glm]", kRayCount * segmentCount, rayTriangleBytes, glmSeconds);
+        printResult("ray vs one long ribbon, all hits [SIMD]", kRayCount * segmentCount, rayTriangleBytes, simdSeconds);
+        std::cout << "    " << glmHits << " vs " << hits.size() << " hits" << std::endl;
+
+        RibbonIntersector scatteredIntersector;
+        size_t trailVertexCount = (kSegmentsPerTrail + 1) * 2;
+        for(size_t firstVertex = 0; firstVertex < scattered.size(); firstVertex += trailVertexCount)
+        {
+            scatteredIntersector.addTrail(static_cast<uint32_t>(firstVertex / trailVertexCount), scattered.data() + firstVertex,
+                    std::min(trailVertexCount, scattered.size() - firstVertex));
+        }
+        size_t firstHits = 0;
+        double firstSeconds = timeBest([&](){
+            firstHits = 0;
+            for(size_t rayIdx = 0; rayIdx < kRayCount; rayIdx++)
+            {
+                RibbonHit hit;
+                firstHits += scatteredIntersector.intersectFirst(rayOrigins[rayIdx], rayTargets[rayIdx] - rayOrigins[rayIdx],
+                        std::numeric_limits<float>::max(), hit) ? 1 : 0;
+            }
+        });
+        // bounds culling means most trails' triangles are never read, so count the bounds as the bytes touched
+        size_t boundsBytes = kRayCount * scatteredIntersector.getTrailCount() * sizeof(glm::vec3) * 2;
+        printResult("ray vs scattered trails, first hit [SIMD]", kRayCount * segmentCount, boundsBytes, firstSeconds);
+        std::cout << "    " << scatteredIntersector.getTrailCount() << " trails, " << firstHits << " of " << kRayCount
+        << " rays hit" << std::endl;
+    }
+
+    /**
+     * Converting a batch of cursor positions to device coords through the cached InputTransform, against
+     * the per-event divides processInput() used to do
+     */
+    void benchmarkInputTransform(size_t count)
+    {
+        std::vector<glm::dvec2> cursorPositions(count);
+        std::vector<glm::vec3> randomPositions = makeRandomVectors<glm::vec3>(count, 0.0F, 800.0F);
+        for(size_t posIdx = 0; posIdx < count; posIdx++)
+        {
+            cursorPositions[posIdx] = glm::dvec2(randomPositions[posIdx]);
+        }
+        std::vector<glm::vec2> perEvent(count);
+        std::vector<glm::vec2> batched(count);
+        // a HiDPI window: 800x600 screen units backed by a 1600x1200 framebuffer
+        int width = 800;
+        int height = 600;
+        InputTransform inputTransform;
+        inputTransform.setWindowSize(width, height);
+        inputTransform.setFramebufferSize(width * 2, height * 2);
+        inputTransform.setViewport(0, 0, width * 2, height * 2);
+
+        double perEventSeconds = timeBest([&](){
+            for(size_t posIdx = 0; posIdx < count; posIdx++)
+            {
+                float halfMagX = 0.5F * static_cast<float>(width);
+                float halfMagY = 0.5F * static_cast<float>(height);
+                perEvent[posIdx] = glm::vec2((cursorPositions[posIdx].x - halfMagX) / halfMagX,
+                                             1.0F - (cursorPositions[posIdx].y / halfMagY));
+            }
+        });
+        double batchedSeconds = timeBest([&](){
+            inputTransform.windowToDevice(cursorPositions.data(), batched.data(), count);
+        });
+        float maxError = 0.0F;
+        for(size_t posIdx = 0; posIdx < count; posIdx++)
+        {
+            maxError = std::max(maxError, glm::length(perEvent[posIdx] - batched[posIdx]));
+        }
+        size_t bytesTouched = count * (sizeof(glm::dvec2) + sizeof(glm::vec2));
+        printResult("window to device [per-event divides]", count, bytesTouched, perEventSeconds);
+        printResult("window to device [InputTransform batch]", count, bytesTouched, batchedSeconds);
+        std::cout << "    max difference " << std::scientific << maxError << std::fixed << std::endl;
+    }
+
+    /**
+     * Procedural ribbon texture synthesis in texels per second: the scalar reference, the SIMD kernel on one
+     * thread, and the SIMD kernel tiled across a ThreadPool
+     */
+    void benchmarkProceduralTexture(size_t count)
+    {
+        const GLsizei kWidth = 1024;
+        GLsizei height = static_cast<GLsizei>(std::max<size_t>(count / kWidth, 1));
+        size_t texelCount = static_cast<size_t>(kWidth) * static_cast<size_t>(height);
+        size_t rowStride = static_cast<size_t>(kWidth) * 4;
+        RibbonTextureParameters parameters;
+        parameters.seed = 1234;
+        std::vector<uint8_t> scalarTexels(texelCount * 4);
+        std::vector<uint8_t> simdTexels(texelCount * 4);
+        std::vector<uint8_t> pooledTexels(texelCount * 4);
+        ThreadPool pool;
+
+        double scalarSeconds = timeBest([&](){
+            for(GLsizei y = 0; y < height; y++)
+            {
+                for(GLsizei x = 0; x < kWidth; x++)
+                {
+                    glm::u8vec4 texel = evaluateRibbonTexel(parameters, kWidth, height, x, y);
+                    std::memcpy(&scalarTexels[(static_cast<size_t>(y) * kWidth + x) * 4], &texel, 4);
+                }
+            }
+        }, 3);
+        double simdSeconds = timeBest([&](){
+            generateRibbonTextureRegion(parameters, kWidth, height, 0, 0, kWidth, height, simdTexels.data(), rowStride);
+        }, 3);
+        double pooledSeconds = timeBest([&](){
+            generateRibbonTexture(parameters, kWidth, height, 0, height, pooledTexels.data(), pool);
+        }, 3);
+
+        int maxDifference = 0;
+        for(size_t byteIdx = 0; byteIdx < scalarTexels.size(); byteIdx++)
+        {
+            maxDifference = std::max(maxDifference, std::abs(scalarTexels[byteIdx] - simdTexels[byteIdx]));
+        }
+        size_t bytesWritten = texelCount * 4;
+        printResult("ribbon texture [scalar]", texelCount, bytesWritten, scalarSeconds);
+        printResult("ribbon texture [SIMD, 1 thread]", texelCount, bytesWritten, simdSeconds);
+        printResult("ribbon texture [SIMD, " + std::to_string(pool.getThreadCount()) + " threads]", texelCount,
+                bytesWritten, pooledSeconds);
+        std::cout << "    " << static_cast<double>(texelCount) / pooledSeconds / 1e6 << " Mtexels/s pooled, max difference "
+        << maxDifference << ", pooled output " << (pooledTexels == simdTexels ? "matches" : "differs from")
+        << " 1 thread" << std::endl;
+        if(pooledTexels != simdTexels)
+        {
+            reportMismatch("pooled ribbon texture differs from the single threaded one");
+        }
+    }
+
+    /**
+     * Writes a wavy grid with about triangleCount triangles as an OBJ with shared v/vt/vn indices and as a
+     * binary PLY, both with positions, normals and texture coords
+     */
+    void writeMeshGrid(size_t triangleCount, const std::string& objPath, const std::string& plyPath)
+    {
+        size_t quadsPerSide = std::max<size_t>(static_cast<size_t>(std::sqrt(static_cast<double>(triangleCount) / 2.0)), 1);
+        size_t verticesPerSide = quadsPerSide + 1;
+        std::vector<MeshVertex> vertices;
+        vertices.reserve(verticesPerSide * verticesPerSide);
+        for(size_t row = 0; row < verticesPerSide; row++)
+        {
+            for(size_t column = 0; column < verticesPerSide; column++)
+            {
+                glm::vec2 texCoord = glm::vec2(column, row) / static_cast<float>(quadsPerSide);
+                float height = 0.05F * std::sin(texCoord.x * 40.0F) * std::cos(texCoord.y * 30.0F);
+                glm::vec3 normal = glm::normalize(glm::vec3(-2.0F * std::cos(texCoord.x * 40.0F) * std::cos(texCoord.y * 30.0F),
+                        1.5F * std::sin(texCoord.x * 40.0F) * std::sin(texCoord.y * 30.0F), 1.0F));
+                vertices.push_back(MeshVertex{glm::vec3(texCoord.x * 10.0F - 5.0F, texCoord.y * 10.0F - 5.0F, height),
+                        normal, texCoord});
+            }
+        }
+        std::vector<uint32_t> quads;
+        quads.reserve(quadsPerSide * quadsPerSide * 4);
+        for(size_t row = 0; row < quadsPerSide; row++)
+        {
+            for(size_t column = 0; column < quadsPerSide; column++)
+            {
+                uint32_t corner = static_cast<uint32_t>(row * verticesPerSide + column);
+                uint32_t cornerQuad[] = {corner, corner + 1, corner + 1 + static_cast<uint32_t>(verticesPerSide),
+                                         corner + static_cast<uint32_t>(verticesPerSide)};
+                quads.insert(quads.end(), cornerQuad, cornerQuad + 4);
+            }
+        }
+
+        FILE* obj = std::fopen(objPath.c_str(), "w");
+        std::fprintf(obj, "# %zu quad grid\no grid\n", quadsPerSide * quadsPerSide);
+        for(const MeshVertex& vertex : vertices)
+        {
+            std::fprintf(obj, "v %.6f %.6f %.6f\n", vertex.position.x, vertex.position.y, vertex.position.z);
+        }
+        for(const MeshVertex& vertex : vertices)
+        {
+            std::fprintf(obj, "vt %.6f %.6f\n", vertex.texCoord.x, vertex.texCoord.y);
+        }
+        for(const MeshVertex& vertex : vertices)
+        {
+            std::fprintf(obj, "vn %.6f %.6f %.6f\n", vertex.normal.x, vertex.normal.y, vertex.normal.z);
+        }
+        for(size_t quadIdx = 0; quadIdx < quads.size(); quadIdx += 4)
+        {
+            // half the quads as two triangles, half left for the importer to triangulate
+            const uint32_t* quad = &quads[quadIdx];
+            if(quadIdx % 8 == 0)
+            {
+                std::fprintf(obj, "f %u/%u/%u %u/%u/%u %u/%u/%u\nf %u/%u/%u %u/%u/%u %u/%u/%u\n",
+                        quad[0] + 1, quad[0] + 1, quad[0] + 1, quad[1] + 1, quad[1] + 1, quad[1] + 1, quad[2] + 1, quad[2] + 1, quad[2] + 1,
+                        quad[0] + 1, quad[0] + 1, quad[0] + 1, quad[2] + 1, quad[2] + 1, quad[2] + 1, quad[3] + 1, quad[3] + 1, quad[3] + 1);
+            }
+            else
+            {
+                std::fprintf(obj, "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", quad[0] + 1, quad[0] + 1, quad[0] + 1,
+                        quad[1] + 1, quad[1] + 1, quad[1] + 1, quad[2] + 1, quad[2] + 1, quad[2] + 1, quad[3] + 1, quad[3] + 1, quad[3] + 1);
+            }
+        }
+        std::fclose(obj);
+
+        FILE* ply = std::fopen(plyPath.c_str(), "wb");
+        std::fprintf(ply, "ply\nformat binary_little_endian 1.0\nelement vertex %zu\nproperty float x\nproperty float y\n"
+                          "property float z\nproperty float nx\nproperty float ny\nproperty float nz\nproperty float u\n"
+                          "property float v\nelement face %zu\nproperty list uchar int vertex_indices\nend_header\n",
+                vertices.size(), quads.size() / 4);
+        std::fwrite(vertices.data(), sizeof(MeshVertex), vertices.size(), ply);
+        for(size_t quadIdx = 0; quadIdx < quads.size(); quadIdx += 4)
+        {
+            uint8_t cornerCount = 4;
+            std::fwrite(&cornerCount, 1, 1, ply);
+            std::fwrite(&quads[quadIdx], sizeof(uint32_t), 4, ply);
+        }
+        std::fclose(ply);
+    }
+
+    struct MeshVertexHash
+    {
+        size_t operator()(const MeshVertex& vertex) const
+        {
+            return std::hash<glm::vec3>()(vertex.position) ^ (std::hash<glm::vec3>()(vertex.normal) * 31)
+                   ^ (std::hash<glm::vec2>()(vertex.texCoord) * 131);
+        }
+    };
+
+    struct MeshVertexEqual
+    {
+        bool operator()(const MeshVertex& left, const MeshVertex& right) const
+        {
+            return std::memcmp(&left, &right, sizeof(MeshVertex)) == 0;
+        }
+    };
+
+    /**
+     * The textbook importer: getline, a stringstream per line and one std::unordered_map
+     */
+    void importObjWithStreams(const std::string& path, ImportedMesh& mesh)
+    {
+        std::ifstream input(path);
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> texCoords;
+        std::unordered_map<MeshVertex, uint32_t, MeshVertexHash, MeshVertexEqual> welded;
+        mesh.vertices.clear();
+        mesh.indices.clear();
+        std::string line;
+        std::vector<uint32_t> face;
+        while(std::getline(input, line))
+        {
+            std::istringstream tokens(line);
+            std::string keyword;
+            tokens >> keyword;
+            if(keyword == "v")
+            {
+                glm::vec3 position;
+                tokens >> position.x >> position.y >> position.z;
+                positions.push_back(position);
+            }
+            else if(keyword == "vt")
+            {
+                glm::vec2 texCoord;
+                tokens >> texCoord.x >> texCoord.y;
+                texCoords.push_back(texCoord);
+            }
+            else if(keyword == "vn")
+            {
+                glm::vec3 normal;
+                tokens >> normal.x >> normal.y >> normal.z;
+                normals.push_back(normal);
+            }
+            else if(keyword == "f")
+            {
+                face.clear();
+                std::string corner;
+                while(tokens >> corner)
+                {
+                    int position = 0;
+                    int texCoord = 0;
+                    int normal = 0;
+                    std::sscanf(corner.c_str(), "%d/%d/%d", &position, &texCoord, &normal);
+                    MeshVertex vertex{positions[position - 1], normals[normal - 1], texCoords[texCoord - 1]};
+                    auto inserted = welded.emplace(vertex, static_cast<uint32_t>(mesh.vertices.size()));
+                    if(inserted.second)
+                    {
+                        mesh.vertices.push_back(vertex);
+                    }
+                    face.push_back(inserted.first->second);
+                }
+                for(size_t cornerIdx = 2; cornerIdx < face.size(); cornerIdx++)
+                {
+                    mesh.indices.insert(mesh.indices.end(), {face[0], face[cornerIdx - 1], face[cornerIdx]});
+                }
+            }
+        }
+    }
+
+    /**
+     * @return the largest difference between any attribute of two meshes' vertices, or infinity if their
+     *         vertex or index lists differ in shape
+     */
+    float compareMeshes(const ImportedMesh& left, const ImportedMesh& right)
+    {
+        if(left.vertices.size() != right.vertices.size() || left.indices != right.indices)
+        {
+            return std::numeric_limits<float>::infinity();
+        }
+        float maxDifference = 0.0F;
+        for(size_t vertexIdx = 0; vertexIdx < left.vertices.size(); vertexIdx++)
+        {
+            const float* leftValues = &left.vertices[vertexIdx].position.x;
+            const float* rightValues = &right.vertices[vertexIdx].position.x;
+            for(size_t valueIdx = 0; valueIdx < sizeof(MeshVertex) / sizeof(float); valueIdx++)
+            {
+                maxDifference = std::max(maxDifference, std::abs(leftValues[valueIdx] - rightValues[valueIdx]));
+            }
+        }
+        return maxDifference;
+    }
+
+    void benchmarkMeshImport(size_t count)
+    {
+        const std::string objPath = "OpenGLSandboxBench_grid.obj";
+        const std::string plyPath = "OpenGLSandboxBench_grid.ply";
+        writeMeshGrid(count, objPath, plyPath);
+        ThreadPool pool;
+        ThreadPool serialPool(1);
+        ImportedMesh streamMesh;
+        ImportedMesh objMesh;
+        ImportedMesh serialObjMesh;
+        ImportedMesh plyMesh;
+
+        double streamSeconds = timeBest([&](){ importObjWithStreams(objPath, streamMesh); }, 1);
+        double serialObjSeconds = timeBest([&](){ importMesh(objPath, serialObjMesh, serialPool, false); }, 3);
+        double objSeconds = timeBest([&](){ importMesh(objPath, objMesh, pool, false); }, 3);
+        double plySeconds = timeBest([&](){ importMesh(plyPath, plyMesh, pool, false); }, 3);
+
+        std::ifstream objFile(objPath, std::ios::binary | std::ios::ate);
+        size_t objBytes = static_cast<size_t>(objFile.tellg());
+        std::ifstream plyFile(plyPath, std::ios::binary | std::ios::ate);
+        size_t plyBytes = static_cast<size_t>(plyFile.tellg());
+        size_t triangleCount = objMesh.indices.size() / 3;
+        printResult("OBJ import [ifstream, unordered_map]", triangleCount, objBytes, streamSeconds);
+        printResult("OBJ import [mapped, 1 thread]", triangleCount, objBytes, serialObjSeconds);
+        printResult("OBJ import [mapped, " + std::to_string(pool.getThreadCount()) + " threads]", triangleCount,
+                objBytes, objSeconds);
+        printResult("binary PLY import [mapped, " + std::to_string(pool.getThreadCount()) + " threads]", triangleCount,
+                plyBytes, plySeconds);
+        std::cout << "    " << objMesh.vertices.size() << " welded vertices, max difference from ifstream "
+        << compareMeshes(objMesh, streamMesh) << ", 1 thread " << compareMeshes(objMesh, serialObjMesh)
+        << ", PLY " << compareMeshes(objMesh, plyMesh) << std::endl;
+        std::remove(objPath.c_str());
+        std::remove(plyPath.c_str());
+    }
+
+    void benchmarkMeshCache(size_t count)
+    {
+        const std::string objPath = "OpenGLSandboxBench_grid.obj";
+        const std::string plyPath = "OpenGLSandboxBench_grid.ply";
+        const std::string cachePath = "OpenGLSandboxBench_grid.meshcache";
+        const std::string compressedCachePath = "OpenGLSandboxBench_grid_compressed.meshcache";
+        writeMeshGrid(count, objPath, plyPath);
+        ThreadPool pool;
+        ImportedMesh mesh;
+        MeshSourceStamp source;
+        getMeshSourceStamp(objPath, source);
+
+        double importSeconds = timeBest([&](){ importMesh(objPath, mesh, pool, false); }, 1);
+        double writeSeconds = timeBest([&](){ writeMeshCache(cachePath, mesh, source, false); }, 3);
+        double compressedWriteSeconds = timeBest([&](){ writeMeshCache(compressedCachePath, mesh, source, true); }, 3);
+        MeshCache cache;
+        MeshCache compressedCache;
+        double openSeconds = timeBest([&](){ cache.open(cachePath); }, 3);
+        double compressedOpenSeconds = timeBest([&](){ compressedCache.open(compressedCachePath); }, 3);
+
+        MeshSourceStamp cacheStamp;
+        MeshSourceStamp compressedStamp;
+        getMeshSourceStamp(cachePath, cacheStamp);
+        getMeshSourceStamp(compressedCachePath, compressedStamp);
+        size_t triangleCount = mesh.indices.size() / 3;
+        printResult("OBJ import", triangleCount, source.size, importSeconds);
+        printResult("cache write", triangleCount, cacheStamp.size, writeSeconds);
+        printResult("cache write [compressed indices]", triangleCount, compressedStamp.size, compressedWriteSeconds);
+        printResult("cache open + validate", triangleCount, cacheStamp.size, openSeconds);
+        printResult("cache open + validate [compressed indices]", triangleCount, compressedStamp.size, compressedOpenSeconds);
+        std::vector<uint32_t> cachedIndices = mesh.indices;
+        replaceWithStripsIfShorter(cachedIndices, mesh.vertices.size());
+        bool matches = cache.isOpen() && compressedCache.isOpen() && cache.getVertexCount() == mesh.vertices.size()
+                && std::memcmp(cache.getVertexData(), mesh.vertices.data(), sizeof(MeshVertex) * mesh.vertices.size()) == 0
+                && cache.getIndexCount() == cachedIndices.size()
+                && std::equal(cachedIndices.begin(), cachedIndices.end(), cache.getIndices())
+                && std::equal(cachedIndices.begin(), cachedIndices.end(), compressedCache.getIndices());
+        std::cout << "    " << source.size / 1024 << " KB OBJ, " << cacheStamp.size / 1024 << " KB cache, "
+        << compressedStamp.size / 1024 << " KB compressed ("
+        << static_cast<double>(compressedStamp.size - mesh.vertices.size() * sizeof(MeshVertex)) * 8.0
+           / static_cast<double>(cachedIndices.size())
+        << " bits/index), contents " << (matches ? "match" : "differ from") << " the import" << std::endl;
+        if(!matches)
+        {
+            reportMismatch("cached mesh differs from the import");
+        }
+        cache.close();
+        compressedCache.close();
+        std::remove(objPath.c_str());
+        std::remove(plyPath.c_str());
+        std::remove(cachePath.c_str());
+        std::remove(compressedCachePath.c_str());
+    }
+
+    void printMeshOrderStatistics(const std::string& label, const ImportedMesh& mesh)
+    {
+        VertexCacheStatistics cache = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+        float overfetch = analyzeVertexFetch(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(),
+                sizeof(MeshVertex));
+        std::cout << "    " << std::left << std::setw(34) << label << std::right << std::setprecision(3)
+        << " ACMR " << cache.acmr << "  ATVR " << cache.atvr << "  overfetch " << overfetch << std::endl;
+    }
+
+    void benchmarkMeshOptimization(size_t count)
+    {
+        const std::string objPath = "OpenGLSandboxBench_grid.obj";
+        const std::string plyPath = "OpenGLSandboxBench_grid.ply";
+        writeMeshGrid(count, objPath, plyPath);
+        ThreadPool pool;
+        ImportedMesh fileOrder;
+        importMesh(objPath, fileOrder, pool, false);
+        std::remove(objPath.c_str());
+        std::remove(plyPath.c_str());
+
+        // the same mesh with its triangles and vertices shuffled, as an arbitrary exporter might leave them
+        ImportedMesh shuffled = fileOrder;
+        std::mt19937 generator(1234);
+        size_t triangleCount = shuffled.indices.size() / 3;
+        std::vector<uint32_t> triangleOrder(triangleCount);
+        std::iota(triangleOrder.begin(), triangleOrder.end(), 0);
+        std::shuffle(triangleOrder.begin(), triangleOrder.end(), generator);
+        std::vector<uint32_t> vertexOrder(shuffled.vertices.size());
+        std::iota(vertexOrder.begin(), vertexOrder.end(), 0);
+        std::shuffle(vertexOrder.begin(), vertexOrder.end(), generator);
+        for(size_t triangle = 0; triangle < triangleCount; triangle++)
+        {
+            for(size_t corner = 0; corner < 3; corner++)
+            {
+                shuffled.indices[triangle * 3 + corner] = vertexOrder[fileOrder.indices[triangleOrder[triangle] * 3 + corner]];
+            }
+        }
+        for(size_t vertex = 0; vertex < vertexOrder.size(); vertex++)
+        {
+            shuffled.vertices[vertexOrder[vertex]] = fileOrder.vertices[vertex];
+        }
+
+        const std::pair<const char*, const ImportedMesh*> sources[] = {{"file order", &fileOrder}, {"shuffled", &shuffled}};
+        for(const std::pair<const char*, const ImportedMesh*>& source : sources)
+        {
+            ImportedMesh mesh = *source.second;
+            double cacheSeconds = timeBest([&](){
+                std::copy(source.second->indices.begin(), source.second->indices.end(), mesh.indices.begin());
+                optimizeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+            }, 1);
+            ImportedMesh cacheOptimized = mesh;
+            double overdrawSeconds = timeBest([&](){
+                std::copy(cacheOptimized.indices.begin(), cacheOptimized.indices.end(), mesh.indices.begin());
+                optimizeOverdraw(mesh.indices.data(), mesh.indices.size(), &mesh.vertices.data()->position.x,
+                        sizeof(MeshVertex), mesh.vertices.size());
+            }, 1);
+            ImportedMesh overdrawOptimized = mesh;
+            double fetchSeconds = timeBest([&](){
+                optimizeVertexFetch(mesh.vertices.data(), mesh.vertices.size(), sizeof(MeshVertex), mesh.indices.data(),
+                        mesh.indices.size());
+            }, 1);
+            std::string label = std::string(source.first) + " ";
+            printResult(label + "vertex cache [Forsyth]", triangleCount, mesh.indices.size() * sizeof(uint32_t), cacheSeconds);
+            printResult(label + "overdraw clusters", triangleCount, mesh.indices.size() * sizeof(uint32_t), overdrawSeconds);
+            printResult(label + "vertex fetch", triangleCount, mesh.vertices.size() * sizeof(MeshVertex), fetchSeconds);
+            printMeshOrderStatistics(label + "before", *source.second);
+            printMeshOrderStatistics(label + "after vertex cache", cacheOptimized);
+            printMeshOrderStatistics(label + "after overdraw", overdrawOptimized);
+            printMeshOrderStatistics(label + "after vertex fetch", mesh);
+        }
+    }
+
+    /**
+     * Expands restart-joined strips back into a triangle list, each triangle rotated to start at its lowest
+     * index so the same triangles with the same winding compare equal however they were emitted
+     */
+    std::vector<std::array<uint32_t, 3>> unstripify(const std::vector<uint32_t>& strips)
+    {
+        std::vector<std::array<uint32_t, 3>> triangles;
+        size_t stripStart = 0;
+        for(size_t indexIdx = 0; indexIdx <= strips.size(); indexIdx++)
+        {
+            if(indexIdx < strips.size() && strips[indexIdx] != kPrimitiveRestartIndex)
+            {
+                continue;
+            }
+            for(size_t corner = stripStart; corner + 2 < indexIdx; corner++)
+            {
+                bool odd = (corner - stripStart) % 2 == 1;
+                triangles.push_back({{strips[odd ? corner + 1 : corner], strips[odd ? corner : corner + 1], strips[corner + 2]}});
+            }
+            stripStart = indexIdx + 1;
+        }
+        return triangles;
+    }
+
+    std::vector<std::array<uint32_t, 3>> canonicalTriangles(std::vector<std::array<uint32_t, 3>> triangles)
+    {
+        for(std::array<uint32_t, 3>& triangle : triangles)
+        {
+            std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    void benchmarkStripify(size_t count)
+    {
+        const std::string objPath = "OpenGLSandboxBench_grid.obj";
+        const std::string plyPath = "OpenGLSandboxBench_grid.ply";
+        writeMeshGrid(count, objPath, plyPath);
+        ThreadPool pool;
+        ImportedMesh fileOrder;
+        importMesh(objPath, fileOrder, pool, false);
+        std::remove(objPath.c_str());
+        std::remove(plyPath.c_str());
+        ImportedMesh optimized = fileOrder;
+        optimizeImportedMesh(optimized);
+
+        const std::pair<const char*, const ImportedMesh*> sources[] = {{"file order", &fileOrder}, {"optimised", &optimized}};
+        for(const std::pair<const char*, const ImportedMesh*>& source : sources)
+        {
+            const ImportedMesh& mesh = *source.second;
+            std::vector<uint32_t> strips;
+            double seconds = timeBest([&](){
+                strips = stripifyTriangles(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+            }, 3);
+            size_t triangleCount = mesh.indices.size() / 3;
+            size_t stripCount = static_cast<size_t>(std::count(strips.begin(), strips.end(), kPrimitiveRestartIndex)) + 1;
+            std::vector<std::array<uint32_t, 3>> listTriangles(triangleCount);
+            std::memcpy(listTriangles.data(), mesh.indices.data(), sizeof(uint32_t) * mesh.indices.size());
+            bool matches = canonicalTriangles(unstripify(strips)) == canonicalTriangles(listTriangles);
+            // a restart leaves the post-transform cache as it was, so the cache sees the strips without them
+            std::vector<uint32_t> stripsWithoutRestarts;
+            std::remove_copy(strips.begin(), strips.end(), std::back_inserter(stripsWithoutRestarts), kPrimitiveRestartIndex);
+            VertexCacheStatistics stripCache = analyzeVertexCache(stripsWithoutRestarts.data(), stripsWithoutRestarts.size(),
+                    mesh.vertices.size());
+            VertexCacheStatistics listCache = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+            printResult(std::string("stripify [") + source.first + "]", triangleCount, mesh.indices.size() * sizeof(uint32_t),
+                    seconds);
+            std::cout << "    " << mesh.indices.size() << " list indices -> " << strips.size() << " strip indices ("
+            << std::setprecision(3) << 100.0 * static_cast<double>(strips.size()) / static_cast<double>(mesh.indices.size())
+            << "%) in " << stripCount << " strips, ACMR " << listCache.acmr << " as a list, "
+            << static_cast<double>(stripCache.transformedVertices) / static_cast<double>(triangleCount)
+            << " as strips, triangles " << (matches ? "match" : "differ") << std::endl;
+            if(!matches)
+            {
+                reportMismatch(std::string("strips of ") + source.first + " differ from its triangle list");
+            }
+        }
+    }
+
+    /**
+     * Scalar reference for cullMeshClusters()
+     */
+    std::vector<DrawElementsIndirectCommand> cullMeshClustersScalar(const MeshClusters& clusters, const ViewFrustum& frustum,
+            const glm::vec3& cameraPosition)
+    {
+        std::vector<DrawElementsIndirectCommand> commands;
+        for(size_t cluster = 0; cluster < clusters.size(); cluster++)
+        {
+            glm::vec3 center = clusters.centers.get(cluster);
+            float radius = clusters.radii[cluster];
+            glm::vec3 toCenter = center - cameraPosition;
+            if(sphereInFrustum(frustum, center, radius)
+               && glm::dot(toCenter, clusters.coneAxes.get(cluster)) < clusters.coneCutoffs[cluster] * glm::length(toCenter) + radius)
+            {
+                commands.push_back(DrawElementsIndirectCommand{clusters.indexCounts[cluster], 1, clusters.firstIndices[cluster], 0,
+                                                               static_cast<GLuint>(cluster)});
+            }
+        }
+        return commands;
+    }
+
+    /**
+     * @return whether any of the triangle could produce fragments: it faces the camera and isn't wholly outside one
+     *         of the frustum's planes
+     */
+    bool triangleMaybeVisible(const ViewFrustum& frustum, const glm::vec3& cameraPosition, const glm::vec3& a,
+            const glm::vec3& b, const glm::vec3& c)
+    {
+        if(glm::dot(glm::cross(b - a, c - a), a - cameraPosition) >= 0.0F)
+        {
+            return false;
+        }
+        for(const glm::vec4& plane : frustum.planes)
+        {
+            glm::vec3 normal(plane);
+            if(glm::dot(normal, a) + plane.w < 0.0F && glm::dot(normal, b) + plane.w < 0.0F && glm::dot(normal, c) + plane.w < 0.0F)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void benchmarkMeshClusters(size_t count)
+    {
+        const std::string objPath = "OpenGLSandboxBench_grid.obj";
+        const std::string plyPath = "OpenGLSandboxBench_grid.ply";
+        writeMeshGrid(count, objPath, plyPath);
+        ThreadPool pool;
+        ImportedMesh mesh;
+        importMesh(objPath, mesh, pool, false);
+        std::remove(objPath.c_str());
+        std::remove(plyPath.c_str());
+        optimizeImportedMesh(mesh);
+        size_t triangleCount = mesh.indices.size() / 3;
+
+        MeshClusters clusters;
+        double buildSeconds = timeBest([&](){
+            clusters = buildMeshClusters(mesh.indices.data(), mesh.indices.size(), &mesh.vertices.data()->position.x,
+                    sizeof(MeshVertex), mesh.vertices.size());
+        }, 1);
+        printResult("build clusters", triangleCount, mesh.indices.size() * sizeof(uint32_t), buildSeconds);
+        std::vector<std::array<uint32_t, 3>> listTriangles(triangleCount);
+        std::memcpy(listTriangles.data(), mesh.indices.data(), sizeof(uint32_t) * mesh.indices.size());
+        std::vector<std::array<uint32_t, 3>> clusterTriangles(triangleCount);
+        std::memcpy(clusterTriangles.data(), clusters.indices.data(), sizeof(uint32_t) * clusters.indices.size());
+        bool matches = canonicalTriangles(clusterTriangles) == canonicalTriangles(listTriangles);
+        double radiusSum = std::accumulate(clusters.radii.begin(), clusters.radii.begin() + static_cast<ptrdiff_t>(clusters.size()), 0.0);
+        size_t coneCount = static_cast<size_t>(std::count_if(clusters.coneCutoffs.begin(),
+                clusters.coneCutoffs.begin() + static_cast<ptrdiff_t>(clusters.size()), [](float cutoff){ return cutoff < 1.0F; }));
+        std::cout << "    " << clusters.size() << " clusters of " << std::setprecision(4)
+        << static_cast<double>(triangleCount) / static_cast<double>(clusters.size()) << " triangles on average, mean radius "
+        << radiusSum / static_cast<double>(clusters.size()) << ", " << coneCount << " with cones, ACMR "
+        << analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size()).acmr << " -> "
+        << analyzeVertexCache(clusters.indices.data(), clusters.indices.size(), mesh.vertices.size()).acmr
+        << ", triangles " << (matches ? "match" : "differ") << std::endl;
+        if(!matches)
+        {
+            reportMismatch("clusters' triangles differ from the mesh's");
+        }
+
+        struct View
+        {
+            const char* name;
+            glm::vec3 eye;
+            glm::vec3 target;
+        };
+        const View views[] = {
+                {"overhead", glm::vec3(0.0F, 0.0F, 9.0F), glm::vec3(0.0F)},
+                {"close to one corner", glm::vec3(-4.5F, -4.5F, 0.6F), glm::vec3(-3.0F, -3.0F, 0.0F)},
+                {"from below", glm::vec3(0.0F, 0.0F, -9.0F), glm::vec3(0.0F)}
+        };
+        const int kCullsPerRun = 100;
+        glm::mat4 projection = glm::perspective(glm::radians(60.0F), 16.0F / 9.0F, 0.1F, 100.0F);
+        for(const View& view : views)
+        {
+            ViewFrustum frustum = extractViewFrustum(projection * glm::lookAt(view.eye, view.target, glm::vec3(0.0F, 1.0F, 0.0F)));
+            std::vector<DrawElementsIndirectCommand> commands;
+            ClusterCullStatistics statistics;
+            double simdSeconds = timeBest([&](){
+                for(int cullIdx = 0; cullIdx < kCullsPerRun; cullIdx++)
+                {
+                    statistics = cullMeshClusters(clusters, frustum, view.eye, commands);
+                }
+            });
+            std::vector<DrawElementsIndirectCommand> scalarCommands;
+            double scalarSeconds = timeBest([&](){
+                for(int cullIdx = 0; cullIdx < kCullsPerRun; cullIdx++)
+                {
+                    scalarCommands = cullMeshClustersScalar(clusters, frustum, view.eye);
+                }
+            });
+            bool simdMatches = commands.size() == scalarCommands.size() && std::equal(commands.begin(), commands.end(),
+                    scalarCommands.begin(), [](const DrawElementsIndirectCommand& a, const DrawElementsIndirectCommand& b){
+                        return a.baseInstance == b.baseInstance;
+                    });
+
+            // every triangle of a culled cluster must be invisible, and most of a drawn one's should be visible
+            std::vector<bool> drawn(clusters.size(), false);
+            size_t drawnTriangles = 0;
+            for(const DrawElementsIndirectCommand& command : commands)
+            {
+                drawn[command.baseInstance] = true;
+                drawnTriangles += command.count / 3;
+            }
+            size_t visibleTriangles = 0;
+            size_t wronglyCulled = 0;
+            for(size_t cluster = 0; cluster < clusters.size(); cluster++)
+            {
+                for(uint32_t indexIdx = clusters.firstIndices[cluster];
+                    indexIdx < clusters.firstIndices[cluster] + clusters.indexCounts[cluster]; indexIdx += 3)
+                {
+                    if(triangleMaybeVisible(frustum, view.eye, mesh.vertices[clusters.indices[indexIdx]].position,
+                            mesh.vertices[clusters.indices[indexIdx + 1]].position, mesh.vertices[clusters.indices[indexIdx + 2]].position))
+                    {
+                        visibleTriangles++;
+                        wronglyCulled += drawn[cluster] ? 0 : 1;
+                    }
+                }
+            }
+
+            std::string label = std::string("cull [") + view.name + "]";
+            printResult(label, clusters.size(), clusters.size() * 8 * sizeof(float), simdSeconds / kCullsPerRun);
+            printResult(label + " scalar", clusters.size(), clusters.size() * 8 * sizeof(float), scalarSeconds / kCullsPerRun);
+            std::cout << "    " << statistics.visible << " clusters drawn, " << statistics.outsideFrustum << " outside the frustum, "
+            << statistics.backFacing << " back-facing; " << drawnTriangles << " of " << triangleCount << " triangles drawn for "
+            << visibleTriangles << " visible, " << wronglyCulled << " visible ones culled, SIMD "
+            << (simdMatches ? "matches" : "differs from") << " scalar" << std::endl;
+            if(!simdMatches || wronglyCulled > 0)
+            {
+                reportMismatch(label + " culled visible triangles or disagrees with the scalar cull");
+            }
+        }
+    }
+
+    void benchmarkObjectCulling(size_t count)
+    {
+        // objects scattered through a cube around a camera looking down -z, each drawing its own index range
+        std::mt19937 generator(1234);
+        std::uniform_real_distribution<float> position(-100.0F, 100.0F);
+        std::uniform_real_distribution<float> radius(0.5F, 2.0F);
+        std::vector<glm::vec4> spheres(count);
+        std::vector<DrawElementsIndirectCommand> commands(count);
+        for(size_t objectIdx = 0; objectIdx < count; objectIdx++)
+        {
+            spheres[objectIdx] = glm::vec4(position(generator), position(generator), position(generator), radius(generator));
+            commands[objectIdx] = DrawElementsIndirectCommand{36, 1, static_cast<GLuint>(objectIdx % 64 * 36), 0,
+                                                              static_cast<GLuint>(objectIdx)};
+        }
+        ViewFrustum frustum = extractViewFrustum(glm::perspective(glm::radians(60.0F), 16.0F / 9.0F, 0.1F, 150.0F)
+                * glm::lookAt(glm::vec3(0.0F), glm::vec3(0.0F, 0.0F, -1.0F), glm::vec3(0.0F, 1.0F, 0.0F)));
+
+        std::vector<DrawElementsIndirectCommand> visibleCommands;
+        double seconds = timeBest([&](){
+            cullObjectsOnCpu(frustum, spheres.data(), commands.data(), count, visibleCommands);
+        });
+        printResult("CPU reference cull", count, count * (sizeof(glm::vec4) + sizeof(DrawElementsIndirectCommand)), seconds);
+
+        std::cout << "    " << visibleCommands.size() << " of " << count << " objects visible ("
+        << std::setprecision(3) << 100.0 * static_cast<double>(visibleCommands.size()) / static_cast<double>(count)
+        << "%)" << std::endl;
+    }
+
+    const Benchmark kBenchmarks[] = {
+            {"pack", benchmarkVertexPacking},
+            {"soa", benchmarkSoAMath},
+            {"quat", benchmarkQuaternionBatch},
+            {"easing", benchmarkEasing},
+            {"pool", benchmarkTrailPool},
+            {"grid", benchmarkSpatialHash},
+            {"ribbon", benchmarkRibbonIntersection},
+            {"input", benchmarkInputTransform},
+            {"texture", benchmarkProceduralTexture},
+            {"mesh", benchmarkMeshImport},
+            {"meshcache", benchmarkMeshCache},
+            {"meshopt", benchmarkMeshOptimization},
+            {"strip", benchmarkStripify},
+            {"cluster", benchmarkMeshClusters},
+            {"objectcull", benchmarkObjectCulling}
+    };
+}
+
+int main(int argc, char** argv)
+{
+    std::string filter;
+    std::vector<size_t> counts;
+    for(int argIdx = 1; argIdx < argc; argIdx++)
+    {
+        char* end = nullptr;
+        unsigned long long count = std::strtoull(argv[argIdx], &end, 10);
+        if(end != argv[argIdx] && *end == '\0')
+        {
+            counts.push_back(static_cast<size_t>(count));
+        }
+        else
+        {
+            filter = argv[argIdx];
+        }
+    }
+    if(counts.empty())
+    {
+        counts = {1000000, 10000000};
+    }
+
+    for(const Benchmark& benchmark : kBenchmarks)
+    {
+        if(std::string(benchmark.name).find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        std::cout << benchmark.name << std::endl;
+        for(size_t count : counts)
+        {
+            benchmark.run(count);
+        }
+    }
+    return g_checkFailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
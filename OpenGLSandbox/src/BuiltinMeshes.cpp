@@ -0,0 +1,209 @@
+#include "BuiltinMeshes.h"
+#include <cstring>
+#include "GLResources.h"
+#include "MeshOptimization.h"
+#include "VertexLayout.h"
+#include "VertexPulling.h"
+
+namespace
+{
+    // raw tri data, using device coords directly
+    constexpr float kTrianglePositions[] = {
+            -0.5f, -0.5f, 0.0f,
+            0.5f, -0.5f, 0.0f,
+            0.0f,  0.5f, 0.0f
+    };
+    constexpr unsigned int kTriangleIndices[] = {0, 1, 2};
+
+    // raw rect data; these are only the unique vertices of the two triangles!
+    constexpr float kRectanglePositions[] = {
+            0.5f,  0.5f, 0.0f,  // top right
+            0.5f, -0.5f, 0.0f,  // bottom right
+            -0.5f, -0.5f, 0.0f,  // bottom left
+            -0.5f,  0.5f, 0.0f   // top left
+    };
+    constexpr unsigned int kRectangleIndices[] = {
+            0, 1, 3, // first triangle, upper-right half
+            1, 2, 3  // second triangle, lower-left half
+    };
+
+    // a triforce in GL_TRIANGLES primitive mode, or a triforce-ish thing in GL_TRIANGLE_STRIP mode
+    constexpr float kTriforcePositions[] = {
+            0, -1, 1,   // P0: bottom right of first tri and bottom left of third tri
+            -0.5, 0, 1, // P1: top of first tri and bottom left of second tri
+            -1, -1, 1,  // P2: bottom left of first tri
+            0.5, 0, 1,  // P3: bottom right of second tri and top of third tri
+            0, 1, 1,    // P4: top of second tri
+            1, -1, 1    // P5: bottom right of third tri
+    };
+    constexpr unsigned int kTriforceIndices[] = {
+            0, 1, 2,
+            3, 4, 1,
+            5, 3, 0
+    };
+
+    // the unique vertices of the 6 triangles making up our three quadrilateral ribbon
+    constexpr float kRibbonDemoPositions[] = {
+            0.75, -0.75, 1.0,
+            0.65, 0.25, 1.0,
+            0.35, 0.65, 1.0,
+            0.45, -0.35, 1.0,
+            -0.25, 0.0, 1.0,
+            -0.35, 1.0, 1.0,
+            -0.95, 0.75, 1.0,
+            -0.85, -0.25, 1.0
+    };
+    constexpr unsigned int kRibbonDemoIndices[] = {
+            0, 1,
+            3, 2,
+            4, 5,
+            7, 6
+    };
+
+    constexpr auto kTriangleMesh = makeMeshTable<3, 3>(kTrianglePositions, kTriangleIndices, GL_TRIANGLES);
+    constexpr auto kRectangleMesh = makeMeshTable<4, 6>(kRectanglePositions, kRectangleIndices, GL_TRIANGLES);
+    constexpr auto kTriforceMesh = makeMeshTable<6, 9>(kTriforcePositions, kTriforceIndices, GL_TRIANGLES);
+    constexpr auto kRibbonDemoMesh = makeMeshTable<8, 8>(kRibbonDemoPositions, kRibbonDemoIndices, GL_TRIANGLE_STRIP);
+    constexpr auto kCircleMesh = makeCircleMesh<64>(0.5F, 0.0F);
+    constexpr auto kGridMesh = makeGridMesh<16, 16>(1.0F, 1.0F, 0.0F);
+    constexpr auto kStripMesh = makeStripMesh<8>(1.5F, 0.25F, 0.0F);
+
+    // everything above really is evaluated by the compiler, not by static initializers at startup
+    static_assert(kTriforceMesh.boundsMin[0] == -1.0F && kTriforceMesh.boundsMax[1] == 1.0F, "triforce bounds");
+    static_assert(kCircleMesh.boundsMax[0] == 0.5F, "circle bounds");
+    static_assert(sizeof(kGridMesh.indices[0]) == 2, "a 17x17 vertex grid needs 16 bit indices");
+}
+
+template<size_t V, size_t I>
+void BuiltinMeshLibrary::appendMesh(
+        BuiltinMesh mesh,
+        const MeshTable<V, I>& table,
+        std::vector<float>& positions,
+        std::vector<uint8_t>& indexBytes
+)
+{
+    using IndexType = typename MeshTable<V, I>::IndexType;
+    BuiltinMeshRange& range = mRanges[static_cast<size_t>(mesh)];
+    range.baseVertex = static_cast<GLint>(positions.size() / 3);
+    range.vertexCount = static_cast<GLsizei>(V);
+    // keep every mesh's indices aligned to the widest index type we use
+    indexBytes.resize((indexBytes.size() + sizeof(uint32_t) - 1) / sizeof(uint32_t) * sizeof(uint32_t));
+    range.indexOffset = indexBytes.size();
+    range.indexCount = static_cast<GLsizei>(I);
+    range.indexType = IndexTypeTraits<IndexType>::glType;
+    range.primitive = table.primitive;
+    range.boundsMin = glm::vec3(table.boundsMin[0], table.boundsMin[1], table.boundsMin[2]);
+    range.boundsMax = glm::vec3(table.boundsMax[0], table.boundsMax[1], table.boundsMax[2]);
+
+    size_t firstPosition = positions.size();
+    positions.insert(positions.end(), table.positions, table.positions + V * 3);
+    indexBytes.resize(range.indexOffset + sizeof(table.indices));
+    std::memcpy(indexBytes.data() + range.indexOffset, table.indices, sizeof(table.indices));
+    if(table.primitive != GL_TRIANGLES)
+    {
+        return;
+    }
+
+    // the tables keep the order they were authored or generated in, which is rarely the best one to draw in,
+    // so triangle lists get reordered for the vertex cache, and their vertices for fetch, as they're staged
+    std::vector<uint32_t> indices(table.indices, table.indices + I);
+    optimizeVertexCache(indices.data(), indices.size(), V);
+    optimizeVertexFetch(positions.data() + firstPosition, V, sizeof(float) * 3, indices.data(), indices.size());
+    // then become restart-joined strips where that's fewer indices; MeshIndexType leaves the index type's
+    // all-ones value free to be the restart index
+    if(replaceWithStripsIfShorter(indices, V))
+    {
+        range.primitive = GL_TRIANGLE_STRIP;
+        range.indexCount = static_cast<GLsizei>(indices.size());
+    }
+    indexBytes.resize(range.indexOffset + sizeof(IndexType) * indices.size());
+    IndexType* stagedIndices = reinterpret_cast<IndexType*>(indexBytes.data() + range.indexOffset);
+    for(size_t idx = 0; idx < indices.size(); idx++)
+    {
+        stagedIndices[idx] = static_cast<IndexType>(indices[idx]);
+    }
+}
+
+BuiltinMeshLibrary::BuiltinMeshLibrary(VertexPullingBuffers* pulledMeshes)
+{
+    std::vector<float> positions;
+    std::vector<uint8_t> indexBytes;
+    appendMesh(BuiltinMesh::triangle, kTriangleMesh, positions, indexBytes);
+    appendMesh(BuiltinMesh::rectangle, kRectangleMesh, positions, indexBytes);
+    appendMesh(BuiltinMesh::triforce, kTriforceMesh, positions, indexBytes);
+    appendMesh(BuiltinMesh::ribbonDemo, kRibbonDemoMesh, positions, indexBytes);
+    appendMesh(BuiltinMesh::circle, kCircleMesh, positions, indexBytes);
+    appendMesh(BuiltinMesh::grid, kGridMesh, positions, indexBytes);
+    appendMesh(BuiltinMesh::strip, kStripMesh, positions, indexBytes);
+
+    // one immutable upload each for every built-in mesh's vertices and indices
+    mVertexBuffer = createBuffer(sizeof(float) * positions.size(), positions.data(), 0);
+    mIndexBuffer = createBuffer(indexBytes.size(), indexBytes.data(), 0);
+    mVAO = createVertexArray();
+    applyVertexLayout<PositionVertex>(mVAO, 0, mVertexBuffer, 0);
+    setElementBuffer(mVAO, mIndexBuffer);
+
+    // the same staged data again for vertex pulling, which widens the indices to its shared 32 bit buffer
+    for(size_t meshIdx = 0; meshIdx < static_cast<size_t>(BuiltinMesh::count); meshIdx++)
+    {
+        mPulledMeshes[meshIdx] = SIZE_MAX;
+        if(pulledMeshes == nullptr)
+        {
+            continue;
+        }
+        const BuiltinMeshRange& range = mRanges[meshIdx];
+        const float* vertices = positions.data() + static_cast<size_t>(range.baseVertex) * 3;
+        const uint8_t* indices = indexBytes.data() + range.indexOffset;
+        size_t vertexCount = static_cast<size_t>(range.vertexCount);
+        size_t indexCount = static_cast<size_t>(range.indexCount);
+        if(range.indexType == GL_UNSIGNED_BYTE)
+        {
+            mPulledMeshes[meshIdx] = pulledMeshes->addMesh(PulledVertexFormat::float3Position, sizeof(PositionVertex),
+                    vertices, vertexCount, indices, indexCount, range.primitive);
+        }
+        else if(range.indexType == GL_UNSIGNED_SHORT)
+        {
+            mPulledMeshes[meshIdx] = pulledMeshes->addMesh(PulledVertexFormat::float3Position, sizeof(PositionVertex),
+                    vertices, vertexCount, reinterpret_cast<const uint16_t*>(indices), indexCount, range.primitive);
+        }
+        else
+        {
+            mPulledMeshes[meshIdx] = pulledMeshes->addMesh(PulledVertexFormat::float3Position, sizeof(PositionVertex),
+                    vertices, vertexCount, reinterpret_cast<const uint32_t*>(indices), indexCount, range.primitive);
+        }
+    }
+}
+
+BuiltinMeshLibrary::~BuiltinMeshLibrary()
+{
+    unsigned int buffers[] = {mVertexBuffer, mIndexBuffer};
+    glDeleteBuffers(2, buffers);
+    glDeleteVertexArrays(1, &mVAO);
+}
+
+unsigned int BuiltinMeshLibrary::getVAO() const
+{
+    return mVAO;
+}
+
+const BuiltinMeshRange& BuiltinMeshLibrary::getRange(BuiltinMesh mesh) const
+{
+    return mRanges[static_cast<size_t>(mesh)];
+}
+
+void BuiltinMeshLibrary::draw(BuiltinMesh mesh, GLsizei indexCount) const
+{
+    const BuiltinMeshRange& range = getRange(mesh);
+    glDrawElementsBaseVertex(
+            range.primitive,
+            indexCount < 0 ? range.indexCount : indexCount,
+            range.indexType,
+            reinterpret_cast<const void*>(range.indexOffset),
+            range.baseVertex
+    );
+}
+
+size_t BuiltinMeshLibrary::getPulledMesh(BuiltinMesh mesh) const
+{
+    return mPulledMeshes[static_cast<size_t>(mesh)];
+}
@@ -0,0 +1,281 @@
+#ifndef OPENGLSANDBOX_BUILTINMESHES_H
+#define OPENGLSANDBOX_BUILTINMESHES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+#include "ConstexprMath.h"
+
+class VertexPullingBuffers;
+
+/*
+ * Built-in mesh library.  Every built-in shape, including parametric ones (circles, grids, strips of N
+ * segments), is generated at compile time into a constexpr MeshTable holding positions, indices of the
+ * narrowest type that can address its vertices, its primitive mode, and precomputed bounds.  At startup
+ * BuiltinMeshLibrary packs all of the tables into one immutable vertex buffer and one immutable index
+ * buffer behind a single VAO, so drawing any built-in shape is a draw call with a base vertex and index
+ * offset and nothing is ever rebuilt or re-uploaded.  Triangle-list tables are reordered for the vertex cache
+ * as they're staged, and staged as strips joined by primitive restarts where that takes fewer indices, so
+ * drawing needs GL_PRIMITIVE_RESTART_FIXED_INDEX enabled.
+ */
+
+/**
+ * The narrowest unsigned integer type able to index VertexCount vertices while leaving its all-ones value
+ * free, since GL_PRIMITIVE_RESTART_FIXED_INDEX treats that value as a restart in every draw
+ */
+template<size_t VertexCount>
+using MeshIndexType = typename std::conditional<
+        (VertexCount < 256),
+        uint8_t,
+        typename std::conditional<(VertexCount < 65536), uint16_t, uint32_t>::type
+>::type;
+
+/**
+ * Maps an index type onto its GL enum
+ */
+template<typename T>
+struct IndexTypeTraits;
+template<> struct IndexTypeTraits<uint8_t> { static constexpr GLenum glType = GL_UNSIGNED_BYTE; };
+template<> struct IndexTypeTraits<uint16_t> { static constexpr GLenum glType = GL_UNSIGNED_SHORT; };
+template<> struct IndexTypeTraits<uint32_t> { static constexpr GLenum glType = GL_UNSIGNED_INT; };
+
+/**
+ * Compile-time geometry for one mesh: tightly packed vec3 positions, indices and bounds
+ */
+template<size_t VertexCount, size_t IndexCount>
+struct MeshTable
+{
+    using IndexType = MeshIndexType<VertexCount>;
+    static_assert(VertexCount <= std::numeric_limits<IndexType>::max(),
+            "the restart index must never be a real vertex");
+    static constexpr size_t vertexCount = VertexCount;
+    static constexpr size_t indexCount = IndexCount;
+    float positions[VertexCount * 3];
+    IndexType indices[IndexCount];
+    GLenum primitive;
+    float boundsMin[3];
+    float boundsMax[3];
+};
+
+/**
+ * Computes and stores a table's bounds from its positions
+ */
+template<size_t V, size_t I>
+constexpr void computeMeshBounds(MeshTable<V, I>& mesh)
+{
+    for(size_t axis = 0; axis < 3; axis++)
+    {
+        mesh.boundsMin[axis] = mesh.positions[axis];
+        mesh.boundsMax[axis] = mesh.positions[axis];
+    }
+    for(size_t vertIdx = 1; vertIdx < V; vertIdx++)
+    {
+        for(size_t axis = 0; axis < 3; axis++)
+        {
+            float value = mesh.positions[vertIdx * 3 + axis];
+            mesh.boundsMin[axis] = value < mesh.boundsMin[axis] ? value : mesh.boundsMin[axis];
+            mesh.boundsMax[axis] = value > mesh.boundsMax[axis] ? value : mesh.boundsMax[axis];
+        }
+    }
+}
+
+/**
+ * Builds a table from literal data; used for the hand-authored demo shapes
+ */
+template<size_t V, size_t I>
+constexpr MeshTable<V, I> makeMeshTable(const float (&positions)[V * 3], const unsigned int (&indices)[I], GLenum primitive)
+{
+    MeshTable<V, I> mesh{};
+    for(size_t floatIdx = 0; floatIdx < V * 3; floatIdx++)
+    {
+        mesh.positions[floatIdx] = positions[floatIdx];
+    }
+    for(size_t idx = 0; idx < I; idx++)
+    {
+        mesh.indices[idx] = static_cast<typename MeshTable<V, I>::IndexType>(indices[idx]);
+    }
+    mesh.primitive = primitive;
+    computeMeshBounds(mesh);
+    return mesh;
+}
+
+/**
+ * A filled circle in the XY plane as GL_TRIANGLES around a center vertex
+ * @tparam Segments number of rim vertices
+ */
+template<size_t Segments>
+constexpr MeshTable<Segments + 1, Segments * 3> makeCircleMesh(float radius, float z)
+{
+    MeshTable<Segments + 1, Segments * 3> mesh{};
+    using IndexType = typename MeshTable<Segments + 1, Segments * 3>::IndexType;
+    mesh.positions[0] = 0.0F;
+    mesh.positions[1] = 0.0F;
+    mesh.positions[2] = z;
+    for(size_t segment = 0; segment < Segments; segment++)
+    {
+        double angle = 2.0 * constexpr_math::pi * static_cast<double>(segment) / static_cast<double>(Segments);
+        mesh.positions[(segment + 1) * 3] = static_cast<float>(radius * constexpr_math::cos(angle));
+        mesh.positions[(segment + 1) * 3 + 1] = static_cast<float>(radius * constexpr_math::sin(angle));
+        mesh.positions[(segment + 1) * 3 + 2] = z;
+        // counter-clockwise fan triangle: center, this rim vertex, next rim vertex
+        mesh.indices[segment * 3] = 0;
+        mesh.indices[segment * 3 + 1] = static_cast<IndexType>(segment + 1);
+        mesh.indices[segment * 3 + 2] = static_cast<IndexType>((segment + 1) % Segments + 1);
+    }
+    mesh.primitive = GL_TRIANGLES;
+    computeMeshBounds(mesh);
+    return mesh;
+}
+
+/**
+ * A grid of Columns x Rows quads in the XY plane, centered on the origin, as GL_TRIANGLES
+ */
+template<size_t Columns, size_t Rows>
+constexpr MeshTable<(Columns + 1) * (Rows + 1), Columns * Rows * 6> makeGridMesh(float width, float height, float z)
+{
+    MeshTable<(Columns + 1) * (Rows + 1), Columns * Rows * 6> mesh{};
+    using IndexType = typename MeshTable<(Columns + 1) * (Rows + 1), Columns * Rows * 6>::IndexType;
+    for(size_t row = 0; row <= Rows; row++)
+    {
+        for(size_t column = 0; column <= Columns; column++)
+        {
+            size_t vertIdx = row * (Columns + 1) + column;
+            mesh.positions[vertIdx * 3] = width * (static_cast<float>(column) / Columns - 0.5F);
+            mesh.positions[vertIdx * 3 + 1] = height * (static_cast<float>(row) / Rows - 0.5F);
+            mesh.positions[vertIdx * 3 + 2] = z;
+        }
+    }
+    for(size_t row = 0; row < Rows; row++)
+    {
+        for(size_t column = 0; column < Columns; column++)
+        {
+            size_t bottomLeft = row * (Columns + 1) + column;
+            size_t topLeft = bottomLeft + Columns + 1;
+            size_t quad = (row * Columns + column) * 6;
+            mesh.indices[quad] = static_cast<IndexType>(bottomLeft);
+            mesh.indices[quad + 1] = static_cast<IndexType>(bottomLeft + 1);
+            mesh.indices[quad + 2] = static_cast<IndexType>(topLeft);
+            mesh.indices[quad + 3] = static_cast<IndexType>(bottomLeft + 1);
+            mesh.indices[quad + 4] = static_cast<IndexType>(topLeft + 1);
+            mesh.indices[quad + 5] = static_cast<IndexType>(topLeft);
+        }
+    }
+    mesh.primitive = GL_TRIANGLES;
+    computeMeshBounds(mesh);
+    return mesh;
+}
+
+/**
+ * A straight ribbon of Segments quads along X, centered on the origin, as a single GL_TRIANGLE_STRIP
+ * laid out the way RibbonTrail lays out its vertex pairs
+ */
+template<size_t Segments>
+constexpr MeshTable<(Segments + 1) * 2, (Segments + 1) * 2> makeStripMesh(float length, float width, float z)
+{
+    MeshTable<(Segments + 1) * 2, (Segments + 1) * 2> mesh{};
+    using IndexType = typename MeshTable<(Segments + 1) * 2, (Segments + 1) * 2>::IndexType;
+    for(size_t pair = 0; pair <= Segments; pair++)
+    {
+        float x = length * (static_cast<float>(pair) / Segments - 0.5F);
+        mesh.positions[pair * 6] = x;
+        mesh.positions[pair * 6 + 1] = -0.5F * width;
+        mesh.positions[pair * 6 + 2] = z;
+        mesh.positions[pair * 6 + 3] = x;
+        mesh.positions[pair * 6 + 4] = 0.5F * width;
+        mesh.positions[pair * 6 + 5] = z;
+        mesh.indices[pair * 2] = static_cast<IndexType>(pair * 2);
+        mesh.indices[pair * 2 + 1] = static_cast<IndexType>(pair * 2 + 1);
+    }
+    mesh.primitive = GL_TRIANGLE_STRIP;
+    computeMeshBounds(mesh);
+    return mesh;
+}
+
+/**
+ * The shapes BuiltinMeshLibrary provides
+ */
+enum class BuiltinMesh
+{
+    triangle,
+    rectangle,
+    triforce,
+    ribbonDemo,
+    circle,
+    grid,
+    strip,
+    count
+};
+
+/**
+ * Where a built-in mesh lives in the library's shared buffers, and how to draw it
+ */
+struct BuiltinMeshRange
+{
+    GLint baseVertex;
+    GLsizei vertexCount;
+    /**
+     * Byte offset of the first index in the shared index buffer
+     */
+    size_t indexOffset;
+    GLsizei indexCount;
+    GLenum indexType;
+    GLenum primitive;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+};
+
+/**
+ * Owns the shared immutable buffers holding every built-in mesh
+ */
+class BuiltinMeshLibrary
+{
+private:
+    unsigned int mVAO = 0;
+    unsigned int mVertexBuffer = 0;
+    unsigned int mIndexBuffer = 0;
+    BuiltinMeshRange mRanges[static_cast<size_t>(BuiltinMesh::count)];
+    /**
+     * Handles of the meshes' copies in the VertexPullingBuffers given at construction, if any
+     */
+    size_t mPulledMeshes[static_cast<size_t>(BuiltinMesh::count)];
+    /**
+     * Appends a table's data to the staging arrays and records its range
+     */
+    template<size_t V, size_t I>
+    void appendMesh(
+            BuiltinMesh mesh,
+            const MeshTable<V, I>& table,
+            std::vector<float>& positions,
+            std::vector<uint8_t>& indexBytes
+    );
+public:
+    /**
+     * Uploads every built-in mesh.  Must be called on the thread owning the current GL context.
+     * @param pulledMeshes if not null, every mesh is also added to these, to be drawn by vertex pulling
+     */
+    explicit BuiltinMeshLibrary(VertexPullingBuffers* pulledMeshes = nullptr);
+    ~BuiltinMeshLibrary();
+    BuiltinMeshLibrary(const BuiltinMeshLibrary&) = delete;
+    BuiltinMeshLibrary& operator=(const BuiltinMeshLibrary&) = delete;
+    /**
+     * @return the ID of the vertex array object all built-in meshes draw from
+     */
+    unsigned int getVAO() const;
+    const BuiltinMeshRange& getRange(BuiltinMesh mesh) const;
+    /**
+     * @return the mesh's handle in the VertexPullingBuffers given at construction, or SIZE_MAX if there were none
+     */
+    size_t getPulledMesh(BuiltinMesh mesh) const;
+    /**
+     * Draws the first indexCount indices of a mesh (all of them by default) with the library VAO,
+     * which must already be bound
+     */
+    void draw(BuiltinMesh mesh, GLsizei indexCount = -1) const;
+};
+
+
+#endif //OPENGLSANDBOX_BUILTINMESHES_H
@@ -0,0 +1,85 @@
+#ifndef OPENGLSANDBOX_CONSTEXPRMATH_H
+#define OPENGLSANDBOX_CONSTEXPRMATH_H
+
+/**
+ * constexpr-evaluable math for tables generated at compile time (built-in meshes, easing curves);
+ * std::sin and friends aren't constexpr
+ */
+namespace constexpr_math
+{
+    constexpr double pi = 3.14159265358979323846;
+    constexpr double ln2 = 0.69314718055994530942;
+
+    /**
+     * Sine via range reduction into [-pi, pi] and a Taylor series, accurate to well below float precision
+     */
+    constexpr double sin(double x)
+    {
+        double turns = x / (2.0 * pi);
+        long long wholeTurns = static_cast<long long>(turns < 0.0 ? turns - 0.5 : turns + 0.5);
+        x -= static_cast<double>(wholeTurns) * 2.0 * pi;
+        double term = x;
+        double sum = x;
+        for(int n = 1; n < 12; n++)
+        {
+            term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+            sum += term;
+        }
+        return sum;
+    }
+
+    constexpr double cos(double x)
+    {
+        return sin(x + pi / 2.0);
+    }
+
+    /**
+     * Square root by Newton's method; negative inputs give 0
+     */
+    constexpr double sqrt(double x)
+    {
+        if(x <= 0.0)
+        {
+            return 0.0;
+        }
+        double guess = x > 1.0 ? x : 1.0;
+        for(int iteration = 0; iteration < 64; iteration++)
+        {
+            double next = 0.5 * (guess + x / guess);
+            if(next >= guess)
+            {
+                break;
+            }
+            guess = next;
+        }
+        return guess;
+    }
+
+    /**
+     * 2^x via an integer power of two times a Taylor series for e^(fraction * ln 2)
+     */
+    constexpr double exp2(double x)
+    {
+        long long whole = static_cast<long long>(x < 0.0 ? x - 1.0 : x);
+        double fraction = (x - static_cast<double>(whole)) * ln2;
+        double term = 1.0;
+        double sum = 1.0;
+        for(int n = 1; n < 20; n++)
+        {
+            term *= fraction / n;
+            sum += term;
+        }
+        for(; whole > 0; whole--)
+        {
+            sum *= 2.0;
+        }
+        for(; whole < 0; whole++)
+        {
+            sum *= 0.5;
+        }
+        return sum;
+    }
+}
+
+
+#endif //OPENGLSANDBOX_CONSTEXPRMATH_H
@@ -0,0 +1,56 @@
+#include "EasingTables.h"
+#include <glad/glad.h>
+
+namespace
+{
+    constexpr EasingTables kEasingTables = makeEasingTables();
+
+    // the tables really are generated by the compiler rather than by a static initializer
+    static_assert(kEasingTables.samples[static_cast<size_t>(EasingCurve::sineOut)][kEasingTableSamples - 1] > 0.9999F,
+            "sineOut ends at 1");
+    static_assert(kEasingTables.samples[static_cast<size_t>(EasingCurve::bounceOut)][0] == 0.0F, "bounceOut starts at 0");
+
+    inline float lookUp(const float* table, float t)
+    {
+        // written so NaN falls through to the first sample, same as a clamp to 0 would
+        float position = (t > 0.0F ? (t < 1.0F ? t : 1.0F) : 0.0F) * static_cast<float>(kEasingTableSamples - 1);
+        size_t sample = static_cast<size_t>(position);
+        if(sample >= kEasingTableSamples - 1)
+        {
+            return table[kEasingTableSamples - 1];
+        }
+        float fraction = position - static_cast<float>(sample);
+        return table[sample] + (table[sample + 1] - table[sample]) * fraction;
+    }
+}
+
+const float* getEasingTable(EasingCurve curve)
+{
+    return kEasingTables.samples[static_cast<size_t>(curve)];
+}
+
+float sampleEasing(EasingCurve curve, float t)
+{
+    return lookUp(getEasingTable(curve), t);
+}
+
+void sampleEasing(EasingCurve curve, const float* t, float* out, size_t count)
+{
+    const float* table = getEasingTable(curve);
+    for(size_t idx = 0; idx < count; idx++)
+    {
+        out[idx] = lookUp(table, t[idx]);
+    }
+}
+
+unsigned int createEasingTexture()
+{
+    unsigned int texture = 0;
+    glCreateTextures(GL_TEXTURE_1D_ARRAY, 1, &texture);
+    glTextureStorage2D(texture, 1, GL_R32F, kEasingTableSamples, kEasingCurveCount);
+    glTextureSubImage2D(texture, 0, 0, 0, kEasingTableSamples, kEasingCurveCount, GL_RED, GL_FLOAT, kEasingTables.samples);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    return texture;
+}
@@ -0,0 +1,130 @@
+#ifndef OPENGLSANDBOX_EASINGTABLES_H
+#define OPENGLSANDBOX_EASINGTABLES_H
+
+#include <cstddef>
+#include "ConstexprMath.h"
+
+/*
+ * Easing curves as lookup tables generated at compile time.  Each curve from glm/gtx/easing.hpp that fades
+ * want is sampled kEasingTableSamples times over [0, 1] by the compiler, so evaluating one at runtime is a
+ * clamp, a table lookup and a lerp instead of sin/pow.  The same tables can be uploaded as a 1D array
+ * texture, one layer per curve, so shaders get identical curves with hardware filtering doing the lerp.
+ */
+
+/**
+ * The curves we build tables for; the names follow glm's <name>EaseIn/Out/InOut functions
+ */
+enum class EasingCurve
+{
+    linear,
+    quadraticOut,
+    cubicInOut,
+    sineIn,
+    sineOut,
+    sineInOut,
+    exponentialOut,
+    elasticOut,
+    bounceOut,
+    count
+};
+
+constexpr size_t kEasingCurveCount = static_cast<size_t>(EasingCurve::count);
+/**
+ * Samples per curve, i.e. 255 linear segments.  Worst-case error against the exact curve is around 1e-5 for
+ * smooth curves, 1e-3 around the steep start of exponentialOut and elasticOut and 7e-3 at bounceOut's kinks.
+ * Curves whose tangent goes vertical, like circularOut at t = 0, are left out, since evenly spaced samples
+ * miss them by over 2e-2
+ */
+constexpr size_t kEasingTableSamples = 256;
+
+/**
+ * Exact curve value at t in [0, 1], mirroring glm's definitions, evaluable at compile time
+ */
+constexpr double evaluateEasingCurve(EasingCurve curve, double t)
+{
+    switch(curve)
+    {
+        case EasingCurve::linear:
+            return t;
+        case EasingCurve::quadraticOut:
+            return -(t * (t - 2.0));
+        case EasingCurve::cubicInOut:
+            return t < 0.5 ? 4.0 * t * t * t : 0.5 * (2.0 * t - 2.0) * (2.0 * t - 2.0) * (2.0 * t - 2.0) + 1.0;
+        case EasingCurve::sineIn:
+            return constexpr_math::sin((t - 1.0) * constexpr_math::pi / 2.0) + 1.0;
+        case EasingCurve::sineOut:
+            return constexpr_math::sin(t * constexpr_math::pi / 2.0);
+        case EasingCurve::sineInOut:
+            return 0.5 * (1.0 - constexpr_math::cos(t * constexpr_math::pi));
+        case EasingCurve::exponentialOut:
+            return t >= 1.0 ? t : 1.0 - constexpr_math::exp2(-10.0 * t);
+        case EasingCurve::elasticOut:
+            return constexpr_math::sin(-13.0 * constexpr_math::pi / 2.0 * (t + 1.0)) * constexpr_math::exp2(-10.0 * t) + 1.0;
+        case EasingCurve::bounceOut:
+            if(t < 4.0 / 11.0)
+            {
+                return (121.0 * t * t) / 16.0;
+            }
+            if(t < 8.0 / 11.0)
+            {
+                return (363.0 / 40.0 * t * t) - (99.0 / 10.0 * t) + 17.0 / 5.0;
+            }
+            if(t < 9.0 / 10.0)
+            {
+                return (4356.0 / 361.0 * t * t) - (35442.0 / 1805.0 * t) + 16061.0 / 1805.0;
+            }
+            return (54.0 / 5.0 * t * t) - (513.0 / 25.0 * t) + 268.0 / 25.0;
+        case EasingCurve::count:
+            break;
+    }
+    return t;
+}
+
+/**
+ * Every curve's samples, curve-major, so the whole thing uploads as one texture
+ */
+struct EasingTables
+{
+    float samples[kEasingCurveCount][kEasingTableSamples];
+};
+
+constexpr EasingTables makeEasingTables()
+{
+    EasingTables tables{};
+    for(size_t curve = 0; curve < kEasingCurveCount; curve++)
+    {
+        for(size_t sample = 0; sample < kEasingTableSamples; sample++)
+        {
+            double t = static_cast<double>(sample) / static_cast<double>(kEasingTableSamples - 1);
+            tables.samples[curve][sample] = static_cast<float>(evaluateEasingCurve(static_cast<EasingCurve>(curve), t));
+        }
+    }
+    return tables;
+}
+
+/**
+ * @return the curve's kEasingTableSamples samples, evenly spaced over [0, 1] inclusive
+ */
+const float* getEasingTable(EasingCurve curve);
+/**
+ * Looks the curve up at t, clamped to [0, 1], interpolating linearly between samples
+ */
+float sampleEasing(EasingCurve curve, float t);
+/**
+ * Batched sampleEasing(), e.g. for a whole trail's vertex ages at once
+ * @param t parameters, clamped to [0, 1]
+ * @param out where the curve values are written; may alias t
+ */
+void sampleEasing(EasingCurve curve, const float* t, float* out, size_t count);
+/**
+ * Uploads every table as an R32F 1D array texture, kEasingTableSamples wide with one layer per EasingCurve,
+ * set to linear filtering and edge clamping.  Shaders should sample it at
+ *   vec2((t * (kEasingTableSamples - 1) + 0.5) / kEasingTableSamples, float(curve))
+ * so that t = 0 and t = 1 land on the centers of the first and last texels.
+ * Must be called on the thread owning the current GL context.
+ * @return the texture ID
+ */
+unsigned int createEasingTexture();
+
+
+#endif //OPENGLSANDBOX_EASINGTABLES_H
@@ -0,0 +1,83 @@
+#include "GLResources.h"
+#include "VertexLayout.h"
+
+unsigned int createBuffer(GLsizeiptr size, const void* data, GLbitfield storageFlags)
+{
+    unsigned int buffer;
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, size, data, storageFlags);
+    return buffer;
+}
+
+void updateBuffer(unsigned int buffer, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    glNamedBufferSubData(buffer, offset, size, data);
+}
+
+unsigned int createVertexArray()
+{
+    unsigned int vao;
+    glCreateVertexArrays(1, &vao);
+    return vao;
+}
+
+void setVertexBuffer(unsigned int vao, GLuint bindingIndex, unsigned int buffer, GLintptr offset, GLsizei stride)
+{
+    glVertexArrayVertexBuffer(vao, bindingIndex, buffer, offset, stride);
+}
+
+void setVertexAttribute(
+        unsigned int vao,
+        GLuint attribIndex,
+        GLuint bindingIndex,
+        GLint components,
+        GLenum type,
+        GLboolean normalized,
+        GLuint relativeOffset
+)
+{
+    glVertexArrayAttribFormat(vao, attribIndex, components, type, normalized, relativeOffset);
+    glVertexArrayAttribBinding(vao, attribIndex, bindingIndex);
+    glEnableVertexArrayAttrib(vao, attribIndex);
+}
+
+void setIntegerVertexAttribute(
+        unsigned int vao,
+        GLuint attribIndex,
+        GLuint bindingIndex,
+        GLint components,
+        GLenum type,
+        GLuint relativeOffset
+)
+{
+    glVertexArrayAttribIFormat(vao, attribIndex, components, type, relativeOffset);
+    glVertexArrayAttribBinding(vao, attribIndex, bindingIndex);
+    glEnableVertexArrayAttrib(vao, attribIndex);
+}
+
+void setVertexBindingDivisor(unsigned int vao, GLuint bindingIndex, GLuint divisor)
+{
+    glVertexArrayBindingDivisor(vao, bindingIndex, divisor);
+}
+
+void setElementBuffer(unsigned int vao, unsigned int buffer)
+{
+    glVertexArrayElementBuffer(vao, buffer);
+}
+
+IndexedVertexArray createIndexedPositionVertexArray(
+        const float* vertices,
+        GLsizeiptr verticesSize,
+        const unsigned int* indices,
+        GLsizeiptr indicesSize,
+        GLbitfield storageFlags
+)
+{
+    IndexedVertexArray vertexArray;
+    vertexArray.vbo = createBuffer(verticesSize, vertices, storageFlags);
+    vertexArray.ebo = createBuffer(indicesSize, indices, storageFlags);
+    vertexArray.vao = createVertexArray();
+    applyVertexLayout<PositionVertex>(vertexArray.vao, 0, vertexArray.vbo, 0);
+    setElementBuffer(vertexArray.vao, vertexArray.ebo);
+    return vertexArray;
+}
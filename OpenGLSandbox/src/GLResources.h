@@ -0,0 +1,139 @@
+#ifndef OPENGLSANDBOX_GLRESOURCES_H
+#define OPENGLSANDBOX_GLRESOURCES_H
+
+#include <glad/glad.h>
+
+/*
+ * Buffer and vertex array creation/update via Direct State Access (core since 4.5).  Every function here
+ * names the object it works on instead of binding it first, so creating or updating resources never disturbs
+ * the VAO, buffer bindings or anything else the render loop has bound for drawing, and the driver doesn't have
+ * to revalidate draw state just because we uploaded some data.
+ */
+
+/**
+ * The objects behind a typical indexed mesh
+ */
+struct IndexedVertexArray
+{
+    unsigned int vao = 0;
+    unsigned int vbo = 0;
+    unsigned int ebo = 0;
+};
+
+/**
+ * One draw of glMultiDrawElementsIndirect(), laid out as GL reads it from a GL_DRAW_INDIRECT_BUFFER
+ */
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+/**
+ * Creates a buffer with immutable storage
+ * @param size size of the storage in bytes
+ * @param data initial contents, or nullptr to leave them undefined
+ * @param storageFlags e.g. 0 for contents that never change, GL_DYNAMIC_STORAGE_BIT to allow updateBuffer()
+ * @return the new buffer's ID
+ */
+unsigned int createBuffer(GLsizeiptr size, const void* data, GLbitfield storageFlags);
+
+/**
+ * Replaces part of a buffer's contents; the buffer must have been created with GL_DYNAMIC_STORAGE_BIT
+ * @param buffer buffer to update
+ * @param offset byte offset into the buffer
+ * @param size number of bytes to replace
+ * @param data the new contents
+ */
+void updateBuffer(unsigned int buffer, GLintptr offset, GLsizeiptr size, const void* data);
+
+/**
+ * @return the ID of a new, fully initialised but empty vertex array object
+ */
+unsigned int createVertexArray();
+
+/**
+ * Attaches a vertex buffer to one of a VAO's buffer binding points
+ * @param vao vertex array object to modify
+ * @param bindingIndex buffer binding point attributes will source from
+ * @param buffer vertex buffer to attach
+ * @param offset byte offset of the first vertex in the buffer
+ * @param stride byte distance between consecutive vertices
+ */
+void setVertexBuffer(unsigned int vao, GLuint bindingIndex, unsigned int buffer, GLintptr offset, GLsizei stride);
+
+/**
+ * Describes and enables one float-typed vertex attribute, sourcing from the given binding point
+ * @param vao vertex array object to modify
+ * @param attribIndex shader attribute location, e.g. 0 for aPos
+ * @param bindingIndex buffer binding point the attribute sources from
+ * @param components number of components, 1-4
+ * @param type component type, e.g. GL_FLOAT or GL_HALF_FLOAT
+ * @param normalized whether integer components are normalised into [0, 1] or [-1, 1]
+ * @param relativeOffset byte offset of the attribute within a vertex
+ */
+void setVertexAttribute(
+        unsigned int vao,
+        GLuint attribIndex,
+        GLuint bindingIndex,
+        GLint components,
+        GLenum type,
+        GLboolean normalized,
+        GLuint relativeOffset
+);
+
+/**
+ * Describes and enables one integer-typed vertex attribute (int/uint/ivecN/uvecN shader input),
+ * sourcing from the given binding point
+ * @param vao vertex array object to modify
+ * @param attribIndex shader attribute location
+ * @param bindingIndex buffer binding point the attribute sources from
+ * @param components number of components, 1-4
+ * @param type integer component type, e.g. GL_UNSIGNED_SHORT
+ * @param relativeOffset byte offset of the attribute within a vertex
+ */
+void setIntegerVertexAttribute(
+        unsigned int vao,
+        GLuint attribIndex,
+        GLuint bindingIndex,
+        GLint components,
+        GLenum type,
+        GLuint relativeOffset
+);
+
+/**
+ * Sets how often vertices sourced from a binding point advance
+ * @param vao vertex array object to modify
+ * @param bindingIndex buffer binding point
+ * @param divisor 0 to advance per vertex, N to advance once every N instances
+ */
+void setVertexBindingDivisor(unsigned int vao, GLuint bindingIndex, GLuint divisor);
+
+/**
+ * Attaches an element buffer to a VAO
+ */
+void setElementBuffer(unsigned int vao, unsigned int buffer);
+
+/**
+ * Creates a VAO over new vertex and element buffers holding tightly packed vec3 positions sourced by attribute 0,
+ * the layout every basic mesh in the sandbox uses
+ * @param vertices position data, 3 floats per vertex
+ * @param verticesSize size of the position data in bytes
+ * @param indices unsigned int index data
+ * @param indicesSize size of the index data in bytes
+ * @param storageFlags storage flags for both buffers, see createBuffer()
+ * @return the created objects
+ */
+IndexedVertexArray createIndexedPositionVertexArray(
+        const float* vertices,
+        GLsizeiptr verticesSize,
+        const unsigned int* indices,
+        GLsizeiptr indicesSize,
+        GLbitfield storageFlags
+);
+
+
+#endif //OPENGLSANDBOX_GLRESOURCES_H
@@ -0,0 +1,122 @@
+#include "GpuFrustumCuller.h"
+#include <algorithm>
+
+namespace
+{
+    /**
+     * Must match local_size_x in frustum_cull.comp
+     */
+    const GLuint kCullWorkgroupSize = 64;
+
+    /**
+     * SSBO binding points, as declared in frustum_cull.comp
+     */
+    const GLuint kSphereBinding = 0;
+    const GLuint kCommandBinding = 1;
+    const GLuint kVisibleCommandBinding = 2;
+    const GLuint kVisibleCountBinding = 3;
+}
+
+void cullObjectsOnCpu(const ViewFrustum& frustum, const glm::vec4* spheres, const DrawElementsIndirectCommand* commands,
+        size_t objectCount, std::vector<DrawElementsIndirectCommand>& visibleCommands)
+{
+    visibleCommands.clear();
+    for(size_t objectIdx = 0; objectIdx < objectCount; objectIdx++)
+    {
+        if(sphereInFrustum(frustum, glm::vec3(spheres[objectIdx]), spheres[objectIdx].w))
+        {
+            visibleCommands.push_back(commands[objectIdx]);
+        }
+    }
+}
+
+GpuFrustumCuller::GpuFrustumCuller(unsigned int cullProgramId, size_t maxObjects)
+        : mCullProgramId(cullProgramId), mCapacity(maxObjects)
+{
+    mFrustumPlanesLocation = glGetUniformLocation(mCullProgramId, "frustumPlanes");
+    mObjectCountLocation = glGetUniformLocation(mCullProgramId, "objectCount");
+    // zero-sized storage isn't allowed, so always have room for at least one object
+    GLsizeiptr objects = static_cast<GLsizeiptr>(std::max<size_t>(maxObjects, 1));
+    mSphereBuffer = createBuffer(objects * static_cast<GLsizeiptr>(sizeof(glm::vec4)), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    mCommandBuffer = createBuffer(objects * static_cast<GLsizeiptr>(sizeof(DrawElementsIndirectCommand)), nullptr,
+            GL_DYNAMIC_STORAGE_BIT);
+    // the outputs are only ever written by the GPU
+    mVisibleCommandBuffer = createBuffer(objects * static_cast<GLsizeiptr>(sizeof(DrawElementsIndirectCommand)), nullptr, 0);
+    mVisibleCountBuffer = createBuffer(sizeof(GLuint), nullptr, 0);
+}
+
+GpuFrustumCuller::~GpuFrustumCuller()
+{
+    unsigned int buffers[] = {mSphereBuffer, mCommandBuffer, mVisibleCommandBuffer, mVisibleCountBuffer};
+    glDeleteBuffers(4, buffers);
+}
+
+void GpuFrustumCuller::setObjects(const glm::vec4* spheres, const DrawElementsIndirectCommand* commands, size_t objectCount)
+{
+    mObjectCount = std::min(objectCount, mCapacity);
+    if(mObjectCount > 0)
+    {
+        updateBuffer(mSphereBuffer, 0, static_cast<GLsizeiptr>(sizeof(glm::vec4) * mObjectCount), spheres);
+        updateBuffer(mCommandBuffer, 0, static_cast<GLsizeiptr>(sizeof(DrawElementsIndirectCommand) * mObjectCount), commands);
+    }
+}
+
+void GpuFrustumCuller::updateSpheres(size_t firstObject, const glm::vec4* spheres, size_t objectCount)
+{
+    if(firstObject >= mObjectCount)
+    {
+        return;
+    }
+    objectCount = std::min(objectCount, mObjectCount - firstObject);
+    updateBuffer(mSphereBuffer, static_cast<GLintptr>(sizeof(glm::vec4) * firstObject),
+            static_cast<GLsizeiptr>(sizeof(glm::vec4) * objectCount), spheres);
+}
+
+size_t GpuFrustumCuller::getObjectCount() const
+{
+    return mObjectCount;
+}
+
+void GpuFrustumCuller::cull(const ViewFrustum& frustum)
+{
+    GLuint zero = 0;
+    glClearNamedBufferSubData(mVisibleCountBuffer, GL_R32UI, 0, sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    if(mObjectCount == 0)
+    {
+        return;
+    }
+    glUseProgram(mCullProgramId);
+    glUniform4fv(mFrustumPlanesLocation, 6, &frustum.planes[0].x);
+    glUniform1ui(mObjectCountLocation, static_cast<GLuint>(mObjectCount));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kSphereBinding, mSphereBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kCommandBinding, mCommandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kVisibleCommandBinding, mVisibleCommandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kVisibleCountBinding, mVisibleCountBuffer);
+    glDispatchCompute((static_cast<GLuint>(mObjectCount) + kCullWorkgroupSize - 1) / kCullWorkgroupSize, 1, 1);
+    // both outputs are read as draw parameters, which the command barrier covers
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+}
+
+void GpuFrustumCuller::draw()
+{
+    if(mObjectCount == 0)
+    {
+        return;
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mVisibleCommandBuffer);
+    glBindBuffer(GL_PARAMETER_BUFFER, mVisibleCountBuffer);
+    glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0, static_cast<GLsizei>(mObjectCount), 0);
+}
+
+void GpuFrustumCuller::readBackVisible(std::vector<DrawElementsIndirectCommand>& visibleCommands) const
+{
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    GLuint visibleCount = 0;
+    glGetNamedBufferSubData(mVisibleCountBuffer, 0, sizeof(GLuint), &visibleCount);
+    visibleCommands.resize(std::min<size_t>(visibleCount, mObjectCount));
+    if(!visibleCommands.empty())
+    {
+        glGetNamedBufferSubData(mVisibleCommandBuffer, 0,
+                static_cast<GLsizeiptr>(sizeof(DrawElementsIndirectCommand) * visibleCommands.size()), visibleCommands.data());
+    }
+}
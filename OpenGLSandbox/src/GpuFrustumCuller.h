@@ -0,0 +1,91 @@
+#ifndef OPENGLSANDBOX_GPUFRUSTUMCULLER_H
+#define OPENGLSANDBOX_GPUFRUSTUMCULLER_H
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+#include "GLResources.h"
+#include "ViewFrustum.h"
+
+/*
+ * Frustum culling of large object sets on the GPU, so the CPU's per-frame cost stays the same however many
+ * objects there are.  Every object is a bounding sphere plus the DrawElementsIndirectCommand that draws it
+ * out of buffers all the objects share, both kept in SSBOs that only change when objects are added or move.
+ * cull() dispatches frustum_cull.comp with one invocation per object; survivors append their command to a
+ * compacted GL_DRAW_INDIRECT_BUFFER, counting themselves with an atomic in a GL_PARAMETER_BUFFER, and draw()
+ * then issues them all with one glMultiDrawElementsIndirectCount() without the count ever reaching the CPU.
+ *
+ * Survivors land in whatever order the GPU finishes them, so gl_DrawID doesn't identify the object; give each
+ * command the object's index as baseInstance to look up per-object data through gl_BaseInstance instead.
+ * cullObjectsOnCpu() runs the same test in the same way, as the reference the GPU's results are checked
+ * against and for running without a GL context.
+ */
+
+/**
+ * The CPU reference of GpuFrustumCuller::cull(): appends the command of every object whose sphere isn't
+ * wholly outside one of the frustum's planes, in object order
+ * @param spheres world space center in xyz, radius in w
+ * @param visibleCommands replaced with the visible objects' commands
+ */
+void cullObjectsOnCpu(const ViewFrustum& frustum, const glm::vec4* spheres, const DrawElementsIndirectCommand* commands,
+        size_t objectCount, std::vector<DrawElementsIndirectCommand>& visibleCommands);
+
+class GpuFrustumCuller
+{
+private:
+    unsigned int mCullProgramId;
+    int mFrustumPlanesLocation;
+    int mObjectCountLocation;
+    /**
+     * Inputs: a vec4 sphere and a command per object
+     */
+    unsigned int mSphereBuffer = 0;
+    unsigned int mCommandBuffer = 0;
+    /**
+     * Outputs: the compacted commands and how many there are
+     */
+    unsigned int mVisibleCommandBuffer = 0;
+    unsigned int mVisibleCountBuffer = 0;
+    size_t mCapacity;
+    size_t mObjectCount = 0;
+public:
+    /**
+     * Creates the object and output buffers.  Must be called on the thread owning the current GL context
+     * @param cullProgramId program linked from frustum_cull.comp
+     * @param maxObjects the most objects setObjects() will be given
+     */
+    GpuFrustumCuller(unsigned int cullProgramId, size_t maxObjects);
+    ~GpuFrustumCuller();
+    GpuFrustumCuller(const GpuFrustumCuller&) = delete;
+    GpuFrustumCuller& operator=(const GpuFrustumCuller&) = delete;
+    /**
+     * Replaces every object; anything beyond maxObjects is dropped
+     * @param spheres world space center in xyz, radius in w
+     * @param commands draws of the objects, out of the buffers bound when draw() is called
+     */
+    void setObjects(const glm::vec4* spheres, const DrawElementsIndirectCommand* commands, size_t objectCount);
+    /**
+     * Replaces the spheres of a run of objects, e.g. ones that moved
+     */
+    void updateSpheres(size_t firstObject, const glm::vec4* spheres, size_t objectCount);
+    size_t getObjectCount() const;
+    /**
+     * Dispatches the culling pass, and a barrier so draw() reads its results; leaves the cull program bound
+     */
+    void cull(const ViewFrustum& frustum);
+    /**
+     * Draws the last cull()'s survivors as GL_TRIANGLES with 32 bit indices in one
+     * glMultiDrawElementsIndirectCount(); the VAO the objects' commands index into must be bound.  Leaves the
+     * output buffers bound to GL_DRAW_INDIRECT_BUFFER and GL_PARAMETER_BUFFER
+     */
+    void draw();
+    /**
+     * Waits for the last cull() and reads its survivors back, for checking against cullObjectsOnCpu(); this
+     * stalls the pipeline, so it's for tests and debugging only
+     * @param visibleCommands replaced with the survivors, in the order the GPU wrote them
+     */
+    void readBackVisible(std::vector<DrawElementsIndirectCommand>& visibleCommands) const;
+};
+
+
+#endif //OPENGLSANDBOX_GPUFRUSTUMCULLER_H
@@ -0,0 +1,226 @@
+#include "GpuStatistics.h"
+#include <cassert>
+#include <cstring>
+
+bool hasGLExtension(const char* extensionName)
+{
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for(GLint extensionIdx = 0; extensionIdx < extensionCount; extensionIdx++)
+    {
+        const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, extensionIdx));
+        if(name && std::strcmp(name, extensionName) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+const GLenum GpuStatistics::kQueryTargets[] = {
+        GL_VERTICES_SUBMITTED,
+        GL_PRIMITIVES_SUBMITTED,
+        GL_VERTEX_SHADER_INVOCATIONS,
+        GL_CLIPPING_INPUT_PRIMITIVES,
+        GL_CLIPPING_OUTPUT_PRIMITIVES,
+        GL_FRAGMENT_SHADER_INVOCATIONS
+};
+
+GpuStatistics::GpuStatistics()
+{
+    // pipeline statistics queries went core in 4.6, which glad records for us as it loads
+    mPipelineStatisticsSupported = GLAD_GL_VERSION_4_6 || hasGLExtension("GL_ARB_pipeline_statistics_query");
+    mNvxMemoryInfoSupported = hasGLExtension("GL_NVX_gpu_memory_info");
+    mAtiMemInfoSupported = hasGLExtension("GL_ATI_meminfo");
+}
+
+GpuStatistics::~GpuStatistics()
+{
+    for(FrameSlot& slot : mFrameSlots)
+    {
+        for(PassQueries& pass : slot.passes)
+        {
+            glDeleteQueries(kQueryTargetCount, pass.queries);
+        }
+    }
+}
+
+void GpuStatistics::beginPass(const char* passName)
+{
+    if(!mPipelineStatisticsSupported)
+    {
+        return;
+    }
+    // only one query per target can be active at a time
+    assert(!mPassActive);
+    FrameSlot& slot = mFrameSlots[mCurrentSlot];
+    if(slot.passCount == slot.passes.size())
+    {
+        slot.passes.emplace_back();
+        glGenQueries(kQueryTargetCount, slot.passes.back().queries);
+    }
+    PassQueries& pass = slot.passes[slot.passCount++];
+    pass.name = passName;
+    for(size_t targetIdx = 0; targetIdx < kQueryTargetCount; targetIdx++)
+    {
+        glBeginQuery(kQueryTargets[targetIdx], pass.queries[targetIdx]);
+    }
+    mPassActive = true;
+}
+
+void GpuStatistics::endPass()
+{
+    if(!mPipelineStatisticsSupported)
+    {
+        return;
+    }
+    assert(mPassActive);
+    for(size_t targetIdx = 0; targetIdx < kQueryTargetCount; targetIdx++)
+    {
+        glEndQuery(kQueryTargets[targetIdx]);
+    }
+    mPassActive = false;
+}
+
+bool GpuStatistics::tryResolve(FrameSlot& slot)
+{
+    // the last query issued finishes last, but check them all rather than lean on driver ordering
+    for(size_t passIdx = 0; passIdx < slot.passCount; passIdx++)
+    {
+        for(GLuint query : slot.passes[passIdx].queries)
+        {
+            GLuint available = 0;
+            glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if(!available)
+            {
+                return false;
+            }
+        }
+    }
+    mLatestPasses.resize(slot.passCount);
+    for(size_t passIdx = 0; passIdx < slot.passCount; passIdx++)
+    {
+        const PassQueries& pass = slot.passes[passIdx];
+        PassStatistics& stats = mLatestPasses[passIdx];
+        stats.name = pass.name;
+        GLuint64* fields[] = {
+                &stats.verticesSubmitted,
+                &stats.primitivesSubmitted,
+                &stats.vertexShaderInvocations,
+                &stats.clippingInputPrimitives,
+                &stats.clippingOutputPrimitives,
+                &stats.fragmentShaderInvocations
+        };
+        for(size_t targetIdx = 0; targetIdx < kQueryTargetCount; targetIdx++)
+        {
+            glGetQueryObjectui64v(pass.queries[targetIdx], GL_QUERY_RESULT, fields[targetIdx]);
+        }
+    }
+    slot.pending = false;
+    mResolvedFrames++;
+    return true;
+}
+
+void GpuStatistics::sampleMemory()
+{
+    if(mNvxMemoryInfoSupported)
+    {
+        glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &mLatestMemory.totalKB);
+        glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &mLatestMemory.availableKB);
+    }
+    if(mAtiMemInfoSupported)
+    {
+        // each ATI query yields {total free, largest free block, total auxiliary free, largest auxiliary block}
+        GLint memInfo[4] = {0, 0, 0, 0};
+        glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, memInfo);
+        mLatestMemory.textureFreeKB = memInfo[0];
+        glGetIntegerv(GL_VBO_FREE_MEMORY_ATI, memInfo);
+        mLatestMemory.bufferFreeKB = memInfo[0];
+    }
+}
+
+void GpuStatistics::endFrame()
+{
+    if(mPipelineStatisticsSupported)
+    {
+        assert(!mPassActive);
+        mFrameSlots[mCurrentSlot].pending = mFrameSlots[mCurrentSlot].passCount > 0;
+
+        // resolve oldest first so mLatestPasses ends up holding the newest ready frame
+        for(size_t age = kFrameSlots - 1; age > 0; age--)
+        {
+            FrameSlot& slot = mFrameSlots[(mCurrentSlot + kFrameSlots - age) % kFrameSlots];
+            if(slot.pending)
+            {
+                tryResolve(slot);
+            }
+        }
+
+        // move on to the oldest slot, giving up on it if the GPU still hasn't gotten to it
+        mCurrentSlot = (mCurrentSlot + 1) % kFrameSlots;
+        FrameSlot& nextSlot = mFrameSlots[mCurrentSlot];
+        if(nextSlot.pending && !tryResolve(nextSlot))
+        {
+            mDroppedFrames++;
+        }
+        nextSlot.pending = false;
+        nextSlot.passCount = 0;
+    }
+    sampleMemory();
+}
+
+bool GpuStatistics::isPipelineStatisticsSupported() const
+{
+    return mPipelineStatisticsSupported;
+}
+
+bool GpuStatistics::isMemoryInfoSupported() const
+{
+    return mNvxMemoryInfoSupported || mAtiMemInfoSupported;
+}
+
+const std::vector<PassStatistics>& GpuStatistics::getLatestPasses() const
+{
+    return mLatestPasses;
+}
+
+const GpuMemoryStatistics& GpuStatistics::getLatestMemory() const
+{
+    return mLatestMemory;
+}
+
+void GpuStatistics::report(std::ostream& outputStream) const
+{
+    if(!mPipelineStatisticsSupported)
+    {
+        outputStream << "gpu: pipeline statistics unsupported by driver" << std::endl;
+    }
+    else
+    {
+        for(const PassStatistics& pass : mLatestPasses)
+        {
+            outputStream << "gpu pass " << pass.name << ": "
+            << pass.verticesSubmitted << " verts, "
+            << pass.primitivesSubmitted << " prims, "
+            << pass.vertexShaderInvocations << " vs invocations, "
+            << pass.clippingOutputPrimitives << "/" << pass.clippingInputPrimitives << " prims past clipping, "
+            << pass.fragmentShaderInvocations << " fs invocations" << std::endl;
+        }
+        outputStream << "gpu: " << mResolvedFrames << " frames resolved, "
+        << mDroppedFrames << " dropped waiting on results" << std::endl;
+    }
+    if(mNvxMemoryInfoSupported)
+    {
+        outputStream << "gpu memory: " << mLatestMemory.availableKB / 1024 << " of "
+        << mLatestMemory.totalKB / 1024 << " MB available" << std::endl;
+    }
+    else if(mAtiMemInfoSupported)
+    {
+        outputStream << "gpu memory: " << mLatestMemory.textureFreeKB / 1024 << " MB texture pool free, "
+        << mLatestMemory.bufferFreeKB / 1024 << " MB buffer pool free" << std::endl;
+    }
+    else
+    {
+        outputStream << "gpu memory: no memory-info extension available" << std::endl;
+    }
+}
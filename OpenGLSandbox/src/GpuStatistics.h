@@ -0,0 +1,138 @@
+#ifndef OPENGLSANDBOX_GPUSTATISTICS_H
+#define OPENGLSANDBOX_GPUSTATISTICS_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+// memory-info extension tokens; our glad loader is generated without extensions so we define the few we need
+#ifndef GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX
+#define GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX 0x9048
+#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#endif
+#ifndef GL_VBO_FREE_MEMORY_ATI
+#define GL_VBO_FREE_MEMORY_ATI 0x87FB
+#define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+#endif
+
+/**
+ * @param extensionName e.g. GL_ARB_pipeline_statistics_query
+ * @return true if the current context advertises the named extension
+ */
+bool hasGLExtension(const char* extensionName);
+
+/**
+ * Pipeline statistics gathered for one render pass over one frame
+ */
+struct PassStatistics
+{
+    std::string name;
+    GLuint64 verticesSubmitted = 0;
+    GLuint64 primitivesSubmitted = 0;
+    GLuint64 vertexShaderInvocations = 0;
+    GLuint64 clippingInputPrimitives = 0;
+    GLuint64 clippingOutputPrimitives = 0;
+    GLuint64 fragmentShaderInvocations = 0;
+};
+
+/**
+ * Snapshot of video memory usage in kilobytes; fields the driver can't report are left at 0
+ */
+struct GpuMemoryStatistics
+{
+    GLint totalKB = 0;
+    GLint availableKB = 0;
+    GLint textureFreeKB = 0;
+    GLint bufferFreeKB = 0;
+};
+
+/**
+ * Instrumentation collecting per-pass pipeline statistics (ARB_pipeline_statistics_query, core in 4.6) and video
+ * memory usage (NVX_gpu_memory_info or ATI_meminfo) without ever stalling on the GPU.  Queries for each frame
+ * come from a small pool of frame slots that are only read back once every query in the slot reports
+ * GL_QUERY_RESULT_AVAILABLE, by which point the GPU has long finished with them; a slot still pending when we
+ * wrap around to it is dropped rather than waited on.  When the driver supports neither feature every call is
+ * a cheap no-op and report() says so.
+ */
+class GpuStatistics
+{
+private:
+    /**
+     * Query targets we issue for every pass, in PassStatistics field order
+     */
+    static const GLenum kQueryTargets[];
+    static const size_t kQueryTargetCount = 6;
+    /**
+     * Number of frames of queries in flight before we drop rather than wait
+     */
+    static const size_t kFrameSlots = 4;
+    struct PassQueries
+    {
+        std::string name;
+        GLuint queries[kQueryTargetCount];
+    };
+    struct FrameSlot
+    {
+        /**
+         * Query sets used this frame; grown on demand and reused across frames
+         */
+        std::vector<PassQueries> passes;
+        size_t passCount = 0;
+        bool pending = false;
+    };
+    bool mPipelineStatisticsSupported;
+    bool mNvxMemoryInfoSupported;
+    bool mAtiMemInfoSupported;
+    FrameSlot mFrameSlots[kFrameSlots];
+    size_t mCurrentSlot = 0;
+    bool mPassActive = false;
+    /**
+     * Results of the most recently resolved frame
+     */
+    std::vector<PassStatistics> mLatestPasses;
+    GpuMemoryStatistics mLatestMemory;
+    size_t mResolvedFrames = 0;
+    size_t mDroppedFrames = 0;
+    /**
+     * Reads back the slot if all of its queries are available
+     * @return true if the slot was resolved
+     */
+    bool tryResolve(FrameSlot& slot);
+    void sampleMemory();
+public:
+    /**
+     * Probes driver support; must be called on the thread owning the current GL context
+     */
+    GpuStatistics();
+    ~GpuStatistics();
+    GpuStatistics(const GpuStatistics&) = delete;
+    GpuStatistics& operator=(const GpuStatistics&) = delete;
+    /**
+     * Starts collecting statistics for the named pass; passes may not nest
+     */
+    void beginPass(const char* passName);
+    /**
+     * Stops collecting statistics for the current pass
+     */
+    void endPass();
+    /**
+     * Closes out the current frame's queries, resolves any earlier frames whose results are ready,
+     * and samples memory usage; call once per frame after the last pass
+     */
+    void endFrame();
+    bool isPipelineStatisticsSupported() const;
+    bool isMemoryInfoSupported() const;
+    /**
+     * @return per-pass statistics of the most recently resolved frame
+     */
+    const std::vector<PassStatistics>& getLatestPasses() const;
+    const GpuMemoryStatistics& getLatestMemory() const;
+    /**
+     * Writes the latest resolved statistics in human readable form, one line per pass
+     */
+    void report(std::ostream& outputStream) const;
+};
+
+
+#endif //OPENGLSANDBOX_GPUSTATISTICS_H
@@ -0,0 +1,94 @@
+#include "InputTransform.h"
+
+void InputTransform::recalculate()
+{
+    // a minimized window reports zero sizes; keep converting with the last usable transform until it's back
+    if(mWindowSize.x <= 0 || mWindowSize.y <= 0 || mFramebufferSize.x <= 0 || mFramebufferSize.y <= 0
+       || mViewport.z <= 0 || mViewport.w <= 0)
+    {
+        return;
+    }
+    mFramebufferScale = glm::dvec2(mFramebufferSize) / glm::dvec2(mWindowSize);
+    // window -> framebuffer pixel is a scale; flipping y to GL's bottom-left origin and mapping the viewport
+    // to [-1, 1] is another scale and offset, so the two fold into one per axis
+    glm::dvec2 viewportOrigin(mViewport.x, mViewport.y);
+    glm::dvec2 viewportSize(mViewport.z, mViewport.w);
+    mDeviceScale = glm::dvec2(2.0, -2.0) * mFramebufferScale / viewportSize;
+    mDeviceOffset = glm::dvec2(
+            -2.0 * viewportOrigin.x / viewportSize.x - 1.0,
+            2.0 * (static_cast<double>(mFramebufferSize.y) - viewportOrigin.y) / viewportSize.y - 1.0
+    );
+}
+
+void InputTransform::setWindowSize(int width, int height)
+{
+    mWindowSize = glm::ivec2(width, height);
+    recalculate();
+}
+
+void InputTransform::setFramebufferSize(int width, int height)
+{
+    mFramebufferSize = glm::ivec2(width, height);
+    recalculate();
+}
+
+void InputTransform::setViewport(int x, int y, int width, int height)
+{
+    mViewport = glm::ivec4(x, y, width, height);
+    recalculate();
+}
+
+void InputTransform::setViewProjection(const glm::mat4& viewProjection)
+{
+    mInverseViewProjection = glm::inverse(viewProjection);
+}
+
+glm::vec2 InputTransform::windowToFramebuffer(const glm::dvec2& windowPosition) const
+{
+    return glm::vec2(windowPosition * mFramebufferScale);
+}
+
+glm::vec2 InputTransform::windowToDevice(const glm::dvec2& windowPosition) const
+{
+    return glm::vec2(windowPosition * mDeviceScale + mDeviceOffset);
+}
+
+void InputTransform::windowToDevice(const glm::dvec2* windowPositions, glm::vec2* devicePositions, size_t count) const
+{
+    // copied to locals so the compiler can keep them in registers rather than reload them through this
+    glm::dvec2 scale = mDeviceScale;
+    glm::dvec2 offset = mDeviceOffset;
+    for(size_t posIdx = 0; posIdx < count; posIdx++)
+    {
+        devicePositions[posIdx] = glm::vec2(windowPositions[posIdx] * scale + offset);
+    }
+}
+
+glm::vec3 InputTransform::windowToWorld(const glm::dvec2& windowPosition, float deviceDepth) const
+{
+    glm::vec3 worldPosition;
+    windowToWorld(&windowPosition, deviceDepth, &worldPosition, 1);
+    return worldPosition;
+}
+
+void InputTransform::windowToWorld(const glm::dvec2* windowPositions, float deviceDepth, glm::vec3* worldPositions,
+        size_t count) const
+{
+    // inverse * (x, y, depth, 1) is column0 * x + column1 * y plus a term that's the same for the whole batch
+    glm::vec4 column0 = mInverseViewProjection[0];
+    glm::vec4 column1 = mInverseViewProjection[1];
+    glm::vec4 depthTerm = mInverseViewProjection[2] * deviceDepth + mInverseViewProjection[3];
+    glm::dvec2 scale = mDeviceScale;
+    glm::dvec2 offset = mDeviceOffset;
+    for(size_t posIdx = 0; posIdx < count; posIdx++)
+    {
+        glm::vec2 device(windowPositions[posIdx] * scale + offset);
+        glm::vec4 clip = column0 * device.x + column1 * device.y + depthTerm;
+        worldPositions[posIdx] = glm::vec3(clip) / clip.w;
+    }
+}
+
+glm::vec2 InputTransform::getContentScale() const
+{
+    return glm::vec2(mFramebufferScale);
+}
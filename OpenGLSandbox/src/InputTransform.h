@@ -0,0 +1,84 @@
+#ifndef OPENGLSANDBOX_INPUTTRANSFORM_H
+#define OPENGLSANDBOX_INPUTTRANSFORM_H
+
+#include <cstddef>
+#include <glm/glm.hpp>
+
+/**
+ * Converts cursor positions from GLFW's window coordinates to framebuffer pixels, normalized device coords
+ * and world space.  Window coordinates are in screen units with the origin top left, which on HiDPI displays
+ * differ from the framebuffer's pixels by the content scale, and NDC are relative to the viewport rather
+ * than the window.  The transforms only change when the window, framebuffer, viewport or camera do, so they're
+ * cached as one scale and offset per step when those are set (e.g. from framebuffer_size_callback()), and
+ * converting a position is then a multiply-add per component; the batch overloads convert a frame's worth of
+ * input events in one pass.
+ */
+class InputTransform
+{
+private:
+    glm::ivec2 mWindowSize = glm::ivec2(1);
+    glm::ivec2 mFramebufferSize = glm::ivec2(1);
+    /**
+     * x, y, width, height as passed to glViewport()
+     */
+    glm::ivec4 mViewport = glm::ivec4(0, 0, 1, 1);
+    glm::mat4 mInverseViewProjection = glm::mat4(1.0F);
+    /**
+     * Cached window -> framebuffer pixel (top-left origin) and window -> NDC affine maps, per component
+     */
+    glm::dvec2 mFramebufferScale = glm::dvec2(1.0);
+    glm::dvec2 mDeviceScale = glm::dvec2(2.0, -2.0);
+    glm::dvec2 mDeviceOffset = glm::dvec2(-1.0, 1.0);
+    void recalculate();
+public:
+    /**
+     * @param width window width in screen coordinates, as from glfwGetWindowSize()
+     * @param height window height in screen coordinates
+     */
+    void setWindowSize(int width, int height);
+    /**
+     * @param width framebuffer width in pixels, as from glfwGetFramebufferSize()
+     * @param height framebuffer height in pixels
+     */
+    void setFramebufferSize(int width, int height);
+    /**
+     * @param x, y, width, height the current glViewport() rectangle in framebuffer pixels
+     */
+    void setViewport(int x, int y, int width, int height);
+    /**
+     * @param viewProjection the camera's projection * view matrix, used by windowToWorld()
+     */
+    void setViewProjection(const glm::mat4& viewProjection);
+
+    /**
+     * @return the framebuffer pixel under a window position, origin top left like the window's
+     */
+    glm::vec2 windowToFramebuffer(const glm::dvec2& windowPosition) const;
+    /**
+     * @return the normalized device coords of a window position; (-1, -1) is the viewport's bottom left
+     */
+    glm::vec2 windowToDevice(const glm::dvec2& windowPosition) const;
+    /**
+     * Batched windowToDevice(), e.g. for every cursor event since the last frame
+     * @param devicePositions room for count results
+     */
+    void windowToDevice(const glm::dvec2* windowPositions, glm::vec2* devicePositions, size_t count) const;
+    /**
+     * Unprojects a window position through the inverse view-projection matrix
+     * @param deviceDepth NDC depth of the point wanted, -1 at the near plane and 1 at the far plane
+     */
+    glm::vec3 windowToWorld(const glm::dvec2& windowPosition, float deviceDepth) const;
+    /**
+     * Batched windowToWorld(), with every position unprojected at the same depth
+     * @param worldPositions room for count results
+     */
+    void windowToWorld(const glm::dvec2* windowPositions, float deviceDepth, glm::vec3* worldPositions, size_t count) const;
+
+    /**
+     * @return framebuffer pixels per window unit on each axis, i.e. the display's content scale
+     */
+    glm::vec2 getContentScale() const;
+};
+
+
+#endif //OPENGLSANDBOX_INPUTTRANSFORM_H
@@ -0,0 +1,62 @@
+#include "MappedFile.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if(descriptor < 0)
+    {
+        std::cerr << "failed to open " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat status;
+    if(fstat(descriptor, &status) != 0)
+    {
+        std::cerr << "failed to stat " << path << ": " << std::strerror(errno) << std::endl;
+        ::close(descriptor);
+        return false;
+    }
+    size_t size = static_cast<size_t>(status.st_size);
+    // mmap() refuses zero lengths, and there'd be nothing to map anyway
+    if(size > 0)
+    {
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if(mapping == MAP_FAILED)
+        {
+            std::cerr << "failed to map " << path << ": " << std::strerror(errno) << std::endl;
+            ::close(descriptor);
+            return false;
+        }
+        // parsers read the whole file, often from several threads at once, so have it paged in ahead of them
+        madvise(mapping, size, MADV_WILLNEED);
+        mData = static_cast<const char*>(mapping);
+    }
+    // the mapping stays valid without the descriptor
+    ::close(descriptor);
+    mSize = size;
+    mOpen = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(mData != nullptr)
+    {
+        munmap(const_cast<char*>(mData), mSize);
+    }
+    mData = nullptr;
+    mSize = 0;
+    mOpen = false;
+}
@@ -0,0 +1,37 @@
+#ifndef OPENGLSANDBOX_MAPPEDFILE_H
+#define OPENGLSANDBOX_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * A whole file mapped read-only into memory, so parsers can walk it as one array without read() copies
+ * and the OS pages it in on demand, in parallel when several threads touch different parts of it
+ */
+class MappedFile
+{
+private:
+    const char* mData = nullptr;
+    size_t mSize = 0;
+    bool mOpen = false;
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    /**
+     * Maps the named file, unmapping any file mapped before
+     * @return false if the file couldn't be opened or mapped (see std::cerr)
+     */
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return mOpen; }
+    /**
+     * @return the file's contents, or nullptr for an empty file; not null terminated
+     */
+    const char* data() const { return mData; }
+    size_t size() const { return mSize; }
+};
+
+
+#endif //OPENGLSANDBOX_MAPPEDFILE_H
@@ -0,0 +1,428 @@
+#include "MeshCache.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+#include "MeshImporter.h"
+#include "MeshOptimization.h"
+
+namespace
+{
+    const char kMeshCacheMagic[8] = {'O', 'G', 'S', 'M', 'E', 'S', 'H', '\0'};
+
+    static_assert(sizeof(MeshCacheHeader) % 8 == 0, "MeshCacheHeader must keep its 64 bit fields aligned in arrays");
+    static_assert(sizeof(MeshVertex) % 4 == 0, "MeshVertex blobs are assumed to keep the index blob 4 byte aligned");
+
+    size_t alignUp(size_t offset)
+    {
+        return (offset + kMeshCacheAlignment - 1) / kMeshCacheAlignment * kMeshCacheAlignment;
+    }
+
+    /**
+     * @return whether [offset, offset + size) lies within a file of fileSize bytes, without overflowing
+     */
+    bool isWithinFile(uint64_t offset, uint64_t size, uint64_t fileSize)
+    {
+        return offset <= fileSize && size <= fileSize - offset;
+    }
+
+    /**
+     * Zigzags each index's difference from the one before, so small steps either way are small numbers, and
+     * writes them as LEB128 varints: 7 bits a byte, the high bit set on all but the last byte
+     */
+    std::vector<uint8_t> encodeIndices(const std::vector<uint32_t>& indices)
+    {
+        std::vector<uint8_t> encoded;
+        encoded.reserve(indices.size() * 2);
+        int64_t previous = 0;
+        for(uint32_t index : indices)
+        {
+            int64_t delta = static_cast<int64_t>(index) - previous;
+            uint64_t zigzag = (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+            while(zigzag >= 0x80)
+            {
+                encoded.push_back(static_cast<uint8_t>(zigzag | 0x80));
+                zigzag >>= 7;
+            }
+            encoded.push_back(static_cast<uint8_t>(zigzag));
+            previous = index;
+        }
+        return encoded;
+    }
+
+    /**
+     * Reverses encodeIndices()
+     * @return false if the data runs out early or yields an index outside [0, vertexCount) other than
+     *         kPrimitiveRestartIndex
+     */
+    bool decodeIndices(const uint8_t* data, size_t size, size_t indexCount, uint64_t vertexCount,
+            std::vector<uint32_t>& indices)
+    {
+        // every index takes at least a byte, so a count beyond that is corrupt rather than worth allocating for
+        if(indexCount > size)
+        {
+            return false;
+        }
+        indices.resize(indexCount);
+        const uint8_t* cursor = data;
+        const uint8_t* end = data + size;
+        int64_t previous = 0;
+        for(size_t indexIdx = 0; indexIdx < indexCount; indexIdx++)
+        {
+            uint64_t zigzag = 0;
+            for(int shift = 0;; shift += 7)
+            {
+                if(cursor == end || shift > 63)
+                {
+                    return false;
+                }
+                uint8_t byte = *cursor++;
+                zigzag |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if(byte < 0x80)
+                {
+                    break;
+                }
+            }
+            int64_t delta = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+            previous += delta;
+            if(previous < 0 || (static_cast<uint64_t>(previous) >= vertexCount && previous != kPrimitiveRestartIndex))
+            {
+                return false;
+            }
+            indices[indexIdx] = static_cast<uint32_t>(previous);
+        }
+        return cursor == end;
+    }
+
+    /**
+     * The check decodeIndices() makes, for indices stored uncompressed
+     * @return false if any index is outside [0, vertexCount) and not kPrimitiveRestartIndex
+     */
+    bool areIndicesInRange(const uint32_t* indices, size_t indexCount, uint64_t vertexCount)
+    {
+        for(size_t indexIdx = 0; indexIdx < indexCount; indexIdx++)
+        {
+            if(indices[indexIdx] >= vertexCount && indices[indexIdx] != kPrimitiveRestartIndex)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void writePadding(std::ofstream& output, size_t alignedOffset)
+    {
+        static const char kZeros[kMeshCacheAlignment] = {};
+        size_t padding = alignedOffset - static_cast<size_t>(output.tellp());
+        output.write(kZeros, static_cast<std::streamsize>(padding));
+    }
+}
+
+bool getMeshSourceStamp(const std::string& path, MeshSourceStamp& stamp)
+{
+    struct stat status;
+    if(stat(path.c_str(), &status) != 0)
+    {
+        return false;
+    }
+    stamp.size = static_cast<uint64_t>(status.st_size);
+    stamp.modifiedTime = static_cast<int64_t>(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+    return true;
+}
+
+uint64_t hashMeshCacheBytes(const void* data, size_t size, uint64_t seed)
+{
+    const uint64_t kMultiplier = 0x9E3779B97F4A7C15ULL;
+    const uint64_t kMixer = 0xBF58476D1CE4E5B9ULL;
+    const char* bytes = static_cast<const char*>(data);
+    uint64_t hash = seed ^ (static_cast<uint64_t>(size) * kMultiplier);
+    size_t wordCount = size / 8;
+    for(size_t wordIdx = 0; wordIdx < wordCount; wordIdx++)
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes + wordIdx * 8, 8);
+        hash ^= word * kMultiplier;
+        hash = ((hash << 29) | (hash >> 35)) * kMixer;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, bytes + wordCount * 8, size - wordCount * 8);
+    hash ^= tail * kMultiplier;
+    // splitmix64's finaliser, so every input bit reaches every output bit
+    hash = (hash ^ (hash >> 30)) * kMixer;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+}
+
+bool writeMeshCache(const std::string& path, const ImportedMesh& mesh, const MeshSourceStamp& source,
+        bool compressIndices)
+{
+    MeshCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMeshCacheMagic, sizeof(header.magic));
+    header.version = kMeshCacheVersion;
+    header.flags = (mesh.hasNormals ? kMeshCacheHasNormals : 0) | (mesh.hasTexCoords ? kMeshCacheHasTexCoords : 0)
+            | (compressIndices ? kMeshCacheCompressedIndices : 0);
+    header.sourceSize = source.size;
+    header.sourceModifiedTime = source.modifiedTime;
+
+    auto attributes = VertexLayout<MeshVertex>::attributes();
+    static_assert(VertexLayout<MeshVertex>::attributes().size() <= kMeshCacheMaxAttributes,
+            "MeshVertex has more attributes than the header holds");
+    header.vertexStride = sizeof(MeshVertex);
+    header.attributeCount = static_cast<uint32_t>(attributes.size());
+    for(size_t attribIdx = 0; attribIdx < attributes.size(); attribIdx++)
+    {
+        const VertexAttribute& attribute = attributes[attribIdx];
+        header.attributes[attribIdx] = MeshCacheAttribute{attribute.location, static_cast<uint32_t>(attribute.components),
+                attribute.type, static_cast<uint32_t>(attribute.kind), attribute.offset, attribute.size};
+    }
+
+    std::vector<uint32_t> indices = mesh.indices;
+    header.primitive = replaceWithStripsIfShorter(indices, mesh.vertices.size()) ? GL_TRIANGLE_STRIP : GL_TRIANGLES;
+    std::vector<uint8_t> encodedIndices;
+    if(compressIndices)
+    {
+        encodedIndices = encodeIndices(indices);
+    }
+    const void* indexBlob = compressIndices ? static_cast<const void*>(encodedIndices.data()) : indices.data();
+    header.vertexCount = mesh.vertices.size();
+    header.indexCount = indices.size();
+    header.vertexBlobOffset = alignUp(sizeof(MeshCacheHeader));
+    header.vertexBlobSize = sizeof(MeshVertex) * mesh.vertices.size();
+    header.indexBlobOffset = alignUp(header.vertexBlobOffset + header.vertexBlobSize);
+    header.indexBlobSize = compressIndices ? encodedIndices.size() : sizeof(uint32_t) * indices.size();
+    for(glm::length_t component = 0; component < 3; component++)
+    {
+        header.boundsMin[component] = mesh.boundsMin[component];
+        header.boundsMax[component] = mesh.boundsMax[component];
+    }
+    header.contentHash = hashMeshCacheBytes(indexBlob, header.indexBlobSize,
+            hashMeshCacheBytes(mesh.vertices.data(), header.vertexBlobSize, 0));
+
+    // write beside the destination and rename over it, so the cache is either the old file or the whole new one
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writePadding(output, header.vertexBlobOffset);
+        output.write(reinterpret_cast<const char*>(mesh.vertices.data()), static_cast<std::streamsize>(header.vertexBlobSize));
+        writePadding(output, header.indexBlobOffset);
+        output.write(static_cast<const char*>(indexBlob), static_cast<std::streamsize>(header.indexBlobSize));
+        output.close();
+        if(!output)
+        {
+            std::cerr << "failed to write mesh cache " << temporaryPath << std::endl;
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+    }
+    if(std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        std::cerr << "failed to move mesh cache into place at " << path << ": " << std::strerror(errno) << std::endl;
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool MeshCache::open(const std::string& path)
+{
+    close();
+    if(!mFile.open(path))
+    {
+        return false;
+    }
+    // mappings are page aligned, so the header can be read in place
+    const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(mFile.data());
+    uint64_t fileSize = mFile.size();
+    const char* problem = nullptr;
+    if(fileSize < sizeof(MeshCacheHeader) || std::memcmp(header->magic, kMeshCacheMagic, sizeof(kMeshCacheMagic)) != 0)
+    {
+        problem = "not a mesh cache";
+    }
+    else if(header->version != kMeshCacheVersion)
+    {
+        problem = "written by a different version";
+    }
+    else if(header->attributeCount > kMeshCacheMaxAttributes || header->vertexStride == 0
+            || header->vertexBlobSize / header->vertexStride != header->vertexCount
+            || header->vertexBlobSize % header->vertexStride != 0
+            || (header->primitive != GL_TRIANGLES && header->primitive != GL_TRIANGLE_STRIP)
+            || (header->primitive == GL_TRIANGLES && header->indexCount % 3 != 0)
+            || header->vertexBlobOffset % kMeshCacheAlignment != 0 || header->indexBlobOffset % kMeshCacheAlignment != 0
+            || !isWithinFile(header->vertexBlobOffset, header->vertexBlobSize, fileSize)
+            || !isWithinFile(header->indexBlobOffset, header->indexBlobSize, fileSize)
+            || ((header->flags & kMeshCacheCompressedIndices) == 0
+                && header->indexBlobSize / sizeof(uint32_t) != header->indexCount))
+    {
+        problem = "inconsistent header";
+    }
+    else
+    {
+        for(uint32_t attribIdx = 0; attribIdx < header->attributeCount; attribIdx++)
+        {
+            const MeshCacheAttribute& attribute = header->attributes[attribIdx];
+            if(attribute.offset + static_cast<uint64_t>(attribute.size) > header->vertexStride)
+            {
+                problem = "vertex attribute outside the vertex";
+            }
+        }
+    }
+    if(problem == nullptr)
+    {
+        uint64_t contentHash = hashMeshCacheBytes(mFile.data() + header->indexBlobOffset, header->indexBlobSize,
+                hashMeshCacheBytes(mFile.data() + header->vertexBlobOffset, header->vertexBlobSize, 0));
+        if(contentHash != header->contentHash)
+        {
+            problem = "content hash mismatch, the file is truncated or corrupt";
+        }
+    }
+    if(problem == nullptr && (header->flags & kMeshCacheCompressedIndices) != 0
+       && !decodeIndices(reinterpret_cast<const uint8_t*>(mFile.data() + header->indexBlobOffset), header->indexBlobSize,
+                         header->indexCount, header->vertexCount, mDecodedIndices))
+    {
+        problem = "malformed compressed indices";
+    }
+    // the hash only catches damage since writing, so a cache written with a bad index is still checked here
+    if(problem == nullptr && (header->flags & kMeshCacheCompressedIndices) == 0
+       && !areIndicesInRange(reinterpret_cast<const uint32_t*>(mFile.data() + header->indexBlobOffset),
+                             header->indexCount, header->vertexCount))
+    {
+        problem = "index outside the vertices";
+    }
+    if(problem != nullptr)
+    {
+        std::cerr << "can't use mesh cache " << path << ": " << problem << std::endl;
+        close();
+        return false;
+    }
+    mHeader = header;
+    return true;
+}
+
+void MeshCache::close()
+{
+    mHeader = nullptr;
+    std::vector<uint32_t>().swap(mDecodedIndices);
+    mFile.close();
+}
+
+bool MeshCache::matchesSource(const MeshSourceStamp& source) const
+{
+    return mHeader->sourceSize == source.size && mHeader->sourceModifiedTime == source.modifiedTime;
+}
+
+const void* MeshCache::getVertexData() const
+{
+    return mFile.data() + mHeader->vertexBlobOffset;
+}
+
+size_t MeshCache::getVertexCount() const
+{
+    return mHeader->vertexCount;
+}
+
+GLsizei MeshCache::getVertexStride() const
+{
+    return static_cast<GLsizei>(mHeader->vertexStride);
+}
+
+size_t MeshCache::getAttributeCount() const
+{
+    return mHeader->attributeCount;
+}
+
+VertexAttribute MeshCache::getAttribute(size_t attribIdx) const
+{
+    const MeshCacheAttribute& attribute = mHeader->attributes[attribIdx];
+    return VertexAttribute{
+            attribute.location,
+            static_cast<GLint>(attribute.components),
+            attribute.type,
+            static_cast<AttributeKind>(attribute.kind),
+            attribute.offset,
+            attribute.size
+    };
+}
+
+const uint32_t* MeshCache::getIndices() const
+{
+    if((mHeader->flags & kMeshCacheCompressedIndices) != 0)
+    {
+        return mDecodedIndices.data();
+    }
+    return reinterpret_cast<const uint32_t*>(mFile.data() + mHeader->indexBlobOffset);
+}
+
+size_t MeshCache::getIndexCount() const
+{
+    return mHeader->indexCount;
+}
+
+GLenum MeshCache::getPrimitive() const
+{
+    return mHeader->primitive;
+}
+
+glm::vec3 MeshCache::getBoundsMin() const
+{
+    return glm::vec3(mHeader->boundsMin[0], mHeader->boundsMin[1], mHeader->boundsMin[2]);
+}
+
+glm::vec3 MeshCache::getBoundsMax() const
+{
+    return glm::vec3(mHeader->boundsMax[0], mHeader->boundsMax[1], mHeader->boundsMax[2]);
+}
+
+bool MeshCache::hasNormals() const
+{
+    return (mHeader->flags & kMeshCacheHasNormals) != 0;
+}
+
+bool MeshCache::hasTexCoords() const
+{
+    return (mHeader->flags & kMeshCacheHasTexCoords) != 0;
+}
+
+IndexedVertexArray MeshCache::createVertexArray() const
+{
+    std::vector<VertexAttribute> attributes;
+    for(size_t attribIdx = 0; attribIdx < getAttributeCount(); attribIdx++)
+    {
+        attributes.push_back(getAttribute(attribIdx));
+    }
+    IndexedVertexArray vertexArray;
+    vertexArray.vbo = createBuffer(static_cast<GLsizeiptr>(mHeader->vertexBlobSize), getVertexData(), 0);
+    vertexArray.ebo = createBuffer(static_cast<GLsizeiptr>(sizeof(uint32_t) * getIndexCount()), getIndices(), 0);
+    vertexArray.vao = ::createVertexArray();
+    applyVertexAttributes(vertexArray.vao, 0, vertexArray.vbo, 0, getVertexStride(), 0, attributes.data(),
+            attributes.size());
+    setElementBuffer(vertexArray.vao, vertexArray.ebo);
+    return vertexArray;
+}
+
+bool loadCachedMesh(const std::string& sourcePath, MeshCache& cache, ThreadPool& pool, bool compressIndices)
+{
+    MeshSourceStamp source;
+    if(!getMeshSourceStamp(sourcePath, source))
+    {
+        std::cerr << "failed to load mesh " << sourcePath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    std::string cachePath = sourcePath + ".meshcache";
+    MeshSourceStamp cacheStamp;
+    if(getMeshSourceStamp(cachePath, cacheStamp) && cache.open(cachePath))
+    {
+        if(cache.matchesSource(source))
+        {
+            return true;
+        }
+        std::cout << "mesh cache " << cachePath << " is out of date, reimporting " << sourcePath << std::endl;
+        cache.close();
+    }
+    ImportedMesh mesh;
+    return importMesh(sourcePath, mesh, pool) && writeMeshCache(cachePath, mesh, source, compressIndices)
+           && cache.open(cachePath);
+}
@@ -0,0 +1,184 @@
+#ifndef OPENGLSANDBOX_MESHCACHE_H
+#define OPENGLSANDBOX_MESHCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "GLResources.h"
+#include "MappedFile.h"
+#include "VertexLayout.h"
+
+struct ImportedMesh;
+class ThreadPool;
+
+/*
+ * A binary container for imported meshes that's loaded by mapping it and pointing GL at the mapping: a
+ * fixed-size MeshCacheHeader, then the vertex blob and the index blob, each 64 byte aligned, in exactly the
+ * layout the GPU consumes.  The header describes the vertex attributes the way VertexLayout does, so the
+ * loader needs no knowledge of the vertex struct, and records the source file's size and modification time
+ * so stale caches are noticed.  A 64 bit hash of both blobs guards against truncated or corrupted files.
+ *
+ * Indices can optionally be stored compressed, as zigzagged deltas from the previous index in LEB128
+ * varints; welded meshes index nearby vertices, so most take one or two bytes rather than four, at the cost
+ * of a decode pass on load.  Indices are stored as restart-joined triangle strips instead of a triangle list
+ * whenever that takes fewer of them.  Files are written in native (little endian) byte order.
+ */
+
+const uint32_t kMeshCacheVersion = 2;
+const size_t kMeshCacheMaxAttributes = 8;
+/**
+ * Alignment of the blobs within the file
+ */
+const size_t kMeshCacheAlignment = 64;
+
+/**
+ * MeshCacheHeader::flags bits
+ */
+const uint32_t kMeshCacheHasNormals = 1;
+const uint32_t kMeshCacheHasTexCoords = 2;
+const uint32_t kMeshCacheCompressedIndices = 4;
+
+/**
+ * VertexAttribute with fixed-size fields
+ */
+struct MeshCacheAttribute
+{
+    uint32_t location;
+    uint32_t components;
+    uint32_t type;
+    uint32_t kind;
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct MeshCacheHeader
+{
+    /**
+     * "OGSMESH" and a terminating 0
+     */
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    /**
+     * GL_TRIANGLES, or GL_TRIANGLE_STRIP for strips joined by kPrimitiveRestartIndex
+     */
+    uint32_t primitive;
+    uint32_t reserved;
+    uint64_t sourceSize;
+    /**
+     * In nanoseconds since the epoch
+     */
+    int64_t sourceModifiedTime;
+    uint32_t vertexStride;
+    uint32_t attributeCount;
+    MeshCacheAttribute attributes[kMeshCacheMaxAttributes];
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    uint64_t vertexBlobOffset;
+    uint64_t vertexBlobSize;
+    uint64_t indexBlobOffset;
+    uint64_t indexBlobSize;
+    float boundsMin[3];
+    float boundsMax[3];
+    /**
+     * hashMeshCacheBytes() of the vertex blob, continued over the index blob
+     */
+    uint64_t contentHash;
+};
+
+/**
+ * Identifies the version of a source file a cache was built from
+ */
+struct MeshSourceStamp
+{
+    uint64_t size = 0;
+    int64_t modifiedTime = 0;
+};
+
+/**
+ * @return false if the file can't be stat()ed, which is expected for caches not written yet
+ */
+bool getMeshSourceStamp(const std::string& path, MeshSourceStamp& stamp);
+
+/**
+ * Fast non-cryptographic 64 bit hash, 8 bytes a step
+ * @param seed 0, or the hash of the data before this, to hash several pieces as one
+ */
+uint64_t hashMeshCacheBytes(const void* data, size_t size, uint64_t seed);
+
+/**
+ * Writes an imported mesh as a cache file, replacing it atomically so a concurrent reader never sees half a
+ * file; its triangles are stored as strips if they take fewer indices than its triangle list
+ * @param source stamp of the file the mesh was imported from
+ * @param compressIndices whether to delta and varint encode the indices
+ * @return false if the file couldn't be written (see std::cerr)
+ */
+bool writeMeshCache(const std::string& path, const ImportedMesh& mesh, const MeshSourceStamp& source,
+        bool compressIndices);
+
+/**
+ * A mapped, validated mesh cache file.  Vertices, and indices unless they were compressed, are read straight
+ * out of the mapping
+ */
+class MeshCache
+{
+private:
+    MappedFile mFile;
+    const MeshCacheHeader* mHeader = nullptr;
+    /**
+     * Only used for compressed indices
+     */
+    std::vector<uint32_t> mDecodedIndices;
+public:
+    MeshCache() = default;
+    MeshCache(const MeshCache&) = delete;
+    MeshCache& operator=(const MeshCache&) = delete;
+    /**
+     * Maps a cache file and checks its header, sizes and content hash, decoding compressed indices
+     * @return false if it isn't a valid cache of this version (see std::cerr)
+     */
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return mHeader != nullptr; }
+    /**
+     * @return whether the cache was built from this version of its source
+     */
+    bool matchesSource(const MeshSourceStamp& source) const;
+
+    const void* getVertexData() const;
+    size_t getVertexCount() const;
+    GLsizei getVertexStride() const;
+    size_t getAttributeCount() const;
+    VertexAttribute getAttribute(size_t attribIdx) const;
+    /**
+     * Drawn with getPrimitive(); strips are separated by kPrimitiveRestartIndex
+     */
+    const uint32_t* getIndices() const;
+    size_t getIndexCount() const;
+    /**
+     * GL_TRIANGLES or GL_TRIANGLE_STRIP; strips need GL_PRIMITIVE_RESTART_FIXED_INDEX enabled
+     */
+    GLenum getPrimitive() const;
+    glm::vec3 getBoundsMin() const;
+    glm::vec3 getBoundsMax() const;
+    bool hasNormals() const;
+    bool hasTexCoords() const;
+    /**
+     * Uploads the vertices and indices into new immutable buffers, straight from the mapping, behind a VAO set
+     * up from the stored attribute layout; must be called on the thread owning the current GL context
+     */
+    IndexedVertexArray createVertexArray() const;
+};
+
+/**
+ * Opens the cache next to a mesh (sourcePath + ".meshcache"), importing the mesh and writing the cache
+ * first if there isn't a valid one for the current version of the source
+ * @param compressIndices used when a new cache has to be written
+ * @return false if neither the cache nor the source could be loaded (see std::cerr)
+ */
+bool loadCachedMesh(const std::string& sourcePath, MeshCache& cache, ThreadPool& pool, bool compressIndices = false);
+
+
+#endif //OPENGLSANDBOX_MESHCACHE_H
@@ -0,0 +1,291 @@
+#include "MeshClusters.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "MeshOptimization.h"
+#include "SimdLane.h"
+
+namespace
+{
+    /**
+     * Cones whose triangles lean further than this (as a cosine) from their axis would almost never cull, so
+     * they're stored as no cone at all
+     */
+    const float kMinConeSpread = 0.1F;
+
+    inline glm::vec3 loadPosition(const float* positions, size_t positionStride, uint32_t vertex)
+    {
+        glm::vec3 position;
+        std::memcpy(&position, reinterpret_cast<const char*>(positions) + static_cast<size_t>(vertex) * positionStride,
+                sizeof(position));
+        return position;
+    }
+
+    /**
+     * @return how many distinct vertices of the triangle aren't in the cluster yet
+     */
+    inline size_t countNewVertices(const uint32_t* corners, const std::vector<uint32_t>& vertexCluster, uint32_t cluster)
+    {
+        size_t newVertices = 0;
+        for(size_t corner = 0; corner < 3; corner++)
+        {
+            bool repeated = (corner > 0 && corners[corner] == corners[0]) || (corner > 1 && corners[corner] == corners[1]);
+            if(!repeated && vertexCluster[corners[corner]] != cluster)
+            {
+                newVertices++;
+            }
+        }
+        return newVertices;
+    }
+
+    /**
+     * Records the bounding sphere and normal cone of the cluster whose triangles end the index list
+     */
+    void finishCluster(MeshClusters& clusters, const std::vector<uint32_t>& clusterVertices, const float* positions,
+            size_t positionStride)
+    {
+        uint32_t firstIndex = clusters.firstIndices.back();
+        const uint32_t* indices = clusters.indices.data() + firstIndex;
+        size_t indexCount = clusters.indices.size() - firstIndex;
+        clusters.indexCounts.push_back(static_cast<uint32_t>(indexCount));
+
+        glm::vec3 boundsMin = loadPosition(positions, positionStride, clusterVertices[0]);
+        glm::vec3 boundsMax = boundsMin;
+        for(uint32_t vertex : clusterVertices)
+        {
+            glm::vec3 position = loadPosition(positions, positionStride, vertex);
+            boundsMin = glm::min(boundsMin, position);
+            boundsMax = glm::max(boundsMax, position);
+        }
+        glm::vec3 center = (boundsMin + boundsMax) * 0.5F;
+        float radiusSquared = 0.0F;
+        for(uint32_t vertex : clusterVertices)
+        {
+            glm::vec3 offset = loadPosition(positions, positionStride, vertex) - center;
+            radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+        }
+        clusters.centers.push_back(center);
+        clusters.radii.push_back(std::sqrt(radiusSquared));
+
+        // the cone's axis is the mean of the unit face normals, and its cutoff comes from the one furthest from it
+        glm::vec3 normals[kMaxClusterTriangles];
+        size_t normalCount = 0;
+        glm::vec3 axis(0.0F);
+        for(size_t indexIdx = 0; indexIdx < indexCount; indexIdx += 3)
+        {
+            glm::vec3 a = loadPosition(positions, positionStride, indices[indexIdx]);
+            glm::vec3 b = loadPosition(positions, positionStride, indices[indexIdx + 1]);
+            glm::vec3 c = loadPosition(positions, positionStride, indices[indexIdx + 2]);
+            glm::vec3 normal = glm::cross(b - a, c - a);
+            float length = glm::length(normal);
+            // degenerate triangles draw nothing, so they don't constrain the cone
+            if(length > 0.0F)
+            {
+                normals[normalCount] = normal / length;
+                axis += normals[normalCount++];
+            }
+        }
+        float axisLength = glm::length(axis);
+        float minimumDot = -1.0F;
+        if(axisLength > 0.0F)
+        {
+            axis /= axisLength;
+            minimumDot = 1.0F;
+            for(size_t normalIdx = 0; normalIdx < normalCount; normalIdx++)
+            {
+                minimumDot = std::min(minimumDot, glm::dot(axis, normals[normalIdx]));
+            }
+        }
+        if(minimumDot <= kMinConeSpread)
+        {
+            clusters.coneAxes.push_back(glm::vec3(0.0F));
+            clusters.coneCutoffs.push_back(1.0F);
+        }
+        else
+        {
+            clusters.coneAxes.push_back(axis);
+            clusters.coneCutoffs.push_back(std::sqrt(1.0F - minimumDot * minimumDot));
+        }
+    }
+}
+
+MeshClusters buildMeshClusters(const uint32_t* indices, size_t indexCount, const float* positions,
+        size_t positionStride, size_t vertexCount)
+{
+    MeshClusters clusters;
+    size_t triangleCount = indexCount / 3;
+    clusters.indices.reserve(triangleCount * 3);
+    TriangleAdjacency adjacency(indices, triangleCount, vertexCount);
+    std::vector<bool> emitted(triangleCount, false);
+    // the cluster each vertex was last added to, so moving on to a new cluster needs no clearing
+    std::vector<uint32_t> vertexCluster(vertexCount, UINT32_MAX);
+    std::vector<uint32_t> clusterVertices;
+    clusterVertices.reserve(kMaxClusterVertices);
+    size_t clusterTriangles = 0;
+    size_t nextUnemitted = 0;
+    while(true)
+    {
+        // indexCounts only grows once a cluster is finished, so it counts the finished ones
+        uint32_t cluster = static_cast<uint32_t>(clusters.indexCounts.size());
+        // Cluster Step 1: the triangle touching the cluster that adds the fewest vertices, searching from the
+        // newest vertex back; one adding none ends the search early, so ties only go to the earliest triangle
+        // among those seen by then
+        uint32_t best = UINT32_MAX;
+        size_t bestNewVertices = 4;
+        for(auto vertex = clusterVertices.rbegin(); vertex != clusterVertices.rend() && bestNewVertices > 0; ++vertex)
+        {
+            const uint32_t* live = adjacency.getLiveTriangles(*vertex);
+            for(uint32_t liveIdx = 0; liveIdx < adjacency.getLiveCount(*vertex); liveIdx++)
+            {
+                size_t newVertices = countNewVertices(indices + static_cast<size_t>(live[liveIdx]) * 3, vertexCluster, cluster);
+                if(newVertices < bestNewVertices || (newVertices == bestNewVertices && live[liveIdx] < best))
+                {
+                    best = live[liveIdx];
+                    bestNewVertices = newVertices;
+                }
+            }
+        }
+        // Cluster Step 2: with nothing touching it, carry on from the first triangle not in a cluster yet
+        if(best == UINT32_MAX)
+        {
+            while(nextUnemitted < triangleCount && emitted[nextUnemitted])
+            {
+                nextUnemitted++;
+            }
+            if(nextUnemitted == triangleCount)
+            {
+                break;
+            }
+            best = static_cast<uint32_t>(nextUnemitted);
+            bestNewVertices = countNewVertices(indices + nextUnemitted * 3, vertexCluster, cluster);
+        }
+        // Cluster Step 3: start a new cluster if the triangle doesn't fit in this one
+        if(clusterTriangles == kMaxClusterTriangles || clusterVertices.size() + bestNewVertices > kMaxClusterVertices)
+        {
+            finishCluster(clusters, clusterVertices, positions, positionStride);
+            clusterVertices.clear();
+            clusterTriangles = 0;
+            continue;
+        }
+        if(clusterTriangles == 0)
+        {
+            clusters.firstIndices.push_back(static_cast<uint32_t>(clusters.indices.size()));
+        }
+        emitted[best] = true;
+        clusterTriangles++;
+        for(size_t corner = 0; corner < 3; corner++)
+        {
+            uint32_t vertex = indices[static_cast<size_t>(best) * 3 + corner];
+            adjacency.retire(vertex, best);
+            clusters.indices.push_back(vertex);
+            if(vertexCluster[vertex] != cluster)
+            {
+                vertexCluster[vertex] = cluster;
+                clusterVertices.push_back(vertex);
+            }
+        }
+    }
+    if(clusterTriangles > 0)
+    {
+        finishCluster(clusters, clusterVertices, positions, positionStride);
+    }
+    clusters.radii.resize(clusters.centers.paddedSize(), 0.0F);
+    clusters.coneCutoffs.resize(clusters.coneAxes.paddedSize(), 0.0F);
+    return clusters;
+}
+
+ClusterCullStatistics cullMeshClusters(const MeshClusters& clusters, const ViewFrustum& frustum,
+        const glm::vec3& cameraPosition, std::vector<DrawElementsIndirectCommand>& commands)
+{
+    using namespace simd;
+    commands.clear();
+    ClusterCullStatistics statistics;
+    Lane planeX[6];
+    Lane planeY[6];
+    Lane planeZ[6];
+    Lane planeW[6];
+    for(size_t planeIdx = 0; planeIdx < 6; planeIdx++)
+    {
+        planeX[planeIdx] = splat(frustum.planes[planeIdx].x);
+        planeY[planeIdx] = splat(frustum.planes[planeIdx].y);
+        planeZ[planeIdx] = splat(frustum.planes[planeIdx].z);
+        planeW[planeIdx] = splat(frustum.planes[planeIdx].w);
+    }
+    const Lane cameraX = splat(cameraPosition.x);
+    const Lane cameraY = splat(cameraPosition.y);
+    const Lane cameraZ = splat(cameraPosition.z);
+    const Lane zero = splat(0.0F);
+
+    for(size_t first = 0; first < clusters.size(); first += kLaneWidth)
+    {
+        Lane x = load(clusters.centers.x() + first);
+        Lane y = load(clusters.centers.y() + first);
+        Lane z = load(clusters.centers.z() + first);
+        Lane radius = load(clusters.radii.data() + first);
+        Lane negativeRadius = subtract(zero, radius);
+        // inside unless the sphere is wholly behind one of the planes
+        Mask inside = greaterEqual(add(add(add(multiply(planeX[0], x), multiply(planeY[0], y)), multiply(planeZ[0], z)),
+                planeW[0]), negativeRadius);
+        for(size_t planeIdx = 1; planeIdx < 6; planeIdx++)
+        {
+            Lane distance = add(add(add(multiply(planeX[planeIdx], x), multiply(planeY[planeIdx], y)),
+                    multiply(planeZ[planeIdx], z)), planeW[planeIdx]);
+            inside = maskAnd(inside, greaterEqual(distance, negativeRadius));
+        }
+        // back-facing if the direction to the sphere is inside the cone widened by the sphere's radius:
+        // dot(center - camera, axis) >= cutoff * |center - camera| + radius
+        Lane toX = subtract(x, cameraX);
+        Lane toY = subtract(y, cameraY);
+        Lane toZ = subtract(z, cameraZ);
+        Lane distance = squareRoot(add(add(multiply(toX, toX), multiply(toY, toY)), multiply(toZ, toZ)));
+        Lane along = add(add(multiply(toX, load(clusters.coneAxes.x() + first)), multiply(toY, load(clusters.coneAxes.y() + first))),
+                multiply(toZ, load(clusters.coneAxes.z() + first)));
+        Mask frontFacing = greater(add(multiply(load(clusters.coneCutoffs.data() + first), distance), radius), along);
+        int insideBits = maskBits(inside);
+        int visibleBits = maskBits(maskAnd(inside, frontFacing));
+
+        size_t laneCount = std::min(kLaneWidth, clusters.size() - first);
+        for(size_t lane = 0; lane < laneCount; lane++)
+        {
+            if((insideBits & (1 << lane)) == 0)
+            {
+                statistics.outsideFrustum++;
+            }
+            else if((visibleBits & (1 << lane)) == 0)
+            {
+                statistics.backFacing++;
+            }
+            else
+            {
+                size_t cluster = first + lane;
+                commands.push_back(DrawElementsIndirectCommand{clusters.indexCounts[cluster], 1,
+                        clusters.firstIndices[cluster], 0, static_cast<GLuint>(cluster)});
+            }
+        }
+    }
+    statistics.visible = commands.size();
+    return statistics;
+}
+
+ClusterDrawBuffer::ClusterDrawBuffer(size_t maxCommands): mCapacity(maxCommands)
+{
+    mBuffer = createBuffer(static_cast<GLsizeiptr>(sizeof(DrawElementsIndirectCommand) * std::max<size_t>(maxCommands, 1)),
+            nullptr, GL_DYNAMIC_STORAGE_BIT);
+}
+
+ClusterDrawBuffer::~ClusterDrawBuffer()
+{
+    glDeleteBuffers(1, &mBuffer);
+}
+
+void ClusterDrawBuffer::draw(const std::vector<DrawElementsIndirectCommand>& commands)
+{
+    size_t commandCount = std::min(commands.size(), mCapacity);
+    if(commandCount == 0)
+    {
+        return;
+    }
+    updateBuffer(mBuffer, 0, static_cast<GLsizeiptr>(sizeof(DrawElementsIndirectCommand) * commandCount), commands.data());
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mBuffer);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(commandCount), 0);
+}
@@ -0,0 +1,117 @@
+#ifndef OPENGLSANDBOX_MESHCLUSTERS_H
+#define OPENGLSANDBOX_MESHCLUSTERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "GLResources.h"
+#include "Vec3SoA.h"
+#include "ViewFrustum.h"
+
+/*
+ * Cluster (meshlet) partitioning and culling, so a large mesh that's only partly on screen or partly facing
+ * away doesn't have all of its vertices transformed.  buildMeshClusters() regroups a triangle list into
+ * clusters of up to kMaxClusterVertices vertices and kMaxClusterTriangles triangles, each grown across shared
+ * vertices into a compact patch, and records each one's bounding sphere and the cone bounding its triangles'
+ * normals.  Every frame cullMeshClusters() tests kLaneWidth clusters a step against the view frustum and,
+ * through the cone, for facing entirely away from the camera, and writes a DrawElementsIndirectCommand for
+ * each survivor; ClusterDrawBuffer then draws them all with one glMultiDrawElementsIndirect() over the
+ * mesh's single index buffer, uploaded from MeshClusters::indices in place of the original triangle list.
+ */
+
+const size_t kMaxClusterVertices = 64;
+const size_t kMaxClusterTriangles = 124;
+
+/**
+ * A triangle list regrouped into clusters, with each cluster's bounds in SoA for cullMeshClusters()
+ */
+struct MeshClusters
+{
+    /**
+     * The mesh's triangles, each cluster's contiguous
+     */
+    std::vector<uint32_t> indices;
+    /**
+     * Per cluster, the range of indices it draws
+     */
+    std::vector<uint32_t> firstIndices;
+    std::vector<uint32_t> indexCounts;
+    /**
+     * Per cluster bounding spheres; radii is padded like a component array
+     */
+    Vec3SoA centers;
+    AlignedFloatVector radii;
+    /**
+     * Per cluster normal cones: the unit axis, and the sine of the widest angle between it and a triangle's
+     * normal.  Clusters whose normals spread too far for the cone to ever cull them get a zero axis and a
+     * cutoff of 1.  coneCutoffs is padded like a component array
+     */
+    Vec3SoA coneAxes;
+    AlignedFloatVector coneCutoffs;
+
+    size_t size() const { return firstIndices.size(); }
+};
+
+/**
+ * Partitions a triangle list into clusters.  Each cluster starts at the first triangle not yet in one and
+ * grows by whichever triangle touching it adds the fewest new vertices, so a list in vertex cache order
+ * keeps most of its reuse within each cluster
+ * @param positions x, y, z of the first vertex
+ * @param positionStride bytes between consecutive vertices' positions
+ */
+MeshClusters buildMeshClusters(const uint32_t* indices, size_t indexCount, const float* positions,
+        size_t positionStride, size_t vertexCount);
+
+/**
+ * How many clusters cullMeshClusters() kept and why it dropped the rest
+ */
+struct ClusterCullStatistics
+{
+    size_t visible = 0;
+    size_t outsideFrustum = 0;
+    /**
+     * In the frustum, but with every triangle facing away from the camera
+     */
+    size_t backFacing = 0;
+};
+
+/**
+ * Culls clusters whose bounding sphere lies outside the frustum or whose normal cone faces away from the
+ * camera.  Both tests are conservative: a culled cluster has no triangle that could be drawn
+ * @param frustum in the mesh's model space, e.g. extractViewFrustum(projection * view * model)
+ * @param cameraPosition likewise in the mesh's model space
+ * @param commands replaced with one command per visible cluster, in cluster order, each with its cluster's
+ *        index as baseInstance
+ */
+ClusterCullStatistics cullMeshClusters(const MeshClusters& clusters, const ViewFrustum& frustum,
+        const glm::vec3& cameraPosition, std::vector<DrawElementsIndirectCommand>& commands);
+
+/**
+ * The GL_DRAW_INDIRECT_BUFFER cullMeshClusters()' commands are uploaded into each frame, and the
+ * multi-draw over it
+ */
+class ClusterDrawBuffer
+{
+private:
+    unsigned int mBuffer = 0;
+    size_t mCapacity = 0;
+public:
+    /**
+     * Must be called on the thread owning the current GL context
+     * @param maxCommands the most commands draw() will be given, e.g. MeshClusters::size()
+     */
+    explicit ClusterDrawBuffer(size_t maxCommands);
+    ~ClusterDrawBuffer();
+    ClusterDrawBuffer(const ClusterDrawBuffer&) = delete;
+    ClusterDrawBuffer& operator=(const ClusterDrawBuffer&) = delete;
+    /**
+     * Uploads the commands and draws them as GL_TRIANGLES with 32 bit indices in one
+     * glMultiDrawElementsIndirect(); the clustered mesh's VAO must be bound.  Leaves the buffer bound to
+     * GL_DRAW_INDIRECT_BUFFER
+     */
+    void draw(const std::vector<DrawElementsIndirectCommand>& commands);
+};
+
+
+#endif //OPENGLSANDBOX_MESHCLUSTERS_H
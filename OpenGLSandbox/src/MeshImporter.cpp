@@ -0,0 +1,1368 @@
+#include "MeshImporter.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#ifndef GLM_ENABLE_EXPERIMENTAL
+#define GLM_ENABLE_EXPERIMENTAL
+#endif
+#include <glm/gtx/hash.hpp>
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+namespace
+{
+    /**
+     * Files are cut into chunks of about this many bytes for parsing, enough of them to keep every thread
+     * busy while each is big enough that the per-chunk bookkeeping doesn't matter
+     */
+    const size_t kTargetChunkBytes = 256 * 1024;
+    /**
+     * Triangle corners welded per task
+     */
+    const size_t kWeldRangeCorners = 3 * 64 * 1024;
+    /**
+     * Vertices converted per task when reading binary PLY
+     */
+    const size_t kBinaryVertexRange = 64 * 1024;
+
+    /// number parsing ///
+
+    /**
+     * Exactly representable powers of ten, for the fast path of parseFloat()
+     */
+    const double kPowersOfTen[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    inline bool isDigit(char character)
+    {
+        return character >= '0' && character <= '9';
+    }
+
+    /**
+     * Skips spaces, tabs and carriage returns, but not the newline ending the line
+     */
+    inline void skipSpaces(const char*& cursor, const char* end)
+    {
+        while(cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r'))
+        {
+            cursor++;
+        }
+    }
+
+    inline bool atLineEnd(const char* cursor, const char* end)
+    {
+        return cursor >= end || *cursor == '\n';
+    }
+
+    /**
+     * @return the start of the line after the one cursor is on, or end
+     */
+    inline const char* nextLine(const char* cursor, const char* end)
+    {
+        const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+        return newline != nullptr ? newline + 1 : end;
+    }
+
+    /**
+     * Parses a decimal float at cursor, skipping leading spaces, and leaves cursor after it.  Up to 19
+     * significant digits are gathered into an integer that, in the overwhelmingly common case of it fitting
+     * a double's mantissa with a small exponent, is scaled by an exact power of ten in double precision and
+     * rounded to float, which is correctly rounded bar the odd double rounding tie.  Anything else,
+     * including inf and nan, goes to strtof()
+     * @return false if there's no number at cursor
+     */
+    bool parseFloat(const char*& cursor, const char* end, float& value)
+    {
+        skipSpaces(cursor, end);
+        const char* start = cursor;
+        bool negative = false;
+        if(cursor < end && (*cursor == '-' || *cursor == '+'))
+        {
+            negative = *cursor == '-';
+            cursor++;
+        }
+        uint64_t mantissa = 0;
+        int significantDigits = 0;
+        int exponent = 0;
+        bool anyDigits = false;
+        for(; cursor < end && isDigit(*cursor); cursor++)
+        {
+            anyDigits = true;
+            if(significantDigits < 19)
+            {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*cursor - '0');
+                significantDigits += mantissa != 0 ? 1 : 0;
+            }
+            else
+            {
+                exponent++;
+            }
+        }
+        if(cursor < end && *cursor == '.')
+        {
+            for(cursor++; cursor < end && isDigit(*cursor); cursor++)
+            {
+                anyDigits = true;
+                if(significantDigits < 19)
+                {
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(*cursor - '0');
+                    significantDigits += mantissa != 0 ? 1 : 0;
+                    exponent--;
+                }
+            }
+        }
+        if(anyDigits && cursor < end && (*cursor == 'e' || *cursor == 'E'))
+        {
+            const char* exponentStart = cursor;
+            cursor++;
+            bool negativeExponent = false;
+            if(cursor < end && (*cursor == '-' || *cursor == '+'))
+            {
+                negativeExponent = *cursor == '-';
+                cursor++;
+            }
+            if(cursor < end && isDigit(*cursor))
+            {
+                int explicitExponent = 0;
+                for(; cursor < end && isDigit(*cursor); cursor++)
+                {
+                    explicitExponent = std::min(explicitExponent * 10 + (*cursor - '0'), 100000);
+                }
+                exponent += negativeExponent ? -explicitExponent : explicitExponent;
+            }
+            else
+            {
+                // an 'e' not followed by an exponent isn't part of the number
+                cursor = exponentStart;
+            }
+        }
+
+        if(anyDigits && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+        {
+            double scaled = static_cast<double>(mantissa);
+            scaled = exponent < 0 ? scaled / kPowersOfTen[-exponent] : scaled * kPowersOfTen[exponent];
+            value = static_cast<float>(negative ? -scaled : scaled);
+            return true;
+        }
+
+        // slow path: strtof() wants a terminated string, so copy the token out of the mapped file
+        const char* tokenEnd = start;
+        while(tokenEnd < end && !std::isspace(static_cast<unsigned char>(*tokenEnd)) && *tokenEnd != '/')
+        {
+            tokenEnd++;
+        }
+        std::string token(start, tokenEnd);
+        char* parsedEnd = nullptr;
+        value = std::strtof(token.c_str(), &parsedEnd);
+        if(parsedEnd == token.c_str())
+        {
+            cursor = start;
+            return false;
+        }
+        cursor = start + (parsedEnd - token.c_str());
+        return true;
+    }
+
+    /**
+     * Parses a decimal integer at cursor, skipping leading spaces, and leaves cursor after it
+     * @return false if there's no integer at cursor
+     */
+    bool parseInteger(const char*& cursor, const char* end, int64_t& value)
+    {
+        skipSpaces(cursor, end);
+        bool negative = false;
+        if(cursor < end && (*cursor == '-' || *cursor == '+'))
+        {
+            negative = *cursor == '-';
+            cursor++;
+        }
+        if(cursor >= end || !isDigit(*cursor))
+        {
+            return false;
+        }
+        int64_t magnitude = 0;
+        for(; cursor < end && isDigit(*cursor); cursor++)
+        {
+            magnitude = magnitude * 10 + (*cursor - '0');
+        }
+        value = negative ? -magnitude : magnitude;
+        return true;
+    }
+
+    /**
+     * Chunk boundaries over [begin, end) of data, each at the start of a line
+     */
+    std::vector<size_t> splitAtLines(const char* data, size_t begin, size_t end)
+    {
+        size_t chunkCount = std::max<size_t>((end - begin) / kTargetChunkBytes, 1);
+        std::vector<size_t> boundaries;
+        boundaries.reserve(chunkCount + 1);
+        boundaries.push_back(begin);
+        for(size_t chunkIdx = 1; chunkIdx < chunkCount; chunkIdx++)
+        {
+            size_t position = begin + (end - begin) * chunkIdx / chunkCount;
+            position = std::max(position, boundaries.back());
+            position = static_cast<size_t>(nextLine(data + position, data + end) - data);
+            if(position > boundaries.back() && position < end)
+            {
+                boundaries.push_back(position);
+            }
+        }
+        boundaries.push_back(end);
+        return boundaries;
+    }
+
+    size_t countLines(const char* begin, const char* end)
+    {
+        size_t lines = 0;
+        for(const char* line = begin; line < end; line = nextLine(line, end))
+        {
+            lines++;
+        }
+        return lines;
+    }
+
+    /// parsed geometry and welding ///
+
+    /**
+     * Indices of one triangle corner's attributes into ParsedGeometry's arrays, -1 where it has none
+     */
+    struct CornerIndices
+    {
+        int64_t position;
+        int64_t texCoord;
+        int64_t normal;
+    };
+
+    /**
+     * Attribute arrays as the file lists them, and triangle corners indexing them, per parse chunk
+     */
+    struct ParsedGeometry
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> texCoords;
+        std::vector<std::vector<CornerIndices>> chunkCorners;
+    };
+
+    /**
+     * First parse error of a chunk, if any; the first failing chunk's is reported
+     */
+    struct ParseError
+    {
+        bool failed = false;
+        std::string message;
+
+        void fail(size_t line, const std::string& reason)
+        {
+            if(!failed)
+            {
+                failed = true;
+                std::ostringstream stream;
+                stream << "line " << line << ": " << reason;
+                message = stream.str();
+            }
+        }
+    };
+
+    bool reportFirstError(const std::vector<ParseError>& errors, const char* format)
+    {
+        for(const ParseError& error : errors)
+        {
+            if(error.failed)
+            {
+                std::cerr << "failed to parse " << format << " " << error.message << std::endl;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline void hashCombine(size_t& seed, size_t hash)
+    {
+        seed ^= hash + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+
+    inline size_t hashVertex(const MeshVertex& vertex)
+    {
+        size_t seed = std::hash<glm::vec3>()(vertex.position);
+        hashCombine(seed, std::hash<glm::vec3>()(vertex.normal));
+        hashCombine(seed, std::hash<glm::vec2>()(vertex.texCoord));
+        return seed;
+    }
+
+    /**
+     * Open addressing hash set of vertices, storing indices into a vertex array plus a few hash bits per slot
+     * so most mismatches are rejected without touching the vertex.  Vertices are only welded when bit-identical.
+     * Sized up front for the most vertices it can receive, so it never rehashes
+     */
+    class VertexWeldTable
+    {
+    private:
+        /**
+         * Vertex index + 1, or 0 for an empty slot
+         */
+        std::vector<uint32_t> mSlots;
+        std::vector<uint32_t> mSlotTags;
+        size_t mMask;
+    public:
+        explicit VertexWeldTable(size_t maxVertices)
+        {
+            size_t capacity = 16;
+            while(capacity < maxVertices * 2)
+            {
+                capacity *= 2;
+            }
+            mSlots.assign(capacity, 0);
+            mSlotTags.resize(capacity);
+            mMask = capacity - 1;
+        }
+
+        /**
+         * @return the index of the vertex in vertices equal to vertex, appending it (and its hash) if there's none
+         */
+        uint32_t findOrAdd(const MeshVertex& vertex, size_t hash, std::vector<MeshVertex>& vertices,
+                std::vector<size_t>& hashes)
+        {
+            uint32_t tag = static_cast<uint32_t>(hash >> 32) ^ static_cast<uint32_t>(hash);
+            for(size_t slot = hash & mMask;; slot = (slot + 1) & mMask)
+            {
+                uint32_t entry = mSlots[slot];
+                if(entry == 0)
+                {
+                    vertices.push_back(vertex);
+                    hashes.push_back(hash);
+                    mSlots[slot] = static_cast<uint32_t>(vertices.size());
+                    mSlotTags[slot] = tag;
+                    return static_cast<uint32_t>(vertices.size() - 1);
+                }
+                if(mSlotTags[slot] == tag && std::memcmp(&vertices[entry - 1], &vertex, sizeof(MeshVertex)) == 0)
+                {
+                    return entry - 1;
+                }
+            }
+        }
+    };
+
+    /**
+     * Welds the geometry's triangle corners into mesh's vertices and indices
+     */
+    bool weldGeometry(const ParsedGeometry& geometry, bool hasNormals, bool hasTexCoords, ImportedMesh& mesh,
+            ThreadPool& pool)
+    {
+        // Weld Step 1: cut the corners into ranges of whole triangles, one task each
+        struct CornerRange
+        {
+            const CornerIndices* corners;
+            size_t count;
+            size_t firstIndex;
+        };
+        std::vector<CornerRange> ranges;
+        size_t indexCount = 0;
+        for(const std::vector<CornerIndices>& corners : geometry.chunkCorners)
+        {
+            for(size_t first = 0; first < corners.size(); first += kWeldRangeCorners)
+            {
+                size_t count = std::min(kWeldRangeCorners, corners.size() - first);
+                ranges.push_back(CornerRange{corners.data() + first, count, indexCount});
+                indexCount += count;
+            }
+        }
+
+        // Weld Step 2: weld each range on its own, in parallel
+        struct LocalWeld
+        {
+            std::vector<MeshVertex> vertices;
+            std::vector<size_t> hashes;
+            std::vector<uint32_t> indices;
+            bool valid = true;
+        };
+        std::vector<LocalWeld> localWelds(ranges.size());
+        int64_t positionCount = static_cast<int64_t>(geometry.positions.size());
+        int64_t normalCount = static_cast<int64_t>(geometry.normals.size());
+        int64_t texCoordCount = static_cast<int64_t>(geometry.texCoords.size());
+        pool.parallelFor(ranges.size(), [&](size_t rangeIdx){
+            const CornerRange& range = ranges[rangeIdx];
+            LocalWeld& local = localWelds[rangeIdx];
+            VertexWeldTable table(range.count);
+            local.indices.resize(range.count);
+            for(size_t cornerIdx = 0; cornerIdx < range.count; cornerIdx++)
+            {
+                const CornerIndices& corner = range.corners[cornerIdx];
+                if(corner.position < 0 || corner.position >= positionCount || corner.normal >= normalCount
+                   || corner.texCoord >= texCoordCount)
+                {
+                    local.valid = false;
+                    return;
+                }
+                MeshVertex vertex;
+                vertex.position = geometry.positions[corner.position];
+                vertex.normal = hasNormals && corner.normal >= 0 ? geometry.normals[corner.normal] : glm::vec3(0.0F);
+                vertex.texCoord = hasTexCoords && corner.texCoord >= 0 ? geometry.texCoords[corner.texCoord] : glm::vec2(0.0F);
+                local.indices[cornerIdx] = table.findOrAdd(vertex, hashVertex(vertex), local.vertices, local.hashes);
+            }
+        });
+        size_t localVertexTotal = 0;
+        for(const LocalWeld& local : localWelds)
+        {
+            if(!local.valid)
+            {
+                std::cerr << "failed to import mesh: a face refers to a vertex, normal or texture coord that "
+                << "doesn't exist" << std::endl;
+                return false;
+            }
+            localVertexTotal += local.vertices.size();
+        }
+
+        // Weld Step 3: merge the ranges' unique vertices through one table, reusing their hashes; this is
+        // the only serial part, and sees each range's unique vertices rather than all its corners
+        mesh.vertices.clear();
+        mesh.vertices.reserve(localVertexTotal);
+        std::vector<size_t> globalHashes;
+        globalHashes.reserve(localVertexTotal);
+        VertexWeldTable globalTable(localVertexTotal);
+        std::vector<std::vector<uint32_t>> remaps(ranges.size());
+        for(size_t rangeIdx = 0; rangeIdx < ranges.size(); rangeIdx++)
+        {
+            const LocalWeld& local = localWelds[rangeIdx];
+            remaps[rangeIdx].resize(local.vertices.size());
+            for(size_t vertexIdx = 0; vertexIdx < local.vertices.size(); vertexIdx++)
+            {
+                remaps[rangeIdx][vertexIdx] = globalTable.findOrAdd(local.vertices[vertexIdx], local.hashes[vertexIdx],
+                        mesh.vertices, globalHashes);
+            }
+        }
+
+        // Weld Step 4: rewrite the local indices as global ones, in parallel again
+        mesh.indices.resize(indexCount);
+        pool.parallelFor(ranges.size(), [&](size_t rangeIdx){
+            const std::vector<uint32_t>& localIndices = localWelds[rangeIdx].indices;
+            const std::vector<uint32_t>& remap = remaps[rangeIdx];
+            uint32_t* destination = mesh.indices.data() + ranges[rangeIdx].firstIndex;
+            for(size_t cornerIdx = 0; cornerIdx < localIndices.size(); cornerIdx++)
+            {
+                destination[cornerIdx] = remap[localIndices[cornerIdx]];
+            }
+        });
+
+        mesh.hasNormals = hasNormals;
+        mesh.hasTexCoords = hasTexCoords;
+        mesh.boundsMin = mesh.boundsMax = glm::vec3(0.0F);
+        if(!mesh.vertices.empty())
+        {
+            mesh.boundsMin = mesh.boundsMax = mesh.vertices.front().position;
+            for(const MeshVertex& vertex : mesh.vertices)
+            {
+                mesh.boundsMin = glm::min(mesh.boundsMin, vertex.position);
+                mesh.boundsMax = glm::max(mesh.boundsMax, vertex.position);
+            }
+        }
+        return true;
+    }
+
+    /// OBJ ///
+
+    /**
+     * What the first pass finds in an OBJ chunk
+     */
+    struct ObjChunkCounts
+    {
+        size_t lines = 0;
+        size_t positions = 0;
+        size_t texCoords = 0;
+        size_t normals = 0;
+    };
+
+    /**
+     * @return the kind of OBJ line starting at cursor ('v', 't' for vt, 'n' for vn, 'f', or 0 for anything
+     *         else), leaving cursor after its keyword
+     */
+    inline char classifyObjLine(const char*& cursor, const char* end)
+    {
+        skipSpaces(cursor, end);
+        if(end - cursor < 2)
+        {
+            return 0;
+        }
+        char first = cursor[0];
+        char second = cursor[1];
+        if(first == 'v' && (second == ' ' || second == '\t'))
+        {
+            cursor += 1;
+            return 'v';
+        }
+        if(first == 'f' && (second == ' ' || second == '\t'))
+        {
+            cursor += 1;
+            return 'f';
+        }
+        if(first == 'v' && (second == 't' || second == 'n') && end - cursor > 2 && (cursor[2] == ' ' || cursor[2] == '\t'))
+        {
+            cursor += 2;
+            return second;
+        }
+        return 0;
+    }
+
+    /**
+     * Turns an OBJ index, 1-based or negative relative to the count so far, into a 0-based one
+     * @return false for 0, which OBJ doesn't allow
+     */
+    inline bool resolveObjIndex(int64_t objIndex, size_t countSoFar, int64_t& index)
+    {
+        if(objIndex == 0)
+        {
+            return false;
+        }
+        index = objIndex > 0 ? objIndex - 1 : static_cast<int64_t>(countSoFar) + objIndex;
+        return true;
+    }
+
+    /**
+     * Parses an OBJ chunk's lines, writing its attributes at the offsets the first pass worked out
+     */
+    void parseObjChunk(const char* begin, const char* end, const ObjChunkCounts& offsets, ParsedGeometry& geometry,
+            std::vector<CornerIndices>& corners, ParseError& error)
+    {
+        size_t positionCount = offsets.positions;
+        size_t texCoordCount = offsets.texCoords;
+        size_t normalCount = offsets.normals;
+        size_t lineNumber = offsets.lines;
+        for(const char* line = begin; line < end; line = nextLine(line, end), lineNumber++)
+        {
+            const char* cursor = line;
+            switch(classifyObjLine(cursor, end))
+            {
+                case 'v':
+                {
+                    glm::vec3& position = geometry.positions[positionCount++];
+                    if(!parseFloat(cursor, end, position.x) || !parseFloat(cursor, end, position.y)
+                       || !parseFloat(cursor, end, position.z))
+                    {
+                        error.fail(lineNumber + 1, "expected three position components");
+                        return;
+                    }
+                    break;
+                }
+                case 't':
+                {
+                    glm::vec2& texCoord = geometry.texCoords[texCoordCount++];
+                    texCoord.y = 0.0F;
+                    if(!parseFloat(cursor, end, texCoord.x))
+                    {
+                        error.fail(lineNumber + 1, "expected texture coords");
+                        return;
+                    }
+                    // v is optional
+                    const char* optional = cursor;
+                    if(!parseFloat(optional, end, texCoord.y))
+                    {
+                        texCoord.y = 0.0F;
+                    }
+                    break;
+                }
+                case 'n':
+                {
+                    glm::vec3& normal = geometry.normals[normalCount++];
+                    if(!parseFloat(cursor, end, normal.x) || !parseFloat(cursor, end, normal.y)
+                       || !parseFloat(cursor, end, normal.z))
+                    {
+                        error.fail(lineNumber + 1, "expected three normal components");
+                        return;
+                    }
+                    break;
+                }
+                case 'f':
+                {
+                    // v, v/vt, v//vn or v/vt/vn corners, triangulated as a fan around the first
+                    CornerIndices first = {0, -1, -1};
+                    CornerIndices previous = {0, -1, -1};
+                    int cornerCount = 0;
+                    while(true)
+                    {
+                        skipSpaces(cursor, end);
+                        if(atLineEnd(cursor, end))
+                        {
+                            break;
+                        }
+                        CornerIndices corner = {0, -1, -1};
+                        int64_t objIndex = 0;
+                        bool valid = parseInteger(cursor, end, objIndex)
+                                     && resolveObjIndex(objIndex, positionCount, corner.position);
+                        if(valid && cursor < end && *cursor == '/')
+                        {
+                            cursor++;
+                            if(cursor < end && *cursor != '/')
+                            {
+                                valid = parseInteger(cursor, end, objIndex)
+                                        && resolveObjIndex(objIndex, texCoordCount, corner.texCoord);
+                            }
+                            if(valid && cursor < end && *cursor == '/')
+                            {
+                                cursor++;
+                                valid = parseInteger(cursor, end, objIndex)
+                                        && resolveObjIndex(objIndex, normalCount, corner.normal);
+                            }
+                        }
+                        if(!valid)
+                        {
+                            error.fail(lineNumber + 1, "malformed face corner");
+                            return;
+                        }
+                        if(cornerCount == 0)
+                        {
+                            first = corner;
+                        }
+                        else if(cornerCount >= 2)
+                        {
+                            corners.push_back(first);
+                            corners.push_back(previous);
+                            corners.push_back(corner);
+                        }
+                        previous = corner;
+                        cornerCount++;
+                    }
+                    if(cornerCount < 3)
+                    {
+                        error.fail(lineNumber + 1, "face with fewer than three corners");
+                        return;
+                    }
+                    break;
+                }
+                default:
+                    // comments, groups, materials, smoothing groups and the like
+                    break;
+            }
+        }
+    }
+
+    /// PLY ///
+
+    enum class PlyType
+    {
+        int8,
+        uint8,
+        int16,
+        uint16,
+        int32,
+        uint32,
+        float32,
+        float64,
+        invalid
+    };
+
+    PlyType parsePlyType(const std::string& name)
+    {
+        if(name == "char" || name == "int8") return PlyType::int8;
+        if(name == "uchar" || name == "uint8") return PlyType::uint8;
+        if(name == "short" || name == "int16") return PlyType::int16;
+        if(name == "ushort" || name == "uint16") return PlyType::uint16;
+        if(name == "int" || name == "int32") return PlyType::int32;
+        if(name == "uint" || name == "uint32") return PlyType::uint32;
+        if(name == "float" || name == "float32") return PlyType::float32;
+        if(name == "double" || name == "float64") return PlyType::float64;
+        return PlyType::invalid;
+    }
+
+    size_t getPlyTypeSize(PlyType type)
+    {
+        switch(type)
+        {
+            case PlyType::int8:
+            case PlyType::uint8:
+                return 1;
+            case PlyType::int16:
+            case PlyType::uint16:
+                return 2;
+            case PlyType::int32:
+            case PlyType::uint32:
+            case PlyType::float32:
+                return 4;
+            case PlyType::float64:
+                return 8;
+            default:
+                return 0;
+        }
+    }
+
+    /**
+     * Reads a little endian binary PLY scalar
+     */
+    template<typename T>
+    inline double readScalar(const char* source)
+    {
+        T value;
+        std::memcpy(&value, source, sizeof(T));
+        return static_cast<double>(value);
+    }
+
+    double readPlyValue(PlyType type, const char* source)
+    {
+        switch(type)
+        {
+            case PlyType::int8: return readScalar<int8_t>(source);
+            case PlyType::uint8: return readScalar<uint8_t>(source);
+            case PlyType::int16: return readScalar<int16_t>(source);
+            case PlyType::uint16: return readScalar<uint16_t>(source);
+            case PlyType::int32: return readScalar<int32_t>(source);
+            case PlyType::uint32: return readScalar<uint32_t>(source);
+            case PlyType::float32: return readScalar<float>(source);
+            case PlyType::float64: return readScalar<double>(source);
+            default: return 0.0;
+        }
+    }
+
+    struct PlyProperty
+    {
+        std::string name;
+        PlyType type;
+        bool isList;
+        /**
+         * Type of a list's length; type is then the type of its items
+         */
+        PlyType countType;
+    };
+
+    struct PlyElement
+    {
+        std::string name;
+        size_t count;
+        std::vector<PlyProperty> properties;
+    };
+
+    enum class PlyFormat
+    {
+        ascii,
+        binaryLittleEndian
+    };
+
+    struct PlyHeader
+    {
+        PlyFormat format;
+        std::vector<PlyElement> elements;
+        /**
+         * Offset of the first byte after end_header's line
+         */
+        size_t bodyOffset;
+    };
+
+    bool parsePlyHeader(const char* data, size_t size, PlyHeader& header)
+    {
+        const char* end = data + size;
+        const char* line = data;
+        bool sawFormat = false;
+        size_t lineNumber = 1;
+        for(; line < end; line = nextLine(line, end), lineNumber++)
+        {
+            const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+            std::istringstream tokens(std::string(line, lineEnd != nullptr ? lineEnd : end));
+            std::string keyword;
+            tokens >> keyword;
+            if(lineNumber == 1)
+            {
+                if(keyword != "ply")
+                {
+                    std::cerr << "failed to parse PLY: missing \"ply\" magic" << std::endl;
+                    return false;
+                }
+                continue;
+            }
+            if(keyword == "format")
+            {
+                std::string format;
+                tokens >> format;
+                if(format == "ascii")
+                {
+                    header.format = PlyFormat::ascii;
+                }
+                else if(format == "binary_little_endian")
+                {
+                    header.format = PlyFormat::binaryLittleEndian;
+                }
+                else
+                {
+                    std::cerr << "failed to parse PLY: unsupported format " << format << std::endl;
+                    return false;
+                }
+                sawFormat = true;
+            }
+            else if(keyword == "element")
+            {
+                PlyElement element;
+                tokens >> element.name >> element.count;
+                if(tokens.fail())
+                {
+                    std::cerr << "failed to parse PLY header line " << lineNumber << ": malformed element" << std::endl;
+                    return false;
+                }
+                header.elements.push_back(element);
+            }
+            else if(keyword == "property")
+            {
+                PlyProperty property;
+                std::string typeName;
+                tokens >> typeName;
+                property.isList = typeName == "list";
+                property.countType = PlyType::invalid;
+                if(property.isList)
+                {
+                    std::string countTypeName;
+                    tokens >> countTypeName >> typeName;
+                    property.countType = parsePlyType(countTypeName);
+                }
+                property.type = parsePlyType(typeName);
+                tokens >> property.name;
+                if(tokens.fail() || header.elements.empty() || property.type == PlyType::invalid
+                   || (property.isList && property.countType == PlyType::invalid))
+                {
+                    std::cerr << "failed to parse PLY header line " << lineNumber << ": malformed property" << std::endl;
+                    return false;
+                }
+                header.elements.back().properties.push_back(property);
+            }
+            else if(keyword == "end_header")
+            {
+                if(!sawFormat)
+                {
+                    std::cerr << "failed to parse PLY: no format line" << std::endl;
+                    return false;
+                }
+                header.bodyOffset = static_cast<size_t>(nextLine(line, end) - data);
+                return true;
+            }
+            // comment, obj_info and anything else we don't know are skipped
+        }
+        std::cerr << "failed to parse PLY: no end_header" << std::endl;
+        return false;
+    }
+
+    /**
+     * @return the fewest bytes an item of the element can take: in ASCII a digit and a separator per value,
+     *         in binary its scalars plus its lists' counts
+     */
+    size_t getMinimumPlyItemSize(const PlyElement& element, PlyFormat format)
+    {
+        size_t itemSize = 0;
+        for(const PlyProperty& property : element.properties)
+        {
+            itemSize += format == PlyFormat::ascii ? 2 : getPlyTypeSize(property.isList ? property.countType : property.type);
+        }
+        return itemSize;
+    }
+
+    /**
+     * Checks the header's element counts against the size of the body before anything is sized by them, so
+     * a truncated or hostile file fails here rather than in a huge allocation
+     */
+    bool checkPlyElementCounts(const PlyHeader& header, size_t size)
+    {
+        // the last ASCII item needn't end in a newline
+        size_t bodySize = size - header.bodyOffset + (header.format == PlyFormat::ascii ? 1 : 0);
+        size_t minimumBodySize = 0;
+        for(const PlyElement& element : header.elements)
+        {
+            size_t itemSize = getMinimumPlyItemSize(element, header.format);
+            if(itemSize > 0 && element.count > (bodySize - minimumBodySize) / itemSize)
+            {
+                std::cerr << "failed to parse PLY: " << element.count << " " << element.name
+                << " items can't fit in the rest of the file" << std::endl;
+                return false;
+            }
+            minimumBodySize += itemSize * element.count;
+        }
+        return true;
+    }
+
+    /**
+     * Where the vertex element's properties we want are, -1 for missing ones
+     */
+    struct PlyVertexProperties
+    {
+        int position[3] = {-1, -1, -1};
+        int normal[3] = {-1, -1, -1};
+        int texCoord[2] = {-1, -1};
+    };
+
+    PlyVertexProperties findPlyVertexProperties(const PlyElement& element)
+    {
+        PlyVertexProperties found;
+        for(size_t propertyIdx = 0; propertyIdx < element.properties.size(); propertyIdx++)
+        {
+            const std::string& name = element.properties[propertyIdx].name;
+            int index = static_cast<int>(propertyIdx);
+            if(name == "x") found.position[0] = index;
+            else if(name == "y") found.position[1] = index;
+            else if(name == "z") found.position[2] = index;
+            else if(name == "nx") found.normal[0] = index;
+            else if(name == "ny") found.normal[1] = index;
+            else if(name == "nz") found.normal[2] = index;
+            else if(name == "u" || name == "s" || name == "texture_u" || name == "texture_s") found.texCoord[0] = index;
+            else if(name == "v" || name == "t" || name == "texture_v" || name == "texture_t") found.texCoord[1] = index;
+        }
+        return found;
+    }
+
+    bool hasAll(const int* properties, size_t count)
+    {
+        return std::all_of(properties, properties + count, [](int property){ return property >= 0; });
+    }
+
+    /**
+     * Stores a vertex's wanted property values from an array of all its values
+     */
+    void storePlyVertex(const PlyVertexProperties& wanted, const float* values, size_t vertexIdx,
+            ParsedGeometry& geometry, bool hasNormals, bool hasTexCoords)
+    {
+        geometry.positions[vertexIdx] = glm::vec3(values[wanted.position[0]], values[wanted.position[1]],
+                values[wanted.position[2]]);
+        if(hasNormals)
+        {
+            geometry.normals[vertexIdx] = glm::vec3(values[wanted.normal[0]], values[wanted.normal[1]],
+                    values[wanted.normal[2]]);
+        }
+        if(hasTexCoords)
+        {
+            geometry.texCoords[vertexIdx] = glm::vec2(values[wanted.texCoord[0]], values[wanted.texCoord[1]]);
+        }
+    }
+
+    /**
+     * Appends a face's fan triangulation; PLY faces index vertices, which carry their own normals and
+     * texture coords
+     */
+    inline void appendPlyFace(const int64_t* vertexIndices, size_t count, bool hasNormals, bool hasTexCoords,
+            std::vector<CornerIndices>& corners)
+    {
+        for(size_t cornerIdx = 2; cornerIdx < count; cornerIdx++)
+        {
+            const int64_t triangle[] = {vertexIndices[0], vertexIndices[cornerIdx - 1], vertexIndices[cornerIdx]};
+            for(int64_t vertexIndex : triangle)
+            {
+                corners.push_back(CornerIndices{vertexIndex, hasTexCoords ? vertexIndex : -1, hasNormals ? vertexIndex : -1});
+            }
+        }
+    }
+
+    bool isPlyFaceList(const PlyProperty& property)
+    {
+        return property.isList && (property.name == "vertex_indices" || property.name == "vertex_index");
+    }
+
+    bool importAsciiPly(const char* data, size_t size, const PlyHeader& header, size_t vertexElement,
+            size_t faceElement, ParsedGeometry& geometry, bool hasNormals, bool hasTexCoords, ThreadPool& pool)
+    {
+        const PlyElement& vertices = header.elements[vertexElement];
+        PlyVertexProperties wanted = findPlyVertexProperties(vertices);
+        // every element is one line per item, so an item's global line number says which element it's in
+        std::vector<size_t> elementFirstLine(header.elements.size() + 1, 0);
+        for(size_t elementIdx = 0; elementIdx < header.elements.size(); elementIdx++)
+        {
+            elementFirstLine[elementIdx + 1] = elementFirstLine[elementIdx] + header.elements[elementIdx].count;
+        }
+
+        // Parse Step 1: count each chunk's lines, so chunks know their first line's number
+        std::vector<size_t> boundaries = splitAtLines(data, header.bodyOffset, size);
+        size_t chunkCount = boundaries.size() - 1;
+        std::vector<size_t> chunkFirstLine(chunkCount + 1, 0);
+        pool.parallelFor(chunkCount, [&](size_t chunkIdx){
+            chunkFirstLine[chunkIdx + 1] = countLines(data + boundaries[chunkIdx], data + boundaries[chunkIdx + 1]);
+        });
+        for(size_t chunkIdx = 0; chunkIdx < chunkCount; chunkIdx++)
+        {
+            chunkFirstLine[chunkIdx + 1] += chunkFirstLine[chunkIdx];
+        }
+        if(chunkFirstLine[chunkCount] < elementFirstLine[std::max(vertexElement, faceElement) + 1])
+        {
+            std::cerr << "failed to parse PLY: the file ends before its last vertex or face" << std::endl;
+            return false;
+        }
+
+        // Parse Step 2: parse the vertex and face lines of every chunk
+        geometry.chunkCorners.assign(chunkCount, std::vector<CornerIndices>());
+        std::vector<ParseError> errors(chunkCount);
+        size_t headerLines = countLines(data, data + header.bodyOffset);
+        pool.parallelFor(chunkCount, [&](size_t chunkIdx){
+            const char* end = data + boundaries[chunkIdx + 1];
+            std::vector<float> values;
+            std::vector<int64_t> faceIndices;
+            size_t lineNumber = chunkFirstLine[chunkIdx];
+            for(const char* line = data + boundaries[chunkIdx]; line < end; line = nextLine(line, end), lineNumber++)
+            {
+                const char* cursor = line;
+                if(lineNumber >= elementFirstLine[vertexElement] && lineNumber < elementFirstLine[vertexElement + 1])
+                {
+                    values.assign(vertices.properties.size(), 0.0F);
+                    for(size_t propertyIdx = 0; propertyIdx < vertices.properties.size(); propertyIdx++)
+                    {
+                        bool parsed = true;
+                        if(vertices.properties[propertyIdx].isList)
+                        {
+                            int64_t count = 0;
+                            float ignored;
+                            parsed = parseInteger(cursor, end, count);
+                            for(int64_t itemIdx = 0; parsed && itemIdx < count; itemIdx++)
+                            {
+                                parsed = parseFloat(cursor, end, ignored);
+                            }
+                        }
+                        else
+                        {
+                            parsed = parseFloat(cursor, end, values[propertyIdx]);
+                        }
+                        if(!parsed)
+                        {
+                            errors[chunkIdx].fail(headerLines + lineNumber + 1, "malformed vertex");
+                            return;
+                        }
+                    }
+                    storePlyVertex(wanted, values.data(), lineNumber - elementFirstLine[vertexElement], geometry,
+                            hasNormals, hasTexCoords);
+                }
+                else if(lineNumber >= elementFirstLine[faceElement] && lineNumber < elementFirstLine[faceElement + 1])
+                {
+                    for(const PlyProperty& property : header.elements[faceElement].properties)
+                    {
+                        bool parsed = true;
+                        int64_t count = 1;
+                        if(property.isList)
+                        {
+                            // every item takes at least a digit and a separator, which bounds the allocation
+                            parsed = parseInteger(cursor, end, count) && count <= (end - cursor) / 2 + 1;
+                        }
+                        faceIndices.resize(parsed ? static_cast<size_t>(std::max<int64_t>(count, 0)) : 0);
+                        for(size_t itemIdx = 0; parsed && itemIdx < faceIndices.size(); itemIdx++)
+                        {
+                            float value;
+                            parsed = parseFloat(cursor, end, value);
+                            faceIndices[itemIdx] = static_cast<int64_t>(value);
+                        }
+                        if(!parsed)
+                        {
+                            errors[chunkIdx].fail(headerLines + lineNumber + 1, "malformed face");
+                            return;
+                        }
+                        if(isPlyFaceList(property))
+                        {
+                            appendPlyFace(faceIndices.data(), faceIndices.size(), hasNormals, hasTexCoords,
+                                    geometry.chunkCorners[chunkIdx]);
+                        }
+                    }
+                }
+            }
+        });
+        return !reportFirstError(errors, "PLY");
+    }
+
+    /**
+     * @return the size of one item of a binary PLY element, or 0 if its items vary in size
+     */
+    size_t getFixedPlyItemSize(const PlyElement& element)
+    {
+        size_t itemSize = 0;
+        for(const PlyProperty& property : element.properties)
+        {
+            if(property.isList)
+            {
+                return 0;
+            }
+            itemSize += getPlyTypeSize(property.type);
+        }
+        return itemSize;
+    }
+
+    /**
+     * Walks a binary PLY element's items, calling visitList(property, count, items) for every list and
+     * visitItemEnd() after every item
+     * @return the offset after the element, or SIZE_MAX if the file ends first
+     */
+    template<typename ListVisitor>
+    size_t walkBinaryPlyElement(const char* data, size_t size, size_t offset, const PlyElement& element,
+            ListVisitor visitList)
+    {
+        for(size_t itemIdx = 0; itemIdx < element.count; itemIdx++)
+        {
+            for(const PlyProperty& property : element.properties)
+            {
+                if(!property.isList)
+                {
+                    offset += getPlyTypeSize(property.type);
+                    continue;
+                }
+                size_t countSize = getPlyTypeSize(property.countType);
+                if(offset + countSize > size)
+                {
+                    return SIZE_MAX;
+                }
+                double count = readPlyValue(property.countType, data + offset);
+                offset += countSize;
+                size_t listSize = static_cast<size_t>(std::max(count, 0.0)) * getPlyTypeSize(property.type);
+                if(offset + listSize > size)
+                {
+                    return SIZE_MAX;
+                }
+                visitList(property, static_cast<size_t>(std::max(count, 0.0)), data + offset);
+                offset += listSize;
+            }
+            if(offset > size)
+            {
+                return SIZE_MAX;
+            }
+        }
+        return offset;
+    }
+
+    bool importBinaryPly(const char* data, size_t size, const PlyHeader& header, size_t vertexElement,
+            size_t faceElement, ParsedGeometry& geometry, bool hasNormals, bool hasTexCoords, ThreadPool& pool)
+    {
+        geometry.chunkCorners.assign(1, std::vector<CornerIndices>());
+        std::vector<CornerIndices>& corners = geometry.chunkCorners.front();
+        std::vector<int64_t> faceIndices;
+        size_t offset = header.bodyOffset;
+        for(size_t elementIdx = 0; elementIdx < header.elements.size() && offset != SIZE_MAX; elementIdx++)
+        {
+            const PlyElement& element = header.elements[elementIdx];
+            size_t itemSize = getFixedPlyItemSize(element);
+            if(elementIdx == vertexElement)
+            {
+                // fixed size vertices are converted in parallel ranges straight from the mapped file
+                if(itemSize == 0 || offset + itemSize * element.count > size)
+                {
+                    std::cerr << "failed to parse PLY: vertices with list properties or past the end of the file"
+                    << std::endl;
+                    return false;
+                }
+                PlyVertexProperties wanted = findPlyVertexProperties(element);
+                std::vector<size_t> propertyOffsets;
+                size_t propertyOffset = 0;
+                for(const PlyProperty& property : element.properties)
+                {
+                    propertyOffsets.push_back(propertyOffset);
+                    propertyOffset += getPlyTypeSize(property.type);
+                }
+                size_t elementOffset = offset;
+                size_t rangeCount = (element.count + kBinaryVertexRange - 1) / kBinaryVertexRange;
+                pool.parallelFor(rangeCount, [&](size_t rangeIdx){
+                    std::vector<float> values(element.properties.size());
+                    size_t firstVertex = rangeIdx * kBinaryVertexRange;
+                    size_t lastVertex = std::min(firstVertex + kBinaryVertexRange, element.count);
+                    for(size_t vertexIdx = firstVertex; vertexIdx < lastVertex; vertexIdx++)
+                    {
+                        const char* item = data + elementOffset + vertexIdx * itemSize;
+                        for(size_t propertyIdx = 0; propertyIdx < values.size(); propertyIdx++)
+                        {
+                            values[propertyIdx] = static_cast<float>(readPlyValue(element.properties[propertyIdx].type,
+                                    item + propertyOffsets[propertyIdx]));
+                        }
+                        storePlyVertex(wanted, values.data(), vertexIdx, geometry, hasNormals, hasTexCoords);
+                    }
+                });
+                offset += itemSize * element.count;
+            }
+            else if(elementIdx == faceElement)
+            {
+                // faces vary in size, so finding one means reading all before it; this walk stays serial
+                offset = walkBinaryPlyElement(data, size, offset, element,
+                        [&](const PlyProperty& property, size_t count, const char* items){
+                    if(!isPlyFaceList(property))
+                    {
+                        return;
+                    }
+                    size_t itemTypeSize = getPlyTypeSize(property.type);
+                    faceIndices.resize(count);
+                    for(size_t itemIdx = 0; itemIdx < count; itemIdx++)
+                    {
+                        faceIndices[itemIdx] = static_cast<int64_t>(readPlyValue(property.type, items + itemIdx * itemTypeSize));
+                    }
+                    appendPlyFace(faceIndices.data(), count, hasNormals, hasTexCoords, corners);
+                });
+            }
+            else if(elementIdx < std::max(vertexElement, faceElement))
+            {
+                offset = itemSize > 0 ? offset + itemSize * element.count
+                                      : walkBinaryPlyElement(data, size, offset, element,
+                                                             [](const PlyProperty&, size_t, const char*){});
+            }
+        }
+        if(offset == SIZE_MAX || offset > size)
+        {
+            std::cerr << "failed to parse PLY: the file ends before its last vertex or face" << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+
+bool importObj(const char* data, size_t size, ImportedMesh& mesh, ThreadPool& pool)
+{
+    // Parse Step 1: count each chunk's lines and attributes, in parallel
+    std::vector<size_t> boundaries = splitAtLines(data, 0, size);
+    size_t chunkCount = boundaries.size() - 1;
+    std::vector<ObjChunkCounts> chunkOffsets(chunkCount + 1);
+    pool.parallelFor(chunkCount, [&](size_t chunkIdx){
+        ObjChunkCounts& counts = chunkOffsets[chunkIdx + 1];
+        const char* end = data + boundaries[chunkIdx + 1];
+        for(const char* line = data + boundaries[chunkIdx]; line < end; line = nextLine(line, end))
+        {
+            const char* cursor = line;
+            switch(classifyObjLine(cursor, end))
+            {
+                case 'v': counts.positions++; break;
+                case 't': counts.texCoords++; break;
+                case 'n': counts.normals++; break;
+                default: break;
+            }
+            counts.lines++;
+        }
+    });
+    // prefix sums turn the counts into each chunk's first line and first attribute of each kind
+    for(size_t chunkIdx = 0; chunkIdx < chunkCount; chunkIdx++)
+    {
+        chunkOffsets[chunkIdx + 1].lines += chunkOffsets[chunkIdx].lines;
+        chunkOffsets[chunkIdx + 1].positions += chunkOffsets[chunkIdx].positions;
+        chunkOffsets[chunkIdx + 1].texCoords += chunkOffsets[chunkIdx].texCoords;
+        chunkOffsets[chunkIdx + 1].normals += chunkOffsets[chunkIdx].normals;
+    }
+
+    // Parse Step 2: parse every chunk straight into place, in parallel
+    ParsedGeometry geometry;
+    geometry.positions.resize(chunkOffsets[chunkCount].positions);
+    geometry.texCoords.resize(chunkOffsets[chunkCount].texCoords);
+    geometry.normals.resize(chunkOffsets[chunkCount].normals);
+    geometry.chunkCorners.resize(chunkCount);
+    std::vector<ParseError> errors(chunkCount);
+    pool.parallelFor(chunkCount, [&](size_t chunkIdx){
+        parseObjChunk(data + boundaries[chunkIdx], data + boundaries[chunkIdx + 1], chunkOffsets[chunkIdx], geometry,
+                geometry.chunkCorners[chunkIdx], errors[chunkIdx]);
+    });
+    if(reportFirstError(errors, "OBJ"))
+    {
+        return false;
+    }
+
+    // Parse Step 3: weld the corners into vertices
+    return weldGeometry(geometry, !geometry.normals.empty(), !geometry.texCoords.empty(), mesh, pool);
+}
+
+bool importPly(const char* data, size_t size, ImportedMesh& mesh, ThreadPool& pool)
+{
+    PlyHeader header;
+    if(!parsePlyHeader(data, size, header))
+    {
+        return false;
+    }
+    size_t vertexElement = SIZE_MAX;
+    size_t faceElement = SIZE_MAX;
+    for(size_t elementIdx = 0; elementIdx < header.elements.size(); elementIdx++)
+    {
+        if(header.elements[elementIdx].name == "vertex")
+        {
+            vertexElement = elementIdx;
+        }
+        else if(header.elements[elementIdx].name == "face")
+        {
+            faceElement = elementIdx;
+        }
+    }
+    if(vertexElement == SIZE_MAX || faceElement == SIZE_MAX)
+    {
+        std::cerr << "failed to parse PLY: it needs both vertex and face elements" << std::endl;
+        return false;
+    }
+    const std::vector<PlyProperty>& faceProperties = header.elements[faceElement].properties;
+    if(std::none_of(faceProperties.begin(), faceProperties.end(), isPlyFaceList))
+    {
+        std::cerr << "failed to parse PLY: faces have no vertex_indices list" << std::endl;
+        return false;
+    }
+    PlyVertexProperties wanted = findPlyVertexProperties(header.elements[vertexElement]);
+    if(!hasAll(wanted.position, 3))
+    {
+        std::cerr << "failed to parse PLY: vertices have no x, y and z" << std::endl;
+        return false;
+    }
+    bool hasNormals = hasAll(wanted.normal, 3);
+    bool hasTexCoords = hasAll(wanted.texCoord, 2);
+    if(!checkPlyElementCounts(header, size))
+    {
+        return false;
+    }
+
+    ParsedGeometry geometry;
+    size_t vertexCount = header.elements[vertexElement].count;
+    geometry.positions.resize(vertexCount);
+    geometry.normals.resize(hasNormals ? vertexCount : 0);
+    geometry.texCoords.resize(hasTexCoords ? vertexCount : 0);
+    bool parsed = header.format == PlyFormat::ascii
+            ? importAsciiPly(data, size, header, vertexElement, faceElement, geometry, hasNormals, hasTexCoords, pool)
+            : importBinaryPly(data, size, header, vertexElement, faceElement, geometry, hasNormals, hasTexCoords, pool);
+    return parsed && weldGeometry(geometry, hasNormals, hasTexCoords, mesh, pool);
+}
+
+bool importMesh(const std::string& path, ImportedMesh& mesh, ThreadPool& pool, bool optimize,
+        MeshOptimizationReport* report)
+{
+    std::string extension = path.substr(std::min(path.rfind('.'), path.size()));
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char character){
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+    });
+    if(extension != ".obj" && extension != ".ply")
+    {
+        std::cerr << "can't import " << path << ": only .obj and .ply meshes are supported" << std::endl;
+        return false;
+    }
+    MappedFile file;
+    if(!file.open(path))
+    {
+        return false;
+    }
+    bool imported = extension == ".obj" ? importObj(file.data(), file.size(), mesh, pool)
+                                        : importPly(file.data(), file.size(), mesh, pool);
+    if(!imported)
+    {
+        std::cerr << "failed to import " << path << std::endl;
+        return false;
+    }
+    if(optimize)
+    {
+        MeshOptimizationReport optimizationReport = optimizeImportedMesh(mesh);
+        if(report != nullptr)
+        {
+            *report = optimizationReport;
+        }
+    }
+    return true;
+}
+
+MeshOptimizationReport optimizeImportedMesh(ImportedMesh& mesh)
+{
+    MeshOptimizationReport report;
+    report.cacheBefore = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    report.overfetchBefore = analyzeVertexFetch(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(),
+            sizeof(MeshVertex));
+    optimizeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    optimizeOverdraw(mesh.indices.data(), mesh.indices.size(), &mesh.vertices.data()->position.x, sizeof(MeshVertex),
+            mesh.vertices.size());
+    size_t vertexCount = optimizeVertexFetch(mesh.vertices.data(), mesh.vertices.size(), sizeof(MeshVertex),
+            mesh.indices.data(), mesh.indices.size());
+    mesh.vertices.resize(vertexCount);
+    report.cacheAfter = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    report.overfetchAfter = analyzeVertexFetch(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(),
+            sizeof(MeshVertex));
+    return report;
+}
+
+IndexedVertexArray createMeshVertexArray(const ImportedMesh& mesh)
+{
+    IndexedVertexArray vertexArray;
+    vertexArray.vbo = createBuffer(sizeof(MeshVertex) * mesh.vertices.size(), mesh.vertices.data(), 0);
+    vertexArray.ebo = createBuffer(sizeof(uint32_t) * mesh.indices.size(), mesh.indices.data(), 0);
+    vertexArray.vao = createVertexArray();
+    applyVertexLayout<MeshVertex>(vertexArray.vao, 0, vertexArray.vbo, 0);
+    setElementBuffer(vertexArray.vao, vertexArray.ebo);
+    return vertexArray;
+}
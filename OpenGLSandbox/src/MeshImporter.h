@@ -0,0 +1,113 @@
+#ifndef OPENGLSANDBOX_MESHIMPORTER_H
+#define OPENGLSANDBOX_MESHIMPORTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "GLResources.h"
+#include "MeshOptimization.h"
+#include "VertexLayout.h"
+
+class ThreadPool;
+
+/*
+ * Wavefront OBJ and PLY (ASCII and binary little endian) mesh import.  Files are memory-mapped and cut into
+ * chunks at line boundaries that a ThreadPool parses in parallel, with hand-rolled number parsing that only
+ * falls back to strtof for the rare number it can't round exactly (only the short PLY header goes through
+ * iostreams).  A first parallel pass counts each chunk's lines of every kind, so the second knows
+ * where its elements land globally (and can resolve OBJ's relative indices) without any chunk waiting on
+ * another.  Faces are triangulated as fans, and every triangle corner's position, normal and texture coords
+ * are then welded into unique interleaved MeshVertex vertices through hash tables: each chunk welds its own
+ * corners in parallel, and only the chunks' unique vertices go through the one shared table.  By default the
+ * result is then put through the MeshOptimization passes, in file order being arbitrary.
+ */
+
+/**
+ * Interleaved position, normal and texture coords, ready to upload as one vertex buffer
+ */
+struct MeshVertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoord;
+};
+
+template<>
+struct VertexLayout<MeshVertex>
+{
+    static constexpr GLuint divisor = 0;
+    static constexpr std::array<VertexAttribute, 3> attributes()
+    {
+        return {{
+                VERTEX_ATTRIBUTE(MeshVertex, position, 0),
+                VERTEX_ATTRIBUTE(MeshVertex, normal, 1),
+                VERTEX_ATTRIBUTE(MeshVertex, texCoord, 2)
+        }};
+    }
+};
+
+/**
+ * A triangle list over welded vertices
+ */
+struct ImportedMesh
+{
+    std::vector<MeshVertex> vertices;
+    /**
+     * Three per triangle
+     */
+    std::vector<uint32_t> indices;
+    glm::vec3 boundsMin = glm::vec3(0.0F);
+    glm::vec3 boundsMax = glm::vec3(0.0F);
+    /**
+     * Whether the file had normals and texture coords; where it didn't, they're zero
+     */
+    bool hasNormals = false;
+    bool hasTexCoords = false;
+};
+
+/**
+ * Vertex cache and fetch metrics of a mesh before and after optimizeImportedMesh()
+ */
+struct MeshOptimizationReport
+{
+    VertexCacheStatistics cacheBefore;
+    VertexCacheStatistics cacheAfter;
+    float overfetchBefore = 0.0F;
+    float overfetchAfter = 0.0F;
+};
+
+/**
+ * Imports an .obj or .ply file, chosen by the path's extension
+ * @param mesh replaced with the file's contents
+ * @param optimize whether to run optimizeImportedMesh() on the result
+ * @param report if not null and optimize is set, receives optimizeImportedMesh()'s report
+ * @return false if the file couldn't be read or parsed (see std::cerr)
+ */
+bool importMesh(const std::string& path, ImportedMesh& mesh, ThreadPool& pool, bool optimize = true,
+        MeshOptimizationReport* report = nullptr);
+/**
+ * Parses Wavefront OBJ text: v, vt, vn and f lines, with negative (relative) indices; everything else,
+ * including groups and materials, is skipped
+ */
+bool importObj(const char* data, size_t size, ImportedMesh& mesh, ThreadPool& pool);
+/**
+ * Parses an ASCII or binary little endian PLY file's vertex (x, y, z, nx, ny, nz and u, v or s, t) and face
+ * (vertex_indices or vertex_index lists) elements; other properties and elements are skipped
+ */
+bool importPly(const char* data, size_t size, ImportedMesh& mesh, ThreadPool& pool);
+
+/**
+ * Reorders a mesh's triangles for the vertex cache and for overdraw, then its vertices for fetch locality
+ */
+MeshOptimizationReport optimizeImportedMesh(ImportedMesh& mesh);
+
+/**
+ * Uploads a mesh into new immutable buffers behind a VAO laid out for MeshVertex; must be called on the
+ * thread owning the current GL context
+ */
+IndexedVertexArray createMeshVertexArray(const ImportedMesh& mesh);
+
+
+#endif //OPENGLSANDBOX_MESHIMPORTER_H
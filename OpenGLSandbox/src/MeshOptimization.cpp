@@ -0,0 +1,519 @@
+#include "MeshOptimization.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace
+{
+    /**
+     * Forsyth's tuning constants; the cache here is the one the scoring models, bigger than real ones so
+     * vertices keep some pull for a while after falling out of them
+     */
+    const int kForsythCacheSize = 32;
+    const float kCacheDecayPower = 1.5F;
+    const float kLastTriangleScore = 0.75F;
+    const float kValenceBoostScale = 2.0F;
+    const float kValenceBoostPower = 0.5F;
+    const size_t kValenceScoreTableSize = 64;
+
+    /**
+     * FIFO post-transform cache of cacheSize entries, tracked as the time each vertex was last transformed
+     * rather than as a queue: a vertex is still cached while fewer than cacheSize transforms came after it
+     */
+    class FifoVertexCache
+    {
+    private:
+        std::vector<uint64_t> mTransformedAt;
+        uint64_t mTime;
+        unsigned int mCacheSize;
+    public:
+        FifoVertexCache(size_t vertexCount, unsigned int cacheSize)
+                : mTransformedAt(vertexCount, 0), mTime(cacheSize + 1), mCacheSize(cacheSize)
+        {
+        }
+
+        /**
+         * @return 1 if the vertex had to be transformed, 0 if it was cached
+         */
+        unsigned int access(uint32_t vertex)
+        {
+            if(mTime - mTransformedAt[vertex] > mCacheSize)
+            {
+                mTransformedAt[vertex] = mTime++;
+                return 1;
+            }
+            return 0;
+        }
+
+        void reset()
+        {
+            mTime += mCacheSize + 1;
+        }
+    };
+
+    /**
+     * Forsyth's vertex scores, tabulated by cache position and by live triangle count
+     */
+    struct ForsythScoreTables
+    {
+        float cache[kForsythCacheSize];
+        float valence[kValenceScoreTableSize];
+
+        ForsythScoreTables()
+        {
+            for(int position = 0; position < kForsythCacheSize; position++)
+            {
+                // the last triangle's vertices get a fixed score, a bit below the next ones', so the next
+                // triangle doesn't just reuse the same edge and make long thin strips
+                cache[position] = position < 3
+                        ? kLastTriangleScore
+                        : std::pow(1.0F - static_cast<float>(position - 3) / (kForsythCacheSize - 3), kCacheDecayPower);
+            }
+            valence[0] = 0.0F;
+            for(size_t liveTriangles = 1; liveTriangles < kValenceScoreTableSize; liveTriangles++)
+            {
+                valence[liveTriangles] = kValenceBoostScale * std::pow(static_cast<float>(liveTriangles), -kValenceBoostPower);
+            }
+        }
+
+        float score(int cachePosition, uint32_t liveTriangles) const
+        {
+            if(liveTriangles == 0)
+            {
+                return 0.0F;
+            }
+            float cacheScore = cachePosition >= 0 ? cache[cachePosition] : 0.0F;
+            float valenceScore = liveTriangles < kValenceScoreTableSize
+                    ? valence[liveTriangles]
+                    : kValenceBoostScale * std::pow(static_cast<float>(liveTriangles), -kValenceBoostPower);
+            return cacheScore + valenceScore;
+        }
+    };
+
+    /**
+     * Finds a live triangle before triangleLimit with the directed edge from -> to along its winding
+     * @return the triangle, or UINT32_MAX if there's none; third receives its remaining vertex
+     */
+    uint32_t findTriangleWithEdge(const TriangleAdjacency& adjacency, const uint32_t* indices, uint32_t from,
+            uint32_t to, size_t triangleLimit, uint32_t& third)
+    {
+        const uint32_t* live = adjacency.getLiveTriangles(from);
+        for(uint32_t liveIdx = 0; liveIdx < adjacency.getLiveCount(from); liveIdx++)
+        {
+            if(live[liveIdx] >= triangleLimit)
+            {
+                continue;
+            }
+            const uint32_t* corners = indices + static_cast<size_t>(live[liveIdx]) * 3;
+            for(int corner = 0; corner < 3; corner++)
+            {
+                if(corners[corner] == from && corners[(corner + 1) % 3] == to)
+                {
+                    third = corners[(corner + 2) % 3];
+                    return live[liveIdx];
+                }
+            }
+        }
+        return UINT32_MAX;
+    }
+
+    inline glm::vec3 loadPosition(const float* positions, size_t positionStride, uint32_t vertex)
+    {
+        const float* position = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions)
+                + static_cast<size_t>(vertex) * positionStride);
+        return glm::vec3(position[0], position[1], position[2]);
+    }
+}
+
+TriangleAdjacency::TriangleAdjacency(const uint32_t* indices, size_t triangleCount, size_t vertexCount)
+        : mOffsets(vertexCount + 1, 0), mTriangles(triangleCount * 3), mLiveCounts(vertexCount, 0)
+{
+    for(size_t indexIdx = 0; indexIdx < triangleCount * 3; indexIdx++)
+    {
+        mLiveCounts[indices[indexIdx]]++;
+    }
+    std::partial_sum(mLiveCounts.begin(), mLiveCounts.end(), mOffsets.begin() + 1);
+    std::vector<size_t> fillOffsets(mOffsets.begin(), mOffsets.end() - 1);
+    for(size_t indexIdx = 0; indexIdx < triangleCount * 3; indexIdx++)
+    {
+        mTriangles[fillOffsets[indices[indexIdx]]++] = static_cast<uint32_t>(indexIdx / 3);
+    }
+}
+
+VertexCacheStatistics analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+        unsigned int cacheSize)
+{
+    VertexCacheStatistics statistics;
+    FifoVertexCache cache(vertexCount, cacheSize);
+    std::vector<uint8_t> referenced(vertexCount, 0);
+    size_t referencedCount = 0;
+    for(size_t indexIdx = 0; indexIdx < indexCount; indexIdx++)
+    {
+        statistics.transformedVertices += cache.access(indices[indexIdx]);
+        referencedCount += referenced[indices[indexIdx]] == 0 ? 1 : 0;
+        referenced[indices[indexIdx]] = 1;
+    }
+    size_t triangleCount = indexCount / 3;
+    statistics.acmr = triangleCount > 0 ? static_cast<float>(statistics.transformedVertices) / triangleCount : 0.0F;
+    statistics.atvr = referencedCount > 0 ? static_cast<float>(statistics.transformedVertices) / referencedCount : 0.0F;
+    return statistics;
+}
+
+float analyzeVertexFetch(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t vertexSize)
+{
+    const size_t kLineSize = 64;
+    const size_t kLineCount = 256;
+    // line address + 1 held by each slot, 0 when empty
+    std::vector<size_t> lineTags(kLineCount, 0);
+    FifoVertexCache cache(vertexCount, 16);
+    std::vector<uint8_t> referenced(vertexCount, 0);
+    size_t referencedCount = 0;
+    size_t bytesFetched = 0;
+    for(size_t indexIdx = 0; indexIdx < indexCount; indexIdx++)
+    {
+        uint32_t vertex = indices[indexIdx];
+        referencedCount += referenced[vertex] == 0 ? 1 : 0;
+        referenced[vertex] = 1;
+        if(cache.access(vertex) == 0)
+        {
+            continue;
+        }
+        size_t firstLine = vertex * vertexSize / kLineSize;
+        size_t lastLine = (vertex * vertexSize + vertexSize - 1) / kLineSize;
+        for(size_t line = firstLine; line <= lastLine; line++)
+        {
+            size_t& tag = lineTags[line % kLineCount];
+            if(tag != line + 1)
+            {
+                tag = line + 1;
+                bytesFetched += kLineSize;
+            }
+        }
+    }
+    return referencedCount > 0 ? static_cast<float>(bytesFetched) / static_cast<float>(referencedCount * vertexSize) : 0.0F;
+}
+
+void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+    size_t triangleCount = indexCount / 3;
+    if(triangleCount == 0)
+    {
+        return;
+    }
+    static const ForsythScoreTables kScores;
+
+    // Optimise Step 1: list every vertex's triangles
+    TriangleAdjacency adjacency(indices, triangleCount, vertexCount);
+
+    // Optimise Step 2: score every vertex and triangle
+    std::vector<float> vertexScores(vertexCount);
+    for(size_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        vertexScores[vertex] = kScores.score(-1, adjacency.getLiveCount(static_cast<uint32_t>(vertex)));
+    }
+    std::vector<float> triangleScores(triangleCount);
+    for(size_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        const uint32_t* corners = indices + triangle * 3;
+        triangleScores[triangle] = vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+    }
+    size_t bestTriangle = static_cast<size_t>(std::max_element(triangleScores.begin(), triangleScores.end())
+            - triangleScores.begin());
+
+    // Optimise Step 3: emit the best triangle, then rescore the cache's vertices and look for the next best
+    // among their triangles; if they have none left, carry on from the first triangle not yet emitted
+    std::vector<uint32_t> output;
+    output.reserve(triangleCount * 3);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    size_t deadEndCursor = 0;
+    uint32_t cache[kForsythCacheSize + 3];
+    size_t cacheCount = 0;
+    uint32_t newCache[kForsythCacheSize + 3];
+    for(size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+    {
+        if(bestTriangle == SIZE_MAX)
+        {
+            while(emitted[deadEndCursor])
+            {
+                deadEndCursor++;
+            }
+            bestTriangle = deadEndCursor;
+        }
+        const uint32_t* corners = indices + bestTriangle * 3;
+        emitted[bestTriangle] = 1;
+        output.insert(output.end(), corners, corners + 3);
+        for(int corner = 0; corner < 3; corner++)
+        {
+            adjacency.retire(corners[corner], static_cast<uint32_t>(bestTriangle));
+        }
+
+        // the triangle's vertices go to the front of the cache, everything else moves back
+        size_t newCount = 0;
+        for(int corner = 0; corner < 3; corner++)
+        {
+            if(std::find(newCache, newCache + newCount, corners[corner]) == newCache + newCount)
+            {
+                newCache[newCount++] = corners[corner];
+            }
+        }
+        for(size_t cacheIdx = 0; cacheIdx < cacheCount; cacheIdx++)
+        {
+            if(cache[cacheIdx] != corners[0] && cache[cacheIdx] != corners[1] && cache[cacheIdx] != corners[2])
+            {
+                newCache[newCount++] = cache[cacheIdx];
+            }
+        }
+
+        // rescore the vertices, including the ones just pushed out, and pass the change on to their triangles
+        for(size_t cacheIdx = 0; cacheIdx < newCount; cacheIdx++)
+        {
+            uint32_t vertex = newCache[cacheIdx];
+            int position = cacheIdx < static_cast<size_t>(kForsythCacheSize) ? static_cast<int>(cacheIdx) : -1;
+            float score = kScores.score(position, adjacency.getLiveCount(vertex));
+            float delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+            const uint32_t* live = adjacency.getLiveTriangles(vertex);
+            for(uint32_t liveIdx = 0; liveIdx < adjacency.getLiveCount(vertex); liveIdx++)
+            {
+                triangleScores[live[liveIdx]] += delta;
+            }
+        }
+        cacheCount = std::min(newCount, static_cast<size_t>(kForsythCacheSize));
+        std::copy(newCache, newCache + cacheCount, cache);
+
+        bestTriangle = SIZE_MAX;
+        float bestScore = -1.0F;
+        for(size_t cacheIdx = 0; cacheIdx < cacheCount; cacheIdx++)
+        {
+            uint32_t vertex = cache[cacheIdx];
+            const uint32_t* live = adjacency.getLiveTriangles(vertex);
+            for(uint32_t liveIdx = 0; liveIdx < adjacency.getLiveCount(vertex); liveIdx++)
+            {
+                if(triangleScores[live[liveIdx]] > bestScore)
+                {
+                    bestScore = triangleScores[live[liveIdx]];
+                    bestTriangle = live[liveIdx];
+                }
+            }
+        }
+    }
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void optimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride,
+        size_t vertexCount, float threshold)
+{
+    size_t triangleCount = indexCount / 3;
+    if(triangleCount < 2)
+    {
+        return;
+    }
+    FifoVertexCache cache(vertexCount, 16);
+    auto triangleMisses = [&](size_t triangle){
+        return cache.access(indices[triangle * 3]) + cache.access(indices[triangle * 3 + 1])
+               + cache.access(indices[triangle * 3 + 2]);
+    };
+
+    // Overdraw Step 1: hard boundaries, where the cache order restarted and a triangle misses on every vertex
+    std::vector<size_t> hardBoundaries;
+    for(size_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        if(triangleMisses(triangle) == 3 || triangle == 0)
+        {
+            hardBoundaries.push_back(triangle);
+        }
+    }
+    hardBoundaries.push_back(triangleCount);
+
+    // Overdraw Step 2: split each hard cluster again as soon as the part so far is within threshold of the
+    // whole cluster's ACMR, with the cache cold at each split the way it would be after reordering
+    std::vector<size_t> clusterStarts;
+    for(size_t hardIdx = 0; hardIdx + 1 < hardBoundaries.size(); hardIdx++)
+    {
+        size_t start = hardBoundaries[hardIdx];
+        size_t end = hardBoundaries[hardIdx + 1];
+        cache.reset();
+        size_t clusterMisses = 0;
+        for(size_t triangle = start; triangle < end; triangle++)
+        {
+            clusterMisses += triangleMisses(triangle);
+        }
+        float targetAcmr = static_cast<float>(clusterMisses) / static_cast<float>(end - start) * threshold;
+
+        cache.reset();
+        size_t subStart = start;
+        size_t subMisses = 0;
+        clusterStarts.push_back(start);
+        for(size_t triangle = start; triangle + 1 < end; triangle++)
+        {
+            subMisses += triangleMisses(triangle);
+            if(static_cast<float>(subMisses) <= targetAcmr * static_cast<float>(triangle + 1 - subStart))
+            {
+                subStart = triangle + 1;
+                subMisses = 0;
+                cache.reset();
+                clusterStarts.push_back(subStart);
+            }
+        }
+    }
+    clusterStarts.push_back(triangleCount);
+    size_t clusterCount = clusterStarts.size() - 1;
+
+    // Overdraw Step 3: key each cluster by how far its area-weighted centroid lies out from the mesh's
+    // along its average normal
+    std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3(0.0F));
+    std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0F));
+    glm::vec3 meshCentroid(0.0F);
+    float meshArea = 0.0F;
+    for(size_t clusterIdx = 0; clusterIdx < clusterCount; clusterIdx++)
+    {
+        float clusterArea = 0.0F;
+        for(size_t triangle = clusterStarts[clusterIdx]; triangle < clusterStarts[clusterIdx + 1]; triangle++)
+        {
+            glm::vec3 a = loadPosition(positions, positionStride, indices[triangle * 3]);
+            glm::vec3 b = loadPosition(positions, positionStride, indices[triangle * 3 + 1]);
+            glm::vec3 c = loadPosition(positions, positionStride, indices[triangle * 3 + 2]);
+            glm::vec3 normal = glm::cross(b - a, c - a);
+            float area = glm::length(normal);
+            clusterCentroids[clusterIdx] += (a + b + c) * (area / 3.0F);
+            clusterNormals[clusterIdx] += normal;
+            clusterArea += area;
+        }
+        meshCentroid += clusterCentroids[clusterIdx];
+        meshArea += clusterArea;
+        clusterCentroids[clusterIdx] = clusterArea > 0.0F ? clusterCentroids[clusterIdx] / clusterArea
+                                                          : loadPosition(positions, positionStride, indices[clusterStarts[clusterIdx] * 3]);
+    }
+    meshCentroid = meshArea > 0.0F ? meshCentroid / meshArea : glm::vec3(0.0F);
+    std::vector<float> clusterKeys(clusterCount);
+    for(size_t clusterIdx = 0; clusterIdx < clusterCount; clusterIdx++)
+    {
+        float normalLength = glm::length(clusterNormals[clusterIdx]);
+        clusterKeys[clusterIdx] = normalLength > 0.0F
+                ? glm::dot(clusterCentroids[clusterIdx] - meshCentroid, clusterNormals[clusterIdx] / normalLength)
+                : 0.0F;
+    }
+
+    // Overdraw Step 4: outermost clusters first
+    std::vector<size_t> clusterOrder(clusterCount);
+    std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](size_t left, size_t right){
+        return clusterKeys[left] > clusterKeys[right];
+    });
+    std::vector<uint32_t> output;
+    output.reserve(triangleCount * 3);
+    for(size_t clusterIdx : clusterOrder)
+    {
+        output.insert(output.end(), indices + clusterStarts[clusterIdx] * 3, indices + clusterStarts[clusterIdx + 1] * 3);
+    }
+    std::copy(output.begin(), output.end(), indices);
+}
+
+size_t optimizeVertexFetch(void* vertices, size_t vertexCount, size_t vertexSize, uint32_t* indices, size_t indexCount)
+{
+    std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+    uint32_t nextVertex = 0;
+    for(size_t indexIdx = 0; indexIdx < indexCount; indexIdx++)
+    {
+        uint32_t& newIndex = remap[indices[indexIdx]];
+        if(newIndex == UINT32_MAX)
+        {
+            newIndex = nextVertex++;
+        }
+        indices[indexIdx] = newIndex;
+    }
+    std::vector<uint8_t> reordered(static_cast<size_t>(nextVertex) * vertexSize);
+    const uint8_t* source = static_cast<const uint8_t*>(vertices);
+    for(size_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        if(remap[vertex] != UINT32_MAX)
+        {
+            std::memcpy(reordered.data() + remap[vertex] * vertexSize, source + vertex * vertexSize, vertexSize);
+        }
+    }
+    std::memcpy(vertices, reordered.data(), reordered.size());
+    return nextVertex;
+}
+
+std::vector<uint32_t> stripifyTriangles(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t lookahead)
+{
+    size_t triangleCount = indexCount / 3;
+    TriangleAdjacency adjacency(indices, triangleCount, vertexCount);
+    std::vector<uint8_t> used(triangleCount, 0);
+    auto retire = [&](uint32_t triangle){
+        used[triangle] = 1;
+        for(int corner = 0; corner < 3; corner++)
+        {
+            adjacency.retire(indices[static_cast<size_t>(triangle) * 3 + corner], triangle);
+        }
+    };
+    std::vector<uint32_t> strips;
+    strips.reserve(indexCount);
+    for(size_t start = 0; start < triangleCount; start++)
+    {
+        const uint32_t* corners = indices + start * 3;
+        if(used[start])
+        {
+            continue;
+        }
+        if(corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0])
+        {
+            retire(static_cast<uint32_t>(start));
+            continue;
+        }
+        retire(static_cast<uint32_t>(start));
+        size_t triangleLimit = lookahead < triangleCount - start ? start + lookahead : triangleCount;
+
+        // Strip Step 1: rotate the first triangle so the strip can carry on across its last edge; the second
+        // triangle of a strip is odd, so it has to have that edge reversed
+        int rotation = 0;
+        uint32_t third;
+        for(int candidate = 0; candidate < 3; candidate++)
+        {
+            if(findTriangleWithEdge(adjacency, indices, corners[(candidate + 2) % 3], corners[(candidate + 1) % 3],
+                                    triangleLimit, third) != UINT32_MAX)
+            {
+                rotation = candidate;
+                break;
+            }
+        }
+        if(!strips.empty())
+        {
+            strips.push_back(kPrimitiveRestartIndex);
+        }
+        strips.push_back(corners[rotation]);
+        strips.push_back(corners[(rotation + 1) % 3]);
+        strips.push_back(corners[(rotation + 2) % 3]);
+
+        // Strip Step 2: extend it while some triangle shares its last edge with the winding the next position
+        // needs: even triangles are (a, b, new), odd ones (b, a, new) for the strip's last two vertices a, b
+        for(bool odd = true;; odd = !odd)
+        {
+            uint32_t a = strips[strips.size() - 2];
+            uint32_t b = strips[strips.size() - 1];
+            uint32_t next = odd ? findTriangleWithEdge(adjacency, indices, b, a, triangleLimit, third)
+                                : findTriangleWithEdge(adjacency, indices, a, b, triangleLimit, third);
+            if(next == UINT32_MAX)
+            {
+                break;
+            }
+            retire(next);
+            strips.push_back(third);
+        }
+    }
+    return strips;
+}
+
+bool replaceWithStripsIfShorter(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+    std::vector<uint32_t> strips = stripifyTriangles(indices.data(), indices.size(), vertexCount);
+    if(strips.size() >= indices.size())
+    {
+        return false;
+    }
+    indices.swap(strips);
+    return true;
+}
@@ -0,0 +1,142 @@
+#ifndef OPENGLSANDBOX_MESHOPTIMIZATION_H
+#define OPENGLSANDBOX_MESHOPTIMIZATION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/*
+ * Index and vertex order optimisation for indexed triangle lists, and the metrics to judge it by.  The usual
+ * pipeline runs optimizeVertexCache(), so triangles reuse recently transformed vertices, then
+ * optimizeOverdraw(), which reorders whole runs of those triangles roughly front-to-back without undoing
+ * much of the reuse, then optimizeVertexFetch(), which renumbers vertices in the order the triangles first
+ * use them so vertex fetches walk the buffer forwards.  All of them work in place on 32 bit indices.
+ *
+ * Triangle lists can also be turned into triangle strips joined by primitive restarts, for meshes where that
+ * takes fewer indices.
+ *
+ * The vertex cache metrics simulate a FIFO post-transform cache: ACMR is transformed vertices per triangle
+ * (0.5 is ideal for a large regular mesh, 3 is the worst), ATVR is transformed vertices per vertex (1 is ideal).
+ */
+
+/**
+ * Post-transform vertex cache simulation results
+ */
+struct VertexCacheStatistics
+{
+    size_t transformedVertices = 0;
+    /**
+     * Average cache miss ratio, transformed vertices per triangle
+     */
+    float acmr = 0.0F;
+    /**
+     * Average transformed vertex ratio, transformed vertices per referenced vertex
+     */
+    float atvr = 0.0F;
+};
+
+/**
+ * Every vertex's triangles, of which the first getLiveCount() are the ones not yet retired; passes that
+ * consume triangles one at a time retire them from each of their vertices as they go
+ */
+class TriangleAdjacency
+{
+private:
+    std::vector<size_t> mOffsets;
+    std::vector<uint32_t> mTriangles;
+    std::vector<uint32_t> mLiveCounts;
+public:
+    TriangleAdjacency(const uint32_t* indices, size_t triangleCount, size_t vertexCount);
+
+    uint32_t getLiveCount(uint32_t vertex) const
+    {
+        return mLiveCounts[vertex];
+    }
+
+    const uint32_t* getLiveTriangles(uint32_t vertex) const
+    {
+        return mTriangles.data() + mOffsets[vertex];
+    }
+
+    /**
+     * Retires one of the vertex's live triangles; call once per corner the triangle has at the vertex
+     */
+    void retire(uint32_t vertex, uint32_t triangle)
+    {
+        uint32_t* live = mTriangles.data() + mOffsets[vertex];
+        uint32_t* found = std::find(live, live + mLiveCounts[vertex], triangle);
+        std::swap(*found, live[mLiveCounts[vertex] - 1]);
+        mLiveCounts[vertex]--;
+    }
+};
+
+/**
+ * Simulates drawing a triangle list through a FIFO post-transform vertex cache
+ * @param cacheSize entries in the simulated cache; 16 is a fair model of current GPUs
+ */
+VertexCacheStatistics analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+        unsigned int cacheSize = 16);
+
+/**
+ * Simulates the vertex fetches of a triangle list, through the vertex cache above and a small direct-mapped
+ * cache of 64 byte lines in front of the vertex buffer
+ * @return bytes fetched from the vertex buffer over the bytes of vertices referenced; 1 means every vertex
+ *         was fetched exactly once, in whole cache lines shared with no other fetch
+ */
+float analyzeVertexFetch(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t vertexSize);
+
+/**
+ * Reorders triangles to maximise post-transform vertex cache hits, with Tom Forsyth's linear-speed
+ * algorithm: triangles are emitted greedily by a score favouring vertices recently used and vertices with
+ * few triangles left, so fans get finished rather than left with one stray triangle
+ */
+void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+/**
+ * Reorders clusters of triangles, already in vertex cache order, so surfaces facing outwards from the mesh's
+ * centre draw first, which makes them roughly front-to-back from any viewpoint and cuts overdraw.  Clusters
+ * are split wherever the cache order restarts, and further wherever that keeps each cluster's ACMR within
+ * threshold of what it was
+ * @param positions x, y, z of the first vertex
+ * @param positionStride bytes between consecutive vertices' positions
+ * @param threshold how much ACMR may worsen for finer clusters, e.g. 1.05 for 5%
+ */
+void optimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride,
+        size_t vertexCount, float threshold = 1.05F);
+
+/**
+ * Renumbers vertices in the order the indices first reference them and reorders the vertex data to match,
+ * dropping vertices nothing references
+ * @param vertices vertexCount vertices of vertexSize bytes each, reordered in place
+ * @return the number of vertices kept, at the start of vertices
+ */
+size_t optimizeVertexFetch(void* vertices, size_t vertexCount, size_t vertexSize, uint32_t* indices, size_t indexCount);
+
+/**
+ * Index separating strips; drawn with GL_PRIMITIVE_RESTART_FIXED_INDEX enabled, which restarts on the all-ones
+ * value of the index type, so it still works once narrowed to 8 or 16 bit indices
+ */
+const uint32_t kPrimitiveRestartIndex = UINT32_MAX;
+
+/**
+ * Converts a triangle list into GL_TRIANGLE_STRIP strips separated by kPrimitiveRestartIndex.  Each strip
+ * starts at the first triangle not yet in one and grows greedily across shared edges; every triangle keeps
+ * its winding, and degenerate triangles, which draw nothing, are dropped
+ * @param lookahead how far past that first triangle strips may take triangles from.  Small values keep close
+ *        to the list's order, so strips of a list in vertex cache order keep most of its reuse; SIZE_MAX
+ *        makes the longest strips, which on a cache-optimised grid take 36% of the list's indices rather than
+ *        48% with the default, but transform 43% more vertices rather than 6%
+ */
+std::vector<uint32_t> stripifyTriangles(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+        size_t lookahead = 32);
+
+/**
+ * Replaces a triangle list with stripifyTriangles()' strips if they take fewer indices
+ * @return true if indices now hold strips
+ */
+bool replaceWithStripsIfShorter(std::vector<uint32_t>& indices, size_t vertexCount);
+
+
+#endif //OPENGLSANDBOX_MESHOPTIMIZATION_H
@@ -0,0 +1,172 @@
+#include "OcclusionCuller.h"
+#include "GLResources.h"
+#include "VertexLayout.h"
+#include <glm/gtc/type_ptr.hpp>
+
+OcclusionCuller::OcclusionCuller(unsigned int proxyProgramId): mProxyProgramId(proxyProgramId)
+{
+    mBoundsMinLocation = glGetUniformLocation(mProxyProgramId, "boundsMin");
+    mBoundsMaxLocation = glGetUniformLocation(mProxyProgramId, "boundsMax");
+
+    // unit cube, scaled and offset onto each object's bounds in occlusion_proxy.vert
+    float vertices[] = {
+            0, 0, 0,
+            1, 0, 0,
+            1, 1, 0,
+            0, 1, 0,
+            0, 0, 1,
+            1, 0, 1,
+            1, 1, 1,
+            0, 1, 1
+    };
+    unsigned char indices[] = {
+            0, 2, 1, 0, 3, 2, // -z
+            4, 5, 6, 4, 6, 7, // +z
+            0, 1, 5, 0, 5, 4, // -y
+            3, 6, 2, 3, 7, 6, // +y
+            0, 4, 7, 0, 7, 3, // -x
+            1, 2, 6, 1, 6, 5  // +x
+    };
+    mCubeVBO = createBuffer(sizeof(vertices), vertices, 0);
+    mCubeEBO = createBuffer(sizeof(indices), indices, 0);
+    mCubeVAO = createVertexArray();
+    // unit cube corners feed aPos in occlusion_proxy.vert
+    applyVertexLayout<PositionVertex>(mCubeVAO, 0, mCubeVBO, 0);
+    setElementBuffer(mCubeVAO, mCubeEBO);
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    for(OccludableObject& object : mObjects)
+    {
+        glDeleteQueries(2, object.queries);
+    }
+    unsigned int buffers[] = {mCubeVBO, mCubeEBO};
+    glDeleteBuffers(2, buffers);
+    glDeleteVertexArrays(1, &mCubeVAO);
+}
+
+size_t OcclusionCuller::registerObject(glm::vec3 boundsMin, glm::vec3 boundsMax)
+{
+    size_t handle;
+    if(!mFreeHandles.empty())
+    {
+        // reuse the freed slot's query objects
+        handle = mFreeHandles.back();
+        mFreeHandles.pop_back();
+    }
+    else
+    {
+        handle = mObjects.size();
+        mObjects.emplace_back();
+        glGenQueries(2, mObjects[handle].queries);
+    }
+    OccludableObject& object = mObjects[handle];
+    object.boundsMin = boundsMin;
+    object.boundsMax = boundsMax;
+    object.issuedFrame[0] = object.issuedFrame[1] = 0;
+    object.conditionalDraws[0] = object.conditionalDraws[1] = 0;
+    object.active = true;
+    return handle;
+}
+
+void OcclusionCuller::unregisterObject(size_t handle)
+{
+    mObjects[handle].active = false;
+    mFreeHandles.push_back(handle);
+}
+
+void OcclusionCuller::updateBounds(size_t handle, glm::vec3 boundsMin, glm::vec3 boundsMax)
+{
+    mObjects[handle].boundsMin = boundsMin;
+    mObjects[handle].boundsMax = boundsMax;
+}
+
+void OcclusionCuller::drawConditional(size_t handle, const std::function<void(void)>& draw)
+{
+    OccludableObject& object = mObjects[handle];
+    size_t previousSlot = (mFrameIndex - 1) % 2;
+    mStatistics.draws++;
+    if(object.issuedFrame[previousSlot] != mFrameIndex - 1)
+    {
+        // no proxy from last frame to go on (newly registered), so draw unconditionally
+        mStatistics.drawsUnconditional++;
+        draw();
+        return;
+    }
+    // GL_QUERY_NO_WAIT: if the GPU doesn't have the result yet it renders rather than stalling
+    glBeginConditionalRender(object.queries[previousSlot], GL_QUERY_NO_WAIT);
+    draw();
+    glEndConditionalRender();
+    object.conditionalDraws[previousSlot]++;
+}
+
+void OcclusionCuller::harvestResult(OccludableObject& object, size_t slot)
+{
+    if(object.issuedFrame[slot] == 0 || object.conditionalDraws[slot] == 0)
+    {
+        return;
+    }
+    // by now the query is two frames old and almost always available; if it isn't we leave
+    // those draws unresolved rather than block on the result
+    unsigned int available = 0;
+    glGetQueryObjectuiv(object.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+    if(available)
+    {
+        unsigned int anySamplesPassed = 0;
+        glGetQueryObjectuiv(object.queries[slot], GL_QUERY_RESULT, &anySamplesPassed);
+        if(anySamplesPassed)
+        {
+            mStatistics.drawsVisible += object.conditionalDraws[slot];
+        }
+        else
+        {
+            mStatistics.drawsSkipped += object.conditionalDraws[slot];
+        }
+    }
+    else
+    {
+        mStatistics.drawsUnresolved += object.conditionalDraws[slot];
+    }
+    object.conditionalDraws[slot] = 0;
+}
+
+void OcclusionCuller::issueQueries()
+{
+    size_t slot = mFrameIndex % 2;
+
+    // proxies must only affect the query results, not the frame
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    glUseProgram(mProxyProgramId);
+    glBindVertexArray(mCubeVAO);
+    for(OccludableObject& object : mObjects)
+    {
+        if(!object.active)
+        {
+            continue;
+        }
+        // this slot was last issued two frames ago and consumed last frame, so collect it before reuse
+        harvestResult(object, slot);
+        glUniform3fv(mBoundsMinLocation, 1, glm::value_ptr(object.boundsMin));
+        glUniform3fv(mBoundsMaxLocation, 1, glm::value_ptr(object.boundsMax));
+        glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, object.queries[slot]);
+        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, nullptr);
+        glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+        object.issuedFrame[slot] = mFrameIndex;
+    }
+    glDepthMask(GL_TRUE);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+    mFrameIndex++;
+}
+
+const OcclusionStatistics& OcclusionCuller::getStatistics() const
+{
+    return mStatistics;
+}
+
+void OcclusionCuller::resetStatistics()
+{
+    mStatistics = OcclusionStatistics();
+}
@@ -0,0 +1,141 @@
+#ifndef OPENGLSANDBOX_OCCLUSIONCULLER_H
+#define OPENGLSANDBOX_OCCLUSIONCULLER_H
+
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
+/**
+ * Counters describing how many conditional draws the GPU actually skipped.  Query results are only ever
+ * read back once they're available, so these lag the frame they describe by a couple of frames and
+ * draws whose result never became available in time are counted as unresolved rather than guessed at.
+ */
+struct OcclusionStatistics
+{
+    /**
+     * Total number of drawConditional() calls
+     */
+    size_t draws = 0;
+    /**
+     * Draws the GPU skipped because their bounding box proxy passed no samples
+     */
+    size_t drawsSkipped = 0;
+    /**
+     * Draws we found to be visible, i.e. the GPU rendered them
+     */
+    size_t drawsVisible = 0;
+    /**
+     * Draws with no previous-frame query to condition on, e.g. on the frame an object was registered
+     */
+    size_t drawsUnconditional = 0;
+    /**
+     * Conditional draws whose query result still wasn't available when its query was reused, so whether the
+     * GPU skipped them is unknown
+     */
+    size_t drawsUnresolved = 0;
+};
+
+/**
+ * Occlusion culling for expensive objects (large trail batches, dense meshes) without CPU readback stalls.
+ * At the end of each frame issueQueries() draws every registered object's bounding box with color and depth
+ * writes disabled inside an occlusion query; during the next frame drawConditional() wraps the object's real
+ * draw in glBeginConditionalRender() against that query, so the GPU decides whether to execute it and the CPU
+ * never waits.  Each object ping-pongs between two queries so last frame's result can be polled for
+ * statistics before the query is reused.
+ *
+ * Proxies are depth tested against whatever is in the depth buffer when issueQueries() runs, so only objects
+ * drawn before that point act as occluders; with depth testing disabled this degrades to off-screen culling.
+ */
+class OcclusionCuller
+{
+private:
+    /**
+     * Per-object query state
+     */
+    struct OccludableObject
+    {
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        /**
+         * Ping-pong pair of GL_ANY_SAMPLES_PASSED_CONSERVATIVE query objects
+         */
+        unsigned int queries[2];
+        /**
+         * Frame index each query was last issued in, or 0 if it never has been
+         */
+        size_t issuedFrame[2];
+        /**
+         * Number of drawConditional() calls made against each query since it was last issued
+         */
+        size_t conditionalDraws[2];
+        bool active;
+    };
+    /**
+     * Program drawing the unit cube proxy scaled to boundsMin/boundsMax uniforms
+     */
+    unsigned int mProxyProgramId;
+    int mBoundsMinLocation;
+    int mBoundsMaxLocation;
+    unsigned int mCubeVAO = 0;
+    unsigned int mCubeVBO = 0;
+    unsigned int mCubeEBO = 0;
+    std::vector<OccludableObject> mObjects;
+    /**
+     * Handles of unregistered objects available for reuse
+     */
+    std::vector<size_t> mFreeHandles;
+    /**
+     * Index of the current frame, starting at 1 so 0 can mean "never issued"
+     */
+    size_t mFrameIndex = 1;
+    OcclusionStatistics mStatistics;
+    /**
+     * Reads back the given query slot's result if it's available, folding it into mStatistics
+     */
+    void harvestResult(OccludableObject& object, size_t slot);
+public:
+    /**
+     * Creates the proxy cube geometry.  Must be called on the thread owning the current GL context.
+     * @param proxyProgramId program linked from occlusion_proxy.vert/.frag
+     */
+    explicit OcclusionCuller(unsigned int proxyProgramId);
+    ~OcclusionCuller();
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+    /**
+     * Starts tracking an expensive object; only worth it when the object costs considerably more
+     * than drawing a box
+     * @param boundsMin minimum corner of the object's axis-aligned bounds
+     * @param boundsMax maximum corner of the object's axis-aligned bounds
+     * @return handle used with the remaining member functions
+     */
+    size_t registerObject(glm::vec3 boundsMin, glm::vec3 boundsMax);
+    /**
+     * Stops tracking an object, releasing its handle for reuse
+     */
+    void unregisterObject(size_t handle);
+    /**
+     * Updates an object's bounds, which take effect at the next issueQueries()
+     */
+    void updateBounds(size_t handle, glm::vec3 boundsMin, glm::vec3 boundsMax);
+    /**
+     * Runs draw conditionally on the object's bounding box having been visible at the end of the previous
+     * frame; the GPU skips the draw's work if it wasn't, and runs it anyway if the result isn't ready yet
+     */
+    void drawConditional(size_t handle, const std::function<void(void)>& draw);
+    /**
+     * Draws every object's bounding box proxy inside its occlusion query, to be consumed by next frame's
+     * drawConditional() calls, then advances to the next frame.  Call once per frame after the occluders
+     * have been drawn; leaves the proxy program and cube VAO bound.
+     */
+    void issueQueries();
+    /**
+     * @return counters accumulated since construction or the last resetStatistics()
+     */
+    const OcclusionStatistics& getStatistics() const;
+    void resetStatistics();
+};
+
+
+#endif //OPENGLSANDBOX_OCCLUSIONCULLER_H
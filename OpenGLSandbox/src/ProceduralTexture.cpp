@@ -0,0 +1,302 @@
+#include "ProceduralTexture.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "SimdLane.h"
+#include "ThreadPool.h"
+
+namespace
+{
+    const size_t kBytesPerTexel = 4;
+    /**
+     * Each octave's lattice is shifted by the seed plus a per-octave step, so octaves don't line up with
+     * each other; offsets stay small, since the hash loses precision on large coordinates
+     */
+    const float kOctaveOffsetX = 131.0F;
+    const float kOctaveOffsetY = 71.0F;
+
+    /**
+     * Noise settings resolved once per call rather than per texel
+     */
+    struct NoiseSetup
+    {
+        float offsetX;
+        float offsetY;
+        /**
+         * Normalizes the sum of the octaves' amplitudes to 1
+         */
+        float amplitudeScale;
+    };
+
+    NoiseSetup makeNoiseSetup(const RibbonTextureParameters& parameters)
+    {
+        NoiseSetup setup;
+        setup.offsetX = static_cast<float>(parameters.seed & 1023U);
+        setup.offsetY = static_cast<float>((parameters.seed >> 10) & 1023U);
+        float amplitudeSum = 0.0F;
+        float amplitude = 1.0F;
+        for(int octave = 0; octave < parameters.noiseOctaves; octave++)
+        {
+            amplitudeSum += amplitude;
+            amplitude *= 0.5F;
+        }
+        setup.amplitudeScale = amplitudeSum > 0.0F ? 1.0F / amplitudeSum : 0.0F;
+        return setup;
+    }
+
+    /// SIMD kernel ///
+
+    inline simd::Lane fract(simd::Lane value)
+    {
+        return simd::subtract(value, simd::floor(value));
+    }
+
+    /**
+     * Dave Hoskins' "hash without sine" of integer lattice coords, in [0, 1); only multiplies, adds and
+     * floors, so it vectorizes where integer hashes would need SSE4's 32 bit multiply
+     */
+    inline simd::Lane hashLattice(simd::Lane x, simd::Lane y)
+    {
+        simd::Lane a = fract(simd::multiply(x, simd::splat(0.1031F)));
+        simd::Lane b = fract(simd::multiply(y, simd::splat(0.1031F)));
+        simd::Lane c = a;
+        simd::Lane bias = simd::splat(33.33F);
+        simd::Lane dot = simd::add(simd::add(
+                simd::multiply(a, simd::add(b, bias)),
+                simd::multiply(b, simd::add(c, bias))),
+                simd::multiply(c, simd::add(a, bias)));
+        a = simd::add(a, dot);
+        b = simd::add(b, dot);
+        c = simd::add(c, dot);
+        return fract(simd::multiply(simd::add(a, b), c));
+    }
+
+    inline simd::Lane lerp(simd::Lane a, simd::Lane b, simd::Lane t)
+    {
+        return simd::add(a, simd::multiply(simd::subtract(b, a), t));
+    }
+
+    /**
+     * Value noise at texture coords (u, v) in [0, 1), wrapping every period lattice cells
+     */
+    inline simd::Lane valueNoise(simd::Lane u, simd::Lane v, float period, float offsetX, float offsetY)
+    {
+        simd::Lane periodLane = simd::splat(period);
+        simd::Lane one = simd::splat(1.0F);
+        simd::Lane latticeX = simd::multiply(u, periodLane);
+        simd::Lane latticeY = simd::multiply(v, periodLane);
+        simd::Lane cellX0 = simd::floor(latticeX);
+        simd::Lane cellY0 = simd::floor(latticeY);
+        simd::Lane fractionX = simd::subtract(latticeX, cellX0);
+        simd::Lane fractionY = simd::subtract(latticeY, cellY0);
+        // u and v are below 1, so only the next cell over can fall off the far edge
+        simd::Lane cellX1 = simd::add(cellX0, one);
+        simd::Lane cellY1 = simd::add(cellY0, one);
+        cellX1 = simd::select(simd::greaterEqual(cellX1, periodLane), simd::splat(0.0F), cellX1);
+        cellY1 = simd::select(simd::greaterEqual(cellY1, periodLane), simd::splat(0.0F), cellY1);
+        simd::Lane offsetXLane = simd::splat(offsetX);
+        simd::Lane offsetYLane = simd::splat(offsetY);
+        cellX0 = simd::add(cellX0, offsetXLane);
+        cellX1 = simd::add(cellX1, offsetXLane);
+        cellY0 = simd::add(cellY0, offsetYLane);
+        cellY1 = simd::add(cellY1, offsetYLane);
+
+        // smoothstep the fractions so the noise has no creases at cell borders
+        simd::Lane three = simd::splat(3.0F);
+        simd::Lane two = simd::splat(2.0F);
+        simd::Lane smoothX = simd::multiply(simd::multiply(fractionX, fractionX),
+                simd::subtract(three, simd::multiply(two, fractionX)));
+        simd::Lane smoothY = simd::multiply(simd::multiply(fractionY, fractionY),
+                simd::subtract(three, simd::multiply(two, fractionY)));
+        simd::Lane bottom = lerp(hashLattice(cellX0, cellY0), hashLattice(cellX1, cellY0), smoothX);
+        simd::Lane top = lerp(hashLattice(cellX0, cellY1), hashLattice(cellX1, cellY1), smoothX);
+        return lerp(bottom, top, smoothY);
+    }
+
+    /**
+     * Scales a channel in [0, 1] (before clamping) to [0, 255] for storeRgba8()
+     */
+    inline simd::Lane toByteRange(simd::Lane value)
+    {
+        return simd::multiply(simd::minimum(simd::maximum(value, simd::splat(0.0F)), simd::splat(1.0F)),
+                simd::splat(255.0F));
+    }
+
+    /// scalar reference, mirroring the kernel above operation for operation ///
+
+    inline float fractScalar(float value)
+    {
+        return value - std::floor(value);
+    }
+
+    inline float hashLatticeScalar(float x, float y)
+    {
+        float a = fractScalar(x * 0.1031F);
+        float b = fractScalar(y * 0.1031F);
+        float c = a;
+        float dot = a * (b + 33.33F) + b * (c + 33.33F) + c * (a + 33.33F);
+        a += dot;
+        b += dot;
+        c += dot;
+        return fractScalar((a + b) * c);
+    }
+
+    inline float lerpScalar(float a, float b, float t)
+    {
+        return a + (b - a) * t;
+    }
+
+    float valueNoiseScalar(float u, float v, float period, float offsetX, float offsetY)
+    {
+        float latticeX = u * period;
+        float latticeY = v * period;
+        float cellX0 = std::floor(latticeX);
+        float cellY0 = std::floor(latticeY);
+        float fractionX = latticeX - cellX0;
+        float fractionY = latticeY - cellY0;
+        float cellX1 = cellX0 + 1.0F;
+        float cellY1 = cellY0 + 1.0F;
+        cellX1 = cellX1 >= period ? 0.0F : cellX1;
+        cellY1 = cellY1 >= period ? 0.0F : cellY1;
+        cellX0 += offsetX;
+        cellX1 += offsetX;
+        cellY0 += offsetY;
+        cellY1 += offsetY;
+        float smoothX = (fractionX * fractionX) * (3.0F - 2.0F * fractionX);
+        float smoothY = (fractionY * fractionY) * (3.0F - 2.0F * fractionY);
+        float bottom = lerpScalar(hashLatticeScalar(cellX0, cellY0), hashLatticeScalar(cellX1, cellY0), smoothX);
+        float top = lerpScalar(hashLatticeScalar(cellX0, cellY1), hashLatticeScalar(cellX1, cellY1), smoothX);
+        return lerpScalar(bottom, top, smoothY);
+    }
+
+    inline uint8_t toByteScalar(float value)
+    {
+        return static_cast<uint8_t>(std::lrint(std::min(std::max(value, 0.0F), 1.0F) * 255.0F));
+    }
+}
+
+void generateRibbonTextureRegion(const RibbonTextureParameters& parameters, GLsizei width, GLsizei height,
+        GLsizei x0, GLsizei y0, GLsizei x1, GLsizei y1, uint8_t* destination, size_t rowStride)
+{
+    NoiseSetup noise = makeNoiseSetup(parameters);
+    simd::Lane inverseWidth = simd::splat(1.0F / static_cast<float>(width));
+    float inverseHeight = 1.0F / static_cast<float>(height);
+    simd::Lane half = simd::splat(0.5F);
+    simd::Lane one = simd::splat(1.0F);
+    simd::Lane headR = simd::splat(parameters.headColor.r);
+    simd::Lane headG = simd::splat(parameters.headColor.g);
+    simd::Lane headB = simd::splat(parameters.headColor.b);
+    simd::Lane headA = simd::splat(parameters.headColor.a);
+    simd::Lane deltaR = simd::splat(parameters.tailColor.r - parameters.headColor.r);
+    simd::Lane deltaG = simd::splat(parameters.tailColor.g - parameters.headColor.g);
+    simd::Lane deltaB = simd::splat(parameters.tailColor.b - parameters.headColor.b);
+    simd::Lane deltaA = simd::splat(parameters.tailColor.a - parameters.headColor.a);
+    simd::Lane amplitude = simd::splat(parameters.noiseAmplitude);
+    simd::Lane amplitudeScale = simd::splat(noise.amplitudeScale);
+
+    for(GLsizei y = y0; y < y1; y++)
+    {
+        uint8_t* row = destination + static_cast<size_t>(y - y0) * rowStride;
+        // v, and the edge fade that depends only on it, are the same across the row
+        float vScalar = (static_cast<float>(y) + 0.5F) * inverseHeight;
+        simd::Lane v = simd::splat(vScalar);
+        float centreScalar = 1.0F - std::abs(2.0F * vScalar - 1.0F);
+        simd::Lane centre = simd::splat(centreScalar);
+        for(GLsizei x = x0; x < x1; x += static_cast<GLsizei>(simd::kLaneWidth))
+        {
+            simd::Lane u = simd::multiply(simd::add(simd::add(simd::splat(static_cast<float>(x)), simd::laneIndices()),
+                    half), inverseWidth);
+
+            // Build Step 1: octaves of wrapping value noise, normalized to [0, 1) then centred on 0
+            simd::Lane noiseSum = simd::splat(0.0F);
+            float octaveAmplitude = 1.0F;
+            for(int octave = 0; octave < parameters.noiseOctaves; octave++)
+            {
+                float period = static_cast<float>(parameters.noiseFrequency << octave);
+                simd::Lane octaveNoise = valueNoise(u, v, period,
+                        noise.offsetX + kOctaveOffsetX * static_cast<float>(octave),
+                        noise.offsetY + kOctaveOffsetY * static_cast<float>(octave));
+                noiseSum = simd::add(noiseSum, simd::multiply(simd::splat(octaveAmplitude), octaveNoise));
+                octaveAmplitude *= 0.5F;
+            }
+            simd::Lane signedNoise = simd::subtract(simd::multiply(simd::splat(2.0F),
+                    simd::multiply(noiseSum, amplitudeScale)), one);
+            simd::Lane brightness = simd::add(one, simd::multiply(amplitude, signedNoise));
+
+            // Build Step 2: gradient along the ribbon, brightened or darkened by the noise, faded at the edges
+            simd::Lane r = simd::multiply(simd::add(headR, simd::multiply(deltaR, u)), brightness);
+            simd::Lane g = simd::multiply(simd::add(headG, simd::multiply(deltaG, u)), brightness);
+            simd::Lane b = simd::multiply(simd::add(headB, simd::multiply(deltaB, u)), brightness);
+            simd::Lane a = simd::multiply(simd::multiply(simd::add(headA, simd::multiply(deltaA, u)), centre), brightness);
+
+            // Build Step 3: store; a row's last few texels may not fill a whole lane
+            uint8_t* texel = row + static_cast<size_t>(x - x0) * kBytesPerTexel;
+            if(x + static_cast<GLsizei>(simd::kLaneWidth) <= x1)
+            {
+                simd::storeRgba8(texel, toByteRange(r), toByteRange(g), toByteRange(b), toByteRange(a));
+            }
+            else
+            {
+                uint8_t partial[simd::kLaneWidth * kBytesPerTexel];
+                simd::storeRgba8(partial, toByteRange(r), toByteRange(g), toByteRange(b), toByteRange(a));
+                std::memcpy(texel, partial, static_cast<size_t>(x1 - x) * kBytesPerTexel);
+            }
+        }
+    }
+}
+
+void generateRibbonTexture(const RibbonTextureParameters& parameters, GLsizei width, GLsizei height,
+        GLsizei firstRow, GLsizei rowCount, uint8_t* destination, ThreadPool& pool)
+{
+    size_t rowStride = static_cast<size_t>(width) * kBytesPerTexel;
+    size_t tileColumns = static_cast<size_t>((width + kRibbonTextureTileWidth - 1) / kRibbonTextureTileWidth);
+    size_t tileRows = static_cast<size_t>((rowCount + kRibbonTextureTileHeight - 1) / kRibbonTextureTileHeight);
+    pool.parallelFor(tileColumns * tileRows, [&](size_t tileIdx){
+        GLsizei tileX = static_cast<GLsizei>(tileIdx % tileColumns) * kRibbonTextureTileWidth;
+        GLsizei tileY = static_cast<GLsizei>(tileIdx / tileColumns) * kRibbonTextureTileHeight;
+        GLsizei tileX1 = std::min(tileX + kRibbonTextureTileWidth, width);
+        GLsizei tileY1 = std::min(tileY + kRibbonTextureTileHeight, rowCount);
+        generateRibbonTextureRegion(parameters, width, height, tileX, firstRow + tileY, tileX1, firstRow + tileY1,
+                destination + static_cast<size_t>(tileY) * rowStride + static_cast<size_t>(tileX) * kBytesPerTexel,
+                rowStride);
+    });
+}
+
+glm::u8vec4 evaluateRibbonTexel(const RibbonTextureParameters& parameters, GLsizei width, GLsizei height,
+        GLsizei x, GLsizei y)
+{
+    NoiseSetup noise = makeNoiseSetup(parameters);
+    float u = (static_cast<float>(x) + 0.5F) * (1.0F / static_cast<float>(width));
+    float v = (static_cast<float>(y) + 0.5F) * (1.0F / static_cast<float>(height));
+    float centre = 1.0F - std::abs(2.0F * v - 1.0F);
+
+    float noiseSum = 0.0F;
+    float octaveAmplitude = 1.0F;
+    for(int octave = 0; octave < parameters.noiseOctaves; octave++)
+    {
+        float period = static_cast<float>(parameters.noiseFrequency << octave);
+        float octaveNoise = valueNoiseScalar(u, v, period,
+                noise.offsetX + kOctaveOffsetX * static_cast<float>(octave),
+                noise.offsetY + kOctaveOffsetY * static_cast<float>(octave));
+        noiseSum = noiseSum + octaveAmplitude * octaveNoise;
+        octaveAmplitude *= 0.5F;
+    }
+    float signedNoise = 2.0F * (noiseSum * noise.amplitudeScale) - 1.0F;
+    float brightness = 1.0F + parameters.noiseAmplitude * signedNoise;
+
+    glm::vec4 delta = parameters.tailColor - parameters.headColor;
+    return glm::u8vec4(
+            toByteScalar((parameters.headColor.r + delta.r * u) * brightness),
+            toByteScalar((parameters.headColor.g + delta.g * u) * brightness),
+            toByteScalar((parameters.headColor.b + delta.b * u) * brightness),
+            toByteScalar(((parameters.headColor.a + delta.a * u) * centre) * brightness)
+    );
+}
+
+TextureRowSource makeRibbonTextureSource(const RibbonTextureParameters& parameters, GLsizei width, GLsizei height,
+        ThreadPool& pool)
+{
+    return [parameters, width, height, &pool](uint8_t* destination, GLsizei firstRow, GLsizei rowCount){
+        generateRibbonTexture(parameters, width, height, firstRow, rowCount, destination, pool);
+    };
+}
@@ -0,0 +1,73 @@
+#ifndef OPENGLSANDBOX_PROCEDURALTEXTURE_H
+#define OPENGLSANDBOX_PROCEDURALTEXTURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "TextureStreamer.h"
+
+class ThreadPool;
+
+/*
+ * Procedural RGBA8 ribbon textures, synthesized on the CPU instead of shipped as files.  u runs along the
+ * ribbon from head to tail and v across it: the colour is a gradient along u, faded out toward the ribbon's
+ * edges in alpha, and modulated by a few octaves of value noise that wraps at the texture's edges so the
+ * texture tiles along a trail.  The kernel evaluates kLaneWidth texels at a time with the SimdLane ops, and
+ * whole textures are cut into tiles spread over a ThreadPool, writing straight into the destination, which
+ * can be mapped staging memory via makeRibbonTextureSource().
+ */
+
+/**
+ * Width and height in texels of the tiles generateRibbonTexture() hands to its pool; a tile's 4 KB of
+ * output stays in one core's cache while it's written
+ */
+const GLsizei kRibbonTextureTileWidth = 64;
+const GLsizei kRibbonTextureTileHeight = 16;
+
+struct RibbonTextureParameters
+{
+    /**
+     * Colours at the head (u = 0) and tail (u = 1) of the ribbon; alpha is further faded toward the edges
+     */
+    glm::vec4 headColor = glm::vec4(1.0F, 0.85F, 0.4F, 1.0F);
+    glm::vec4 tailColor = glm::vec4(0.2F, 0.4F, 1.0F, 0.0F);
+    /**
+     * Noise lattice cells across the texture in the first octave, doubling each octave after
+     */
+    int noiseFrequency = 8;
+    int noiseOctaves = 4;
+    /**
+     * How far noise scales brightness up or down, 0 for a clean gradient
+     */
+    float noiseAmplitude = 0.35F;
+    uint32_t seed = 0;
+};
+
+/**
+ * Generates the texels [x0, x1) x [y0, y1) of a width x height ribbon texture on the calling thread
+ * @param destination where texel (x0, y0) goes
+ * @param rowStride bytes between the starts of consecutive rows in destination
+ */
+void generateRibbonTextureRegion(const RibbonTextureParameters& parameters, GLsizei width, GLsizei height,
+        GLsizei x0, GLsizei y0, GLsizei x1, GLsizei y1, uint8_t* destination, size_t rowStride);
+/**
+ * Generates rows [firstRow, firstRow + rowCount) of a width x height ribbon texture, tile by tile across
+ * the pool, and returns once they're all written
+ * @param destination where the first row goes; rows are tightly packed
+ */
+void generateRibbonTexture(const RibbonTextureParameters& parameters, GLsizei width, GLsizei height,
+        GLsizei firstRow, GLsizei rowCount, uint8_t* destination, ThreadPool& pool);
+/**
+ * Scalar reference for one texel, the same arithmetic as the SIMD kernel one texel at a time
+ */
+glm::u8vec4 evaluateRibbonTexel(const RibbonTextureParameters& parameters, GLsizei width, GLsizei height,
+        GLsizei x, GLsizei y);
+/**
+ * @return a TextureStreamer row source generating a GL_RGBA / GL_UNSIGNED_BYTE ribbon texture straight into
+ *         staging memory; the pool must outlive the texture's upload
+ */
+TextureRowSource makeRibbonTextureSource(const RibbonTextureParameters& parameters, GLsizei width, GLsizei height,
+        ThreadPool& pool);
+
+
+#endif //OPENGLSANDBOX_PROCEDURALTEXTURE_H
@@ -0,0 +1,243 @@
+#include "QuaternionBatch.h"
+#include <algorithm>
+#include <cassert>
+#include "SimdLane.h"
+
+namespace
+{
+    using namespace simd;
+
+    /**
+     * Lanes of one quaternion component set, loaded from a QuatSoA at some offset
+     */
+    struct QuatLanes
+    {
+        Lane x;
+        Lane y;
+        Lane z;
+        Lane w;
+    };
+
+    inline QuatLanes loadQuat(const QuatSoA& quaternions, size_t idx)
+    {
+        return {load(quaternions.x() + idx), load(quaternions.y() + idx), load(quaternions.z() + idx),
+                load(quaternions.w() + idx)};
+    }
+
+    inline void storeQuat(QuatSoA& quaternions, size_t idx, const QuatLanes& lanes)
+    {
+        store(quaternions.x() + idx, lanes.x);
+        store(quaternions.y() + idx, lanes.y);
+        store(quaternions.z() + idx, lanes.z);
+        store(quaternions.w() + idx, lanes.w);
+    }
+
+    inline Lane dot(const QuatLanes& a, const QuatLanes& b)
+    {
+        return add(add(multiply(a.x, b.x), multiply(a.y, b.y)), add(multiply(a.z, b.z), multiply(a.w, b.w)));
+    }
+
+    inline QuatLanes flipSign(const QuatLanes& quaternion, Lane sign)
+    {
+        return {simd::flipSign(quaternion.x, sign), simd::flipSign(quaternion.y, sign),
+                simd::flipSign(quaternion.z, sign), simd::flipSign(quaternion.w, sign)};
+    }
+
+    /**
+     * a * aWeight + b * bWeight
+     */
+    inline QuatLanes weightedSum(const QuatLanes& a, Lane aWeight, const QuatLanes& b, Lane bWeight)
+    {
+        return {add(multiply(a.x, aWeight), multiply(b.x, bWeight)), add(multiply(a.y, aWeight), multiply(b.y, bWeight)),
+                add(multiply(a.z, aWeight), multiply(b.z, bWeight)), add(multiply(a.w, aWeight), multiply(b.w, bWeight))};
+    }
+
+    inline QuatLanes scale(const QuatLanes& quaternion, Lane factor)
+    {
+        return {multiply(quaternion.x, factor), multiply(quaternion.y, factor), multiply(quaternion.z, factor),
+                multiply(quaternion.w, factor)};
+    }
+
+    /**
+     * Evaluates Eberly's slerp weight polynomial for one end of the arc: the weight sin(t * theta) / sin(theta)
+     * written as a series in (cos theta - 1).  The per-term coefficients only depend on t, so they're computed
+     * once per batch and this only does the Horner steps
+     * @param coefficients (u[i] * t^2 - v[i]) for each term
+     */
+    inline Lane slerpWeight(const float (&coefficients)[8], float t, Lane cosThetaMinusOne)
+    {
+        Lane one = splat(1.0F);
+        Lane series = one;
+        for(size_t term = 8; term-- > 0;)
+        {
+            series = add(one, multiply(multiply(splat(coefficients[term]), cosThetaMinusOne), series));
+        }
+        return multiply(splat(t), series);
+    }
+
+    /**
+     * Fills in a slerp term table for parameter t: u[i] = 1 / (i * (2i + 1)) and v[i] = i / (2i + 1) for
+     * i = 1..8, with the last term scaled by 1 + mu to fold in the truncation error of the series
+     */
+    void computeSlerpCoefficients(float t, float (&coefficients)[8])
+    {
+        const float onePlusMu = 1.90110745351730037F;
+        for(size_t term = 1; term <= 8; term++)
+        {
+            float u = 1.0F / static_cast<float>(term * (2 * term + 1));
+            float v = static_cast<float>(term) / static_cast<float>(2 * term + 1);
+            if(term == 8)
+            {
+                u *= onePlusMu;
+                v *= onePlusMu;
+            }
+            coefficients[term - 1] = u * t * t - v;
+        }
+    }
+}
+
+QuatSoA::QuatSoA(size_t count)
+{
+    resize(count);
+}
+
+QuatSoA::QuatSoA(const glm::quat* quaternions, size_t count)
+{
+    resize(count);
+    for(size_t idx = 0; idx < count; idx++)
+    {
+        set(idx, quaternions[idx]);
+    }
+}
+
+void QuatSoA::resize(size_t count)
+{
+    size_t paddedSize = paddedSoASize(count);
+    // shrinking leaves stale values in what become padding lanes, so zero them
+    if(count < mSize)
+    {
+        size_t staleEnd = std::min(mSize, paddedSize);
+        std::fill(mX.begin() + count, mX.begin() + staleEnd, 0.0F);
+        std::fill(mY.begin() + count, mY.begin() + staleEnd, 0.0F);
+        std::fill(mZ.begin() + count, mZ.begin() + staleEnd, 0.0F);
+        std::fill(mW.begin() + count, mW.begin() + staleEnd, 0.0F);
+    }
+    mX.resize(paddedSize, 0.0F);
+    mY.resize(paddedSize, 0.0F);
+    mZ.resize(paddedSize, 0.0F);
+    mW.resize(paddedSize, 0.0F);
+    mSize = count;
+}
+
+DualQuatSoA::DualQuatSoA(size_t count)
+{
+    resize(count);
+}
+
+DualQuatSoA::DualQuatSoA(const glm::dualquat* poses, size_t count)
+{
+    resize(count);
+    for(size_t idx = 0; idx < count; idx++)
+    {
+        set(idx, poses[idx]);
+    }
+}
+
+void DualQuatSoA::resize(size_t count)
+{
+    mReal.resize(count);
+    mDual.resize(count);
+}
+
+void batchNlerp(const QuatSoA& a, const QuatSoA& b, float t, QuatSoA& out)
+{
+    assert(a.size() == b.size());
+    out.resize(a.size());
+    Lane aWeight = splat(1.0F - t);
+    Lane bWeight = splat(t);
+    for(size_t idx = 0; idx < a.paddedSize(); idx += kLaneWidth)
+    {
+        QuatLanes from = loadQuat(a, idx);
+        QuatLanes to = loadQuat(b, idx);
+        // negating b where the quaternions are more than 90 degrees apart takes the shorter arc
+        to = flipSign(to, signBits(dot(from, to)));
+        QuatLanes blended = weightedSum(from, aWeight, to, bWeight);
+        storeQuat(out, idx, scale(blended, inverseLengthOrZero(dot(blended, blended))));
+    }
+}
+
+void batchSlerp(const QuatSoA& a, const QuatSoA& b, float t, QuatSoA& out)
+{
+    assert(a.size() == b.size());
+    out.resize(a.size());
+    float toCoefficients[8];
+    float fromCoefficients[8];
+    computeSlerpCoefficients(t, toCoefficients);
+    computeSlerpCoefficients(1.0F - t, fromCoefficients);
+    Lane one = splat(1.0F);
+    for(size_t idx = 0; idx < a.paddedSize(); idx += kLaneWidth)
+    {
+        QuatLanes from = loadQuat(a, idx);
+        QuatLanes to = loadQuat(b, idx);
+        Lane cosTheta = dot(from, to);
+        Lane sign = signBits(cosTheta);
+        to = flipSign(to, sign);
+        Lane cosThetaMinusOne = subtract(simd::flipSign(cosTheta, sign), one);
+        storeQuat(out, idx, weightedSum(
+                from, slerpWeight(fromCoefficients, 1.0F - t, cosThetaMinusOne),
+                to, slerpWeight(toCoefficients, t, cosThetaMinusOne)
+        ));
+    }
+}
+
+void batchDualQuatLerp(const DualQuatSoA& a, const DualQuatSoA& b, float t, DualQuatSoA& out)
+{
+    assert(a.size() == b.size());
+    out.resize(a.size());
+    Lane aWeight = splat(1.0F - t);
+    Lane bWeight = splat(t);
+    for(size_t idx = 0; idx < a.paddedSize(); idx += kLaneWidth)
+    {
+        QuatLanes fromReal = loadQuat(a.real(), idx);
+        QuatLanes toReal = loadQuat(b.real(), idx);
+        // the rotation picks the arc, and the translation part has to flip along with it
+        Lane sign = signBits(dot(fromReal, toReal));
+        toReal = flipSign(toReal, sign);
+        QuatLanes toDual = flipSign(loadQuat(b.dual(), idx), sign);
+        QuatLanes real = weightedSum(fromReal, aWeight, toReal, bWeight);
+        QuatLanes dual = weightedSum(loadQuat(a.dual(), idx), aWeight, toDual, bWeight);
+        // normalize like glm::normalize(dualquat): both parts divided by the length of the real part
+        Lane inverseLength = inverseLengthOrZero(dot(real, real));
+        storeQuat(out.real(), idx, scale(real, inverseLength));
+        storeQuat(out.dual(), idx, scale(dual, inverseLength));
+    }
+}
+
+void batchTransformPoints(const DualQuatSoA& poses, const Vec3SoA& points, Vec3SoA& out)
+{
+    assert(poses.size() == points.size());
+    out.resize(points.size());
+    Lane two = splat(2.0F);
+    for(size_t idx = 0; idx < points.paddedSize(); idx += kLaneWidth)
+    {
+        QuatLanes real = loadQuat(poses.real(), idx);
+        QuatLanes dual = loadQuat(poses.dual(), idx);
+        Lane px = load(points.x() + idx);
+        Lane py = load(points.y() + idx);
+        Lane pz = load(points.z() + idx);
+        // same expansion glm's dualquat * vec3 uses:
+        //   p + 2 * (cross(r, cross(r, p) + p * r.w + d) + d * r.w - r * d.w)
+        Lane innerX = add(add(subtract(multiply(real.y, pz), multiply(real.z, py)), multiply(px, real.w)), dual.x);
+        Lane innerY = add(add(subtract(multiply(real.z, px), multiply(real.x, pz)), multiply(py, real.w)), dual.y);
+        Lane innerZ = add(add(subtract(multiply(real.x, py), multiply(real.y, px)), multiply(pz, real.w)), dual.z);
+        Lane outerX = subtract(multiply(real.y, innerZ), multiply(real.z, innerY));
+        Lane outerY = subtract(multiply(real.z, innerX), multiply(real.x, innerZ));
+        Lane outerZ = subtract(multiply(real.x, innerY), multiply(real.y, innerX));
+        outerX = subtract(add(outerX, multiply(dual.x, real.w)), multiply(real.x, dual.w));
+        outerY = subtract(add(outerY, multiply(dual.y, real.w)), multiply(real.y, dual.w));
+        outerZ = subtract(add(outerZ, multiply(dual.z, real.w)), multiply(real.z, dual.w));
+        store(out.x() + idx, add(px, multiply(outerX, two)));
+        store(out.y() + idx, add(py, multiply(outerY, two)));
+        store(out.z() + idx, add(pz, multiply(outerZ, two)));
+    }
+}
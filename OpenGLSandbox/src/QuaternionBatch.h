@@ -0,0 +1,122 @@
+#ifndef OPENGLSANDBOX_QUATERNIONBATCH_H
+#define OPENGLSANDBOX_QUATERNIONBATCH_H
+
+#include <cstddef>
+#ifndef GLM_ENABLE_EXPERIMENTAL
+#define GLM_ENABLE_EXPERIMENTAL
+#endif
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/dual_quaternion.hpp>
+#include "Vec3SoA.h"
+
+/*
+ * Batch orientation interpolation for emitter poses.  Quaternions and dual quaternions are stored SoA like
+ * Vec3SoA, and the kernels interpolate a whole array of pose pairs per call with no per-element branches:
+ * slerp uses Eberly's polynomial approximation ("A Fast and Accurate Algorithm for Computing SLERP") in
+ * place of acos/sin, staying within 3e-5 of an exact slerp, and shortest-path sign flips are done with
+ * sign bit masks.  Dual quaternions carry rotation and translation together so rigid poses blend without
+ * the shrinking of interpolating matrices.
+ */
+
+/**
+ * A growable array of quaternions stored as separate, aligned and padded x, y, z and w arrays
+ */
+class QuatSoA
+{
+private:
+    size_t mSize = 0;
+    AlignedFloatVector mX;
+    AlignedFloatVector mY;
+    AlignedFloatVector mZ;
+    AlignedFloatVector mW;
+public:
+    QuatSoA() = default;
+    explicit QuatSoA(size_t count);
+    QuatSoA(const glm::quat* quaternions, size_t count);
+
+    size_t size() const { return mSize; }
+    size_t paddedSize() const { return mX.size(); }
+    /**
+     * Resizes to count quaternions; new quaternions, and all padding lanes, are zero
+     */
+    void resize(size_t count);
+
+    glm::quat get(size_t index) const { return glm::quat(mW[index], mX[index], mY[index], mZ[index]); }
+    void set(size_t index, const glm::quat& quaternion)
+    {
+        mX[index] = quaternion.x;
+        mY[index] = quaternion.y;
+        mZ[index] = quaternion.z;
+        mW[index] = quaternion.w;
+    }
+
+    float* x() { return mX.data(); }
+    float* y() { return mY.data(); }
+    float* z() { return mZ.data(); }
+    float* w() { return mW.data(); }
+    const float* x() const { return mX.data(); }
+    const float* y() const { return mY.data(); }
+    const float* z() const { return mZ.data(); }
+    const float* w() const { return mW.data(); }
+};
+
+/**
+ * A growable array of unit dual quaternions, i.e. rigid poses, as a real (rotation) and dual (translation)
+ * QuatSoA pair
+ */
+class DualQuatSoA
+{
+private:
+    QuatSoA mReal;
+    QuatSoA mDual;
+public:
+    DualQuatSoA() = default;
+    explicit DualQuatSoA(size_t count);
+    DualQuatSoA(const glm::dualquat* poses, size_t count);
+
+    size_t size() const { return mReal.size(); }
+    size_t paddedSize() const { return mReal.paddedSize(); }
+    void resize(size_t count);
+
+    glm::dualquat get(size_t index) const { return glm::dualquat(mReal.get(index), mDual.get(index)); }
+    void set(size_t index, const glm::dualquat& pose)
+    {
+        mReal.set(index, pose.real);
+        mDual.set(index, pose.dual);
+    }
+    /**
+     * Stores the pose rotating by orientation and then translating by position
+     */
+    void set(size_t index, const glm::quat& orientation, const glm::vec3& position)
+    {
+        set(index, glm::dualquat(orientation, position));
+    }
+
+    QuatSoA& real() { return mReal; }
+    QuatSoA& dual() { return mDual; }
+    const QuatSoA& real() const { return mReal; }
+    const QuatSoA& dual() const { return mDual; }
+};
+
+/// batch interpolation; every output is resized to match its inputs and may alias one of them ///
+
+/**
+ * out[i] = normalize(mix(a[i], +-b[i], t)), taking the shorter arc; cheap, but not constant velocity in t
+ */
+void batchNlerp(const QuatSoA& a, const QuatSoA& b, float t, QuatSoA& out);
+/**
+ * out[i] = slerp(a[i], b[i], t) along the shorter arc; a and b should be unit quaternions
+ */
+void batchSlerp(const QuatSoA& a, const QuatSoA& b, float t, QuatSoA& out);
+/**
+ * Dual quaternion linear blending of poses a[i] and b[i] along the shorter arc, renormalized
+ */
+void batchDualQuatLerp(const DualQuatSoA& a, const DualQuatSoA& b, float t, DualQuatSoA& out);
+/**
+ * out[i] = poses[i] * points[i], i.e. each point rotated and then translated by its own pose
+ */
+void batchTransformPoints(const DualQuatSoA& poses, const Vec3SoA& points, Vec3SoA& out);
+
+
+#endif //OPENGLSANDBOX_QUATERNIONBATCH_H
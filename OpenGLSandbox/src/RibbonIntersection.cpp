@@ -0,0 +1,325 @@
+#include "RibbonIntersection.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "RibbonTrail.h"
+#include "SimdLane.h"
+#include "TrailPool.h"
+
+namespace
+{
+    using namespace simd;
+
+    /**
+     * Lanes of one vector per segment, loaded from a Vec3SoA at some offset
+     */
+    struct Vec3Lanes
+    {
+        Lane x;
+        Lane y;
+        Lane z;
+    };
+
+    inline Vec3Lanes loadVec3(const Vec3SoA& vectors, size_t idx)
+    {
+        return {load(vectors.x() + idx), load(vectors.y() + idx), load(vectors.z() + idx)};
+    }
+
+    inline Vec3Lanes splatVec3(const glm::vec3& vector)
+    {
+        return {splat(vector.x), splat(vector.y), splat(vector.z)};
+    }
+
+    inline Vec3Lanes subtract(const Vec3Lanes& a, const Vec3Lanes& b)
+    {
+        return {simd::subtract(a.x, b.x), simd::subtract(a.y, b.y), simd::subtract(a.z, b.z)};
+    }
+
+    /**
+     * Same operation order as glm::dot() and glm::cross(), so results match glm's bit for bit
+     */
+    inline Lane dot(const Vec3Lanes& a, const Vec3Lanes& b)
+    {
+        return add(add(multiply(a.x, b.x), multiply(a.y, b.y)), multiply(a.z, b.z));
+    }
+
+    inline Vec3Lanes cross(const Vec3Lanes& a, const Vec3Lanes& b)
+    {
+        return {simd::subtract(multiply(a.y, b.z), multiply(b.y, a.z)),
+                simd::subtract(multiply(a.z, b.x), multiply(b.z, a.x)),
+                simd::subtract(multiply(a.x, b.y), multiply(b.x, a.y))};
+    }
+
+    /**
+     * Trail bounds are grown by this fraction of their coordinates' magnitude (plus the same absolute amount)
+     * so rounding in the slab test can't reject a hit the triangle test would accept on a bounds face
+     */
+    const float kBoundsSlack = 1e-5F;
+
+    /**
+     * Direction components smaller than this are nudged to it for the slab test, keeping its reciprocal
+     * finite so no lane ever computes 0 * infinity
+     */
+    const float kMinSlabDirection = 1e-30F;
+}
+
+void RibbonIntersector::clear()
+{
+    mTrailIds.clear();
+    mTrailFirstSegment.clear();
+    mTrailSegmentCount.clear();
+    mTrailBoundsMin.clear();
+    mTrailBoundsMax.clear();
+    mFirstOrigin.clear();
+    mFirstEdge1.clear();
+    mFirstEdge2.clear();
+    mSecondOrigin.clear();
+    mSecondEdge1.clear();
+    mSecondEdge2.clear();
+}
+
+void RibbonIntersector::addTrail(uint32_t id, const glm::vec3* vertices, size_t vertexCount)
+{
+    size_t segmentCount = vertexCount >= 4 ? vertexCount / 2 - 1 : 0;
+    mTrailIds.push_back(id);
+    mTrailFirstSegment.push_back(static_cast<uint32_t>(mFirstOrigin.size()));
+    mTrailSegmentCount.push_back(static_cast<uint32_t>(segmentCount));
+
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+    for(size_t vertIdx = 0; vertIdx < segmentCount * 2 + 2 && segmentCount > 0; vertIdx++)
+    {
+        boundsMin = glm::min(boundsMin, vertices[vertIdx]);
+        boundsMax = glm::max(boundsMax, vertices[vertIdx]);
+    }
+    if(segmentCount > 0)
+    {
+        glm::vec3 slack = (glm::abs(boundsMin) + glm::abs(boundsMax) + glm::vec3(1.0F)) * kBoundsSlack;
+        boundsMin -= slack;
+        boundsMax += slack;
+    }
+    mTrailBoundsMin.push_back(boundsMin);
+    mTrailBoundsMax.push_back(boundsMax);
+
+    for(size_t segment = 0; segment < segmentCount; segment++)
+    {
+        const glm::vec3* quad = vertices + segment * 2;
+        // the strip's triangles (0, 1, 2) and (1, 2, 3), with edges as glm::intersectRayTriangle() forms them
+        mFirstOrigin.push_back(quad[0]);
+        mFirstEdge1.push_back(quad[1] - quad[0]);
+        mFirstEdge2.push_back(quad[2] - quad[0]);
+        mSecondOrigin.push_back(quad[1]);
+        mSecondEdge1.push_back(quad[2] - quad[1]);
+        mSecondEdge2.push_back(quad[3] - quad[1]);
+    }
+    // zero edges make the padding degenerate, which the determinant test always rejects
+    while(mFirstOrigin.size() % kLaneWidth != 0)
+    {
+        mFirstOrigin.push_back(glm::vec3(0.0F));
+        mFirstEdge1.push_back(glm::vec3(0.0F));
+        mFirstEdge2.push_back(glm::vec3(0.0F));
+        mSecondOrigin.push_back(glm::vec3(0.0F));
+        mSecondEdge1.push_back(glm::vec3(0.0F));
+        mSecondEdge2.push_back(glm::vec3(0.0F));
+    }
+}
+
+void RibbonIntersector::addTrail(uint32_t id, const RibbonTrail& ribbonTrail)
+{
+    const std::deque<glm::vec3>& vertices = ribbonTrail.getVertices();
+    mScratchVertices.assign(vertices.begin(), vertices.end());
+    addTrail(id, mScratchVertices.data(), mScratchVertices.size());
+}
+
+void RibbonIntersector::addTrails(const TrailPool& pool)
+{
+    const uint8_t* flags = pool.getFlags();
+    mScratchVertices.resize(pool.getPairsPerTrail() * 2);
+    for(uint32_t slot = 0; slot < pool.getSlotCount(); slot++)
+    {
+        if(flags[slot] & TrailPool::alive)
+        {
+            size_t vertexCount = pool.copyVertices(pool.getHandle(slot), mScratchVertices.data());
+            addTrail(slot, mScratchVertices.data(), vertexCount);
+        }
+    }
+}
+
+void RibbonIntersector::findCandidateTrails(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+        std::vector<std::pair<float, uint32_t>>& candidates) const
+{
+    glm::vec3 slabDirection;
+    for(glm::length_t axis = 0; axis < 3; axis++)
+    {
+        slabDirection[axis] = std::abs(direction[axis]) < kMinSlabDirection
+                ? std::copysign(kMinSlabDirection, direction[axis]) : direction[axis];
+    }
+    Vec3Lanes rayOrigin = splatVec3(origin);
+    Vec3Lanes inverseDirection = splatVec3(1.0F / slabDirection);
+    Lane zero = splat(0.0F);
+    Lane limit = splat(maxDistance);
+    alignas(16) float entryDistances[kLaneWidth];
+    size_t trailCount = mTrailIds.size();
+    for(size_t trailIdx = 0; trailIdx < trailCount; trailIdx += kLaneWidth)
+    {
+        Vec3Lanes nearSlab = subtract(loadVec3(mTrailBoundsMin, trailIdx), rayOrigin);
+        Vec3Lanes farSlab = subtract(loadVec3(mTrailBoundsMax, trailIdx), rayOrigin);
+        Lane nearX = multiply(nearSlab.x, inverseDirection.x);
+        Lane farX = multiply(farSlab.x, inverseDirection.x);
+        Lane nearY = multiply(nearSlab.y, inverseDirection.y);
+        Lane farY = multiply(farSlab.y, inverseDirection.y);
+        Lane nearZ = multiply(nearSlab.z, inverseDirection.z);
+        Lane farZ = multiply(farSlab.z, inverseDirection.z);
+        Lane entry = maximum(maximum(zero, minimum(nearX, farX)), maximum(minimum(nearY, farY), minimum(nearZ, farZ)));
+        Lane exit = minimum(minimum(limit, maximum(nearX, farX)), minimum(maximum(nearY, farY), maximum(nearZ, farZ)));
+        int hitBits = maskBits(lessEqual(entry, exit));
+        if(hitBits == 0)
+        {
+            continue;
+        }
+        store(entryDistances, entry);
+        for(size_t lane = 0; lane < kLaneWidth; lane++)
+        {
+            // lanes past the last trail read the bounds SoA's zeroed padding, which a ray can still hit, and
+            // the min > max bounds of empty trails still make a valid slab, just inside out
+            if((hitBits & (1 << lane)) && trailIdx + lane < trailCount && mTrailSegmentCount[trailIdx + lane] > 0)
+            {
+                candidates.emplace_back(entryDistances[lane], static_cast<uint32_t>(trailIdx + lane));
+            }
+        }
+    }
+}
+
+template<typename HitHandler>
+void RibbonIntersector::intersectTrail(uint32_t trailIdx, const glm::vec3& origin, const glm::vec3& direction,
+        float maxDistance, HitHandler onHit) const
+{
+    const Vec3SoA* triangleOrigins[2] = {&mFirstOrigin, &mSecondOrigin};
+    const Vec3SoA* triangleEdges1[2] = {&mFirstEdge1, &mSecondEdge1};
+    const Vec3SoA* triangleEdges2[2] = {&mFirstEdge2, &mSecondEdge2};
+    Vec3Lanes rayOrigin = splatVec3(origin);
+    Vec3Lanes rayDirection = splatVec3(direction);
+    Lane zero = splat(0.0F);
+    Lane one = splat(1.0F);
+    Lane epsilon = splat(std::numeric_limits<float>::epsilon());
+    alignas(16) float distances[kLaneWidth];
+    alignas(16) float baryX[kLaneWidth];
+    alignas(16) float baryY[kLaneWidth];
+    float limit = maxDistance;
+    size_t firstSegment = mTrailFirstSegment[trailIdx];
+    size_t segmentCount = mTrailSegmentCount[trailIdx];
+    for(size_t segment = 0; segment < segmentCount; segment += kLaneWidth)
+    {
+        size_t segmentIdx = firstSegment + segment;
+        for(uint32_t triangle = 0; triangle < 2; triangle++)
+        {
+            // glm::intersectRayTriangle() a lane per triangle; where it branches on the determinant's sign
+            // we flip u, v and the determinant itself positive, which runs its exact comparisons on both sides
+            Vec3Lanes edge1 = loadVec3(*triangleEdges1[triangle], segmentIdx);
+            Vec3Lanes edge2 = loadVec3(*triangleEdges2[triangle], segmentIdx);
+            Vec3Lanes p = cross(rayDirection, edge2);
+            Lane det = dot(edge1, p);
+            Lane detSign = signBits(det);
+            Lane absDet = flipSign(det, detSign);
+            Vec3Lanes dist = subtract(rayOrigin, loadVec3(*triangleOrigins[triangle], segmentIdx));
+            Lane u = dot(dist, p);
+            Vec3Lanes perpendicular = cross(dist, edge1);
+            Lane v = dot(rayDirection, perpendicular);
+            Lane flippedU = flipSign(u, detSign);
+            Lane flippedV = flipSign(v, detSign);
+            Mask inside = maskAnd(maskAnd(greater(absDet, epsilon), greaterEqual(flippedU, zero)),
+                                  maskAnd(maskAnd(lessEqual(flippedU, absDet), greaterEqual(flippedV, zero)),
+                                          lessEqual(add(flippedU, flippedV), absDet)));
+            int hitBits = maskBits(inside);
+            if(hitBits == 0)
+            {
+                continue;
+            }
+            Lane inverseDet = divide(one, det);
+            Lane distance = multiply(dot(edge2, perpendicular), inverseDet);
+            hitBits &= maskBits(maskAnd(greaterEqual(distance, zero), lessEqual(distance, splat(limit))));
+            if(hitBits == 0)
+            {
+                continue;
+            }
+            store(distances, distance);
+            store(baryX, multiply(u, inverseDet));
+            store(baryY, multiply(v, inverseDet));
+            for(size_t lane = 0; lane < kLaneWidth; lane++)
+            {
+                // the limit may have dropped for an earlier lane of this batch
+                if((hitBits & (1 << lane)) && distances[lane] <= limit)
+                {
+                    RibbonHit hit;
+                    hit.trailId = mTrailIds[trailIdx];
+                    hit.segment = static_cast<uint32_t>(segment + lane);
+                    hit.triangle = triangle;
+                    hit.distance = distances[lane];
+                    hit.baryPosition = glm::vec2(baryX[lane], baryY[lane]);
+                    limit = onHit(hit);
+                }
+            }
+        }
+    }
+}
+
+bool RibbonIntersector::intersectFirst(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+        RibbonHit& hit) const
+{
+    std::vector<std::pair<float, uint32_t>> candidates;
+    findCandidateTrails(origin, direction, maxDistance, candidates);
+    // nearest bounds first, so we can stop once the next trail starts beyond our best hit
+    std::sort(candidates.begin(), candidates.end());
+    bool found = false;
+    uint32_t bestTrailIdx = 0;
+    float bestDistance = maxDistance;
+    for(const std::pair<float, uint32_t>& candidate : candidates)
+    {
+        if(candidate.first > bestDistance)
+        {
+            break;
+        }
+        uint32_t trailIdx = candidate.second;
+        intersectTrail(trailIdx, origin, direction, bestDistance, [&](const RibbonHit& candidateHit){
+            // hits come in no useful order across trails or triangles, so break distance ties on the order
+            // things were added: trail, then segment, then triangle
+            bool better = !found || candidateHit.distance < bestDistance
+                          || (candidateHit.distance == bestDistance
+                              && (trailIdx < bestTrailIdx
+                                  || (trailIdx == bestTrailIdx
+                                      && (candidateHit.segment < hit.segment
+                                          || (candidateHit.segment == hit.segment
+                                              && candidateHit.triangle < hit.triangle)))));
+            if(better)
+            {
+                hit = candidateHit;
+                bestTrailIdx = trailIdx;
+                bestDistance = candidateHit.distance;
+                found = true;
+            }
+            return bestDistance;
+        });
+    }
+    return found;
+}
+
+size_t RibbonIntersector::intersectAll(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+        std::vector<RibbonHit>& hits) const
+{
+    std::vector<std::pair<float, uint32_t>> candidates;
+    findCandidateTrails(origin, direction, maxDistance, candidates);
+    size_t firstHit = hits.size();
+    for(const std::pair<float, uint32_t>& candidate : candidates)
+    {
+        intersectTrail(candidate.second, origin, direction, maxDistance, [&](const RibbonHit& hit){
+            hits.push_back(hit);
+            return maxDistance;
+        });
+    }
+    return hits.size() - firstHit;
+}
+
+size_t RibbonIntersector::getTrailCount() const
+{
+    return mTrailIds.size();
+}
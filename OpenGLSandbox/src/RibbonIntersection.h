@@ -0,0 +1,114 @@
+#ifndef OPENGLSANDBOX_RIBBONINTERSECTION_H
+#define OPENGLSANDBOX_RIBBONINTERSECTION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Vec3SoA.h"
+
+class RibbonTrail;
+class TrailPool;
+
+/**
+ * Where a ray or segment hit a ribbon.  Each ribbon segment (quad) is the two strip triangles the ribbon is
+ * drawn with, vertices (2s, 2s+1, 2s+2) and (2s+1, 2s+2, 2s+3) counting from the tail, and distance and
+ * baryPosition follow glm::intersectRayTriangle() for that triangle: the hit is origin + direction * distance,
+ * and v0 + (v1 - v0) * baryPosition.x + (v2 - v0) * baryPosition.y
+ */
+struct RibbonHit
+{
+    uint32_t trailId;
+    uint32_t segment;
+    /**
+     * 0 for the segment's first triangle, 1 for its second
+     */
+    uint32_t triangle;
+    float distance;
+    glm::vec2 baryPosition;
+};
+
+/**
+ * Ray and segment queries against many ribbon trails at once, for gameplay-style hit detection.
+ *
+ * Like SpatialHashGrid this is rebuilt every frame: addTrail() precomputes each triangle's first vertex and
+ * edges into structure-of-arrays form, each trail's run starting on a SIMD lane boundary, and queries test
+ * simd::kLaneWidth segments (both their triangles) per iteration with the same two-sided Moller-Trumbore
+ * test glm::intersectRayTriangle() uses, so they report the same hits with the same distances and
+ * barycentrics.  Unlike glm's, hits behind the origin are rejected.  Trails whose bounds the query misses
+ * are skipped before any of their triangles are touched, with the bounds themselves slab-tested a lane's
+ * worth of trails at a time.
+ *
+ * For a segment from start to end pass direction = end - start and maxDistance = 1.
+ */
+class RibbonIntersector
+{
+private:
+    /// per-trail ///
+    std::vector<uint32_t> mTrailIds;
+    std::vector<uint32_t> mTrailFirstSegment;
+    std::vector<uint32_t> mTrailSegmentCount;
+    Vec3SoA mTrailBoundsMin;
+    Vec3SoA mTrailBoundsMax;
+    /// per-segment, each trail's run padded with degenerate segments to a multiple of the lane width ///
+    Vec3SoA mFirstOrigin;
+    Vec3SoA mFirstEdge1;
+    Vec3SoA mFirstEdge2;
+    Vec3SoA mSecondOrigin;
+    Vec3SoA mSecondEdge1;
+    Vec3SoA mSecondEdge2;
+    /**
+     * Scratch the vertices of RibbonTrail and TrailPool trails are gathered into
+     */
+    std::vector<glm::vec3> mScratchVertices;
+
+    /**
+     * Appends the trails whose bounds the ray passes through within maxDistance, with the distance it
+     * enters them at
+     */
+    void findCandidateTrails(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+            std::vector<std::pair<float, uint32_t>>& candidates) const;
+    /**
+     * Tests the ray against every segment of one trail, calling onHit(hit) for each hit no farther than the
+     * distance limit, which starts at maxDistance and is replaced by whatever onHit() returns
+     */
+    template<typename HitHandler>
+    void intersectTrail(uint32_t trailIdx, const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+            HitHandler onHit) const;
+public:
+    /**
+     * Drops every trail, keeping allocations for the next rebuild
+     */
+    void clear();
+    /**
+     * Adds a ribbon given as tri-strip vertices, oldest pair first
+     * @param id reported back in hits against it
+     * @param vertexCount number of vertices; fewer than 4 adds a trail nothing can hit
+     */
+    void addTrail(uint32_t id, const glm::vec3* vertices, size_t vertexCount);
+    void addTrail(uint32_t id, const RibbonTrail& ribbonTrail);
+    /**
+     * Adds every live trail in the pool, using its slot as the ID
+     */
+    void addTrails(const TrailPool& pool);
+
+    /**
+     * Finds the nearest hit along the ray within maxDistance of its origin, in units of direction; among
+     * equally near hits the one added first wins
+     * @return false if nothing was hit
+     */
+    bool intersectFirst(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RibbonHit& hit) const;
+    /**
+     * Appends every hit along the ray within maxDistance of its origin, in units of direction, to hits, in
+     * no particular order
+     * @return the number of hits appended
+     */
+    size_t intersectAll(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+            std::vector<RibbonHit>& hits) const;
+
+    size_t getTrailCount() const;
+};
+
+
+#endif //OPENGLSANDBOX_RIBBONINTERSECTION_H
@@ -3,14 +3,50 @@
 //
 
 #include "RibbonTrail.h"
+#include "GLResources.h"
+#include "VertexLayout.h"
+#include <utility>
 
 RibbonTrail::RibbonTrail(size_t numSegments): mNumSegments(numSegments){}
 
-// todo: presumably we'll want the ribbon trail to disappear down to nothing when the
-//  attached object stops moving, so some removeOldestVertexPair() function that
-//  gets called at a time interval possibly conditionally on whether addVertexPair() has been
-//  called within that interval (i.e. addVertexPair() resets the clock, such that we can
-//  enforce our segment cap and also support clearing the trail after idle time?)
+RibbonTrail::~RibbonTrail()
+{
+    // trails that were never uploaded (e.g. CPU-only use without a GL context) own nothing to delete
+    if(mVAO)
+    {
+        unsigned int buffers[] = {mVBO, mEBO};
+        glDeleteBuffers(2, buffers);
+        glDeleteVertexArrays(1, &mVAO);
+    }
+}
+
+RibbonTrail::RibbonTrail(RibbonTrail&& other) noexcept
+        : mVertices(std::move(other.mVertices)), mIndices(std::move(other.mIndices)), mNumSegments(other.mNumSegments),
+          mInvalidBuffers(other.mInvalidBuffers), mTotalPairsAdded(other.mTotalPairsAdded), mVAO(other.mVAO),
+          mVBO(other.mVBO), mEBO(other.mEBO), mPackedVertices(std::move(other.mPackedVertices))
+{
+    other.mVAO = 0;
+    other.mVBO = 0;
+    other.mEBO = 0;
+}
+
+RibbonTrail& RibbonTrail::operator=(RibbonTrail&& other) noexcept
+{
+    if(this != &other)
+    {
+        // swapping hands our GL objects to other, whose destructor deletes them
+        std::swap(mVertices, other.mVertices);
+        std::swap(mIndices, other.mIndices);
+        std::swap(mNumSegments, other.mNumSegments);
+        std::swap(mInvalidBuffers, other.mInvalidBuffers);
+        std::swap(mTotalPairsAdded, other.mTotalPairsAdded);
+        std::swap(mVAO, other.mVAO);
+        std::swap(mVBO, other.mVBO);
+        std::swap(mEBO, other.mEBO);
+        std::swap(mPackedVertices, other.mPackedVertices);
+    }
+    return *this;
+}
 
 void RibbonTrail::addVertexPair(glm::vec3 firstVertex, glm::vec3 secondVertex)
 {
@@ -25,6 +61,7 @@ void RibbonTrail::addVertexPair(glm::vec3 firstVertex, glm::vec3 secondVertex)
     }
     mVertices.push_back(firstVertex);
     mVertices.push_back(secondVertex);
+    mTotalPairsAdded++;
 
     // check if we need to build up indices
     if(mIndices.size() <= vertCap - 2)
@@ -55,6 +92,20 @@ void RibbonTrail::addVertexPair(glm::vec3 firstVertex, glm::vec3 secondVertex)
     }
 }
 
+bool RibbonTrail::removeOldestVertexPair()
+{
+    if(mVertices.size() < 2)
+    {
+        return false;
+    }
+    mVertices.pop_front();
+    mVertices.pop_front();
+    // index order only depends on a pair's position in the strip, so what was the second pair now
+    // uses the first pair's indices and so on; the last pair's indices are the ones to drop
+    mIndices.resize(mVertices.size());
+    return true;
+}
+
 size_t RibbonTrail::calculateMaxVertexCount() const
 {
     return 4 + 2*(mNumSegments - 1);
@@ -65,6 +116,36 @@ size_t RibbonTrail::getVertexCount()
     return mVertices.size();
 }
 
+const std::deque<glm::vec3>& RibbonTrail::getVertices() const
+{
+    return mVertices;
+}
+
+const std::vector<unsigned int>& RibbonTrail::getIndices() const
+{
+    return mIndices;
+}
+
+size_t RibbonTrail::getTotalPairsAdded() const
+{
+    return mTotalPairsAdded;
+}
+
+bool RibbonTrail::calculateBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const
+{
+    if(mVertices.empty())
+    {
+        return false;
+    }
+    boundsMin = boundsMax = mVertices.front();
+    for(const glm::vec3& vertex : mVertices)
+    {
+        boundsMin = glm::min(boundsMin, vertex);
+        boundsMax = glm::max(boundsMax, vertex);
+    }
+    return true;
+}
+
 void RibbonTrail::resetRibbon()
 {
     mVertices.clear();
@@ -76,6 +157,11 @@ void RibbonTrail::invalidateBuffers()
     mInvalidBuffers = true;
 }
 
+void RibbonTrail::validateBuffers()
+{
+    mInvalidBuffers = false;
+}
+
 bool RibbonTrail::areBuffersInvalid() const
 {
     return mInvalidBuffers;
@@ -83,70 +169,26 @@ bool RibbonTrail::areBuffersInvalid() const
 
 unsigned int RibbonTrail::generateRibbonTrailVAO()
 {
-    // Config Step 1: create vertex array object to track our config
-    unsigned int VAO;
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-
-    // Config Step 2: extract vertex data and buffer it
-    size_t vertFloatCount = mVertices.size() * 3;
-    float vertices[vertFloatCount];
-    for(size_t vertIdx = 0; vertIdx < mVertices.size(); vertIdx++)
+    // Config Step 1: on first use, create buffers big enough for the full segment count plus the
+    // vertex array object tracking our config; dynamic storage since we update them in place
+    if(!mVAO)
     {
-        vertices[vertIdx * 3] = mVertices[vertIdx].x;
-        vertices[vertIdx * 3 + 1] = mVertices[vertIdx].y;
-        vertices[vertIdx * 3 + 2] = mVertices[vertIdx].z;
+        size_t maxVertexCount = calculateMaxVertexCount();
+        mVBO = createBuffer(sizeof(PackedPositionVertex) * maxVertexCount, nullptr, GL_DYNAMIC_STORAGE_BIT);
+        mEBO = createBuffer(sizeof(unsigned int) * maxVertexCount, nullptr, GL_DYNAMIC_STORAGE_BIT);
+        mVAO = createVertexArray();
+        // ribbon vertices are half float positions feeding our aPos attribute in basic_render.vert
+        applyVertexLayout<PackedPositionVertex>(mVAO, 0, mVBO, 0);
+        setElementBuffer(mVAO, mEBO);
     }
-    unsigned int* indices = mIndices.data();
-
-    /// EBO, deals with indices above ///
-    // generate an element buffer object to manage our unique vertices in GPU memory
-    unsigned int EBO;
-    glGenBuffers(1, &EBO);
-
-    // bind our manager EBO to the appropriate type of GPU buffer,
-    // which for element buffer is GL_ELEMENT_ARRAY_BUFFER
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-
-    // upload vertex data to the GPU memory buffer we're working with,
-    // specifying its size in bytes, the data itself as float array, and
-    // finally a constant indicating how often we expect drawable data to change;
-    // since we're rendering a static tri-strip for now, static is fine.
-    glBufferData(
-            GL_ELEMENT_ARRAY_BUFFER,
-            sizeof(unsigned int) * mIndices.size(),
-            indices,
-            GL_STATIC_DRAW
-            );
-
-    /// VBO, deals with vertices defined above ///
-    // generate a vertex buffer object to manage our vertices in GPU memory
-    unsigned int VBO;
-    glGenBuffers(1, &VBO);
-
-    // bind our manager VBO to the appropriate type of GPU buffer,
-    // which for vertex buffer is GL_ARRAY_BUFFER
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-    // upload vertex data to the GPU memory buffer we're working with,
-    // specifying its size in bytes, the data itself as float array, and
-    // finally a constant indicating how often we expect drawable data to change;
-    // since we're rendering a static tri-mesh for now, static is fine.
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    // Config Step 3: configure vertex attribute pointers to tell OpenGL how to interpret buffered data
-    // 0 is the location we specified for our aPos attribute in basic_render.vert
-    glVertexAttribPointer(
-            0,
-            3,
-            GL_FLOAT,
-            GL_FALSE,
-            3 * sizeof(float),
-            (void*)nullptr
-    );
-    glEnableVertexAttribArray(0);
+
+    // Config Step 2: extract vertex data out of the deque, pack it and upload it along with the indices;
+    // named updates leave whatever VAO/buffers the render loop has bound untouched
+    std::vector<glm::vec3> vertices(mVertices.begin(), mVertices.end());
+    uploadPackedPositions(mVBO, 0, vertices.data(), vertices.size(), mPackedVertices);
+    updateBuffer(mEBO, 0, sizeof(unsigned int) * mIndices.size(), mIndices.data());
 
     // lower invalid buffer flag now that we've updated them
     mInvalidBuffers = false;
-    return VAO;
-}
\ No newline at end of file
+    return mVAO;
+}
@@ -9,6 +9,7 @@
 #include <vector>
 #include <glm/glm.hpp>
 #include <glad/glad.h>
+#include "VertexPacking.h"
 
 /**
  * A sequence of vertex pairs forming the structure of a arbitrarily oriented ribbon trail
@@ -39,6 +40,23 @@ private:
      * should regenerate the buffers via generateRibbonTrailVAO()
      */
     bool mInvalidBuffers = false;
+    /**
+     * Running count of every vertex pair ever added to this ribbon, which unlike mVertices.size()
+     * keeps growing after we hit the segment cap; consumers caching per-pair work (see
+     * RibbonTrailFeedbackCache) diff against it to find out how many new head pairs arrived
+     */
+    size_t mTotalPairsAdded = 0;
+    /**
+     * Vertex array object and buffers created by the first generateRibbonTrailVAO() call,
+     * sized for the maximum vertex count and updated in place thereafter
+     */
+    unsigned int mVAO = 0;
+    unsigned int mVBO = 0;
+    unsigned int mEBO = 0;
+    /**
+     * Scratch array the positions are packed to half floats in before upload, kept to avoid reallocating
+     */
+    std::vector<PackedPositionVertex> mPackedVertices;
 public:
     /**
      * Construct a new RibbonTrail which will build up to the given number of ribbon segments
@@ -46,6 +64,17 @@ public:
      * @param numSegments the maximum number of ribbon segments we want to render at a given time
      */
     explicit RibbonTrail(size_t numSegments);
+    /**
+     * Deletes the VAO and buffers, if generateRibbonTrailVAO() ever created them
+     */
+    ~RibbonTrail();
+    RibbonTrail(const RibbonTrail&) = delete;
+    RibbonTrail& operator=(const RibbonTrail&) = delete;
+    /**
+     * Moving hands the GL objects over, leaving the source without any, so trails can still live in vectors
+     */
+    RibbonTrail(RibbonTrail&& other) noexcept;
+    RibbonTrail& operator=(RibbonTrail&& other) noexcept;
     /**
      * Adds a vertex pair to the vertex buffer, dropping the oldest pair if we're already at capacity
      * based on the desired mNumSegments
@@ -54,7 +83,14 @@ public:
      */
     void addVertexPair(glm::vec3 firstVertex, glm::vec3 secondVertex);
     /**
-     * Generates a VAO, VBO, and EBO to render our set of vertices as a ribbon using GL_TRIANGLE_STRIP
+     * Drops the oldest vertex pair, shrinking the ribbon from its tail end; repeated calls collapse
+     * the ribbon once whatever it's attached to stops moving (see TrailEmitter)
+     * @return false if there was no pair to remove
+     */
+    bool removeOldestVertexPair();
+    /**
+     * Uploads our set of vertices and indices to render as a ribbon using GL_TRIANGLE_STRIP,
+     * generating the VAO, VBO, and EBO on first call and updating them in place on later calls
      * @return the ID of the vertex array object that can be bound at a later time for rendering use
      */
     unsigned int generateRibbonTrailVAO();
@@ -68,6 +104,27 @@ public:
      *         that currently comprise this ribbon trail
      */
     size_t getVertexCount();
+    /**
+     * @return the vertices currently comprising this ribbon trail, oldest first
+     */
+    const std::deque<glm::vec3>& getVertices() const;
+    /**
+     * @return the tri-strip indices into getVertices() that render this ribbon trail
+     */
+    const std::vector<unsigned int>& getIndices() const;
+    /**
+     * @return the total number of vertex pairs ever added to this ribbon, including those
+     *         since discarded from the tail
+     */
+    size_t getTotalPairsAdded() const;
+    /**
+     * Computes the axis-aligned bounds of the current ribbon structure; both corners are
+     * left untouched if the ribbon is empty
+     * @param boundsMin receives the minimum corner
+     * @param boundsMax receives the maximum corner
+     * @return false if the ribbon has no vertices, else true
+     */
+    bool calculateBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const;
     /**
      * Resets mVertices and mIndices containers, emptying the ribbon's structure
      */
@@ -76,6 +133,11 @@ public:
      * Raises the mInvalidBuffers flag
      */
     void invalidateBuffers();
+    /**
+     * Lowers the mInvalidBuffers flag, for consumers uploading the trail's data themselves
+     * (see RibbonTrailUploader)
+     */
+    void validateBuffers();
     /**
      * @return true if the VBO and EBO are no longer valid with respect to
      *         underlying data and need to be updated via a fresh call
@@ -0,0 +1,147 @@
+#include "RibbonTrailFeedbackCache.h"
+#include "GLResources.h"
+#include "VertexLayout.h"
+#include <algorithm>
+
+RibbonTrailFeedbackCache::RibbonTrailFeedbackCache(unsigned int captureProgramId, size_t maxVertexCount):
+    mCaptureProgramId(captureProgramId), mCapacityPairs(maxVertexCount / 2)
+{
+    GLsizeiptr ringBytes = sizeof(glm::vec3) * mCapacityPairs * 2;
+
+    // raw head vertices for the capture pass; at most a full ring's worth per update
+    mSourceVBO = createBuffer(ringBytes, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    mCaptureVAO = createVertexArray();
+    // raw positions feed aPos in ribbontrail_process.vert
+    applyVertexLayout<PositionVertex>(mCaptureVAO, 0, mSourceVBO, 0);
+
+    // processed vertices; written by the GPU only, so the contents never round-trip through the CPU
+    mFeedbackBuffer = createBuffer(ringBytes, nullptr, 0);
+    mElementBuffer = createBuffer(sizeof(unsigned int) * mCapacityPairs * 2, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    mRenderVAO = createVertexArray();
+    // processed positions feed aPos in whichever render program draws the cached trail
+    applyVertexLayout<PositionVertex>(mRenderVAO, 0, mFeedbackBuffer, 0);
+    setElementBuffer(mRenderVAO, mElementBuffer);
+
+    mRemappedIndices.reserve(mCapacityPairs * 2);
+}
+
+RibbonTrailFeedbackCache::~RibbonTrailFeedbackCache()
+{
+    unsigned int buffers[] = {mSourceVBO, mFeedbackBuffer, mElementBuffer};
+    glDeleteBuffers(3, buffers);
+    unsigned int vertexArrays[] = {mCaptureVAO, mRenderVAO};
+    glDeleteVertexArrays(2, vertexArrays);
+}
+
+void RibbonTrailFeedbackCache::capturePairs(size_t firstSourcePair, size_t ringSlot, size_t count)
+{
+    GLsizeiptr pairBytes = sizeof(glm::vec3) * 2;
+    glBindBufferRange(
+            GL_TRANSFORM_FEEDBACK_BUFFER,
+            0,
+            mFeedbackBuffer,
+            pairBytes * ringSlot,
+            pairBytes * count
+    );
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, firstSourcePair * 2, count * 2);
+    glEndTransformFeedback();
+}
+
+void RibbonTrailFeedbackCache::update(const RibbonTrail& ribbonTrail)
+{
+    const std::deque<glm::vec3>& vertices = ribbonTrail.getVertices();
+    size_t trailPairs = vertices.size() / 2;
+    size_t totalPairs = ribbonTrail.getTotalPairsAdded();
+    if(totalPairs == mProcessedPairs && trailPairs == mResidentPairs)
+    {
+        // nothing new at the head, cached pairs and indices are still good
+        return;
+    }
+
+    // every pair added since last time is new; pairs only ever leave the trail from the tail (the segment cap,
+    // idle collapse, a reset), so the trail is always the newest trailPairs pairs and anything it holds that
+    // isn't new should already be resident.  If it isn't (we were invalidated) we start the ring over
+    size_t newPairs = totalPairs >= mProcessedPairs ? totalPairs - mProcessedPairs : trailPairs;
+    if(trailPairs > mResidentPairs + newPairs)
+    {
+        mResidentPairs = 0;
+        mRingHeadPair = 0;
+        newPairs = trailPairs;
+    }
+    // pairs added and already discarded again between updates never need processing
+    size_t capturePairCount = std::min(newPairs, trailPairs);
+
+    if(capturePairCount > 0)
+    {
+        // Capture Step 1: stage just the raw head pairs
+        size_t firstVertex = vertices.size() - capturePairCount * 2;
+        std::vector<glm::vec3> headVertices(vertices.begin() + firstVertex, vertices.end());
+        updateBuffer(mSourceVBO, 0, sizeof(glm::vec3) * headVertices.size(), headVertices.data());
+
+        // Capture Step 2: run them through the processing stage with rasterization off, splitting the
+        // run in two if it wraps past the end of the ring
+        glUseProgram(mCaptureProgramId);
+        glBindVertexArray(mCaptureVAO);
+        glEnable(GL_RASTERIZER_DISCARD);
+        size_t firstRun = std::min(capturePairCount, mCapacityPairs - mRingHeadPair);
+        capturePairs(0, mRingHeadPair, firstRun);
+        if(firstRun < capturePairCount)
+        {
+            capturePairs(firstRun, 0, capturePairCount - firstRun);
+        }
+        glDisable(GL_RASTERIZER_DISCARD);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+        mRingHeadPair = (mRingHeadPair + capturePairCount) % mCapacityPairs;
+    }
+    mResidentPairs = trailPairs;
+    mProcessedPairs = totalPairs;
+
+    // Capture Step 3: the trail's indices address vertices oldest-first, so rotate them onto the ring
+    size_t oldestSlot = (mRingHeadPair + mCapacityPairs - mResidentPairs) % mCapacityPairs;
+    mRemappedIndices.clear();
+    for(unsigned int logicalIdx : ribbonTrail.getIndices())
+    {
+        if(logicalIdx >= vertices.size())
+        {
+            break;
+        }
+        size_t slot = (oldestSlot + logicalIdx / 2) % mCapacityPairs;
+        mRemappedIndices.push_back(static_cast<unsigned int>(slot * 2 + logicalIdx % 2));
+    }
+    mElementCount = static_cast<GLsizei>(mRemappedIndices.size());
+    updateBuffer(mElementBuffer, 0, sizeof(unsigned int) * mRemappedIndices.size(), mRemappedIndices.data());
+}
+
+void RibbonTrailFeedbackCache::invalidate()
+{
+    mResidentPairs = 0;
+    mRingHeadPair = 0;
+    mProcessedPairs = 0;
+    mElementCount = 0;
+}
+
+unsigned int RibbonTrailFeedbackCache::getRenderVAO() const
+{
+    return mRenderVAO;
+}
+
+GLsizei RibbonTrailFeedbackCache::getElementCount() const
+{
+    return mElementCount;
+}
+
+size_t RibbonTrailFeedbackCache::getCapacityPairs() const
+{
+    return mCapacityPairs;
+}
+
+size_t RibbonTrailFeedbackCache::getNewestPairSlot() const
+{
+    return (mRingHeadPair + mCapacityPairs - 1) % mCapacityPairs;
+}
+
+size_t RibbonTrailFeedbackCache::getResidentPairCount() const
+{
+    return mResidentPairs;
+}
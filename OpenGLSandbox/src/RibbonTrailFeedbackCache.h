@@ -0,0 +1,121 @@
+#ifndef OPENGLSANDBOX_RIBBONTRAILFEEDBACKCACHE_H
+#define OPENGLSANDBOX_RIBBONTRAILFEEDBACKCACHE_H
+
+#include <vector>
+#include <glad/glad.h>
+#include "RibbonTrail.h"
+
+/**
+ * Caches the output of the ribbon trail's per-vertex processing stage on the GPU using transform feedback.
+ * Once a vertex pair has been pushed through the capture program its processed position lives in a ring
+ * of pair-sized slots in mFeedbackBuffer and is never touched again; each update only runs the capture
+ * program over the pairs added at the head of the trail since the last update, and rebuilds the (tiny)
+ * index buffer so the tri-strip walks the ring slots in trail order.
+ *
+ * The capture program must be linked with a single interleaved vec3 varying (see
+ * loadTransformFeedbackShader() in main.cpp and ribbontrail_process.vert), and anything time-dependent
+ * belongs in the render program instead, since cached vertices are reused verbatim across frames.
+ */
+class RibbonTrailFeedbackCache
+{
+private:
+    /**
+     * Shader program whose vertex stage processes raw trail vertices and whose output we capture
+     */
+    unsigned int mCaptureProgramId;
+    /**
+     * Maximum number of vertex pairs the ring can hold, matching the trail's segment cap
+     */
+    size_t mCapacityPairs;
+    /**
+     * VAO reading raw head vertices out of mSourceVBO for the capture pass
+     */
+    unsigned int mCaptureVAO = 0;
+    /**
+     * Staging buffer receiving only the raw vertices of newly added head pairs
+     */
+    unsigned int mSourceVBO = 0;
+    /**
+     * Ring of processed vertex pairs written by transform feedback
+     */
+    unsigned int mFeedbackBuffer = 0;
+    /**
+     * VAO reading processed vertices out of mFeedbackBuffer for rendering, with mElementBuffer attached
+     */
+    unsigned int mRenderVAO = 0;
+    /**
+     * Element buffer holding the trail's tri-strip indices remapped onto ring slots
+     */
+    unsigned int mElementBuffer = 0;
+    /**
+     * Value of RibbonTrail::getTotalPairsAdded() as of our last update
+     */
+    size_t mProcessedPairs = 0;
+    /**
+     * Number of pairs currently held in the ring, i.e. the trail's pair count as of our last update
+     */
+    size_t mResidentPairs = 0;
+    /**
+     * Ring slot the next processed pair will be captured into
+     */
+    size_t mRingHeadPair = 0;
+    /**
+     * Number of indices currently in mElementBuffer, i.e. how many elements render() should draw
+     */
+    GLsizei mElementCount = 0;
+    /**
+     * Scratch space for remapped indices so we don't allocate every update
+     */
+    std::vector<unsigned int> mRemappedIndices;
+    /**
+     * Runs the capture program over count raw vertex pairs starting at firstSourcePair in mSourceVBO,
+     * writing them into consecutive ring slots starting at ringSlot; the caller guarantees the run
+     * doesn't wrap around the end of the ring
+     */
+    void capturePairs(size_t firstSourcePair, size_t ringSlot, size_t count);
+public:
+    /**
+     * Allocates the GPU buffers for a ribbon trail with the given maximum vertex count.
+     * Must be called on the thread owning the current GL context.
+     * @param captureProgramId program linked for transform feedback capture of a single vec3 varying
+     * @param maxVertexCount the trail's RibbonTrail::calculateMaxVertexCount()
+     */
+    RibbonTrailFeedbackCache(unsigned int captureProgramId, size_t maxVertexCount);
+    ~RibbonTrailFeedbackCache();
+    RibbonTrailFeedbackCache(const RibbonTrailFeedbackCache&) = delete;
+    RibbonTrailFeedbackCache& operator=(const RibbonTrailFeedbackCache&) = delete;
+    /**
+     * Processes any vertex pairs added to the trail since the last update and refreshes the index
+     * buffer; if the trail was reset or otherwise diverged from what we hold, the whole trail is reprocessed
+     * @param ribbonTrail the trail whose vertices we cache
+     */
+    void update(const RibbonTrail& ribbonTrail);
+    /**
+     * Drops all cached pairs so the next update() reprocesses the full trail, e.g. after the
+     * capture program's inputs (uniforms) changed
+     */
+    void invalidate();
+    /**
+     * @return the ID of the vertex array object rendering the cached, processed trail
+     */
+    unsigned int getRenderVAO() const;
+    /**
+     * @return the number of elements to draw from getRenderVAO() using GL_TRIANGLE_STRIP
+     */
+    GLsizei getElementCount() const;
+    /**
+     * @return the number of pair slots in the ring; slot p holds vertices 2p and 2p + 1 of getRenderVAO()
+     */
+    size_t getCapacityPairs() const;
+    /**
+     * @return the ring slot holding the trail's newest pair, as of the last update
+     */
+    size_t getNewestPairSlot() const;
+    /**
+     * @return the number of pairs held in the ring, as of the last update
+     */
+    size_t getResidentPairCount() const;
+};
+
+
+#endif //OPENGLSANDBOX_RIBBONTRAILFEEDBACKCACHE_H
@@ -0,0 +1,78 @@
+#include "RibbonTrailUploader.h"
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "BackgroundLoader.h"
+#include "GLResources.h"
+#include "RibbonTrail.h"
+#include "VertexLayout.h"
+#include "VertexPacking.h"
+
+RibbonTrailUploader::RibbonTrailUploader(BackgroundLoader& loader, size_t maxVertexCount): mLoader(loader)
+{
+    for(BufferSet& bufferSet : mBufferSets)
+    {
+        bufferSet.vbo = createBuffer(sizeof(PackedPositionVertex) * maxVertexCount, nullptr, GL_DYNAMIC_STORAGE_BIT);
+        bufferSet.ebo = createBuffer(sizeof(unsigned int) * maxVertexCount, nullptr, GL_DYNAMIC_STORAGE_BIT);
+        bufferSet.vao = createVertexArray();
+        applyVertexLayout<PackedPositionVertex>(bufferSet.vao, 0, bufferSet.vbo, 0);
+        setElementBuffer(bufferSet.vao, bufferSet.ebo);
+    }
+}
+
+RibbonTrailUploader::~RibbonTrailUploader()
+{
+    for(BufferSet& bufferSet : mBufferSets)
+    {
+        unsigned int buffers[] = {bufferSet.vbo, bufferSet.ebo};
+        glDeleteBuffers(2, buffers);
+        glDeleteVertexArrays(1, &bufferSet.vao);
+    }
+}
+
+bool RibbonTrailUploader::update(RibbonTrail& trail)
+{
+    if(mUploadInFlight || !trail.areBuffersInvalid())
+    {
+        return false;
+    }
+
+    // Update Step 1: snapshot the trail here, since it keeps changing while the loader works
+    struct Snapshot
+    {
+        std::vector<glm::vec3> vertices;
+        std::vector<unsigned int> indices;
+        std::vector<PackedPositionVertex> packedVertices;
+    };
+    std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+    snapshot->vertices.assign(trail.getVertices().begin(), trail.getVertices().end());
+    snapshot->indices = trail.getIndices();
+    trail.validateBuffers();
+
+    // Update Step 2: fill the set we aren't drawing from on the loader thread, and swap to it once it's in
+    int uploadSet = mDrawSet == 0 ? 1 : 0;
+    unsigned int vbo = mBufferSets[uploadSet].vbo;
+    unsigned int ebo = mBufferSets[uploadSet].ebo;
+    GLsizei indexCount = static_cast<GLsizei>(snapshot->indices.size());
+    mLoader.submit([snapshot, vbo, ebo](){
+        uploadPackedPositions(vbo, 0, snapshot->vertices.data(), snapshot->vertices.size(), snapshot->packedVertices);
+        updateBuffer(ebo, 0, sizeof(unsigned int) * snapshot->indices.size(), snapshot->indices.data());
+    }, [this, uploadSet, indexCount](){
+        mBufferSets[uploadSet].indexCount = indexCount;
+        mDrawSet = uploadSet;
+        mUploadInFlight = false;
+    });
+    // a synchronous loader has already run onReady, so only flag an upload that's actually still going
+    mUploadInFlight = mDrawSet != uploadSet;
+    return true;
+}
+
+unsigned int RibbonTrailUploader::getVAO() const
+{
+    return mDrawSet < 0 ? 0 : mBufferSets[mDrawSet].vao;
+}
+
+GLsizei RibbonTrailUploader::getIndexCount() const
+{
+    return mDrawSet < 0 ? 0 : mBufferSets[mDrawSet].indexCount;
+}
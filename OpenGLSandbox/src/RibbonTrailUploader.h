@@ -0,0 +1,63 @@
+#ifndef OPENGLSANDBOX_RIBBONTRAILUPLOADER_H
+#define OPENGLSANDBOX_RIBBONTRAILUPLOADER_H
+
+#include <cstddef>
+#include <glad/glad.h>
+
+class BackgroundLoader;
+class RibbonTrail;
+
+/**
+ * Uploads a RibbonTrail's vertices and indices on a BackgroundLoader's thread instead of in
+ * generateRibbonTrailVAO() on the render thread.  There are two sets of buffers: the render thread keeps
+ * drawing from one while the loader fills the other, and the two swap roles when the upload is handed
+ * over, so a frame never waits on an upload and never draws a half-written trail.  The VAOs are created
+ * here on the render thread, since VAOs aren't shared between contexts.
+ */
+class RibbonTrailUploader
+{
+private:
+    struct BufferSet
+    {
+        unsigned int vao = 0;
+        unsigned int vbo = 0;
+        unsigned int ebo = 0;
+        GLsizei indexCount = 0;
+    };
+    BackgroundLoader& mLoader;
+    BufferSet mBufferSets[2];
+    /**
+     * The set the render thread draws from, or -1 until the first upload lands; uploads go to the other
+     */
+    int mDrawSet = -1;
+    bool mUploadInFlight = false;
+public:
+    /**
+     * Creates both buffer sets; must be called on the render thread
+     * @param maxVertexCount the trail's RibbonTrail::calculateMaxVertexCount()
+     */
+    RibbonTrailUploader(BackgroundLoader& loader, size_t maxVertexCount);
+    /**
+     * Must run after the loader is destroyed, or while no upload is in flight
+     */
+    ~RibbonTrailUploader();
+    RibbonTrailUploader(const RibbonTrailUploader&) = delete;
+    RibbonTrailUploader& operator=(const RibbonTrailUploader&) = delete;
+    /**
+     * Snapshots the trail and submits its upload if its buffers are invalid and no upload is already in
+     * flight; otherwise the trail stays invalid and is picked up by a later call.  Call once per frame
+     * @return true if an upload was submitted
+     */
+    bool update(RibbonTrail& trail);
+    /**
+     * @return the VAO of the most recently uploaded trail, or 0 if none has landed yet
+     */
+    unsigned int getVAO() const;
+    /**
+     * @return the number of tri-strip indices to draw with getVAO()
+     */
+    GLsizei getIndexCount() const;
+};
+
+
+#endif //OPENGLSANDBOX_RIBBONTRAILUPLOADER_H
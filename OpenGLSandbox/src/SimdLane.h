@@ -0,0 +1,146 @@
+#ifndef OPENGLSANDBOX_SIMDLANE_H
+#define OPENGLSANDBOX_SIMDLANE_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define OPENGLSANDBOX_SIMD_LANE_SSE 1
+#include <emmintrin.h>
+#endif
+
+/*
+ * A small lane abstraction the SoA batch kernels are written once against: four floats in an SSE register on
+ * x86-64, where SSE2 is always available, or a single float anywhere else.  Loads and stores are aligned, so
+ * kernels walk padded, aligned SoA arrays (see Vec3SoA.h) kLaneWidth floats at a time.
+ */
+namespace simd
+{
+#ifdef OPENGLSANDBOX_SIMD_LANE_SSE
+    typedef __m128 Lane;
+    constexpr size_t kLaneWidth = 4;
+    inline Lane load(const float* source) { return _mm_load_ps(source); }
+    inline void store(float* destination, Lane value) { _mm_store_ps(destination, value); }
+    inline Lane splat(float value) { return _mm_set1_ps(value); }
+    inline Lane add(Lane a, Lane b) { return _mm_add_ps(a, b); }
+    inline Lane subtract(Lane a, Lane b) { return _mm_sub_ps(a, b); }
+    inline Lane multiply(Lane a, Lane b) { return _mm_mul_ps(a, b); }
+    inline Lane divide(Lane a, Lane b) { return _mm_div_ps(a, b); }
+    inline Lane squareRoot(Lane value) { return _mm_sqrt_ps(value); }
+    inline Lane minimum(Lane a, Lane b) { return _mm_min_ps(a, b); }
+    inline Lane maximum(Lane a, Lane b) { return _mm_max_ps(a, b); }
+    /**
+     * Rounds toward negative infinity; only valid for |value| < 2^31, which is all the callers need
+     */
+    inline Lane floor(Lane value)
+    {
+        Lane truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(value));
+        return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, value), _mm_set1_ps(1.0F)));
+    }
+    /**
+     * @return 0, 1, 2, ... kLaneWidth - 1, e.g. to step a coordinate across the lanes
+     */
+    inline Lane laneIndices() { return _mm_set_ps(3.0F, 2.0F, 1.0F, 0.0F); }
+    /**
+     * @return just the sign bit of every lane, for flipSign()
+     */
+    inline Lane signBits(Lane value) { return _mm_and_ps(value, _mm_set1_ps(-0.0F)); }
+    /**
+     * Negates the lanes of value whose sign bit is set in sign
+     */
+    inline Lane flipSign(Lane value, Lane sign) { return _mm_xor_ps(value, sign); }
+    /**
+     * 1/sqrt(lengthSquared), or 0 where lengthSquared is 0; a true division and sqrt rather than rsqrt's
+     * 12 bits, so results match glm::normalize
+     */
+    inline Lane inverseLengthOrZero(Lane lengthSquared)
+    {
+        Lane inverse = _mm_div_ps(_mm_set1_ps(1.0F), _mm_sqrt_ps(lengthSquared));
+        return _mm_and_ps(inverse, _mm_cmpgt_ps(lengthSquared, _mm_setzero_ps()));
+    }
+    inline float reduceMin(Lane value)
+    {
+        value = _mm_min_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+        value = _mm_min_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(value);
+    }
+    inline float reduceMax(Lane value)
+    {
+        value = _mm_max_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+        value = _mm_max_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(value);
+    }
+    /**
+     * Per-lane comparison results, all bits set where true, to combine with maskAnd() and read back with
+     * maskBits()
+     */
+    typedef __m128 Mask;
+    inline Mask lessEqual(Lane a, Lane b) { return _mm_cmple_ps(a, b); }
+    inline Mask greaterEqual(Lane a, Lane b) { return _mm_cmpge_ps(a, b); }
+    inline Mask greater(Lane a, Lane b) { return _mm_cmpgt_ps(a, b); }
+    inline Mask maskAnd(Mask a, Mask b) { return _mm_and_ps(a, b); }
+    /**
+     * @return bit i set if lane i of mask is true
+     */
+    inline int maskBits(Mask mask) { return _mm_movemask_ps(mask); }
+    /**
+     * @return ifTrue's lanes where mask is true, ifFalse's elsewhere
+     */
+    inline Lane select(Mask mask, Lane ifTrue, Lane ifFalse)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse));
+    }
+    /**
+     * Rounds four channels in [0, 255] to the nearest integer and stores them interleaved as kLaneWidth
+     * RGBA8 pixels; destination needn't be aligned
+     */
+    inline void storeRgba8(uint8_t* destination, Lane r, Lane g, Lane b, Lane a)
+    {
+        __m128i pixels = _mm_or_si128(
+                _mm_or_si128(_mm_cvtps_epi32(r), _mm_slli_epi32(_mm_cvtps_epi32(g), 8)),
+                _mm_or_si128(_mm_slli_epi32(_mm_cvtps_epi32(b), 16), _mm_slli_epi32(_mm_cvtps_epi32(a), 24)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), pixels);
+    }
+#else
+    typedef float Lane;
+    constexpr size_t kLaneWidth = 1;
+    inline Lane load(const float* source) { return *source; }
+    inline void store(float* destination, Lane value) { *destination = value; }
+    inline Lane splat(float value) { return value; }
+    inline Lane add(Lane a, Lane b) { return a + b; }
+    inline Lane subtract(Lane a, Lane b) { return a - b; }
+    inline Lane multiply(Lane a, Lane b) { return a * b; }
+    inline Lane divide(Lane a, Lane b) { return a / b; }
+    inline Lane squareRoot(Lane value) { return std::sqrt(value); }
+    inline Lane minimum(Lane a, Lane b) { return b < a ? b : a; }
+    inline Lane maximum(Lane a, Lane b) { return a < b ? b : a; }
+    inline Lane floor(Lane value) { return std::floor(value); }
+    inline Lane laneIndices() { return 0.0F; }
+    inline Lane signBits(Lane value) { return std::signbit(value) ? -0.0F : 0.0F; }
+    inline Lane flipSign(Lane value, Lane sign) { return std::signbit(sign) ? -value : value; }
+    inline Lane inverseLengthOrZero(Lane lengthSquared)
+    {
+        return lengthSquared > 0.0F ? 1.0F / std::sqrt(lengthSquared) : 0.0F;
+    }
+    inline float reduceMin(Lane value) { return value; }
+    inline float reduceMax(Lane value) { return value; }
+    typedef bool Mask;
+    inline Mask lessEqual(Lane a, Lane b) { return a <= b; }
+    inline Mask greaterEqual(Lane a, Lane b) { return a >= b; }
+    inline Mask greater(Lane a, Lane b) { return a > b; }
+    inline Mask maskAnd(Mask a, Mask b) { return a && b; }
+    inline int maskBits(Mask mask) { return mask ? 1 : 0; }
+    inline Lane select(Mask mask, Lane ifTrue, Lane ifFalse) { return mask ? ifTrue : ifFalse; }
+    inline void storeRgba8(uint8_t* destination, Lane r, Lane g, Lane b, Lane a)
+    {
+        destination[0] = static_cast<uint8_t>(std::lrint(r));
+        destination[1] = static_cast<uint8_t>(std::lrint(g));
+        destination[2] = static_cast<uint8_t>(std::lrint(b));
+        destination[3] = static_cast<uint8_t>(std::lrint(a));
+    }
+#endif
+}
+
+
+#endif //OPENGLSANDBOX_SIMDLANE_H
@@ -0,0 +1,288 @@
+#include "SpatialHashGrid.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include "RibbonTrail.h"
+#include "TrailPool.h"
+
+namespace
+{
+    /**
+     * Cell coordinates are clamped to this, so boxes reaching towards infinity can't overflow the cell math
+     */
+    const double kMaxCellCoordinate = 1 << 30;
+}
+
+SpatialHashGrid::SpatialHashGrid(float cellSize): mCellSize(cellSize), mInverseCellSize(1.0F / cellSize)
+{
+    assert(cellSize > 0.0F);
+}
+
+glm::ivec3 SpatialHashGrid::cellOf(const glm::vec3& position) const
+{
+    glm::ivec3 cell;
+    for(glm::length_t axis = 0; axis < 3; axis++)
+    {
+        double coordinate = std::floor(static_cast<double>(position[axis]) * mInverseCellSize);
+        cell[axis] = static_cast<int>(std::max(-kMaxCellCoordinate, std::min(kMaxCellCoordinate, coordinate)));
+    }
+    return cell;
+}
+
+uint32_t SpatialHashGrid::bucketOf(const glm::ivec3& cell) const
+{
+    // the large-prime spatial hash of Teschner et al., except x is added rather than multiplied in, so a
+    // row of cells lands in consecutive buckets and a query's inner loop reads contiguous memory; unsigned so
+    // the products wrap rather than overflow
+    uint32_t hash = ((static_cast<uint32_t>(cell.y) * 19349663U) ^ (static_cast<uint32_t>(cell.z) * 83492791U))
+                    + static_cast<uint32_t>(cell.x);
+    return hash & mBucketMask;
+}
+
+void SpatialHashGrid::clear()
+{
+    mEntryIds.clear();
+    mEntryMin.clear();
+    mEntryMax.clear();
+    mBucketStart.clear();
+    mRecords.clear();
+    mOversizedEntries.clear();
+    mBuiltEntryCount = 0;
+}
+
+void SpatialHashGrid::insertPoint(uint32_t id, const glm::vec3& position)
+{
+    insertBox(id, position, position);
+}
+
+void SpatialHashGrid::insertBox(uint32_t id, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    mEntryIds.push_back(id);
+    mEntryMin.push_back(boundsMin);
+    mEntryMax.push_back(boundsMax);
+}
+
+void SpatialHashGrid::insertTrailBounds(const TrailPool& pool)
+{
+    const uint8_t* flags = pool.getFlags();
+    const uint32_t* pairCounts = pool.getPairCounts();
+    for(uint32_t slot = 0; slot < pool.getSlotCount(); slot++)
+    {
+        if((flags[slot] & TrailPool::alive) && pairCounts[slot] > 0)
+        {
+            insertBox(slot, pool.getBoundsMin().get(slot), pool.getBoundsMax().get(slot));
+        }
+    }
+}
+
+void SpatialHashGrid::insertTrailSegments(const RibbonTrail& ribbonTrail)
+{
+    const std::deque<glm::vec3>& vertices = ribbonTrail.getVertices();
+    for(size_t vertIdx = 0; vertIdx + 3 < vertices.size(); vertIdx += 2)
+    {
+        glm::vec3 boundsMin = glm::min(glm::min(vertices[vertIdx], vertices[vertIdx + 1]),
+                                       glm::min(vertices[vertIdx + 2], vertices[vertIdx + 3]));
+        glm::vec3 boundsMax = glm::max(glm::max(vertices[vertIdx], vertices[vertIdx + 1]),
+                                       glm::max(vertices[vertIdx + 2], vertices[vertIdx + 3]));
+        insertBox(static_cast<uint32_t>(vertIdx / 2), boundsMin, boundsMax);
+    }
+}
+
+void SpatialHashGrid::build()
+{
+    size_t entryCount = mEntryIds.size();
+    // Build Step 1: list every cell each entry overlaps
+    mInsertionCells.clear();
+    mInsertionEntries.clear();
+    mOversizedEntries.clear();
+    for(uint32_t entryIdx = 0; entryIdx < entryCount; entryIdx++)
+    {
+        glm::ivec3 cellMin = cellOf(mEntryMin[entryIdx]);
+        glm::ivec3 cellMax = cellOf(mEntryMax[entryIdx]);
+        glm::i64vec3 span = glm::i64vec3(cellMax) - glm::i64vec3(cellMin) + glm::i64vec3(1);
+        if(span.x <= 0 || span.y <= 0 || span.z <= 0)
+        {
+            // inverted bounds overlap nothing
+            continue;
+        }
+        if(span.x * span.y * span.z > static_cast<int64_t>(kMaxCellsPerEntry))
+        {
+            mOversizedEntries.push_back(entryIdx);
+            continue;
+        }
+        glm::ivec3 cell;
+        for(cell.z = cellMin.z; cell.z <= cellMax.z; cell.z++)
+        {
+            for(cell.y = cellMin.y; cell.y <= cellMax.y; cell.y++)
+            {
+                for(cell.x = cellMin.x; cell.x <= cellMax.x; cell.x++)
+                {
+                    mInsertionCells.push_back(cell);
+                    mInsertionEntries.push_back(entryIdx);
+                }
+            }
+        }
+    }
+
+    // Build Step 2: size the bucket table to the record count, so buckets average at most one cell's records
+    size_t recordCount = mInsertionCells.size();
+    size_t bucketCount = 8;
+    while(bucketCount < recordCount)
+    {
+        bucketCount *= 2;
+    }
+    mBucketMask = static_cast<uint32_t>(bucketCount - 1);
+
+    // Build Step 3: counting sort the records by bucket; after the prefix sum mBucketStart[b] is the end of
+    // bucket b, and filling each bucket back to front while walking the records backwards leaves it
+    // pointing at the start, with records in insertion order
+    mInsertionBuckets.resize(recordCount);
+    mBucketStart.assign(bucketCount + 1, 0);
+    for(size_t recordIdx = 0; recordIdx < recordCount; recordIdx++)
+    {
+        mInsertionBuckets[recordIdx] = bucketOf(mInsertionCells[recordIdx]);
+        mBucketStart[mInsertionBuckets[recordIdx]]++;
+    }
+    for(size_t bucketIdx = 1; bucketIdx < bucketCount; bucketIdx++)
+    {
+        mBucketStart[bucketIdx] += mBucketStart[bucketIdx - 1];
+    }
+    mBucketStart[bucketCount] = static_cast<uint32_t>(recordCount);
+    mRecords.resize(recordCount);
+    for(size_t recordIdx = recordCount; recordIdx-- > 0;)
+    {
+        CellRecord& record = mRecords[--mBucketStart[mInsertionBuckets[recordIdx]]];
+        uint32_t entryIdx = mInsertionEntries[recordIdx];
+        record.cell = mInsertionCells[recordIdx];
+        record.entryIdx = entryIdx;
+        record.boundsMin = mEntryMin[entryIdx];
+        record.boundsMax = mEntryMax[entryIdx];
+    }
+    mBuiltEntryCount = entryCount;
+}
+
+template<typename Visitor>
+void SpatialHashGrid::visitCandidates(const glm::vec3& boundsMin, const glm::vec3& boundsMax, Visitor visit) const
+{
+    if(mBuiltEntryCount == 0)
+    {
+        return;
+    }
+    glm::ivec3 cellMin = cellOf(boundsMin);
+    glm::ivec3 cellMax = cellOf(boundsMax);
+    glm::i64vec3 span = glm::i64vec3(cellMax) - glm::i64vec3(cellMin) + glm::i64vec3(1);
+    if(span.x <= 0 || span.y <= 0 || span.z <= 0)
+    {
+        return;
+    }
+    if(span.x * span.y * span.z > static_cast<int64_t>(mBucketStart.size() - 1))
+    {
+        // walking the cells would visit every bucket at least once anyway
+        for(uint32_t entryIdx = 0; entryIdx < mBuiltEntryCount; entryIdx++)
+        {
+            if(glm::all(glm::lessThanEqual(mEntryMin[entryIdx], mEntryMax[entryIdx]))
+               && glm::all(glm::lessThanEqual(mEntryMin[entryIdx], boundsMax))
+               && glm::all(glm::lessThanEqual(boundsMin, mEntryMax[entryIdx])))
+            {
+                visit(entryIdx, mEntryMin[entryIdx], mEntryMax[entryIdx]);
+            }
+        }
+        return;
+    }
+
+    glm::ivec3 cell;
+    for(cell.z = cellMin.z; cell.z <= cellMax.z; cell.z++)
+    {
+        for(cell.y = cellMin.y; cell.y <= cellMax.y; cell.y++)
+        {
+            for(cell.x = cellMin.x; cell.x <= cellMax.x; cell.x++)
+            {
+                uint32_t bucket = bucketOf(cell);
+                for(uint32_t recordIdx = mBucketStart[bucket]; recordIdx < mBucketStart[bucket + 1]; recordIdx++)
+                {
+                    const CellRecord& record = mRecords[recordIdx];
+                    if(record.cell != cell
+                       || !glm::all(glm::lessThanEqual(record.boundsMin, boundsMax))
+                       || !glm::all(glm::lessThanEqual(boundsMin, record.boundsMax)))
+                    {
+                        continue;
+                    }
+                    // the entry is in every cell of its own range, so the first cell it shares with the
+                    // query range is where the two ranges' minimum corners meet; report it only from there
+                    if(glm::max(cellOf(record.boundsMin), cellMin) == cell)
+                    {
+                        visit(record.entryIdx, record.boundsMin, record.boundsMax);
+                    }
+                }
+            }
+        }
+    }
+    for(uint32_t entryIdx : mOversizedEntries)
+    {
+        if(glm::all(glm::lessThanEqual(mEntryMin[entryIdx], boundsMax))
+           && glm::all(glm::lessThanEqual(boundsMin, mEntryMax[entryIdx])))
+        {
+            visit(entryIdx, mEntryMin[entryIdx], mEntryMax[entryIdx]);
+        }
+    }
+}
+
+void SpatialHashGrid::queryBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+        std::vector<uint32_t>& results) const
+{
+    visitCandidates(boundsMin, boundsMax, [&](uint32_t entryIdx, const glm::vec3&, const glm::vec3&){
+        results.push_back(mEntryIds[entryIdx]);
+    });
+}
+
+void SpatialHashGrid::queryRadius(const glm::vec3& center, float radius, std::vector<uint32_t>& results) const
+{
+    float radiusSquared = radius * radius;
+    visitCandidates(center - glm::vec3(radius), center + glm::vec3(radius),
+            [&](uint32_t entryIdx, const glm::vec3& entryMin, const glm::vec3& entryMax){
+        glm::vec3 offset = glm::clamp(center, entryMin, entryMax) - center;
+        if(glm::dot(offset, offset) <= radiusSquared)
+        {
+            results.push_back(mEntryIds[entryIdx]);
+        }
+    });
+}
+
+uint32_t SpatialHashGrid::findNearest(const glm::vec3& position, float maxDistance) const
+{
+    float bestDistanceSquared = maxDistance * maxDistance;
+    uint32_t bestEntry = kNoEntry;
+    visitCandidates(position - glm::vec3(maxDistance), position + glm::vec3(maxDistance),
+            [&](uint32_t entryIdx, const glm::vec3& entryMin, const glm::vec3& entryMax){
+        glm::vec3 offset = glm::clamp(position, entryMin, entryMax) - position;
+        float distanceSquared = glm::dot(offset, offset);
+        // entries arrive in bucket order, so break ties on insertion order explicitly
+        if(distanceSquared < bestDistanceSquared
+           || (distanceSquared == bestDistanceSquared && entryIdx < bestEntry))
+        {
+            bestDistanceSquared = distanceSquared;
+            bestEntry = entryIdx;
+        }
+    });
+    if(bestEntry == kNoEntry)
+    {
+        return kNoEntry;
+    }
+    return mEntryIds[bestEntry];
+}
+
+size_t SpatialHashGrid::getEntryCount() const
+{
+    return mBuiltEntryCount;
+}
+
+size_t SpatialHashGrid::getOversizedCount() const
+{
+    return mOversizedEntries.size();
+}
+
+float SpatialHashGrid::getCellSize() const
+{
+    return mCellSize;
+}
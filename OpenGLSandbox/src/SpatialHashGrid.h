@@ -0,0 +1,128 @@
+#ifndef OPENGLSANDBOX_SPATIALHASHGRID_H
+#define OPENGLSANDBOX_SPATIALHASHGRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+class TrailPool;
+class RibbonTrail;
+
+/**
+ * Uniform grid over points and boxes, hashed into a bucket table so it covers unbounded space, for "what's
+ * near here" queries (click-picking, proximity effects between trails) without scanning every entry.
+ *
+ * The grid is meant to be rebuilt from scratch every frame rather than updated: insert*() just appends to
+ * the entry arrays, and build() sorts the entries into their buckets with a counting sort, leaving every
+ * bucket's entry indices contiguous in one array so queries walk flat memory instead of chasing lists.
+ * A box entry goes into every cell it overlaps, up to kMaxCellsPerEntry; bigger ones are kept in a short
+ * list every query checks directly, so a few huge entries can't flood the buckets.
+ */
+class SpatialHashGrid
+{
+public:
+    /**
+     * Box entries overlapping more cells than this skip the buckets and are tested by every query
+     */
+    static const size_t kMaxCellsPerEntry = 64;
+    /**
+     * Returned by findNearest() when nothing is in range
+     */
+    static const uint32_t kNoEntry = UINT32_MAX;
+private:
+    float mCellSize;
+    float mInverseCellSize;
+    /// entries, in insertion order ///
+    std::vector<uint32_t> mEntryIds;
+    std::vector<glm::vec3> mEntryMin;
+    std::vector<glm::vec3> mEntryMax;
+    /**
+     * One entry's presence in one cell; it carries the cell, since other cells can hash to the same bucket,
+     * and a copy of the entry's bounds, so queries test a bucket's records without touching the entry arrays
+     */
+    struct CellRecord
+    {
+        glm::ivec3 cell;
+        uint32_t entryIdx;
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+    };
+    /**
+     * bucket i's records are mRecords[mBucketStart[i]] up to mRecords[mBucketStart[i + 1]]
+     */
+    std::vector<uint32_t> mBucketStart;
+    std::vector<CellRecord> mRecords;
+    uint32_t mBucketMask = 0;
+    /**
+     * Entries covered by the last build(); later inserts stay invisible to queries until the next one
+     */
+    size_t mBuiltEntryCount = 0;
+    /**
+     * Entries too big for the buckets, see kMaxCellsPerEntry
+     */
+    std::vector<uint32_t> mOversizedEntries;
+    /**
+     * Scratch for build(): the cell and entry of every record, and later its bucket
+     */
+    std::vector<glm::ivec3> mInsertionCells;
+    std::vector<uint32_t> mInsertionEntries;
+    std::vector<uint32_t> mInsertionBuckets;
+
+    glm::ivec3 cellOf(const glm::vec3& position) const;
+    uint32_t bucketOf(const glm::ivec3& cell) const;
+    /**
+     * Calls visit(entryIdx, entryMin, entryMax) exactly once for every entry whose bounds overlap the box;
+     * an entry spanning several cells is only reported from the first of them inside the box.  Falls back
+     * to testing every entry when the box spans more cells than there are buckets
+     */
+    template<typename Visitor>
+    void visitCandidates(const glm::vec3& boundsMin, const glm::vec3& boundsMax, Visitor visit) const;
+public:
+    /**
+     * @param cellSize edge length of the grid's cubic cells; around the typical query size works best
+     */
+    explicit SpatialHashGrid(float cellSize);
+    /**
+     * Drops every entry, keeping allocations for the next rebuild
+     */
+    void clear();
+    void insertPoint(uint32_t id, const glm::vec3& position);
+    void insertBox(uint32_t id, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+    /**
+     * Inserts the bounds of every live, non-empty trail in the pool, using its slot as the ID; call after
+     * TrailPool::updateBounds()
+     */
+    void insertTrailBounds(const TrailPool& pool);
+    /**
+     * Inserts the bounds of each of the ribbon's segments, i.e. of every two consecutive vertex pairs, using
+     * the segment's index from the tail as the ID
+     */
+    void insertTrailSegments(const RibbonTrail& ribbonTrail);
+    /**
+     * Sorts the entries inserted since clear() into the buckets; queries only see entries from the last
+     * build() call
+     */
+    void build();
+
+    /**
+     * Appends the ID of every entry whose bounds overlap the box to results
+     */
+    void queryBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax, std::vector<uint32_t>& results) const;
+    /**
+     * Appends the ID of every entry whose bounds come within radius of center to results
+     */
+    void queryRadius(const glm::vec3& center, float radius, std::vector<uint32_t>& results) const;
+    /**
+     * @return the ID of the entry whose bounds are closest to position and within maxDistance of it, or
+     *         kNoEntry; ties go to the entry inserted first
+     */
+    uint32_t findNearest(const glm::vec3& position, float maxDistance) const;
+
+    size_t getEntryCount() const;
+    size_t getOversizedCount() const;
+    float getCellSize() const;
+};
+
+
+#endif //OPENGLSANDBOX_SPATIALHASHGRID_H
@@ -0,0 +1,295 @@
+#include "TextureStreamer.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <utility>
+
+namespace
+{
+    /**
+     * Ring allocations start on this boundary, which covers the alignment glTextureSubImage2D() wants of
+     * unpack buffer offsets for any pixel type, and keeps rows from sharing cache lines across allocations
+     */
+    const size_t kStagingAlignment = 64;
+
+    size_t alignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+GLsizei getFullMipChainLevels(GLsizei width, GLsizei height)
+{
+    GLsizei levels = 1;
+    for(GLsizei size = std::max(width, height); size > 1; size /= 2)
+    {
+        levels++;
+    }
+    return levels;
+}
+
+size_t getPixelSize(GLenum format, GLenum type)
+{
+    size_t components = 0;
+    switch(format)
+    {
+        case GL_RED:
+        case GL_RED_INTEGER:
+            components = 1;
+            break;
+        case GL_RG:
+        case GL_RG_INTEGER:
+            components = 2;
+            break;
+        case GL_RGB:
+        case GL_BGR:
+        case GL_RGB_INTEGER:
+            components = 3;
+            break;
+        case GL_RGBA:
+        case GL_BGRA:
+        case GL_RGBA_INTEGER:
+            components = 4;
+            break;
+        default:
+            return 0;
+    }
+    switch(type)
+    {
+        case GL_UNSIGNED_BYTE:
+        case GL_BYTE:
+            return components;
+        case GL_UNSIGNED_SHORT:
+        case GL_SHORT:
+        case GL_HALF_FLOAT:
+            return components * 2;
+        case GL_UNSIGNED_INT:
+        case GL_INT:
+        case GL_FLOAT:
+            return components * 4;
+        default:
+            return 0;
+    }
+}
+
+TextureStreamer::TextureStreamer(size_t ringSize, size_t frameBudget): mRingSize(ringSize), mFrameBudget(frameBudget)
+{
+    // persistent and coherent, so rows we write are visible to the GPU without flushing or unmapping
+    const GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &mStagingBuffer);
+    glNamedBufferStorage(mStagingBuffer, static_cast<GLsizeiptr>(mRingSize), nullptr, mapFlags);
+    mStagingMemory = static_cast<uint8_t*>(glMapNamedBufferRange(mStagingBuffer, 0, static_cast<GLsizeiptr>(mRingSize),
+            mapFlags | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if(mStagingMemory == nullptr)
+    {
+        std::cerr << "failed to map texture staging ring of " << mRingSize << " bytes. GL error code: "
+        << glGetError() << std::endl;
+    }
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    for(const InFlightRegion& region : mInFlight)
+    {
+        glDeleteSync(region.fence);
+    }
+    if(mStagingMemory != nullptr)
+    {
+        glUnmapNamedBuffer(mStagingBuffer);
+    }
+    glDeleteBuffers(1, &mStagingBuffer);
+}
+
+unsigned int TextureStreamer::requestTexture(const TextureDescription& description, TextureRowSource source)
+{
+    size_t pixelSize = getPixelSize(description.format, description.type);
+    size_t rowSize = pixelSize * static_cast<size_t>(description.width);
+    if(pixelSize == 0 || description.width <= 0 || description.height <= 0)
+    {
+        std::cerr << "can't stream a " << description.width << "x" << description.height
+        << " texture with pixel format " << description.format << " and type " << description.type << std::endl;
+        return 0;
+    }
+    if(mStagingMemory == nullptr || alignUp(rowSize, kStagingAlignment) >= mRingSize)
+    {
+        std::cerr << "texture rows of " << rowSize << " bytes don't fit the " << mRingSize
+        << " byte staging ring" << std::endl;
+        return 0;
+    }
+
+    GLsizei levels = description.levels > 0 ? description.levels
+                                            : getFullMipChainLevels(description.width, description.height);
+    unsigned int texture = 0;
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+    glTextureStorage2D(texture, levels, description.internalFormat, description.width, description.height);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    PendingTexture pending;
+    pending.texture = texture;
+    pending.description = description;
+    pending.description.levels = levels;
+    pending.source = std::move(source);
+    pending.rowSize = rowSize;
+    pending.rowsUploaded = 0;
+    mPending.push_back(std::move(pending));
+    return texture;
+}
+
+unsigned int TextureStreamer::requestTexture(const TextureDescription& description, std::vector<uint8_t> pixels)
+{
+    size_t rowSize = getPixelSize(description.format, description.type) * static_cast<size_t>(description.width);
+    if(pixels.size() < rowSize * static_cast<size_t>(description.height))
+    {
+        std::cerr << "texture pixel data holds " << pixels.size() << " bytes, "
+        << rowSize * static_cast<size_t>(description.height) << " expected" << std::endl;
+        return 0;
+    }
+    // the lambda owns the pixels until the last rows are staged and it's destroyed along with its request
+    std::shared_ptr<std::vector<uint8_t>> ownedPixels = std::make_shared<std::vector<uint8_t>>(std::move(pixels));
+    return requestTexture(description, [ownedPixels, rowSize](uint8_t* destination, GLsizei firstRow, GLsizei rowCount){
+        std::memcpy(destination, ownedPixels->data() + rowSize * static_cast<size_t>(firstRow),
+                rowSize * static_cast<size_t>(rowCount));
+    });
+}
+
+void TextureStreamer::retireFinishedRegions()
+{
+    while(!mInFlight.empty())
+    {
+        // a zero timeout only polls, we never wait here
+        GLenum status = glClientWaitSync(mInFlight.front().fence, 0, 0);
+        if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        {
+            break;
+        }
+        glDeleteSync(mInFlight.front().fence);
+        mTail = mInFlight.front().end;
+        mInFlight.pop_front();
+    }
+    if(mInFlight.empty())
+    {
+        // nothing in flight, so start over from the beginning rather than fragment the ring
+        mHead = 0;
+        mTail = 0;
+    }
+}
+
+size_t TextureStreamer::allocate(size_t size)
+{
+    size = alignUp(size, kStagingAlignment);
+    if(mHead >= mTail)
+    {
+        // free space is [mHead, end) and [0, mTail); wrapping, like allocating in the wrapped state below,
+        // must never let the head catch the tail, or a full ring would look empty
+        if(mHead + size <= mRingSize)
+        {
+            size_t offset = mHead;
+            mHead += size;
+            return offset;
+        }
+        if(size < mTail)
+        {
+            mHead = size;
+            return 0;
+        }
+        return SIZE_MAX;
+    }
+    // wrapped: free space is [mHead, mTail)
+    if(mHead + size < mTail)
+    {
+        size_t offset = mHead;
+        mHead += size;
+        return offset;
+    }
+    return SIZE_MAX;
+}
+
+void TextureStreamer::update()
+{
+    retireFinishedRegions();
+    size_t bytesStaged = 0;
+    bool uploadedAny = false;
+    bool ringFull = false;
+    while(!mPending.empty() && !ringFull && bytesStaged < mFrameBudget)
+    {
+        PendingTexture& pending = mPending.front();
+        // Update Step 1: take as many rows as the budget allows, but always at least one so huge rows progress
+        GLsizei rowsLeft = pending.description.height - pending.rowsUploaded;
+        size_t budgetRows = std::max<size_t>((mFrameBudget - bytesStaged) / pending.rowSize, 1);
+        GLsizei rowCount = static_cast<GLsizei>(std::min<size_t>(budgetRows, static_cast<size_t>(rowsLeft)));
+        size_t offset = allocate(pending.rowSize * static_cast<size_t>(rowCount));
+        while(offset == SIZE_MAX && rowCount > 1)
+        {
+            // not enough contiguous ring space; try a smaller batch before giving up for this frame
+            rowCount /= 2;
+            offset = allocate(pending.rowSize * static_cast<size_t>(rowCount));
+        }
+        if(offset == SIZE_MAX)
+        {
+            ringFull = true;
+            break;
+        }
+
+        // Update Step 2: have the source write the rows straight into staging memory, and upload from there
+        pending.source(mStagingMemory + offset, pending.rowsUploaded, rowCount);
+        if(!uploadedAny)
+        {
+            // rows are tightly packed in the ring, so they needn't start on the default 4 byte boundary
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mStagingBuffer);
+            uploadedAny = true;
+        }
+        glTextureSubImage2D(pending.texture, 0, 0, pending.rowsUploaded, pending.description.width, rowCount,
+                pending.description.format, pending.description.type, reinterpret_cast<const void*>(offset));
+        pending.rowsUploaded += rowCount;
+        size_t batchBytes = pending.rowSize * static_cast<size_t>(rowCount);
+        bytesStaged += batchBytes;
+
+        // Update Step 3: once level 0 is complete, fill in the mip chain and retire the request
+        if(pending.rowsUploaded == pending.description.height)
+        {
+            if(pending.description.levels > 1)
+            {
+                glGenerateTextureMipmap(pending.texture);
+            }
+            mPending.pop_front();
+        }
+    }
+    if(uploadedAny)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        // everything staged this frame up to mHead is released together once the GPU has consumed it
+        InFlightRegion region;
+        region.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        region.end = mHead;
+        mInFlight.push_back(region);
+    }
+    mBytesUploadedLastFrame = bytesStaged;
+    mTotalBytesUploaded += bytesStaged;
+}
+
+bool TextureStreamer::isReady(unsigned int texture) const
+{
+    return std::none_of(mPending.begin(), mPending.end(), [texture](const PendingTexture& pending){
+        return pending.texture == texture;
+    });
+}
+
+size_t TextureStreamer::getPendingTextureCount() const
+{
+    return mPending.size();
+}
+
+size_t TextureStreamer::getBytesUploadedLastFrame() const
+{
+    return mBytesUploadedLastFrame;
+}
+
+size_t TextureStreamer::getTotalBytesUploaded() const
+{
+    return mTotalBytesUploaded;
+}
@@ -0,0 +1,140 @@
+#ifndef OPENGLSANDBOX_TEXTURESTREAMER_H
+#define OPENGLSANDBOX_TEXTURESTREAMER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+#include <glad/glad.h>
+
+/**
+ * What a streamed 2D texture looks like, and what its level 0 pixels we supply look like
+ */
+struct TextureDescription
+{
+    GLsizei width = 1;
+    GLsizei height = 1;
+    /**
+     * Sized internal format for glTextureStorage2D(), e.g. GL_RGBA8
+     */
+    GLenum internalFormat = GL_RGBA8;
+    /**
+     * Layout of the pixels we upload, e.g. GL_RGBA and GL_UNSIGNED_BYTE; rows are tightly packed
+     */
+    GLenum format = GL_RGBA;
+    GLenum type = GL_UNSIGNED_BYTE;
+    /**
+     * Mip levels to allocate, or 0 for a full chain; levels past 0 are generated once level 0 is in
+     */
+    GLsizei levels = 0;
+};
+
+/**
+ * Fills rows [firstRow, firstRow + rowCount) of a texture's level 0 at destination, tightly packed; called
+ * on the render thread with destination pointing straight into mapped staging memory
+ */
+typedef std::function<void(uint8_t* destination, GLsizei firstRow, GLsizei rowCount)> TextureRowSource;
+
+/**
+ * @return bytes per pixel of the given upload format and type, or 0 if we don't know them
+ */
+size_t getPixelSize(GLenum format, GLenum type);
+/**
+ * @return the number of mip levels down to 1x1 for a texture of the given size
+ */
+GLsizei getFullMipChainLevels(GLsizei width, GLsizei height);
+
+/**
+ * Asynchronous texture uploads that never hitch the render loop.
+ *
+ * requestTexture() creates the texture with immutable storage straight away, then update(), called once a
+ * frame, streams its pixels in a few rows at a time: rows are written into a persistently mapped pixel
+ * unpack buffer used as a ring, and glTextureSubImage2D() sources them from there, so the driver copies to
+ * the texture on the GPU's timeline instead of ours.  Each frame's writes are fenced, and ring space is only
+ * reused once its fence has signalled, so we never wait on the GPU and never overwrite staging data it
+ * hasn't read yet.  At most a per-frame byte budget is staged each frame, which spreads big textures over as
+ * many frames as it takes; once a texture's last rows are in, its mip chain is generated and it's ready.
+ */
+class TextureStreamer
+{
+private:
+    struct PendingTexture
+    {
+        unsigned int texture;
+        TextureDescription description;
+        TextureRowSource source;
+        size_t rowSize;
+        GLsizei rowsUploaded;
+    };
+    /**
+     * Ring space written during one frame, released when the fence issued after it signals
+     */
+    struct InFlightRegion
+    {
+        GLsync fence;
+        size_t end;
+    };
+    unsigned int mStagingBuffer = 0;
+    uint8_t* mStagingMemory = nullptr;
+    size_t mRingSize;
+    size_t mFrameBudget;
+    /**
+     * Ring cursors: new data goes at mHead, and [mTail, mHead) (wrapping) is still in flight; they're only
+     * equal when the ring is empty, since allocations never fill it completely
+     */
+    size_t mHead = 0;
+    size_t mTail = 0;
+    std::deque<InFlightRegion> mInFlight;
+    std::deque<PendingTexture> mPending;
+    size_t mBytesUploadedLastFrame = 0;
+    size_t mTotalBytesUploaded = 0;
+
+    /**
+     * Releases the ring space of every frame the GPU has finished reading
+     */
+    void retireFinishedRegions();
+    /**
+     * Claims size contiguous bytes of ring space
+     * @return the offset of the space, or SIZE_MAX if there isn't enough free right now
+     */
+    size_t allocate(size_t size);
+public:
+    /**
+     * Creates and maps the staging ring; must be called on the thread owning the current GL context
+     * @param ringSize bytes of staging memory; a texture row must fit in it
+     * @param frameBudget the most bytes update() stages per frame, though always at least one row
+     */
+    TextureStreamer(size_t ringSize, size_t frameBudget);
+    ~TextureStreamer();
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+    /**
+     * Creates a texture and queues its level 0 contents for upload.  The texture can be bound right away,
+     * but its contents are undefined until isReady() says otherwise.  The caller owns the texture and
+     * shouldn't delete it before it's ready
+     * @param source called from update() for each batch of rows
+     * @return the texture's ID, or 0 if it couldn't be streamed (see std::cerr)
+     */
+    unsigned int requestTexture(const TextureDescription& description, TextureRowSource source);
+    /**
+     * requestTexture() for pixels already in memory, which the streamer takes ownership of
+     * @param pixels the whole of level 0, tightly packed rows
+     */
+    unsigned int requestTexture(const TextureDescription& description, std::vector<uint8_t> pixels);
+    /**
+     * Stages up to the frame budget's worth of pending rows and issues their uploads; call once per frame
+     */
+    void update();
+    /**
+     * @return true once the texture's level 0 has been uploaded and its mips generated, or if it was
+     *         never queued here in the first place
+     */
+    bool isReady(unsigned int texture) const;
+    size_t getPendingTextureCount() const;
+    size_t getBytesUploadedLastFrame() const;
+    size_t getTotalBytesUploaded() const;
+};
+
+
+#endif //OPENGLSANDBOX_TEXTURESTREAMER_H
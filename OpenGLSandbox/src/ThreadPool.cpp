@@ -0,0 +1,101 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t workerCount)
+{
+    if(workerCount == 0)
+    {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+    mWorkers.reserve(workerCount);
+    for(size_t workerIdx = 0; workerIdx < workerCount; workerIdx++)
+    {
+        mWorkers.emplace_back([this](){ workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mWorkAvailable.notify_all();
+    for(std::thread& worker : mWorkers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::workerLoop()
+{
+    uint64_t seenGeneration = 0;
+    while(true)
+    {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWorkAvailable.wait(lock, [&](){ return mStopping || mJobGeneration != seenGeneration; });
+            if(mStopping)
+            {
+                return;
+            }
+            seenGeneration = mJobGeneration;
+            job = mJob;
+        }
+        // a worker waking after its job was already finished and dropped has nothing to do
+        if(job)
+        {
+            runTasks(*job);
+        }
+    }
+}
+
+void ThreadPool::runTasks(Job& job)
+{
+    size_t index;
+    while((index = job.nextIndex.fetch_add(1)) < job.count)
+    {
+        (*job.task)(index);
+        if(job.remaining.fetch_sub(1) == 1)
+        {
+            // take the lock so the dispatcher can't miss the wakeup between checking remaining and sleeping
+            std::lock_guard<std::mutex> lock(mMutex);
+            mWorkDone.notify_all();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task)
+{
+    if(count == 0)
+    {
+        return;
+    }
+    if(mWorkers.empty() || count == 1)
+    {
+        for(size_t index = 0; index < count; index++)
+        {
+            task(index);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> dispatchLock(mDispatchMutex);
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->task = &task;
+    job->count = count;
+    job->nextIndex = 0;
+    job->remaining = count;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJob = job;
+        mJobGeneration++;
+    }
+    mWorkAvailable.notify_all();
+    runTasks(*job);
+    std::unique_lock<std::mutex> lock(mMutex);
+    mWorkDone.wait(lock, [&](){ return job->remaining == 0; });
+    // let the job go once the last worker drops it rather than holding it until the next call
+    mJob.reset();
+}
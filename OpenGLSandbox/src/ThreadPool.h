@@ -0,0 +1,73 @@
+#ifndef OPENGLSANDBOX_THREADPOOL_H
+#define OPENGLSANDBOX_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of worker threads for splitting CPU work, e.g. texture tiles, across cores.
+ *
+ * Work is handed out as a parallelFor() over task indices: the workers and the calling thread pull indices
+ * from a shared atomic counter until they run out, so uneven tasks balance themselves, and the call returns
+ * once every task has finished.  The workers sleep on a condition variable between calls.
+ */
+class ThreadPool
+{
+private:
+    /**
+     * One parallelFor() call's tasks; workers hold on to it by shared_ptr, so one waking late still finds
+     * the counter it took its indices from, sees it's used up and never touches the call's task
+     */
+    struct Job
+    {
+        const std::function<void(size_t)>* task;
+        size_t count;
+        std::atomic<size_t> nextIndex;
+        std::atomic<size_t> remaining;
+    };
+    std::vector<std::thread> mWorkers;
+    std::mutex mMutex;
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mWorkDone;
+    std::shared_ptr<Job> mJob;
+    uint64_t mJobGeneration = 0;
+    bool mStopping = false;
+    /**
+     * Serializes parallelFor() calls from different threads, since there's only one job at a time
+     */
+    std::mutex mDispatchMutex;
+
+    void workerLoop();
+    /**
+     * Runs the job's tasks until its indices run out, waking the dispatcher after the last one finishes
+     */
+    void runTasks(Job& job);
+public:
+    /**
+     * @param workerCount threads to start, or 0 for one fewer than the hardware has, since the thread
+     *        calling parallelFor() works too
+     */
+    explicit ThreadPool(size_t workerCount = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    /**
+     * Runs task(index) for every index in [0, count) across the workers and the calling thread, and returns
+     * once they've all finished; tasks must be safe to run concurrently with each other
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+    /**
+     * @return the number of threads parallelFor() runs tasks on, counting the caller
+     */
+    size_t getThreadCount() const { return mWorkers.size() + 1; }
+};
+
+
+#endif //OPENGLSANDBOX_THREADPOOL_H
@@ -0,0 +1,113 @@
+#include "TrailEmitter.h"
+#include <cmath>
+
+TrailEmitter::TrailEmitter(const TrailEmitterSettings& settings): mSettings(settings){}
+
+void TrailEmitter::emit(RibbonTrail& ribbonTrail, const glm::vec3& position, const glm::vec3& direction)
+{
+    glm::vec3 side = glm::vec3(-direction.y, direction.x, 0.0F) * mSettings.halfWidth;
+    ribbonTrail.addVertexPair(position - side, position + side);
+    mLastEmitPosition = position;
+    mLastEmitDirection = direction;
+    mHasEmitted = true;
+}
+
+bool TrailEmitter::update(RibbonTrail& ribbonTrail, const glm::vec3& position, double time)
+{
+    if(!mHasSample)
+    {
+        mHasSample = true;
+        mLastPosition = position;
+        mLastTime = time;
+        mStoppedTime = time;
+        mLastCollapseTime = time;
+        return false;
+    }
+
+    // Update Step 1: smooth the measured speed so one long or short tick doesn't flip our state
+    glm::vec3 step = position - mLastPosition;
+    float stepLength = glm::length(step);
+    float elapsed = static_cast<float>(time - mLastTime);
+    if(elapsed > 0.0F)
+    {
+        float blend = 1.0F - std::exp(-elapsed / mSettings.speedSmoothingTime);
+        mSmoothedSpeed += (stepLength / elapsed - mSmoothedSpeed) * blend;
+    }
+    mLastPosition = position;
+    mLastTime = time;
+    if(stepLength > 0.0F)
+    {
+        mHeading = step / stepLength;
+    }
+
+    // Update Step 2: stop and resume at different speeds, so hovering around one threshold can't flicker
+    if(mMoving && mSmoothedSpeed < mSettings.stopSpeed)
+    {
+        mMoving = false;
+        mStoppedTime = time;
+        mLastCollapseTime = time;
+    }
+    else if(!mMoving && mSmoothedSpeed > mSettings.resumeSpeed)
+    {
+        mMoving = true;
+    }
+
+    bool trailChanged = false;
+    if(mMoving)
+    {
+        // Update Step 3a: emit when we've gone far enough, or turned far enough, since the previous pair
+        if(stepLength <= 0.0F)
+        {
+            return false;
+        }
+        glm::vec3 heading = mHeading;
+        if(!mHasEmitted)
+        {
+            emit(ribbonTrail, position, heading);
+            return true;
+        }
+        float distance = glm::length(position - mLastEmitPosition);
+        if(distance >= mSettings.minSpacing)
+        {
+            // comparing cosines spares us an acos per tick; a smaller cosine is a sharper turn
+            bool turnedEnough = glm::dot(heading, mLastEmitDirection) <= std::cos(mSettings.maxTurnAngle);
+            if(turnedEnough || distance >= mSettings.maxSpacing)
+            {
+                emit(ribbonTrail, position, heading);
+                trailChanged = true;
+            }
+        }
+    }
+    else if(time - mStoppedTime >= mSettings.idleDelay && time - mLastCollapseTime >= mSettings.collapseInterval)
+    {
+        // Update Step 3b: idle long enough, so eat the trail from its tail one pair at a time
+        trailChanged = ribbonTrail.removeOldestVertexPair();
+        mLastCollapseTime = time;
+        if(ribbonTrail.getVertexCount() == 0)
+        {
+            // fully collapsed; the next run starts a fresh trail rather than bridging from here
+            mHasEmitted = false;
+        }
+    }
+    return trailChanged;
+}
+
+bool TrailEmitter::isMoving() const
+{
+    return mMoving;
+}
+
+float TrailEmitter::getSmoothedSpeed() const
+{
+    return mSmoothedSpeed;
+}
+
+glm::vec3 TrailEmitter::getPosition() const
+{
+    return mLastPosition;
+}
+
+glm::quat TrailEmitter::getOrientation() const
+{
+    return glm::angleAxis(std::atan2(mHeading.y, mHeading.x), glm::vec3(0.0F, 0.0F, 1.0F));
+}
@@ -0,0 +1,115 @@
+#ifndef OPENGLSANDBOX_TRAILEMITTER_H
+#define OPENGLSANDBOX_TRAILEMITTER_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "RibbonTrail.h"
+
+/**
+ * Tuning for a TrailEmitter; distances are in the trail's units (device coords for the demo), times in seconds
+ */
+struct TrailEmitterSettings
+{
+    /**
+     * Half the ribbon's width, i.e. how far either vertex of a pair sits from the emitter's path
+     */
+    float halfWidth = 0.08F;
+    /**
+     * Never emit a pair closer than this to the previous one, however sharply we're turning
+     */
+    float minSpacing = 0.02F;
+    /**
+     * Always emit once we're this far from the previous pair, even going dead straight
+     */
+    float maxSpacing = 0.25F;
+    /**
+     * Emit early, as soon as minSpacing allows, once the heading has turned this many radians since the
+     * previous pair, so curves get their vertices where straight runs don't need them
+     */
+    float maxTurnAngle = 0.2F;
+    /**
+     * Smoothed speed below which the emitter counts as stopped
+     */
+    float stopSpeed = 0.05F;
+    /**
+     * Smoothed speed above which a stopped emitter counts as moving again; keeping this above stopSpeed is
+     * the hysteresis that stops jittery, near-stationary motion from toggling emission on and off
+     */
+    float resumeSpeed = 0.15F;
+    /**
+     * Time constant of the exponential moving average smoothing the measured speed
+     */
+    float speedSmoothingTime = 0.1F;
+    /**
+     * How long the emitter has to stay stopped before its trail starts collapsing
+     */
+    float idleDelay = 0.25F;
+    /**
+     * Seconds between removing pairs from the tail of a collapsing trail
+     */
+    float collapseInterval = 0.05F;
+};
+
+/**
+ * Drives a RibbonTrail from an emitter's motion.  Rather than emitting pairs on a fixed clock, the emitter
+ * spends the trail's vertex budget where it affects the visuals: it emits when it has travelled far enough
+ * or turned sharply enough since the previous pair, so fast or curving motion gets dense segments and
+ * straight runs get long ones, emits nothing while stationary, and once it has been stationary for a while
+ * collapses the trail from its tail until nothing is left.
+ */
+class TrailEmitter
+{
+private:
+    TrailEmitterSettings mSettings;
+    bool mHasSample = false;
+    bool mMoving = false;
+    bool mHasEmitted = false;
+    glm::vec3 mLastPosition = glm::vec3(0.0F);
+    double mLastTime = 0.0;
+    float mSmoothedSpeed = 0.0F;
+    /**
+     * Direction of the latest step that actually moved, kept while stationary so a resting emitter still
+     * faces the way it came
+     */
+    glm::vec3 mHeading = glm::vec3(1.0F, 0.0F, 0.0F);
+    /**
+     * Where the previous pair was emitted, and the heading at that point
+     */
+    glm::vec3 mLastEmitPosition = glm::vec3(0.0F);
+    glm::vec3 mLastEmitDirection = glm::vec3(0.0F);
+    /**
+     * When we last stopped, and when we last collapsed a pair while stopped
+     */
+    double mStoppedTime = 0.0;
+    double mLastCollapseTime = 0.0;
+    /**
+     * Adds the vertex pair straddling position, perpendicular to direction in the XY plane
+     */
+    void emit(RibbonTrail& ribbonTrail, const glm::vec3& position, const glm::vec3& direction);
+public:
+    explicit TrailEmitter(const TrailEmitterSettings& settings = TrailEmitterSettings());
+    /**
+     * Feeds the emitter its latest position, adding pairs to or collapsing the trail as needed
+     * @param ribbonTrail the trail this emitter drives
+     * @param position where the emitter is now
+     * @param time current time in seconds; must not go backwards between calls
+     * @return true if the trail changed, i.e. its buffers need regenerating
+     */
+    bool update(RibbonTrail& ribbonTrail, const glm::vec3& position, double time);
+    /**
+     * @return true while the emitter's smoothed speed has it counted as moving
+     */
+    bool isMoving() const;
+    float getSmoothedSpeed() const;
+    /**
+     * @return the position passed to the latest update()
+     */
+    glm::vec3 getPosition() const;
+    /**
+     * @return the rotation about z taking +x onto the emitter's heading, i.e. its orientation in the XY plane
+     */
+    glm::quat getOrientation() const;
+};
+
+
+#endif //OPENGLSANDBOX_TRAILEMITTER_H
@@ -0,0 +1,247 @@
+#include "TrailPool.h"
+#include <cassert>
+#include <limits>
+
+namespace
+{
+    const glm::vec3 kEmptyBoundsMin = glm::vec3(std::numeric_limits<float>::max());
+    const glm::vec3 kEmptyBoundsMax = glm::vec3(-std::numeric_limits<float>::max());
+}
+
+TrailPool::TrailPool(size_t pairsPerTrail, size_t initialCapacity): mPairsPerTrail(pairsPerTrail)
+{
+    assert(pairsPerTrail > 0);
+    mHeadPair.reserve(initialCapacity);
+    mPairCount.reserve(initialCapacity);
+    mFlags.reserve(initialCapacity);
+    mGenerations.reserve(initialCapacity);
+    mColdState.reserve(initialCapacity);
+    mVertices.reserve(initialCapacity * pairsPerTrail * 2);
+}
+
+size_t TrailPool::tailVertex(uint32_t slot) const
+{
+    size_t tailPair = (mHeadPair[slot] + mPairsPerTrail - mPairCount[slot]) % mPairsPerTrail;
+    return (slot * mPairsPerTrail + tailPair) * 2;
+}
+
+void TrailPool::recomputeBounds(uint32_t slot)
+{
+    glm::vec3 boundsMin = kEmptyBoundsMin;
+    glm::vec3 boundsMax = kEmptyBoundsMax;
+    // the live pairs may wrap around the ring, but for bounds their order doesn't matter, so walk them
+    // as (at most) two contiguous runs
+    size_t ringStart = slot * mPairsPerTrail * 2;
+    size_t ringEnd = ringStart + mPairsPerTrail * 2;
+    size_t first = tailVertex(slot);
+    size_t remaining = mPairCount[slot] * 2;
+    while(remaining > 0)
+    {
+        size_t runEnd = std::min(ringEnd, first + remaining);
+        for(size_t vertIdx = first; vertIdx < runEnd; vertIdx++)
+        {
+            boundsMin = glm::min(boundsMin, mVertices[vertIdx]);
+            boundsMax = glm::max(boundsMax, mVertices[vertIdx]);
+        }
+        remaining -= runEnd - first;
+        first = ringStart;
+    }
+    mBoundsMin.set(slot, boundsMin);
+    mBoundsMax.set(slot, boundsMax);
+    mFlags[slot] &= static_cast<uint8_t>(~boundsStale);
+}
+
+TrailHandle TrailPool::create()
+{
+    uint32_t slot;
+    if(!mFreeSlots.empty())
+    {
+        slot = mFreeSlots.back();
+        mFreeSlots.pop_back();
+        mColdState[slot] = TrailColdState();
+    }
+    else
+    {
+        slot = static_cast<uint32_t>(mFlags.size());
+        mHeadPair.push_back(0);
+        mPairCount.push_back(0);
+        mFlags.push_back(0);
+        mBoundsMin.push_back(kEmptyBoundsMin);
+        mBoundsMax.push_back(kEmptyBoundsMax);
+        mGenerations.push_back(0);
+        mColdState.emplace_back();
+        mVertices.resize(mVertices.size() + mPairsPerTrail * 2);
+    }
+    mHeadPair[slot] = 0;
+    mPairCount[slot] = 0;
+    mFlags[slot] = alive | dirty;
+    mBoundsMin.set(slot, kEmptyBoundsMin);
+    mBoundsMax.set(slot, kEmptyBoundsMax);
+    mLiveCount++;
+    TrailHandle handle;
+    handle.index = slot;
+    handle.generation = mGenerations[slot];
+    return handle;
+}
+
+bool TrailPool::destroy(TrailHandle handle)
+{
+    if(!isValid(handle))
+    {
+        return false;
+    }
+    mFlags[handle.index] = 0;
+    mGenerations[handle.index]++;
+    mFreeSlots.push_back(handle.index);
+    mLiveCount--;
+    return true;
+}
+
+bool TrailPool::isValid(TrailHandle handle) const
+{
+    return handle.index < mFlags.size() && (mFlags[handle.index] & alive)
+           && mGenerations[handle.index] == handle.generation;
+}
+
+void TrailPool::addVertexPair(TrailHandle handle, const glm::vec3& firstVertex, const glm::vec3& secondVertex)
+{
+    assert(isValid(handle));
+    uint32_t slot = handle.index;
+    size_t vertIdx = (slot * mPairsPerTrail + mHeadPair[slot]) * 2;
+    mVertices[vertIdx] = firstVertex;
+    mVertices[vertIdx + 1] = secondVertex;
+    mHeadPair[slot] = static_cast<uint32_t>((mHeadPair[slot] + 1) % mPairsPerTrail);
+    if(mPairCount[slot] < mPairsPerTrail)
+    {
+        mPairCount[slot]++;
+    }
+    else
+    {
+        // we just overwrote the oldest pair, which may have been holding the bounds out
+        mFlags[slot] |= boundsStale;
+    }
+    mFlags[slot] |= dirty;
+    // growing the bounds is exact and cheap, only shrinking needs the full recompute
+    mBoundsMin.set(slot, glm::min(mBoundsMin.get(slot), glm::min(firstVertex, secondVertex)));
+    mBoundsMax.set(slot, glm::max(mBoundsMax.get(slot), glm::max(firstVertex, secondVertex)));
+    mColdState[slot].totalPairsAdded++;
+}
+
+bool TrailPool::removeOldestVertexPair(TrailHandle handle)
+{
+    assert(isValid(handle));
+    uint32_t slot = handle.index;
+    if(mPairCount[slot] == 0)
+    {
+        return false;
+    }
+    mPairCount[slot]--;
+    mFlags[slot] |= dirty;
+    if(mPairCount[slot] == 0)
+    {
+        mBoundsMin.set(slot, kEmptyBoundsMin);
+        mBoundsMax.set(slot, kEmptyBoundsMax);
+        mFlags[slot] &= static_cast<uint8_t>(~boundsStale);
+    }
+    else
+    {
+        mFlags[slot] |= boundsStale;
+    }
+    return true;
+}
+
+size_t TrailPool::copyVertices(TrailHandle handle, glm::vec3* destination) const
+{
+    assert(isValid(handle));
+    uint32_t slot = handle.index;
+    size_t ringStart = slot * mPairsPerTrail * 2;
+    size_t ringEnd = ringStart + mPairsPerTrail * 2;
+    size_t first = tailVertex(slot);
+    size_t vertexCount = mPairCount[slot] * 2;
+    size_t firstRun = std::min(vertexCount, ringEnd - first);
+    std::copy(mVertices.begin() + first, mVertices.begin() + first + firstRun, destination);
+    std::copy(mVertices.begin() + ringStart, mVertices.begin() + ringStart + (vertexCount - firstRun),
+            destination + firstRun);
+    return vertexCount;
+}
+
+TrailColdState& TrailPool::getColdState(TrailHandle handle)
+{
+    assert(isValid(handle));
+    return mColdState[handle.index];
+}
+
+void TrailPool::updateBounds()
+{
+    const uint8_t needsBounds = alive | boundsStale;
+    for(uint32_t slot = 0; slot < mFlags.size(); slot++)
+    {
+        if((mFlags[slot] & needsBounds) == needsBounds)
+        {
+            recomputeBounds(slot);
+        }
+    }
+}
+
+void TrailPool::collectDirty(std::vector<uint32_t>& slots) const
+{
+    const uint8_t liveAndDirty = alive | dirty;
+    for(uint32_t slot = 0; slot < mFlags.size(); slot++)
+    {
+        if((mFlags[slot] & liveAndDirty) == liveAndDirty)
+        {
+            slots.push_back(slot);
+        }
+    }
+}
+
+void TrailPool::clearDirty()
+{
+    for(uint8_t& flags : mFlags)
+    {
+        flags &= static_cast<uint8_t>(~dirty);
+    }
+}
+
+size_t TrailPool::getSlotCount() const
+{
+    return mFlags.size();
+}
+
+size_t TrailPool::getLiveCount() const
+{
+    return mLiveCount;
+}
+
+size_t TrailPool::getPairsPerTrail() const
+{
+    return mPairsPerTrail;
+}
+
+const uint8_t* TrailPool::getFlags() const
+{
+    return mFlags.data();
+}
+
+const uint32_t* TrailPool::getPairCounts() const
+{
+    return mPairCount.data();
+}
+
+const Vec3SoA& TrailPool::getBoundsMin() const
+{
+    return mBoundsMin;
+}
+
+const Vec3SoA& TrailPool::getBoundsMax() const
+{
+    return mBoundsMax;
+}
+
+TrailHandle TrailPool::getHandle(uint32_t slot) const
+{
+    TrailHandle handle;
+    handle.index = slot;
+    handle.generation = mGenerations[slot];
+    return handle;
+}
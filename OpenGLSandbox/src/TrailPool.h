@@ -0,0 +1,147 @@
+#ifndef OPENGLSANDBOX_TRAILPOOL_H
+#define OPENGLSANDBOX_TRAILPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Vec3SoA.h"
+
+/**
+ * Names a trail in a TrailPool.  The generation makes handles to destroyed trails detectably stale even
+ * after their slot has been reused.
+ */
+struct TrailHandle
+{
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+};
+
+/**
+ * State only touched when a trail is created, emits, or gets drawn, kept out of the arrays walked every frame
+ */
+struct TrailColdState
+{
+    /**
+     * Running count of every pair ever added, like RibbonTrail::getTotalPairsAdded()
+     */
+    size_t totalPairsAdded = 0;
+    /**
+     * Free for whoever owns the trail, e.g. an index into their emitter array
+     */
+    uint64_t userData = 0;
+};
+
+/**
+ * Storage for many ribbon trails of the same maximum length, laid out for iterating all of them every frame.
+ *
+ * Where RibbonTrail is one object with its own deque and index vector, a pool keeps every trail's vertex
+ * pairs in one preallocated ring per slot and splits per-trail state by how often it's used: the hot state
+ * the per-frame passes read (ring cursor, pair count, flags, bounds) lives in structure-of-arrays form, so
+ * e.g. finding the trails whose bounds need refreshing only streams through a byte of flags per trail, and
+ * bounds are Vec3SoA ready for batch culling.  Cold state sits in its own array.  Slots are recycled
+ * through a free list, so creating and destroying trails is O(1) and never moves other trails.
+ */
+class TrailPool
+{
+public:
+    /**
+     * Bits of a trail's hot flags byte
+     */
+    enum Flags : uint8_t
+    {
+        alive = 1 << 0,
+        /**
+         * Vertices changed since the last clearDirty(), so GPU copies need refreshing
+         */
+        dirty = 1 << 1,
+        /**
+         * A pair was dropped from the tail, so the bounds may be too big until updateBounds()
+         */
+        boundsStale = 1 << 2
+    };
+private:
+    size_t mPairsPerTrail;
+    size_t mLiveCount = 0;
+    /// hot state, one element per slot ///
+    std::vector<uint32_t> mHeadPair;
+    std::vector<uint32_t> mPairCount;
+    std::vector<uint8_t> mFlags;
+    Vec3SoA mBoundsMin;
+    Vec3SoA mBoundsMax;
+    /// cold state ///
+    std::vector<uint32_t> mGenerations;
+    std::vector<TrailColdState> mColdState;
+    std::vector<uint32_t> mFreeSlots;
+    /**
+     * Every slot's ring of mPairsPerTrail vertex pairs, back to back
+     */
+    std::vector<glm::vec3> mVertices;
+    /**
+     * Index of the oldest pair's first vertex in mVertices
+     */
+    size_t tailVertex(uint32_t slot) const;
+    void recomputeBounds(uint32_t slot);
+public:
+    /**
+     * @param pairsPerTrail how many vertex pairs each trail keeps before dropping its oldest
+     * @param initialCapacity slots to allocate up front
+     */
+    explicit TrailPool(size_t pairsPerTrail, size_t initialCapacity = 0);
+    /**
+     * Claims a slot for a new, empty trail, reusing a destroyed one if there is any
+     */
+    TrailHandle create();
+    /**
+     * Releases the trail's slot; the handle, and any copies of it, become invalid
+     * @return false if the handle was already invalid
+     */
+    bool destroy(TrailHandle handle);
+    bool isValid(TrailHandle handle) const;
+    /**
+     * Appends a pair at the trail's head, overwriting the oldest once it holds pairsPerTrail pairs
+     */
+    void addVertexPair(TrailHandle handle, const glm::vec3& firstVertex, const glm::vec3& secondVertex);
+    /**
+     * Drops the trail's oldest pair
+     * @return false if it had none
+     */
+    bool removeOldestVertexPair(TrailHandle handle);
+    /**
+     * Copies a trail's vertices out oldest first, the order RibbonTrail::getVertices() uses
+     * @param destination room for getPairCount() * 2 vertices
+     * @return number of vertices written
+     */
+    size_t copyVertices(TrailHandle handle, glm::vec3* destination) const;
+    TrailColdState& getColdState(TrailHandle handle);
+
+    /**
+     * Tightens the bounds of every trail that dropped pairs since the last call; call once per frame
+     * before reading bounds
+     */
+    void updateBounds();
+    /**
+     * Appends the slot of every live, dirty trail to slots
+     */
+    void collectDirty(std::vector<uint32_t>& slots) const;
+    void clearDirty();
+
+    /// per-slot hot arrays, getSlotCount() long; entries for dead slots are meaningless ///
+    size_t getSlotCount() const;
+    size_t getLiveCount() const;
+    size_t getPairsPerTrail() const;
+    const uint8_t* getFlags() const;
+    const uint32_t* getPairCounts() const;
+    /**
+     * Per-slot bounds; empty trails have min > max so they never overlap anything
+     */
+    const Vec3SoA& getBoundsMin() const;
+    const Vec3SoA& getBoundsMax() const;
+    /**
+     * @return the handle currently naming a live slot
+     */
+    TrailHandle getHandle(uint32_t slot) const;
+};
+
+
+#endif //OPENGLSANDBOX_TRAILPOOL_H
@@ -0,0 +1,214 @@
+#include "Vec3SoA.h"
+#include <algorithm>
+#include <cassert>
+#include "SimdLane.h"
+
+namespace
+{
+    using namespace simd;
+
+    static_assert(kSoAPadding % kLaneWidth == 0, "component arrays must pad out to whole lanes");
+
+    /**
+     * Applies a lane-wise operation to every component array of a and b; the operation must map zero
+     * padding lanes to zero
+     */
+    template<typename Operation>
+    void componentWise(const Vec3SoA& a, const Vec3SoA& b, Vec3SoA& out, Operation operation)
+    {
+        assert(a.size() == b.size());
+        out.resize(a.size());
+        const float* aComponents[] = {a.x(), a.y(), a.z()};
+        const float* bComponents[] = {b.x(), b.y(), b.z()};
+        float* outComponents[] = {out.x(), out.y(), out.z()};
+        size_t paddedSize = a.paddedSize();
+        for(size_t component = 0; component < 3; component++)
+        {
+            for(size_t idx = 0; idx < paddedSize; idx += kLaneWidth)
+            {
+                store(outComponents[component] + idx,
+                        operation(load(aComponents[component] + idx), load(bComponents[component] + idx)));
+            }
+        }
+    }
+}
+
+Vec3SoA::Vec3SoA(size_t count)
+{
+    resize(count);
+}
+
+Vec3SoA::Vec3SoA(const glm::vec3* vectors, size_t count)
+{
+    resize(count);
+    for(size_t idx = 0; idx < count; idx++)
+    {
+        set(idx, vectors[idx]);
+    }
+}
+
+void Vec3SoA::resize(size_t count)
+{
+    size_t paddedSize = paddedSoASize(count);
+    // shrinking leaves stale values in what become padding lanes, so zero them
+    if(count < mSize)
+    {
+        std::fill(mX.begin() + count, mX.begin() + std::min(mSize, paddedSize), 0.0F);
+        std::fill(mY.begin() + count, mY.begin() + std::min(mSize, paddedSize), 0.0F);
+        std::fill(mZ.begin() + count, mZ.begin() + std::min(mSize, paddedSize), 0.0F);
+    }
+    mX.resize(paddedSize, 0.0F);
+    mY.resize(paddedSize, 0.0F);
+    mZ.resize(paddedSize, 0.0F);
+    mSize = count;
+}
+
+void Vec3SoA::clear()
+{
+    resize(0);
+}
+
+void Vec3SoA::push_back(const glm::vec3& vector)
+{
+    if(mSize == mX.size())
+    {
+        // padding lanes are already zero, so only grow once we run out of them
+        mX.resize(mSize + kSoAPadding, 0.0F);
+        mY.resize(mSize + kSoAPadding, 0.0F);
+        mZ.resize(mSize + kSoAPadding, 0.0F);
+    }
+    set(mSize++, vector);
+}
+
+void Vec3SoA::eraseFront(size_t count)
+{
+    count = std::min(count, mSize);
+    std::copy(mX.begin() + count, mX.begin() + mSize, mX.begin());
+    std::copy(mY.begin() + count, mY.begin() + mSize, mY.begin());
+    std::copy(mZ.begin() + count, mZ.begin() + mSize, mZ.begin());
+    resize(mSize - count);
+}
+
+void Vec3SoA::interleave(glm::vec3* destination) const
+{
+    for(size_t idx = 0; idx < mSize; idx++)
+    {
+        destination[idx] = glm::vec3(mX[idx], mY[idx], mZ[idx]);
+    }
+}
+
+void Vec3SoA::interleave(glm::vec4* destination, float w) const
+{
+    size_t idx = 0;
+#ifdef OPENGLSANDBOX_SIMD_LANE_SSE
+    // 4x4 transpose: four x, y, z and w lanes in, four whole vec4s out
+    const __m128 wLane = _mm_set1_ps(w);
+    for(; idx + 4 <= mSize; idx += 4)
+    {
+        __m128 row0 = _mm_load_ps(mX.data() + idx);
+        __m128 row1 = _mm_load_ps(mY.data() + idx);
+        __m128 row2 = _mm_load_ps(mZ.data() + idx);
+        __m128 row3 = wLane;
+        _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+        _mm_storeu_ps(&destination[idx].x, row0);
+        _mm_storeu_ps(&destination[idx + 1].x, row1);
+        _mm_storeu_ps(&destination[idx + 2].x, row2);
+        _mm_storeu_ps(&destination[idx + 3].x, row3);
+    }
+#endif
+    for(; idx < mSize; idx++)
+    {
+        destination[idx] = glm::vec4(mX[idx], mY[idx], mZ[idx], w);
+    }
+}
+
+void batchAdd(const Vec3SoA& a, const Vec3SoA& b, Vec3SoA& out)
+{
+    componentWise(a, b, out, [](Lane lhs, Lane rhs){ return add(lhs, rhs); });
+}
+
+void batchSubtract(const Vec3SoA& a, const Vec3SoA& b, Vec3SoA& out)
+{
+    componentWise(a, b, out, [](Lane lhs, Lane rhs){ return subtract(lhs, rhs); });
+}
+
+void batchScale(const Vec3SoA& a, float scale, Vec3SoA& out)
+{
+    Lane scaleLane = splat(scale);
+    componentWise(a, a, out, [scaleLane](Lane lhs, Lane){ return multiply(lhs, scaleLane); });
+}
+
+void batchMultiplyAdd(const Vec3SoA& a, const Vec3SoA& b, float scale, Vec3SoA& out)
+{
+    Lane scaleLane = splat(scale);
+    componentWise(a, b, out, [scaleLane](Lane lhs, Lane rhs){ return add(lhs, multiply(rhs, scaleLane)); });
+}
+
+void batchLerp(const Vec3SoA& a, const Vec3SoA& b, float t, Vec3SoA& out)
+{
+    Lane tLane = splat(t);
+    componentWise(a, b, out, [tLane](Lane lhs, Lane rhs){ return add(lhs, multiply(subtract(rhs, lhs), tLane)); });
+}
+
+void batchDot(const Vec3SoA& a, const Vec3SoA& b, AlignedFloatVector& out)
+{
+    assert(a.size() == b.size());
+    size_t paddedSize = a.paddedSize();
+    out.resize(paddedSize);
+    for(size_t idx = 0; idx < paddedSize; idx += kLaneWidth)
+    {
+        Lane dot = multiply(load(a.x() + idx), load(b.x() + idx));
+        dot = add(dot, multiply(load(a.y() + idx), load(b.y() + idx)));
+        dot = add(dot, multiply(load(a.z() + idx), load(b.z() + idx)));
+        store(out.data() + idx, dot);
+    }
+}
+
+void batchNormalize(const Vec3SoA& a, Vec3SoA& out)
+{
+    out.resize(a.size());
+    size_t paddedSize = a.paddedSize();
+    for(size_t idx = 0; idx < paddedSize; idx += kLaneWidth)
+    {
+        Lane x = load(a.x() + idx);
+        Lane y = load(a.y() + idx);
+        Lane z = load(a.z() + idx);
+        Lane inverseLength = inverseLengthOrZero(add(add(multiply(x, x), multiply(y, y)), multiply(z, z)));
+        store(out.x() + idx, multiply(x, inverseLength));
+        store(out.y() + idx, multiply(y, inverseLength));
+        store(out.z() + idx, multiply(z, inverseLength));
+    }
+}
+
+bool batchBounds(const Vec3SoA& a, glm::vec3& min, glm::vec3& max)
+{
+    if(a.empty())
+    {
+        return false;
+    }
+    const float* components[] = {a.x(), a.y(), a.z()};
+    for(glm::length_t component = 0; component < 3; component++)
+    {
+        const float* values = components[component];
+        // padding lanes would drag the bounds towards zero, so only whole lanes of real data go wide
+        size_t wideEnd = a.size() / kLaneWidth * kLaneWidth;
+        Lane lower = splat(values[0]);
+        Lane upper = lower;
+        for(size_t idx = 0; idx < wideEnd; idx += kLaneWidth)
+        {
+            Lane value = load(values + idx);
+            lower = minimum(lower, value);
+            upper = maximum(upper, value);
+        }
+        float componentMin = reduceMin(lower);
+        float componentMax = reduceMax(upper);
+        for(size_t idx = wideEnd; idx < a.size(); idx++)
+        {
+            componentMin = std::min(componentMin, values[idx]);
+            componentMax = std::max(componentMax, values[idx]);
+        }
+        min[component] = componentMin;
+        max[component] = componentMax;
+    }
+    return true;
+}
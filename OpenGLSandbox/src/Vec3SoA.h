@@ -0,0 +1,178 @@
+#ifndef OPENGLSANDBOX_VEC3SOA_H
+#define OPENGLSANDBOX_VEC3SOA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <vector>
+#include <glm/glm.hpp>
+
+/*
+ * Structure-of-arrays vec3 storage and batch math.  Where glm::vec3 arrays interleave x, y and z in 12 byte
+ * elements that SIMD loads straddle, Vec3SoA keeps each component in its own cache line aligned array padded
+ * out to a whole number of SIMD registers, so the batch functions below process 4 (SSE) vectors a step with
+ * aligned loads and no remainder loop.  Padding lanes are kept at zero so they never produce NaNs.
+ */
+
+/**
+ * Minimal allocator handing out Alignment-aligned storage, for std::vector
+ */
+template<typename T, size_t Alignment>
+struct AlignedAllocator
+{
+    static_assert(Alignment >= alignof(void*) && (Alignment & (Alignment - 1)) == 0, "alignment must be a power of two");
+    using value_type = T;
+    template<typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t count)
+    {
+        if(count > std::numeric_limits<size_t>::max() / sizeof(T))
+        {
+            throw std::bad_alloc();
+        }
+        // over-allocate, align, and stash the pointer we got just before the block we hand out
+        void* raw = ::operator new(count * sizeof(T) + Alignment + sizeof(void*));
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + Alignment - 1) & ~(Alignment - 1);
+        reinterpret_cast<void**>(aligned)[-1] = raw;
+        return reinterpret_cast<T*>(aligned);
+    }
+
+    void deallocate(T* pointer, size_t)
+    {
+        ::operator delete(reinterpret_cast<void**>(pointer)[-1]);
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template<typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+/**
+ * Cache line alignment for SoA component arrays, which also satisfies 16 and 32 byte SIMD loads
+ */
+constexpr size_t kSoAAlignment = 64;
+/**
+ * Component arrays are padded to a multiple of this many floats, i.e. a full AVX register
+ */
+constexpr size_t kSoAPadding = 8;
+
+using AlignedFloatVector = std::vector<float, AlignedAllocator<float, kSoAAlignment>>;
+
+/**
+ * Rounds an element count up to the padded length of a component array
+ */
+inline size_t paddedSoASize(size_t count)
+{
+    return (count + kSoAPadding - 1) / kSoAPadding * kSoAPadding;
+}
+
+/**
+ * A growable array of vec3 stored as separate, aligned and padded x, y and z arrays
+ */
+class Vec3SoA
+{
+private:
+    size_t mSize = 0;
+    AlignedFloatVector mX;
+    AlignedFloatVector mY;
+    AlignedFloatVector mZ;
+public:
+    Vec3SoA() = default;
+    explicit Vec3SoA(size_t count);
+    /**
+     * Builds a SoA copy of an interleaved vec3 array
+     */
+    Vec3SoA(const glm::vec3* vectors, size_t count);
+
+    size_t size() const { return mSize; }
+    bool empty() const { return mSize == 0; }
+    /**
+     * @return length of each component array, a multiple of kSoAPadding
+     */
+    size_t paddedSize() const { return mX.size(); }
+    /**
+     * Resizes to count vectors; new vectors, and all padding lanes, are zero
+     */
+    void resize(size_t count);
+    void clear();
+    void push_back(const glm::vec3& vector);
+    /**
+     * Removes the first count vectors, shifting the rest down
+     */
+    void eraseFront(size_t count);
+
+    glm::vec3 get(size_t index) const { return glm::vec3(mX[index], mY[index], mZ[index]); }
+    void set(size_t index, const glm::vec3& vector)
+    {
+        mX[index] = vector.x;
+        mY[index] = vector.y;
+        mZ[index] = vector.z;
+    }
+
+    float* x() { return mX.data(); }
+    float* y() { return mY.data(); }
+    float* z() { return mZ.data(); }
+    const float* x() const { return mX.data(); }
+    const float* y() const { return mY.data(); }
+    const float* z() const { return mZ.data(); }
+
+    /**
+     * Writes the vectors out interleaved in one pass, as glm::vec3 / PositionVertex upload data
+     * @param destination room for size() vec3
+     */
+    void interleave(glm::vec3* destination) const;
+    /**
+     * Writes the vectors out interleaved as 16 byte vec4 with the given w, the padded upload layout
+     * @param destination room for size() vec4
+     */
+    void interleave(glm::vec4* destination, float w) const;
+};
+
+/// batch math; every output is resized to match its inputs and may alias one of them ///
+
+/**
+ * out[i] = a[i] + b[i]; a and b must be the same size
+ */
+void batchAdd(const Vec3SoA& a, const Vec3SoA& b, Vec3SoA& out);
+/**
+ * out[i] = a[i] - b[i]; a and b must be the same size
+ */
+void batchSubtract(const Vec3SoA& a, const Vec3SoA& b, Vec3SoA& out);
+/**
+ * out[i] = a[i] * scale
+ */
+void batchScale(const Vec3SoA& a, float scale, Vec3SoA& out);
+/**
+ * out[i] = a[i] + b[i] * scale, the fused step for integrating velocities or offsetting along normals
+ */
+void batchMultiplyAdd(const Vec3SoA& a, const Vec3SoA& b, float scale, Vec3SoA& out);
+/**
+ * out[i] = mix(a[i], b[i], t); a and b must be the same size
+ */
+void batchLerp(const Vec3SoA& a, const Vec3SoA& b, float t, Vec3SoA& out);
+/**
+ * out[i] = dot(a[i], b[i]); out gets padded like a component array
+ */
+void batchDot(const Vec3SoA& a, const Vec3SoA& b, AlignedFloatVector& out);
+/**
+ * out[i] = normalize(a[i]), except zero-length vectors stay zero instead of turning into NaNs
+ */
+void batchNormalize(const Vec3SoA& a, Vec3SoA& out);
+/**
+ * Component-wise min and max over every vector
+ * @return false, leaving min and max untouched, if there are no vectors
+ */
+bool batchBounds(const Vec3SoA& a, glm::vec3& min, glm::vec3& max);
+
+
+#endif //OPENGLSANDBOX_VEC3SOA_H
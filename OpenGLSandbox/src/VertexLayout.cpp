@@ -0,0 +1,145 @@
+#include "VertexLayout.h"
+#include <iostream>
+
+namespace
+{
+    /**
+     * Shader input kinds as far as attribute setup is concerned
+     */
+    enum class InputBaseType
+    {
+        floating,
+        signedInteger,
+        unsignedInteger,
+        other
+    };
+
+    /**
+     * Decomposes a reflected GL_TYPE such as GL_FLOAT_VEC3 into its component count and base type
+     */
+    void describeInputType(GLenum type, GLint& components, InputBaseType& baseType)
+    {
+        switch(type)
+        {
+            case GL_FLOAT: components = 1; baseType = InputBaseType::floating; break;
+            case GL_FLOAT_VEC2: components = 2; baseType = InputBaseType::floating; break;
+            case GL_FLOAT_VEC3: components = 3; baseType = InputBaseType::floating; break;
+            case GL_FLOAT_VEC4: components = 4; baseType = InputBaseType::floating; break;
+            case GL_INT: components = 1; baseType = InputBaseType::signedInteger; break;
+            case GL_INT_VEC2: components = 2; baseType = InputBaseType::signedInteger; break;
+            case GL_INT_VEC3: components = 3; baseType = InputBaseType::signedInteger; break;
+            case GL_INT_VEC4: components = 4; baseType = InputBaseType::signedInteger; break;
+            case GL_UNSIGNED_INT: components = 1; baseType = InputBaseType::unsignedInteger; break;
+            case GL_UNSIGNED_INT_VEC2: components = 2; baseType = InputBaseType::unsignedInteger; break;
+            case GL_UNSIGNED_INT_VEC3: components = 3; baseType = InputBaseType::unsignedInteger; break;
+            case GL_UNSIGNED_INT_VEC4: components = 4; baseType = InputBaseType::unsignedInteger; break;
+            default: components = 4; baseType = InputBaseType::other; break;
+        }
+    }
+}
+
+void applyVertexAttributes(
+        unsigned int vao,
+        GLuint bindingIndex,
+        unsigned int buffer,
+        GLintptr offset,
+        GLsizei stride,
+        GLuint divisor,
+        const VertexAttribute* attributes,
+        size_t attributeCount
+)
+{
+    setVertexBuffer(vao, bindingIndex, buffer, offset, stride);
+    setVertexBindingDivisor(vao, bindingIndex, divisor);
+    for(size_t attribIdx = 0; attribIdx < attributeCount; attribIdx++)
+    {
+        const VertexAttribute& attribute = attributes[attribIdx];
+        if(attribute.kind == AttributeKind::integer)
+        {
+            setIntegerVertexAttribute(
+                    vao,
+                    attribute.location,
+                    bindingIndex,
+                    attribute.components,
+                    attribute.type,
+                    attribute.offset
+            );
+        }
+        else
+        {
+            setVertexAttribute(
+                    vao,
+                    attribute.location,
+                    bindingIndex,
+                    attribute.components,
+                    attribute.type,
+                    attribute.kind == AttributeKind::normalized ? GL_TRUE : GL_FALSE,
+                    attribute.offset
+            );
+        }
+    }
+}
+
+bool validateVertexAttributes(
+        unsigned int programId,
+        const VertexAttribute* attributes,
+        size_t attributeCount,
+        const char* layoutName
+)
+{
+    bool valid = true;
+    GLint inputCount = 0;
+    glGetProgramInterfaceiv(programId, GL_PROGRAM_INPUT, GL_ACTIVE_RESOURCES, &inputCount);
+    for(GLint inputIdx = 0; inputIdx < inputCount; inputIdx++)
+    {
+        const GLenum properties[] = {GL_LOCATION, GL_TYPE};
+        GLint values[2];
+        glGetProgramResourceiv(programId, GL_PROGRAM_INPUT, inputIdx, 2, properties, 2, nullptr, values);
+        GLint location = values[0];
+        if(location < 0)
+        {
+            // built-ins like gl_VertexID have no location and aren't fed by attributes
+            continue;
+        }
+        char name[128];
+        glGetProgramResourceName(programId, GL_PROGRAM_INPUT, inputIdx, sizeof(name), nullptr, name);
+        GLint inputComponents;
+        InputBaseType inputBaseType;
+        describeInputType(static_cast<GLenum>(values[1]), inputComponents, inputBaseType);
+
+        const VertexAttribute* match = nullptr;
+        for(size_t attribIdx = 0; attribIdx < attributeCount; attribIdx++)
+        {
+            if(attributes[attribIdx].location == static_cast<GLuint>(location))
+            {
+                match = &attributes[attribIdx];
+                break;
+            }
+        }
+        if(!match)
+        {
+            std::cerr << "vertex layout " << layoutName << " has no attribute for shader input " << name
+            << " at location " << location << std::endl;
+            valid = false;
+            continue;
+        }
+        bool integerInput = inputBaseType == InputBaseType::signedInteger
+                || inputBaseType == InputBaseType::unsignedInteger;
+        if(integerInput != (match->kind == AttributeKind::integer))
+        {
+            std::cerr << "vertex layout " << layoutName << " feeds shader input " << name
+            << (integerInput ? " (integer) from non-integer data" : " (float) through the integer path") << std::endl;
+            valid = false;
+        }
+        // fewer components than the input is fine (missing ones default to 0,0,0,1), more are silently dropped;
+        // the one exception is a 4 component packed format padding a vec3, where dropping w is the point
+        bool paddedVec3 = match->components == 4 && inputComponents == 3 && match->kind != AttributeKind::integer;
+        if(inputBaseType != InputBaseType::other && match->components > inputComponents && !paddedVec3)
+        {
+            std::cerr << "vertex layout " << layoutName << " supplies " << match->components
+            << " components to shader input " << name << " which only consumes " << inputComponents << std::endl;
+            valid = false;
+        }
+    }
+    return valid;
+}
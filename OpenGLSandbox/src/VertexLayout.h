@@ -0,0 +1,289 @@
+#ifndef OPENGLSANDBOX_VERTEXLAYOUT_H
+#define OPENGLSANDBOX_VERTEXLAYOUT_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+#include "GLResources.h"
+
+/*
+ * Compile-time vertex layout descriptors.  A vertex format is an ordinary standard-layout struct plus a
+ * VertexLayout<> specialisation listing its attributes with the VERTEX_ATTRIBUTE* macros, which derive
+ * component count, component type and byte offset from the member's declared type; nothing about the layout
+ * is written out by hand, so changing a member's type or the order of members can't desynchronise the
+ * attribute setup.  E.g.
+ *
+ *     struct ColoredVertex { glm::vec3 position; glm::u8vec4 color; };
+ *     template<> struct VertexLayout<ColoredVertex>
+ *     {
+ *         static constexpr GLuint divisor = 0;
+ *         static constexpr std::array<VertexAttribute, 2> attributes()
+ *         {
+ *             return {{
+ *                 VERTEX_ATTRIBUTE(ColoredVertex, position, 0),
+ *                 VERTEX_ATTRIBUTE_NORMALIZED(ColoredVertex, color, 1)
+ *             }};
+ *         }
+ *     };
+ *
+ * applyVertexLayout<ColoredVertex>() then performs the DSA attribute setup, and validateVertexLayout<>()
+ * checks a linked program's active inputs against the layout.
+ */
+
+/**
+ * Four half floats, the packed counterpart of glm::vec4 (or of glm::vec3 plus padding)
+ */
+struct PackedHalf4
+{
+    uint16_t components[4];
+};
+
+/**
+ * Three signed normalised 10 bit components plus a 2 bit one, packed GL_INT_2_10_10_10_REV style with x in
+ * the low bits; the usual choice for normals and tangents
+ */
+struct PackedSnorm1010102
+{
+    uint32_t bits;
+};
+
+/**
+ * Unsigned counterpart of PackedSnorm1010102, GL_UNSIGNED_INT_2_10_10_10_REV
+ */
+struct PackedUnorm1010102
+{
+    uint32_t bits;
+};
+
+/**
+ * How a vertex attribute reaches the shader
+ */
+enum class AttributeKind
+{
+    /**
+     * float inputs fed from float data, or from integer data converted as-is
+     */
+    floating,
+    /**
+     * float inputs fed from integer data normalised into [0, 1] or [-1, 1]
+     */
+    normalized,
+    /**
+     * int/uint inputs fed from integer data
+     */
+    integer
+};
+
+/**
+ * Describes one vertex attribute within a vertex struct
+ */
+struct VertexAttribute
+{
+    GLuint location;
+    GLint components;
+    GLenum type;
+    AttributeKind kind;
+    GLuint offset;
+    /**
+     * sizeof() the member, for compile-time bounds checks
+     */
+    GLuint size;
+};
+
+/**
+ * Maps a member's C++ type onto GL component count and component type; specialised below
+ */
+template<typename T>
+struct AttributeFormat;
+
+/**
+ * Maps a scalar C++ type onto its GL component type
+ */
+template<typename T>
+struct ComponentType;
+template<> struct ComponentType<float> { static constexpr GLenum type = GL_FLOAT; };
+template<> struct ComponentType<int8_t> { static constexpr GLenum type = GL_BYTE; };
+template<> struct ComponentType<uint8_t> { static constexpr GLenum type = GL_UNSIGNED_BYTE; };
+template<> struct ComponentType<int16_t> { static constexpr GLenum type = GL_SHORT; };
+template<> struct ComponentType<uint16_t> { static constexpr GLenum type = GL_UNSIGNED_SHORT; };
+template<> struct ComponentType<int32_t> { static constexpr GLenum type = GL_INT; };
+template<> struct ComponentType<uint32_t> { static constexpr GLenum type = GL_UNSIGNED_INT; };
+
+template<typename T>
+struct AttributeFormat
+{
+    static constexpr GLint components = 1;
+    static constexpr GLenum type = ComponentType<T>::type;
+};
+template<glm::length_t L, typename T, glm::qualifier Q>
+struct AttributeFormat<glm::vec<L, T, Q>>
+{
+    static constexpr GLint components = L;
+    static constexpr GLenum type = ComponentType<T>::type;
+};
+template<>
+struct AttributeFormat<PackedHalf4>
+{
+    static constexpr GLint components = 4;
+    static constexpr GLenum type = GL_HALF_FLOAT;
+};
+template<>
+struct AttributeFormat<PackedSnorm1010102>
+{
+    static constexpr GLint components = 4;
+    static constexpr GLenum type = GL_INT_2_10_10_10_REV;
+};
+template<>
+struct AttributeFormat<PackedUnorm1010102>
+{
+    static constexpr GLint components = 4;
+    static constexpr GLenum type = GL_UNSIGNED_INT_2_10_10_10_REV;
+};
+
+/**
+ * Builds a VertexAttribute for a member of type T; use via the VERTEX_ATTRIBUTE* macros
+ */
+template<typename T>
+constexpr VertexAttribute makeVertexAttribute(GLuint location, size_t offset, AttributeKind kind)
+{
+    return VertexAttribute{
+            location,
+            AttributeFormat<T>::components,
+            AttributeFormat<T>::type,
+            kind,
+            static_cast<GLuint>(offset),
+            static_cast<GLuint>(sizeof(T))
+    };
+}
+
+#define VERTEX_ATTRIBUTE(VertexType, member, location) \
+    makeVertexAttribute<decltype(VertexType::member)>(location, offsetof(VertexType, member), AttributeKind::floating)
+#define VERTEX_ATTRIBUTE_NORMALIZED(VertexType, member, location) \
+    makeVertexAttribute<decltype(VertexType::member)>(location, offsetof(VertexType, member), AttributeKind::normalized)
+#define VERTEX_ATTRIBUTE_INTEGER(VertexType, member, location) \
+    makeVertexAttribute<decltype(VertexType::member)>(location, offsetof(VertexType, member), AttributeKind::integer)
+
+/**
+ * Specialise for each vertex struct, providing
+ *     static constexpr GLuint divisor;  // 0 for per-vertex data, N to advance once every N instances
+ *     static constexpr std::array<VertexAttribute, Count> attributes();
+ */
+template<typename Vertex>
+struct VertexLayout;
+
+/**
+ * Tightly packed vec3 position sourced by aPos at location 0, the layout every basic mesh in the sandbox uses
+ */
+struct PositionVertex
+{
+    glm::vec3 position;
+};
+static_assert(sizeof(PositionVertex) == sizeof(glm::vec3), "PositionVertex must alias an array of glm::vec3");
+
+template<>
+struct VertexLayout<PositionVertex>
+{
+    static constexpr GLuint divisor = 0;
+    static constexpr std::array<VertexAttribute, 1> attributes()
+    {
+        return {{
+                VERTEX_ATTRIBUTE(PositionVertex, position, 0)
+        }};
+    }
+};
+
+/**
+ * @return true if every attribute of Vertex's layout lies within the struct and no two share a location
+ */
+template<typename Vertex>
+constexpr bool isVertexLayoutWellFormed()
+{
+    const auto attributes = VertexLayout<Vertex>::attributes();
+    for(size_t attribIdx = 0; attribIdx < attributes.size(); attribIdx++)
+    {
+        if(attributes[attribIdx].offset + attributes[attribIdx].size > sizeof(Vertex))
+        {
+            return false;
+        }
+        for(size_t otherIdx = attribIdx + 1; otherIdx < attributes.size(); otherIdx++)
+        {
+            if(attributes[attribIdx].location == attributes[otherIdx].location)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Attaches a vertex buffer to a VAO binding point and sets up a run-time list of attributes to source from
+ * it; the non-template half of applyVertexLayout(), for layouts read from files
+ * @param vao vertex array object to modify
+ * @param bindingIndex buffer binding point to use
+ * @param buffer vertex buffer
+ * @param offset byte offset of the first vertex in the buffer
+ * @param stride byte distance between consecutive vertices
+ * @param divisor 0 to advance per vertex, N to advance once every N instances
+ * @param attributes the layout's attributes
+ * @param attributeCount number of attributes
+ */
+void applyVertexAttributes(
+        unsigned int vao,
+        GLuint bindingIndex,
+        unsigned int buffer,
+        GLintptr offset,
+        GLsizei stride,
+        GLuint divisor,
+        const VertexAttribute* attributes,
+        size_t attributeCount
+);
+
+/**
+ * Attaches a buffer of Vertex structs to a VAO binding point and sets up every attribute of Vertex's layout
+ * to source from it
+ * @param vao vertex array object to modify
+ * @param bindingIndex buffer binding point to use
+ * @param buffer vertex buffer holding an array of Vertex
+ * @param offset byte offset of the first vertex in the buffer
+ */
+template<typename Vertex>
+void applyVertexLayout(unsigned int vao, GLuint bindingIndex, unsigned int buffer, GLintptr offset)
+{
+    static_assert(isVertexLayoutWellFormed<Vertex>(), "vertex layout overruns its struct or repeats a location");
+    auto attributes = VertexLayout<Vertex>::attributes();
+    applyVertexAttributes(vao, bindingIndex, buffer, offset, sizeof(Vertex), VertexLayout<Vertex>::divisor,
+            attributes.data(), attributes.size());
+}
+
+/**
+ * Checks the active vertex inputs of a linked program against a set of attributes, printing a description
+ * of every mismatch to std::cerr: inputs no attribute feeds, attributes feeding inputs of a different
+ * kind (float vs int), and attributes supplying more components than the input consumes
+ * @param programId linked shader program
+ * @param attributes the layout's attributes
+ * @param attributeCount number of attributes
+ * @param layoutName name to use in error output
+ * @return true if the layout can feed the program
+ */
+bool validateVertexAttributes(
+        unsigned int programId,
+        const VertexAttribute* attributes,
+        size_t attributeCount,
+        const char* layoutName
+);
+
+/**
+ * Checks the active vertex inputs of a linked program against Vertex's layout, see validateVertexAttributes()
+ */
+template<typename Vertex>
+bool validateVertexLayout(unsigned int programId, const char* layoutName)
+{
+    auto attributes = VertexLayout<Vertex>::attributes();
+    return validateVertexAttributes(programId, attributes.data(), attributes.size(), layoutName);
+}
+
+
+#endif //OPENGLSANDBOX_VERTEXLAYOUT_H
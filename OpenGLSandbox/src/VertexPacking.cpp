@@ -0,0 +1,492 @@
+#include "VertexPacking.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include "GLResources.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define OPENGLSANDBOX_X86_PACKING_KERNELS 1
+#include <immintrin.h>
+#endif
+
+static_assert(sizeof(PackedPositionVertex) == sizeof(PackedHalf4), "PackedPositionVertex must alias PackedHalf4");
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float) && sizeof(glm::vec4) == 4 * sizeof(float),
+        "kernels walk glm vectors as tightly packed floats");
+
+namespace
+{
+    /**
+     * Function signature shared by every kernel: count source vectors of Stride floats, with w substituted
+     * for the fourth component when Stride is 3
+     */
+    typedef void (*PackingKernel)(const float* source, float w, void* destination, size_t count);
+
+    /// scalar element conversions, mirroring SSE semantics (NaN clamps to the lower bound) ///
+
+    inline float clampScalar(float value, float lower, float upper)
+    {
+        float clamped = value > lower ? value : lower;
+        return clamped < upper ? clamped : upper;
+    }
+
+    inline int32_t roundScalar(float value)
+    {
+        // lrint honours the current rounding mode, round-to-nearest-even by default, just like cvtps2dq
+        return static_cast<int32_t>(std::lrint(value));
+    }
+
+    uint16_t floatToHalf(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+        int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF);
+        uint32_t mantissa = bits & 0x7FFFFF;
+        if(exponent == 0xFF)
+        {
+            // infinity stays infinity, NaN stays a quiet NaN
+            return static_cast<uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 | (mantissa >> 13) : 0));
+        }
+        int32_t halfExponent = exponent - 127 + 15;
+        if(halfExponent >= 31)
+        {
+            return static_cast<uint16_t>(sign | 0x7C00);
+        }
+        if(halfExponent <= 0)
+        {
+            if(halfExponent < -10)
+            {
+                return sign;
+            }
+            // subnormal half: shift the mantissa, implicit bit included, into place and round to nearest even
+            mantissa |= 0x800000;
+            uint32_t shift = static_cast<uint32_t>(14 - halfExponent);
+            uint32_t halfMantissa = mantissa >> shift;
+            uint32_t remainder = mantissa & ((1U << shift) - 1);
+            uint32_t halfway = 1U << (shift - 1);
+            if(remainder > halfway || (remainder == halfway && (halfMantissa & 1)))
+            {
+                halfMantissa++;
+            }
+            return static_cast<uint16_t>(sign | halfMantissa);
+        }
+        uint32_t half = static_cast<uint32_t>(halfExponent << 10) | (mantissa >> 13);
+        uint32_t remainder = mantissa & 0x1FFF;
+        // a carry out of the mantissa correctly bumps the exponent, all the way up to infinity
+        if(remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        {
+            half++;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    template<size_t Stride>
+    inline void loadScalar(const float* source, float w, float (&vector)[4])
+    {
+        vector[0] = source[0];
+        vector[1] = source[1];
+        vector[2] = source[2];
+        vector[3] = Stride == 4 ? source[3] : w;
+    }
+
+    template<size_t Stride>
+    void packHalfScalar(const float* source, float w, void* destination, size_t count)
+    {
+        PackedHalf4* output = static_cast<PackedHalf4*>(destination);
+        for(size_t vecIdx = 0; vecIdx < count; vecIdx++)
+        {
+            float vector[4];
+            loadScalar<Stride>(source + vecIdx * Stride, w, vector);
+            for(size_t component = 0; component < 4; component++)
+            {
+                output[vecIdx].components[component] = floatToHalf(vector[component]);
+            }
+        }
+    }
+
+    template<size_t Stride>
+    void packSnorm16Scalar(const float* source, float w, void* destination, size_t count)
+    {
+        glm::i16vec4* output = static_cast<glm::i16vec4*>(destination);
+        for(size_t vecIdx = 0; vecIdx < count; vecIdx++)
+        {
+            float vector[4];
+            loadScalar<Stride>(source + vecIdx * Stride, w, vector);
+            for(glm::length_t component = 0; component < 4; component++)
+            {
+                output[vecIdx][component] = static_cast<int16_t>(
+                        roundScalar(clampScalar(vector[component], -1.0F, 1.0F) * 32767.0F)
+                );
+            }
+        }
+    }
+
+    template<size_t Stride>
+    void packUnorm8Scalar(const float* source, float w, void* destination, size_t count)
+    {
+        glm::u8vec4* output = static_cast<glm::u8vec4*>(destination);
+        for(size_t vecIdx = 0; vecIdx < count; vecIdx++)
+        {
+            float vector[4];
+            loadScalar<Stride>(source + vecIdx * Stride, w, vector);
+            for(glm::length_t component = 0; component < 4; component++)
+            {
+                output[vecIdx][component] = static_cast<uint8_t>(
+                        roundScalar(clampScalar(vector[component], 0.0F, 1.0F) * 255.0F)
+                );
+            }
+        }
+    }
+
+    template<size_t Stride>
+    void packSnorm1010102Scalar(const float* source, float w, void* destination, size_t count)
+    {
+        PackedSnorm1010102* output = static_cast<PackedSnorm1010102*>(destination);
+        for(size_t vecIdx = 0; vecIdx < count; vecIdx++)
+        {
+            float vector[4];
+            loadScalar<Stride>(source + vecIdx * Stride, w, vector);
+            uint32_t x = static_cast<uint32_t>(roundScalar(clampScalar(vector[0], -1.0F, 1.0F) * 511.0F));
+            uint32_t y = static_cast<uint32_t>(roundScalar(clampScalar(vector[1], -1.0F, 1.0F) * 511.0F));
+            uint32_t z = static_cast<uint32_t>(roundScalar(clampScalar(vector[2], -1.0F, 1.0F) * 511.0F));
+            uint32_t wBits = static_cast<uint32_t>(roundScalar(clampScalar(vector[3], -1.0F, 1.0F)));
+            output[vecIdx].bits = (x & 0x3FF) | ((y & 0x3FF) << 10) | ((z & 0x3FF) << 20) | ((wBits & 0x3) << 30);
+        }
+    }
+
+    template<size_t Stride>
+    void packUnorm1010102Scalar(const float* source, float w, void* destination, size_t count)
+    {
+        PackedUnorm1010102* output = static_cast<PackedUnorm1010102*>(destination);
+        for(size_t vecIdx = 0; vecIdx < count; vecIdx++)
+        {
+            float vector[4];
+            loadScalar<Stride>(source + vecIdx * Stride, w, vector);
+            uint32_t x = static_cast<uint32_t>(roundScalar(clampScalar(vector[0], 0.0F, 1.0F) * 1023.0F));
+            uint32_t y = static_cast<uint32_t>(roundScalar(clampScalar(vector[1], 0.0F, 1.0F) * 1023.0F));
+            uint32_t z = static_cast<uint32_t>(roundScalar(clampScalar(vector[2], 0.0F, 1.0F) * 1023.0F));
+            uint32_t wBits = static_cast<uint32_t>(roundScalar(clampScalar(vector[3], 0.0F, 1.0F) * 3.0F));
+            output[vecIdx].bits = x | (y << 10) | (z << 20) | (wBits << 30);
+        }
+    }
+
+#ifdef OPENGLSANDBOX_X86_PACKING_KERNELS
+    /**
+     * Number of leading vectors we may fetch with a full 4-float load; for vec3 sources the final vector
+     * would read past the end of the array, so it's left to the scalar path
+     */
+    template<size_t Stride>
+    inline size_t wideLoadableCount(size_t count)
+    {
+        return Stride == 4 || count == 0 ? count : count - 1;
+    }
+
+    template<size_t Stride>
+    __attribute__((target("sse4.1")))
+    inline __m128 loadVector(const float* source, __m128 wVector)
+    {
+        __m128 vector = _mm_loadu_ps(source);
+        return Stride == 4 ? vector : _mm_blend_ps(vector, wVector, 0x8);
+    }
+
+    template<size_t Stride>
+    __attribute__((target("sse4.1")))
+    void packSnorm16Sse41(const float* source, float w, void* destination, size_t count)
+    {
+        int16_t* output = static_cast<int16_t*>(destination);
+        const __m128 wVector = _mm_set1_ps(w);
+        const __m128 lower = _mm_set1_ps(-1.0F);
+        const __m128 upper = _mm_set1_ps(1.0F);
+        const __m128 scale = _mm_set1_ps(32767.0F);
+        size_t wideCount = wideLoadableCount<Stride>(count);
+        size_t vecIdx = 0;
+        for(; vecIdx < wideCount; vecIdx++)
+        {
+            __m128 vector = loadVector<Stride>(source + vecIdx * Stride, wVector);
+            __m128i integers = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(vector, lower), upper), scale));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(output + vecIdx * 4), _mm_packs_epi32(integers, integers));
+        }
+        packSnorm16Scalar<Stride>(source + vecIdx * Stride, w, output + vecIdx * 4, count - vecIdx);
+    }
+
+    template<size_t Stride>
+    __attribute__((target("sse4.1")))
+    void packUnorm8Sse41(const float* source, float w, void* destination, size_t count)
+    {
+        uint8_t* output = static_cast<uint8_t*>(destination);
+        const __m128 wVector = _mm_set1_ps(w);
+        const __m128 lower = _mm_setzero_ps();
+        const __m128 upper = _mm_set1_ps(1.0F);
+        const __m128 scale = _mm_set1_ps(255.0F);
+        size_t wideCount = wideLoadableCount<Stride>(count);
+        size_t vecIdx = 0;
+        for(; vecIdx < wideCount; vecIdx++)
+        {
+            __m128 vector = loadVector<Stride>(source + vecIdx * Stride, wVector);
+            __m128i integers = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(vector, lower), upper), scale));
+            __m128i shorts = _mm_packs_epi32(integers, integers);
+            int32_t bytes = _mm_cvtsi128_si32(_mm_packus_epi16(shorts, shorts));
+            std::memcpy(output + vecIdx * 4, &bytes, sizeof(bytes));
+        }
+        packUnorm8Scalar<Stride>(source + vecIdx * Stride, w, output + vecIdx * 4, count - vecIdx);
+    }
+
+    template<size_t Stride>
+    __attribute__((target("sse4.1")))
+    void packSnorm1010102Sse41(const float* source, float w, void* destination, size_t count)
+    {
+        uint32_t* output = static_cast<uint32_t*>(destination);
+        const __m128 wVector = _mm_set1_ps(w);
+        const __m128 lower = _mm_set1_ps(-1.0F);
+        const __m128 upper = _mm_set1_ps(1.0F);
+        const __m128 scale = _mm_setr_ps(511.0F, 511.0F, 511.0F, 1.0F);
+        const __m128i mask = _mm_setr_epi32(0x3FF, 0x3FF, 0x3FF, 0x3);
+        // multiplying by a power of two is our per-lane left shift by 0, 10, 20 and 30 bits
+        const __m128i shifts = _mm_setr_epi32(1, 1 << 10, 1 << 20, 1 << 30);
+        size_t wideCount = wideLoadableCount<Stride>(count);
+        size_t vecIdx = 0;
+        for(; vecIdx < wideCount; vecIdx++)
+        {
+            __m128 vector = loadVector<Stride>(source + vecIdx * Stride, wVector);
+            __m128i integers = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(vector, lower), upper), scale));
+            __m128i fields = _mm_mullo_epi32(_mm_and_si128(integers, mask), shifts);
+            // the four fields don't overlap, so OR-ing all lanes together assembles the packed word
+            fields = _mm_or_si128(fields, _mm_shuffle_epi32(fields, _MM_SHUFFLE(1, 0, 3, 2)));
+            fields = _mm_or_si128(fields, _mm_shuffle_epi32(fields, _MM_SHUFFLE(2, 3, 0, 1)));
+            output[vecIdx] = static_cast<uint32_t>(_mm_cvtsi128_si32(fields));
+        }
+        packSnorm1010102Scalar<Stride>(source + vecIdx * Stride, w, output + vecIdx, count - vecIdx);
+    }
+
+    template<size_t Stride>
+    __attribute__((target("sse4.1")))
+    void packUnorm1010102Sse41(const float* source, float w, void* destination, size_t count)
+    {
+        uint32_t* output = static_cast<uint32_t*>(destination);
+        const __m128 wVector = _mm_set1_ps(w);
+        const __m128 lower = _mm_setzero_ps();
+        const __m128 upper = _mm_set1_ps(1.0F);
+        const __m128 scale = _mm_setr_ps(1023.0F, 1023.0F, 1023.0F, 3.0F);
+        const __m128i shifts = _mm_setr_epi32(1, 1 << 10, 1 << 20, 1 << 30);
+        size_t wideCount = wideLoadableCount<Stride>(count);
+        size_t vecIdx = 0;
+        for(; vecIdx < wideCount; vecIdx++)
+        {
+            // clamped to [0, 1] every field already fits its width, so unlike the signed kernel there's nothing to mask
+            __m128 vector = loadVector<Stride>(source + vecIdx * Stride, wVector);
+            __m128i integers = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(vector, lower), upper), scale));
+            __m128i fields = _mm_mullo_epi32(integers, shifts);
+            fields = _mm_or_si128(fields, _mm_shuffle_epi32(fields, _MM_SHUFFLE(1, 0, 3, 2)));
+            fields = _mm_or_si128(fields, _mm_shuffle_epi32(fields, _MM_SHUFFLE(2, 3, 0, 1)));
+            output[vecIdx] = static_cast<uint32_t>(_mm_cvtsi128_si32(fields));
+        }
+        packUnorm1010102Scalar<Stride>(source + vecIdx * Stride, w, output + vecIdx, count - vecIdx);
+    }
+
+    template<size_t Stride>
+    __attribute__((target("avx2,f16c")))
+    void packHalfAvx2(const float* source, float w, void* destination, size_t count)
+    {
+        uint16_t* output = static_cast<uint16_t*>(destination);
+        const __m128 wVector = _mm_set1_ps(w);
+        size_t wideCount = wideLoadableCount<Stride>(count);
+        size_t vecIdx = 0;
+        for(; vecIdx + 2 <= wideCount; vecIdx += 2)
+        {
+            __m256 vectors = _mm256_set_m128(
+                    loadVector<Stride>(source + (vecIdx + 1) * Stride, wVector),
+                    loadVector<Stride>(source + vecIdx * Stride, wVector)
+            );
+            __m128i halves = _mm256_cvtps_ph(vectors, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + vecIdx * 4), halves);
+        }
+        for(; vecIdx < wideCount; vecIdx++)
+        {
+            __m128i halves = _mm_cvtps_ph(
+                    loadVector<Stride>(source + vecIdx * Stride, wVector),
+                    _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC
+            );
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(output + vecIdx * 4), halves);
+        }
+        packHalfScalar<Stride>(source + vecIdx * Stride, w, output + vecIdx * 4, count - vecIdx);
+    }
+
+    template<size_t Stride>
+    __attribute__((target("avx2")))
+    void packSnorm16Avx2(const float* source, float w, void* destination, size_t count)
+    {
+        int16_t* output = static_cast<int16_t*>(destination);
+        const __m128 wVector = _mm_set1_ps(w);
+        const __m256 lower = _mm256_set1_ps(-1.0F);
+        const __m256 upper = _mm256_set1_ps(1.0F);
+        const __m256 scale = _mm256_set1_ps(32767.0F);
+        size_t wideCount = wideLoadableCount<Stride>(count);
+        size_t vecIdx = 0;
+        for(; vecIdx + 2 <= wideCount; vecIdx += 2)
+        {
+            __m256 vectors = _mm256_set_m128(
+                    loadVector<Stride>(source + (vecIdx + 1) * Stride, wVector),
+                    loadVector<Stride>(source + vecIdx * Stride, wVector)
+            );
+            __m256i integers = _mm256_cvtps_epi32(
+                    _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(vectors, lower), upper), scale)
+            );
+            __m128i shorts = _mm_packs_epi32(_mm256_castsi256_si128(integers), _mm256_extracti128_si256(integers, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + vecIdx * 4), shorts);
+        }
+        packSnorm16Sse41<Stride>(source + vecIdx * Stride, w, output + vecIdx * 4, count - vecIdx);
+    }
+#endif
+
+    /**
+     * One kernel per format and source stride
+     */
+    struct PackingKernels
+    {
+        const char* name;
+        PackingKernel half3;
+        PackingKernel half4;
+        PackingKernel snorm16x3;
+        PackingKernel snorm16x4;
+        PackingKernel unorm8x3;
+        PackingKernel unorm8x4;
+        PackingKernel snorm1010102x3;
+        PackingKernel snorm1010102x4;
+        PackingKernel unorm1010102x3;
+        PackingKernel unorm1010102x4;
+    };
+
+    const PackingKernels kScalarKernels = {
+            "scalar",
+            packHalfScalar<3>, packHalfScalar<4>,
+            packSnorm16Scalar<3>, packSnorm16Scalar<4>,
+            packUnorm8Scalar<3>, packUnorm8Scalar<4>,
+            packSnorm1010102Scalar<3>, packSnorm1010102Scalar<4>,
+            packUnorm1010102Scalar<3>, packUnorm1010102Scalar<4>
+    };
+
+#ifdef OPENGLSANDBOX_X86_PACKING_KERNELS
+    const PackingKernels kSse41Kernels = {
+            "sse4.1",
+            packHalfScalar<3>, packHalfScalar<4>,
+            packSnorm16Sse41<3>, packSnorm16Sse41<4>,
+            packUnorm8Sse41<3>, packUnorm8Sse41<4>,
+            packSnorm1010102Sse41<3>, packSnorm1010102Sse41<4>,
+            packUnorm1010102Sse41<3>, packUnorm1010102Sse41<4>
+    };
+
+    const PackingKernels kAvx2Kernels = {
+            "avx2+f16c",
+            packHalfAvx2<3>, packHalfAvx2<4>,
+            packSnorm16Avx2<3>, packSnorm16Avx2<4>,
+            packUnorm8Sse41<3>, packUnorm8Sse41<4>,
+            packSnorm1010102Sse41<3>, packSnorm1010102Sse41<4>,
+            packUnorm1010102Sse41<3>, packUnorm1010102Sse41<4>
+    };
+#endif
+
+    const PackingKernels* detectKernels()
+    {
+#ifdef OPENGLSANDBOX_X86_PACKING_KERNELS
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c"))
+        {
+            return &kAvx2Kernels;
+        }
+        if(__builtin_cpu_supports("sse4.1"))
+        {
+            return &kSse41Kernels;
+        }
+#endif
+        return &kScalarKernels;
+    }
+
+    std::atomic<bool> g_scalarOnly(false);
+
+    const PackingKernels& kernels()
+    {
+        static const PackingKernels* detected = detectKernels();
+        return g_scalarOnly ? kScalarKernels : *detected;
+    }
+}
+
+void packHalf4(const glm::vec4* source, PackedHalf4* destination, size_t count)
+{
+    kernels().half4(&source->x, 0.0F, destination, count);
+}
+
+void packHalf4(const glm::vec3* source, float w, PackedHalf4* destination, size_t count)
+{
+    kernels().half3(&source->x, w, destination, count);
+}
+
+void packSnorm16x4(const glm::vec4* source, glm::i16vec4* destination, size_t count)
+{
+    kernels().snorm16x4(&source->x, 0.0F, destination, count);
+}
+
+void packSnorm16x4(const glm::vec3* source, float w, glm::i16vec4* destination, size_t count)
+{
+    kernels().snorm16x3(&source->x, w, destination, count);
+}
+
+void packUnorm8x4(const glm::vec4* source, glm::u8vec4* destination, size_t count)
+{
+    kernels().unorm8x4(&source->x, 0.0F, destination, count);
+}
+
+void packUnorm8x4(const glm::vec3* source, float w, glm::u8vec4* destination, size_t count)
+{
+    kernels().unorm8x3(&source->x, w, destination, count);
+}
+
+void packSnorm1010102(const glm::vec4* source, PackedSnorm1010102* destination, size_t count)
+{
+    kernels().snorm1010102x4(&source->x, 0.0F, destination, count);
+}
+
+void packSnorm1010102(const glm::vec3* source, float w, PackedSnorm1010102* destination, size_t count)
+{
+    kernels().snorm1010102x3(&source->x, w, destination, count);
+}
+
+void packUnorm1010102(const glm::vec4* source, PackedUnorm1010102* destination, size_t count)
+{
+    kernels().unorm1010102x4(&source->x, 0.0F, destination, count);
+}
+
+void packUnorm1010102(const glm::vec3* source, float w, PackedUnorm1010102* destination, size_t count)
+{
+    kernels().unorm1010102x3(&source->x, w, destination, count);
+}
+
+const char* getVertexPackingKernelName()
+{
+    return kernels().name;
+}
+
+void setVertexPackingScalarOnly(bool scalarOnly)
+{
+    g_scalarOnly = scalarOnly;
+}
+
+void uploadPackedPositions(
+        unsigned int buffer,
+        size_t firstVertex,
+        const glm::vec3* positions,
+        size_t count,
+        std::vector<PackedPositionVertex>& staging
+)
+{
+    if(staging.size() < count)
+    {
+        staging.resize(count);
+    }
+    packHalf4(positions, 1.0F, &staging.data()->position, count);
+    updateBuffer(
+            buffer,
+            sizeof(PackedPositionVertex) * firstVertex,
+            sizeof(PackedPositionVertex) * count,
+            staging.data()
+    );
+}
@@ -0,0 +1,83 @@
+#ifndef OPENGLSANDBOX_VERTEXPACKING_H
+#define OPENGLSANDBOX_VERTEXPACKING_H
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include "VertexLayout.h"
+
+/*
+ * Bulk vertex attribute packing kernels.  Each converts a whole array of vec3/vec4 into a compact GPU format
+ * in one pass, using F16C/AVX2 or SSE4.1 when the CPU has them (checked once at runtime) and a scalar path
+ * otherwise; every path rounds to nearest even so results don't depend on which one ran.  vec3 overloads
+ * take the value to fill the fourth, padding component with, so packed attributes stay 4-byte aligned.
+ *
+ *   half:      IEEE 754 binary16, via PackedHalf4
+ *   snorm16:   clamp to [-1, 1], scale by 32767
+ *   unorm8:    clamp to [0, 1], scale by 255
+ *   1010102:   xyz clamped to [-1, 1] and scaled by 511, w clamped to [-1, 1], GL_INT_2_10_10_10_REV layout
+ *   u1010102:  xyz clamped to [0, 1] and scaled by 1023, w clamped to [0, 1] and scaled by 3,
+ *              GL_UNSIGNED_INT_2_10_10_10_REV layout
+ */
+
+void packHalf4(const glm::vec4* source, PackedHalf4* destination, size_t count);
+void packHalf4(const glm::vec3* source, float w, PackedHalf4* destination, size_t count);
+void packSnorm16x4(const glm::vec4* source, glm::i16vec4* destination, size_t count);
+void packSnorm16x4(const glm::vec3* source, float w, glm::i16vec4* destination, size_t count);
+void packUnorm8x4(const glm::vec4* source, glm::u8vec4* destination, size_t count);
+void packUnorm8x4(const glm::vec3* source, float w, glm::u8vec4* destination, size_t count);
+void packSnorm1010102(const glm::vec4* source, PackedSnorm1010102* destination, size_t count);
+void packSnorm1010102(const glm::vec3* source, float w, PackedSnorm1010102* destination, size_t count);
+void packUnorm1010102(const glm::vec4* source, PackedUnorm1010102* destination, size_t count);
+void packUnorm1010102(const glm::vec3* source, float w, PackedUnorm1010102* destination, size_t count);
+
+/**
+ * @return the instruction set the packing kernels dispatch to on this CPU: "avx2+f16c", "sse4.1" or "scalar"
+ */
+const char* getVertexPackingKernelName();
+
+/**
+ * Forces the portable scalar kernels (or restores runtime dispatch), for benchmarking and cross-checking
+ */
+void setVertexPackingScalarOnly(bool scalarOnly);
+
+/**
+ * vec3 position packed to half floats with w = 1, i.e. 8 bytes a vertex instead of 12; feeds a vec3 or
+ * vec4 aPos at location 0 like PositionVertex does
+ */
+struct PackedPositionVertex
+{
+    PackedHalf4 position;
+};
+
+template<>
+struct VertexLayout<PackedPositionVertex>
+{
+    static constexpr GLuint divisor = 0;
+    static constexpr std::array<VertexAttribute, 1> attributes()
+    {
+        return {{
+                VERTEX_ATTRIBUTE(PackedPositionVertex, position, 0)
+        }};
+    }
+};
+
+/**
+ * Packs positions into a reusable staging array and uploads them into a buffer holding PackedPositionVertex
+ * @param buffer destination buffer, created with GL_DYNAMIC_STORAGE_BIT
+ * @param firstVertex index of the first vertex to overwrite in the buffer
+ * @param positions positions to pack
+ * @param count number of positions
+ * @param staging scratch array, grown as needed and kept by the caller across uploads
+ */
+void uploadPackedPositions(
+        unsigned int buffer,
+        size_t firstVertex,
+        const glm::vec3* positions,
+        size_t count,
+        std::vector<PackedPositionVertex>& staging
+);
+
+
+#endif //OPENGLSANDBOX_VERTEXPACKING_H
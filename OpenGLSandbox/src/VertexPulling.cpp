@@ -0,0 +1,162 @@
+#include "VertexPulling.h"
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+namespace
+{
+    /**
+     * SSBO binding points, as declared in pulled_render.vert
+     */
+    const GLuint kVertexWordBinding = 0;
+    const GLuint kMeshRecordBinding = 1;
+
+    /**
+     * Every mesh's vertices start on a 16 byte boundary
+     */
+    const size_t kMeshAlignmentWords = 4;
+}
+
+VertexPullingBuffers::VertexPullingBuffers(size_t maxVertexBytes, size_t maxIndices, size_t maxMeshes)
+        : mVertexWordCapacity(maxVertexBytes / sizeof(GLuint)), mIndexCapacity(maxIndices), mMeshCapacity(maxMeshes)
+{
+    // zero-sized storage isn't allowed, so always have room for something
+    mVertexBuffer = createBuffer(static_cast<GLsizeiptr>(sizeof(GLuint) * std::max<size_t>(mVertexWordCapacity, 1)),
+            nullptr, GL_DYNAMIC_STORAGE_BIT);
+    mIndexBuffer = createBuffer(static_cast<GLsizeiptr>(sizeof(uint32_t) * std::max<size_t>(mIndexCapacity, 1)),
+            nullptr, GL_DYNAMIC_STORAGE_BIT);
+    mRecordBuffer = createBuffer(static_cast<GLsizeiptr>(sizeof(PulledMeshRecord) * std::max<size_t>(mMeshCapacity, 1)),
+            nullptr, GL_DYNAMIC_STORAGE_BIT);
+    // triangle list commands in the first half, strip commands in the second
+    mIndirectBuffer = createBuffer(
+            static_cast<GLsizeiptr>(sizeof(DrawElementsIndirectCommand) * 2 * std::max<size_t>(mMeshCapacity, 1)), nullptr,
+            GL_DYNAMIC_STORAGE_BIT);
+    // no attributes at all; the vertex shader fetches everything itself
+    mVAO = createVertexArray();
+    setElementBuffer(mVAO, mIndexBuffer);
+}
+
+VertexPullingBuffers::~VertexPullingBuffers()
+{
+    unsigned int buffers[] = {mVertexBuffer, mIndexBuffer, mRecordBuffer, mIndirectBuffer};
+    glDeleteBuffers(4, buffers);
+    glDeleteVertexArrays(1, &mVAO);
+}
+
+size_t VertexPullingBuffers::addMesh(PulledVertexFormat format, size_t vertexStride, const void* vertices,
+        size_t vertexCount, const uint32_t* indices, size_t indexCount, GLenum primitive, size_t vertexCapacity,
+        size_t indexCapacity)
+{
+    vertexCapacity = std::max(vertexCapacity, vertexCount);
+    indexCapacity = std::max(indexCapacity, indexCount);
+    PulledMesh mesh;
+    mesh.primitive = primitive;
+    mesh.firstVertexWord = (mVertexWordsUsed + kMeshAlignmentWords - 1) / kMeshAlignmentWords * kMeshAlignmentWords;
+    mesh.strideWords = vertexStride / sizeof(GLuint);
+    mesh.vertexCapacity = vertexCapacity;
+    mesh.firstIndex = mIndicesUsed;
+    mesh.indexCapacity = indexCapacity;
+    mesh.indexCount = 0;
+    if(vertexStride == 0 || vertexStride % sizeof(GLuint) != 0
+       || (primitive != GL_TRIANGLES && primitive != GL_TRIANGLE_STRIP))
+    {
+        std::cerr << "vertex pulling needs GL_TRIANGLES or GL_TRIANGLE_STRIP meshes with 4 byte aligned vertices"
+        << std::endl;
+        return SIZE_MAX;
+    }
+    if(mMeshes.size() == mMeshCapacity || mesh.firstVertexWord + mesh.strideWords * vertexCapacity > mVertexWordCapacity
+       || mesh.firstIndex + indexCapacity > mIndexCapacity)
+    {
+        std::cerr << "vertex pulling buffers are full; mesh of " << vertexCapacity << " vertices and " << indexCapacity
+        << " indices not added" << std::endl;
+        return SIZE_MAX;
+    }
+    mVertexWordsUsed = mesh.firstVertexWord + mesh.strideWords * vertexCapacity;
+    mIndicesUsed = mesh.firstIndex + indexCapacity;
+
+    size_t handle = mMeshes.size();
+    mMeshes.push_back(mesh);
+    PulledMeshRecord record{static_cast<GLuint>(mesh.firstVertexWord), static_cast<GLuint>(mesh.strideWords),
+                            static_cast<GLuint>(format), 0};
+    updateBuffer(mRecordBuffer, static_cast<GLintptr>(sizeof(PulledMeshRecord) * handle), sizeof(PulledMeshRecord),
+            &record);
+    if(vertexCount > 0)
+    {
+        updateVertices(handle, 0, vertices, vertexCount);
+    }
+    updateIndices(handle, indices, indexCount);
+    return handle;
+}
+
+void VertexPullingBuffers::updateVertices(size_t mesh, size_t firstVertex, const void* vertices, size_t vertexCount)
+{
+    const PulledMesh& pulledMesh = mMeshes[mesh];
+    vertexCount = std::min(vertexCount, pulledMesh.vertexCapacity - std::min(firstVertex, pulledMesh.vertexCapacity));
+    if(vertexCount == 0)
+    {
+        return;
+    }
+    size_t firstWord = pulledMesh.firstVertexWord + pulledMesh.strideWords * firstVertex;
+    updateBuffer(mVertexBuffer, static_cast<GLintptr>(sizeof(GLuint) * firstWord),
+            static_cast<GLsizeiptr>(sizeof(GLuint) * pulledMesh.strideWords * vertexCount), vertices);
+}
+
+void VertexPullingBuffers::updateIndices(size_t mesh, const uint32_t* indices, size_t indexCount)
+{
+    PulledMesh& pulledMesh = mMeshes[mesh];
+    pulledMesh.indexCount = std::min(indexCount, pulledMesh.indexCapacity);
+    if(pulledMesh.indexCount > 0)
+    {
+        updateBuffer(mIndexBuffer, static_cast<GLintptr>(sizeof(uint32_t) * pulledMesh.firstIndex),
+                static_cast<GLsizeiptr>(sizeof(uint32_t) * pulledMesh.indexCount), indices);
+    }
+}
+
+void VertexPullingBuffers::queueDraw(size_t mesh)
+{
+    const PulledMesh& pulledMesh = mMeshes[mesh];
+    std::vector<DrawElementsIndirectCommand>& queue =
+            pulledMesh.primitive == GL_TRIANGLES ? mQueuedTriangles : mQueuedStrips;
+    if(pulledMesh.indexCount == 0 || queue.size() == mMeshCapacity)
+    {
+        return;
+    }
+    // indices are relative to the mesh's own vertices, and baseInstance tells the shader which mesh it's drawing
+    queue.push_back(DrawElementsIndirectCommand{static_cast<GLuint>(pulledMesh.indexCount), 1,
+                                                static_cast<GLuint>(pulledMesh.firstIndex), 0, static_cast<GLuint>(mesh)});
+}
+
+void VertexPullingBuffers::drawQueued()
+{
+    if(mQueuedTriangles.empty() && mQueuedStrips.empty())
+    {
+        return;
+    }
+    glBindVertexArray(mVAO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kVertexWordBinding, mVertexBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kMeshRecordBinding, mRecordBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mIndirectBuffer);
+    const std::pair<GLenum, std::vector<DrawElementsIndirectCommand>*> queues[] = {
+            {GL_TRIANGLES, &mQueuedTriangles},
+            {GL_TRIANGLE_STRIP, &mQueuedStrips}
+    };
+    for(size_t queueIdx = 0; queueIdx < 2; queueIdx++)
+    {
+        std::vector<DrawElementsIndirectCommand>& queue = *queues[queueIdx].second;
+        if(queue.empty())
+        {
+            continue;
+        }
+        size_t offset = sizeof(DrawElementsIndirectCommand) * mMeshCapacity * queueIdx;
+        updateBuffer(mIndirectBuffer, static_cast<GLintptr>(offset),
+                static_cast<GLsizeiptr>(sizeof(DrawElementsIndirectCommand) * queue.size()), queue.data());
+        glMultiDrawElementsIndirect(queues[queueIdx].first, GL_UNSIGNED_INT, reinterpret_cast<const void*>(offset),
+                static_cast<GLsizei>(queue.size()), 0);
+        queue.clear();
+    }
+}
+
+unsigned int VertexPullingBuffers::getVAO() const
+{
+    return mVAO;
+}
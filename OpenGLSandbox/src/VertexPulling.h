@@ -0,0 +1,148 @@
+#ifndef OPENGLSANDBOX_VERTEXPULLING_H
+#define OPENGLSANDBOX_VERTEXPULLING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+#include "GLResources.h"
+#include "MeshOptimization.h"
+
+/*
+ * Programmable vertex pulling: instead of a VAO per vertex format describing where attributes come from,
+ * every mesh's vertices live in one shared SSBO of 32 bit words and pulled_render.vert decodes them itself,
+ * from gl_VertexID and a per-mesh PulledMeshRecord it finds through gl_BaseInstance.  Meshes of different
+ * vertex formats (PositionVertex tables, half float trail vertices, interleaved MeshVertex) therefore all draw
+ * with one bound VAO, which has no attributes and only the shared 32 bit index buffer attached, and
+ * everything queued in a frame goes out as one glMultiDrawElementsIndirect() per primitive type rather than
+ * a VAO bind and draw per mesh.
+ *
+ * Indices are widened to 32 bits on the way in, with strips' narrower restart values becoming
+ * kPrimitiveRestartIndex, so they keep working under GL_PRIMITIVE_RESTART_FIXED_INDEX.  Meshes can reserve
+ * room to grow, for geometry such as ribbon trails that's rewritten as it changes.
+ */
+
+/**
+ * How pulled_render.vert decodes a vertex's position from its first words; must match the shader
+ */
+enum class PulledVertexFormat : GLuint
+{
+    /**
+     * Three floats, e.g. PositionVertex or MeshVertex
+     */
+    float3Position = 0,
+    /**
+     * Four half floats, e.g. PackedPositionVertex
+     */
+    half4Position = 1
+};
+
+/**
+ * Where a mesh's vertices are in the shared vertex buffer, laid out as the shader's std430 MeshRecord
+ */
+struct PulledMeshRecord
+{
+    GLuint firstWord;
+    GLuint strideWords;
+    GLuint format;
+    GLuint padding;
+};
+
+class VertexPullingBuffers
+{
+private:
+    /**
+     * Per-mesh bookkeeping, beside the PulledMeshRecord the shader sees
+     */
+    struct PulledMesh
+    {
+        GLenum primitive;
+        size_t firstVertexWord;
+        size_t strideWords;
+        size_t vertexCapacity;
+        size_t firstIndex;
+        size_t indexCapacity;
+        size_t indexCount;
+    };
+    unsigned int mVAO = 0;
+    unsigned int mVertexBuffer = 0;
+    unsigned int mIndexBuffer = 0;
+    unsigned int mRecordBuffer = 0;
+    unsigned int mIndirectBuffer = 0;
+    size_t mVertexWordCapacity;
+    size_t mIndexCapacity;
+    size_t mMeshCapacity;
+    size_t mVertexWordsUsed = 0;
+    size_t mIndicesUsed = 0;
+    std::vector<PulledMesh> mMeshes;
+    /**
+     * Draws queued since the last drawQueued(), per primitive
+     */
+    std::vector<DrawElementsIndirectCommand> mQueuedTriangles;
+    std::vector<DrawElementsIndirectCommand> mQueuedStrips;
+public:
+    /**
+     * Creates the shared buffers and the empty VAO.  Must be called on the thread owning the current GL context
+     * @param maxVertexBytes room for every mesh's vertices, each rounded up to 16 bytes
+     * @param maxIndices room for every mesh's indices
+     * @param maxMeshes the most meshes addMesh() will be given
+     */
+    VertexPullingBuffers(size_t maxVertexBytes, size_t maxIndices, size_t maxMeshes);
+    ~VertexPullingBuffers();
+    VertexPullingBuffers(const VertexPullingBuffers&) = delete;
+    VertexPullingBuffers& operator=(const VertexPullingBuffers&) = delete;
+    /**
+     * Adds a mesh, uploading whatever vertices and indices it starts with
+     * @param vertexStride bytes per vertex, a multiple of 4
+     * @param primitive GL_TRIANGLES or GL_TRIANGLE_STRIP
+     * @param vertexCapacity vertices to reserve room for, at least vertexCount, so updateVertices() can grow it
+     * @param indexCapacity likewise for updateIndices()
+     * @return the mesh's handle, or SIZE_MAX if it doesn't fit (see std::cerr)
+     */
+    size_t addMesh(PulledVertexFormat format, size_t vertexStride, const void* vertices, size_t vertexCount,
+            const uint32_t* indices, size_t indexCount, GLenum primitive, size_t vertexCapacity = 0,
+            size_t indexCapacity = 0);
+    /**
+     * addMesh() for 8 or 16 bit indices, which are widened.  A strip's all-ones indices are restarts and become
+     * kPrimitiveRestartIndex; a list's are left as vertices, though MeshIndexType never gives them that value
+     */
+    template<typename IndexType>
+    size_t addMesh(PulledVertexFormat format, size_t vertexStride, const void* vertices, size_t vertexCount,
+            const IndexType* indices, size_t indexCount, GLenum primitive)
+    {
+        std::vector<uint32_t> wideIndices(indices, indices + indexCount);
+        if(primitive == GL_TRIANGLE_STRIP)
+        {
+            for(uint32_t& index : wideIndices)
+            {
+                index = index == static_cast<IndexType>(~IndexType(0)) ? kPrimitiveRestartIndex : index;
+            }
+        }
+        return addMesh(format, vertexStride, vertices, vertexCount, wideIndices.data(), indexCount, primitive);
+    }
+    /**
+     * Overwrites some of a mesh's vertices; firstVertex + vertexCount may not exceed its vertex capacity
+     */
+    void updateVertices(size_t mesh, size_t firstVertex, const void* vertices, size_t vertexCount);
+    /**
+     * Replaces a mesh's indices, and so how much of it is drawn; at most its index capacity are kept
+     */
+    void updateIndices(size_t mesh, const uint32_t* indices, size_t indexCount);
+    /**
+     * Queues a mesh to be drawn by the next drawQueued(); meshes with no indices are skipped
+     */
+    void queueDraw(size_t mesh);
+    /**
+     * Draws every queued mesh, one glMultiDrawElementsIndirect() per primitive type, and empties the queue.
+     * The bound program must be linked from pulled_render.vert or share its interface.  Leaves the empty VAO,
+     * the indirect buffer and the SSBO bindings bound
+     */
+    void drawQueued();
+    /**
+     * @return the attribute-less VAO, with only the shared index buffer attached, that every mesh draws with
+     */
+    unsigned int getVAO() const;
+};
+
+
+#endif //OPENGLSANDBOX_VERTEXPULLING_H
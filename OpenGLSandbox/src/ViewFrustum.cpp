@@ -0,0 +1,31 @@
+#include "ViewFrustum.h"
+
+ViewFrustum extractViewFrustum(const glm::mat4& viewProjection)
+{
+    // glm is column-major, so the matrix's rows are gathered across its columns
+    glm::mat4 rows = glm::transpose(viewProjection);
+    ViewFrustum frustum;
+    frustum.planes[0] = rows[3] + rows[0];
+    frustum.planes[1] = rows[3] - rows[0];
+    frustum.planes[2] = rows[3] + rows[1];
+    frustum.planes[3] = rows[3] - rows[1];
+    frustum.planes[4] = rows[3] + rows[2];
+    frustum.planes[5] = rows[3] - rows[2];
+    for(glm::vec4& plane : frustum.planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return frustum;
+}
+
+bool sphereInFrustum(const ViewFrustum& frustum, const glm::vec3& center, float radius)
+{
+    for(const glm::vec4& plane : frustum.planes)
+    {
+        if(glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef OPENGLSANDBOX_VIEWFRUSTUM_H
+#define OPENGLSANDBOX_VIEWFRUSTUM_H
+
+#include <glm/glm.hpp>
+
+/*
+ * The six clip planes of a view-projection matrix, for testing bounding volumes before they're drawn.
+ * Extracting them from projection * view * model rather than projection * view gives the planes in the
+ * model's own space, so a mesh's bounds can be tested without transforming them first.
+ */
+
+struct ViewFrustum
+{
+    /**
+     * Left, right, bottom, top, near, far; xyz is a unit normal pointing into the frustum and w the offset, so
+     * dot(xyz, p) + w is a point's signed distance from the plane
+     */
+    glm::vec4 planes[6];
+};
+
+/**
+ * Extracts the planes of the clip volume -w <= x, y, z <= w (Gribb and Hartmann)
+ */
+ViewFrustum extractViewFrustum(const glm::mat4& viewProjection);
+
+/**
+ * @return false if the sphere lies entirely outside one of the planes; true can still mean it's outside the
+ *         frustum, near its corners
+ */
+bool sphereInFrustum(const ViewFrustum& frustum, const glm::vec3& center, float radius);
+
+
+#endif //OPENGLSANDBOX_VIEWFRUSTUM_H
@@ -1,6 +1,27 @@
 #include <iostream>
 #include "glad/glad.h"
 #include "RibbonTrail.h"
+#include "TrailEmitter.h"
+#include "RibbonTrailFeedbackCache.h"
+#include "OcclusionCuller.h"
+#include "GpuStatistics.h"
+#include "VertexLayout.h"
+#include "BuiltinMeshes.h"
+#include "VertexPacking.h"
+#include "SpatialHashGrid.h"
+#include "InputTransform.h"
+#include "TextureStreamer.h"
+#include "ProceduralTexture.h"
+#include "ThreadPool.h"
+#include "BackgroundLoader.h"
+#include "RibbonTrailUploader.h"
+#include "VertexPulling.h"
+#include "MeshClusters.h"
+#include "GpuFrustumCuller.h"
+#include "MeshOptimization.h"
+#include "ViewFrustum.h"
+#include "QuaternionBatch.h"
+#include "EasingTables.h"
 #include <GLFW/glfw3.h>
 #include <sstream>
 #include <fstream>
@@ -8,12 +29,17 @@
 #include <functional>
 #include <thread>
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <random>
+#include <cmath>
+#include <memory>
+#include <algorithm>
 
 enum ShaderType
 {
     vertex,
-    fragment
+    fragment,
+    compute
 };
 
 /**
@@ -51,6 +77,105 @@ glm::vec2 g_clickBuffer[] = {glm::vec2(0.0F), glm::vec2(0.0F)};
  */
 unsigned int g_numClickPoints = 0;
 
+/**
+ * Maps cursor positions to framebuffer pixels and device coords, kept current by the resize callbacks
+ */
+InputTransform g_inputTransform;
+
+/**
+ * When true the ribbon trail is rendered from a RibbonTrailFeedbackCache, so only newly added
+ * head pairs go through ribbontrail_process.vert each frame; when false we fall back to
+ * regenerating the whole trail VAO whenever it changes
+ */
+bool g_useRibbonFeedbackCache = true;
+
+/**
+ * When true the ribbon trail and the built-in ribbon demo mesh are drawn by pulled_render.vert fetching their
+ * vertices out of VertexPullingBuffers, with one attribute-less VAO for both vertex formats and one multi-draw
+ * for both meshes; takes precedence over g_useRibbonFeedbackCache.  Toggled at runtime with the V key
+ */
+bool g_useVertexPulling = false;
+/**
+ * Cleared at startup if either of those meshes didn't fit in the vertex pulling buffers, in which case
+ * g_useVertexPulling can't be switched on
+ */
+bool g_canUseVertexPulling = true;
+/**
+ * Room in the vertex pulling buffers, enough for the built-in meshes and the ribbon trail
+ */
+const size_t g_pulledVertexBytes = 1024 * 1024;
+const size_t g_pulledIndexCount = 256 * 1024;
+const size_t g_pulledMeshCount = 64;
+
+/**
+ * When true a dense grid hanging off the bottom left corner of the screen is split into clusters at startup
+ * and drawn every frame from only the clusters cullMeshClusters() keeps, most of it being off-screen
+ */
+bool g_drawClusteredGrid = true;
+/**
+ * Quads across and down the clustered grid, and the device coords it spans
+ */
+const size_t g_clusteredGridQuads = 256;
+const glm::vec2 g_clusteredGridMin(-1.5F, -1.5F);
+const glm::vec2 g_clusteredGridMax(-0.5F, -0.5F);
+/**
+ * Where the clusters' cone test puts the camera.  Everything is drawn in device coords, where GL's
+ * counter-clockwise front faces are the ones facing +z, so the camera sits far out along +z, like an
+ * orthographic one
+ */
+const glm::vec3 g_clusterCameraPosition(0.0F, 0.0F, 1.0e4F);
+
+/**
+ * When true, frustum_cull.comp is built at startup and made to cull g_frustumCullCheckObjects generated
+ * objects, and the survivors it writes are checked against cullObjectsOnCpu()
+ */
+bool g_checkGpuFrustumCulling = true;
+const size_t g_frustumCullCheckObjects = 16384;
+
+/**
+ * The demo trail emitter is sampled every g_emitterTickMilliseconds, and alternates between moving for
+ * g_emitterMoveSeconds and resting for g_emitterRestSeconds.  After a stall the render loop catches up at
+ * most g_emitterMaxCatchUpTicks ticks and drops the rest of the missed time
+ */
+const unsigned int g_emitterTickMilliseconds = 16;
+const unsigned int g_emitterMaxCatchUpTicks = 8;
+/**
+ * The arrowhead drawn at the emitter, pointing along +x in the emitter's own frame
+ */
+const glm::vec3 g_emitterMarker[] = {
+        glm::vec3(0.06F, 0.0F, 0.0F),
+        glm::vec3(-0.03F, 0.03F, 0.0F),
+        glm::vec3(-0.03F, -0.03F, 0.0F)
+};
+const double g_emitterMoveSeconds = 4.0;
+const double g_emitterRestSeconds = 2.0;
+
+/**
+ * The easing curve the ribbon trail fades out along, from fully opaque at its head to gone at its tail
+ */
+const EasingCurve g_trailFadeCurve = EasingCurve::sineIn;
+
+/**
+ * Cell size of the spatial hash over the trail's segments, and how far from a click, in device coords, we
+ * look for a segment to pick
+ */
+const float g_trailGridCellSize = 0.1F;
+const float g_pickRadius = 0.05F;
+
+/**
+ * Size of the texture streamer's staging ring, the most it uploads per frame, and the size of the
+ * procedural ribbon texture generated and streamed through it at startup
+ */
+const size_t g_textureStagingRingSize = 4 * 1024 * 1024;
+const size_t g_textureFrameBudget = 512 * 1024;
+const GLsizei g_ribbonTextureSize = 1024;
+
+/**
+ * Seconds between frame reports, i.e. printouts of the occlusion culler's skipped draw statistics
+ * and the GPU's pipeline statistics and memory usage
+ */
+const double g_frameReportInterval = 5.0;
+
 /**
  * Starts the thread managing progression of elements we'll draw from the active EBO,
  * updating the number of elements every interval ms
@@ -84,17 +209,55 @@ void stop_animation()
  * @param width new width dimen value
  * @param height new height dimen value
  */
-void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+void framebuffer_size_callback(GLFWwindow* /*window*/, int width, int height)
 {
     glViewport(0, 0, width, height);
+    g_inputTransform.setFramebufferSize(width, height);
+    g_inputTransform.setViewport(0, 0, width, height);
+}
+
+/**
+ * Callback function for window resize events in screen coordinates, which on HiDPI displays differ
+ * from the framebuffer's pixel dimensions
+ * @param window the GLFW window object that has been resized
+ * @param width new width in screen coordinates
+ * @param height new height in screen coordinates
+ */
+void window_size_callback(GLFWwindow* /*window*/, int width, int height)
+{
+    g_inputTransform.setWindowSize(width, height);
+}
+
+/**
+ * Callback for key events, which unlike the polling in processInput() sees every press exactly once, so
+ * toggles live here: V switches the trail between vertex pulling and its usual vertex arrays
+ * @param window the GLFW window receiving input
+ * @param key the GLFW key code
+ * @param scancode the platform specific scancode
+ * @param action GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+ * @param mods held modifier keys
+ */
+void key_callback(GLFWwindow* /*window*/, int key, int /*scancode*/, int action, int /*mods*/)
+{
+    if(key == GLFW_KEY_V && action == GLFW_PRESS)
+    {
+        if(!g_canUseVertexPulling)
+        {
+            std::cout << "vertex pulling is unavailable, still drawing with vertex arrays" << std::endl;
+            return;
+        }
+        g_useVertexPulling = !g_useVertexPulling;
+        std::cout << "drawing with " << (g_useVertexPulling ? "vertex pulling" : "vertex arrays") << std::endl;
+    }
 }
 
 /**
  * Callback handler for user input
  * @param window GLFW window receiving input
  * @param ribbonTrail the current ribbon trail object, if any
+ * @param trailGrid spatial hash over the ribbon trail's segments, for picking the one clicked on
  */
-void processInput(GLFWwindow *window, RibbonTrail& ribbonTrail)
+void processInput(GLFWwindow *window, RibbonTrail& ribbonTrail, const SpatialHashGrid& trailGrid)
 {
     if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
     {
@@ -110,22 +273,22 @@ void processInput(GLFWwindow *window, RibbonTrail& ribbonTrail)
             double xpos, ypos;
             glfwGetCursorPos(window, &xpos, &ypos);
             std::cout << "click at " << xpos << "," << ypos << std::endl;
-            int width, height;
-            glfwGetWindowSize(window, &width, &height);
-            std::cout << "window size is " << width << "x" << height << std::endl;
-            float xPercMag = xpos / static_cast<float>(width);
-            float yPercMag = ypos / static_cast<float>(height);
-            std::cout << "therefore x,y magnitude factors are " << xPercMag << "," << yPercMag << std::endl;
+            glm::vec2 framebufferPos = g_inputTransform.windowToFramebuffer(glm::dvec2(xpos, ypos));
+            std::cout << "framebuffer pixel is " << framebufferPos.x << "," << framebufferPos.y << std::endl;
 
             // convert screen coordinate click location to OpenGL device coords
-            float xDeviceCoord = 0.0F;
-            float yDeviceCoord = 0.0F;
-            float halfMagX = 0.5F * static_cast<float>(width);
-            float halfMagY = 0.5F * static_cast<float>(height);
-            xDeviceCoord = (xpos - halfMagX)/halfMagX;
-            yDeviceCoord = 1.0F - (ypos/halfMagY);
+            glm::vec2 deviceCoords = g_inputTransform.windowToDevice(glm::dvec2(xpos, ypos));
+            float xDeviceCoord = deviceCoords.x;
+            float yDeviceCoord = deviceCoords.y;
             std::cout << "device coords are " << xDeviceCoord << "," << yDeviceCoord << std::endl;
 
+            // pick the trail segment under the click, if any; the trail lies in the z = 1 plane
+            uint32_t pickedSegment = trailGrid.findNearest(glm::vec3(xDeviceCoord, yDeviceCoord, 1.0F), g_pickRadius);
+            if(pickedSegment != SpatialHashGrid::kNoEntry)
+            {
+                std::cout << "picked ribbon segment " << pickedSegment << " of " << trailGrid.getEntryCount() << std::endl;
+            }
+
             // check for completed vert pair from clicks
             if(g_numClickPoints >= 2)
             {
@@ -199,6 +362,10 @@ unsigned int loadShader(const std::string& shaderName, ShaderType shaderType)
         {
             shaderId = glCreateShader(GL_FRAGMENT_SHADER);
         }
+        else if (shaderType == ShaderType::compute)
+        {
+            shaderId = glCreateShader(GL_COMPUTE_SHADER);
+        }
         const char *shaderSourceCString = shaderSource.c_str();
         glShaderSource(shaderId, 1, &shaderSourceCString, nullptr);
         glCompileShader(shaderId);
@@ -274,314 +441,202 @@ unsigned int loadShaders(const std::string& programName)
 }
 
 /**
- * Performs the OpenGL Dance necessary to summon a vertex array object
- * describing usage of a vertex buffer object which in turn holds vertex data
- * for a simple tightly packed single triangle.
- * @return the ID of the vertex array object that can be bound at a later time for rendering use
+ * Creates a vertex-only shader program for transform feedback capture, e.g. ribbontrail_process
+ * loads ribbontrail_process.vert and captures the named varyings interleaved into a single buffer.
+ * @param programName the base of the vertex shader filename
+ * @param varyings names of the vertex shader outputs to capture, in buffer order
+ * @return non-zero shader program ID if the vertex shader loaded/compiled successfully
+ * and the program linked successfully, else 0
  */
-unsigned int generateBasicTriangleVAO()
+unsigned int loadTransformFeedbackShader(const std::string& programName, const std::vector<const char*>& varyings)
 {
-    // Config Step 1: create vertex array object to track our config
-    unsigned int VAO;
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-
-    // Config Step 2: define and buffer data
-    // raw tri data, using device coords directly
-    float vertices[] = {
-            -0.5f, -0.5f, 0.0f,
-            0.5f, -0.5f, 0.0f,
-            0.0f,  0.5f, 0.0f
-    };
-
-    // generate a vertex buffer object to manage our vertices in GPU memory
-    unsigned int VBO;
-    glGenBuffers(1, &VBO);
-
-    // bind our manager VBO to the appropriate type of GPU buffer,
-    // which for vertex buffer is GL_ARRAY_BUFFER
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-    // upload vertex data to the GPU memory buffer we're working with,
-    // specifying its size in bytes, the data itself as float array, and
-    // finally a constant indicating how often we expect drawable data to change;
-    // since we're rendering a static triangle for now, static is fine.
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    // Config Step 3: configure vertex attribute pointers to tell OpenGL how to interpret buffered data
-    // 0 is the location we specified for our aPos attribute in basic_render.vert
-    /*
-     * Note: Here's how the bridge between our VBO and our vertex attribute aPos works
-     * "
-     * Each vertex attribute takes its data from memory
-     * managed by a VBO and which VBO it takes its data from
-     * (you can have multiple VBOs) is determined by the VBO
-     * currently bound to GL_ARRAY_BUFFER when calling
-     * glVertexAttribPointer. Since the previously defined
-     * VBO is still bound before calling glVertexAttribPointer
-     * vertex attribute 0 is now associated with its vertex data.
-     * "
-     */
-    glVertexAttribPointer(
-            0,
-            3,
-            GL_FLOAT,
-            GL_FALSE,
-            3 * sizeof(float),
-            (void*)nullptr
-    );
-    glEnableVertexAttribArray(0);
-    /*
-     // note that this is allowed, the call to glVertexAttribPointer registered VBO as the vertex attribute's bound vertex buffer object so afterwards we can safely unbind
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    // You can unbind the VAO afterwards so other VAO calls won't accidentally modify this VAO, but this rarely happens. Modifying other
-    // VAOs requires a call to glBindVertexArray anyways so we generally don't unbind VAOs (nor VBOs) when it's not directly necessary.
-    // If we unbound here, we would need to rebind in render loop before trying to use this VAO.
-    glBindVertexArray(0);
+    unsigned int vertexShaderId = loadShader(programName+".vert", ShaderType::vertex);
+    if(!vertexShaderId)
+    {
+        std::cerr << "error occurred compiling " << programName << ".vert and we cannot proceed" << std::endl;
+        return 0;
+    }
+    unsigned int shaderProgramId = glCreateProgram();
+    glAttachShader(shaderProgramId, vertexShaderId);
+    // varyings must be declared before linking, they determine the program's capture layout
+    glTransformFeedbackVaryings(shaderProgramId, varyings.size(), varyings.data(), GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(shaderProgramId);
+    glDeleteShader(vertexShaderId);
 
+    // check link success status
+    int linkSuccessStatus;
+    char infoLog[512];
+    glGetProgramiv(shaderProgramId, GL_LINK_STATUS, &linkSuccessStatus);
+    if(!linkSuccessStatus) {
+        glGetProgramInfoLog(shaderProgramId, 512, nullptr, infoLog);
+        std::cerr << "error linking " << programName << ":\n" << infoLog << std::endl;
+        return 0;
+    }
 
-    // uncomment this call to draw in wireframe polygons.
-    //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-     */
-    return VAO;
+    return shaderProgramId;
 }
 
 /**
- * Performs the OpenGL Dance necessary to summon a vertex array object
- * describing usage of an element buffer object which in turn holds vertex data
- * for two simple tightly packed triangles.
- * @return the ID of the vertex array object that can be bound at a later time for rendering use
+ * Creates a compute-only shader program, e.g. frustum_cull loads frustum_cull.comp
+ * @param programName the base of the compute shader filename
+ * @return non-zero shader program ID if the compute shader loaded/compiled successfully
+ * and the program linked successfully, else 0
  */
-unsigned int generateUniqueVertsRectangleVAO()
+unsigned int loadComputeShader(const std::string& programName)
 {
-    // Config Step 1: create vertex array object to track our config
-    unsigned int VAO;
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-
-    // Config Step 2: define and buffer data
-    // raw rect data, using device coords directly;
-    // these are only the unique vertices of the two triangles!
-    float vertices[] = {
-        0.5f,  0.5f, 0.0f,  // top right
-        0.5f, -0.5f, 0.0f,  // bottom right
-        -0.5f, -0.5f, 0.0f,  // bottom left
-        -0.5f,  0.5f, 0.0f   // top left
-    };
-    unsigned int indices[] = {
-        0, 1, 3, // first triangle, upper-right half
-        1, 2, 3  // second triangle, lower-left half
-    };
+    unsigned int computeShaderId = loadShader(programName+".comp", ShaderType::compute);
+    if(!computeShaderId)
+    {
+        std::cerr << "error occurred compiling " << programName << ".comp and we cannot proceed" << std::endl;
+        return 0;
+    }
+    unsigned int shaderProgramId = glCreateProgram();
+    glAttachShader(shaderProgramId, computeShaderId);
+    glLinkProgram(shaderProgramId);
+    glDeleteShader(computeShaderId);
 
-    /// EBO, deals with indices above ///
-    // generate an element buffer object to manage our unique vertices in GPU memory
-    unsigned int EBO;
-    glGenBuffers(1, &EBO);
-
-    // bind our manager EBO to the appropriate type of GPU buffer,
-    // which for element buffer is GL_ELEMENT_ARRAY_BUFFER
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-
-    // upload vertex data to the GPU memory buffer we're working with,
-    // specifying its size in bytes, the data itself as float array, and
-    // finally a constant indicating how often we expect drawable data to change;
-    // since we're rendering a static triangle for now, static is fine.
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    /// VBO, deals with vertices defined above ///
-    // generate a vertex buffer object to manage our vertices in GPU memory
-    unsigned int VBO;
-    glGenBuffers(1, &VBO);
-
-    // bind our manager VBO to the appropriate type of GPU buffer,
-    // which for vertex buffer is GL_ARRAY_BUFFER
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-    // upload vertex data to the GPU memory buffer we're working with,
-    // specifying its size in bytes, the data itself as float array, and
-    // finally a constant indicating how often we expect drawable data to change;
-    // since we're rendering a static triangle for now, static is fine.
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    // Config Step 3: configure vertex attribute pointers to tell OpenGL how to interpret buffered data
-    // 0 is the location we specified for our aPos attribute in basic_render.vert
-    glVertexAttribPointer(
-            0,
-            3,
-            GL_FLOAT,
-            GL_FALSE,
-            3 * sizeof(float),
-            (void*)nullptr
-    );
-    glEnableVertexAttribArray(0);
+    // check link success status
+    int linkSuccessStatus;
+    char infoLog[512];
+    glGetProgramiv(shaderProgramId, GL_LINK_STATUS, &linkSuccessStatus);
+    if(!linkSuccessStatus) {
+        glGetProgramInfoLog(shaderProgramId, 512, nullptr, infoLog);
+        std::cerr << "error linking " << programName << ":\n" << infoLog << std::endl;
+        return 0;
+    }
 
-    return VAO;
+    return shaderProgramId;
 }
 
 /**
- * Performs the OpenGL Dance necessary to summon a vertex array object
- * describing usage of an element buffer object which in turn holds vertex data
- * for a triforce in GL_TRIANGLES primitive mode and a triforce-ish thing
- * in GL_TRIANGLE_STRIP primitive mode.
- * @return the ID of the vertex array object that can be bound at a later time for rendering use
+ * Generates the clustered grid: columns x rows quads in the z = 0.5 plane between boundsMin and boundsMax,
+ * wound to face the viewer, as a triangle list reordered for the vertex cache so its clusters come out compact
+ * @param vertices replaced with the grid's vertices
+ * @param indices replaced with three indices per triangle
  */
-unsigned int generateTriStripForceVAO()
+void makeClusteredGrid(size_t columns, size_t rows, glm::vec2 boundsMin, glm::vec2 boundsMax,
+        std::vector<PositionVertex>& vertices, std::vector<uint32_t>& indices)
 {
-    // Config Step 1: create vertex array object to track our config
-    unsigned int VAO;
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-
-    // Config Step 2: define and buffer data
-    // raw rect data, using device coords directly;
-    // these are only the unique vertices of the two triangles!
-    float vertices[] = {
-            0, -1, 1,   // P0: bottom right of first tri and bottom left of third tri
-            -0.5, 0, 1, // P1: top of first tri and bottom left of second tri
-            -1, -1, 1,  // P2: bottom left of first tri
-            0.5, 0, 1,  // P3: bottom right of second tri and top of third tri
-            0, 1, 1,    // P4: top of second tri
-            1, -1, 1    // P5: bottom right of third tri
-    };
-    unsigned int indices[] = {
-            0, 1, 2,
-            3, 4, 1,
-            5, 3, 0
-    };
+    vertices.clear();
+    indices.clear();
+    for(size_t row = 0; row <= rows; row++)
+    {
+        for(size_t column = 0; column <= columns; column++)
+        {
+            glm::vec2 fraction(static_cast<float>(column) / columns, static_cast<float>(row) / rows);
+            vertices.push_back(PositionVertex{glm::vec3(glm::mix(boundsMin, boundsMax, fraction), 0.5F)});
+        }
+    }
+    for(size_t row = 0; row < rows; row++)
+    {
+        for(size_t column = 0; column < columns; column++)
+        {
+            uint32_t bottomLeft = static_cast<uint32_t>(row * (columns + 1) + column);
+            uint32_t topLeft = bottomLeft + static_cast<uint32_t>(columns + 1);
+            uint32_t quad[] = {bottomLeft, bottomLeft + 1, topLeft, bottomLeft + 1, topLeft + 1, topLeft};
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+    optimizeVertexCache(indices.data(), indices.size(), vertices.size());
+}
 
-    /// EBO, deals with indices above ///
-    // generate an element buffer object to manage our unique vertices in GPU memory
-    unsigned int EBO;
-    glGenBuffers(1, &EBO);
-
-    // bind our manager EBO to the appropriate type of GPU buffer,
-    // which for element buffer is GL_ELEMENT_ARRAY_BUFFER
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-
-    // upload vertex data to the GPU memory buffer we're working with,
-    // specifying its size in bytes, the data itself as float array, and
-    // finally a constant indicating how often we expect drawable data to change;
-    // since we're rendering a static tri-strip for now, static is fine.
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_DYNAMIC_DRAW);
-
-    /// VBO, deals with vertices defined above ///
-    // generate a vertex buffer object to manage our vertices in GPU memory
-    unsigned int VBO;
-    glGenBuffers(1, &VBO);
-
-    // bind our manager VBO to the appropriate type of GPU buffer,
-    // which for vertex buffer is GL_ARRAY_BUFFER
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-    // upload vertex data to the GPU memory buffer we're working with,
-    // specifying its size in bytes, the data itself as float array, and
-    // finally a constant indicating how often we expect drawable data to change;
-    // since we're rendering a static tri-mesh for now, static is fine.
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);//GL_STATIC_DRAW);
-
-    // Config Step 3: configure vertex attribute pointers to tell OpenGL how to interpret buffered data
-    // 0 is the location we specified for our aPos attribute in animated_render.vert
-    glVertexAttribPointer(
-            0,
-            3,
-            GL_FLOAT,
-            GL_FALSE,
-            3 * sizeof(float),
-            (void*)nullptr
-    );
-    glEnableVertexAttribArray(0);
+/**
+ * Culls objects scattered around a camera with frustum_cull.comp, reads the survivors back and compares them,
+ * in object order, with cullObjectsOnCpu()'s; stalls on the readback, so it's only for startup
+ * @return false if the compute program didn't build or the GPU kept a different set of objects
+ */
+bool checkGpuFrustumCulling(size_t objectCount)
+{
+    unsigned int cullProgramId = loadComputeShader("frustum_cull");
+    if(!cullProgramId)
+    {
+        return false;
+    }
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> position(-100.0F, 100.0F);
+    std::uniform_real_distribution<float> radius(0.5F, 2.0F);
+    std::vector<glm::vec4> spheres(objectCount);
+    std::vector<DrawElementsIndirectCommand> commands(objectCount);
+    for(size_t objectIdx = 0; objectIdx < objectCount; objectIdx++)
+    {
+        spheres[objectIdx] = glm::vec4(position(generator), position(generator), position(generator), radius(generator));
+        commands[objectIdx] = DrawElementsIndirectCommand{36, 1, static_cast<GLuint>(objectIdx * 36), 0,
+                                                          static_cast<GLuint>(objectIdx)};
+    }
+    ViewFrustum frustum = extractViewFrustum(glm::perspective(glm::radians(60.0F), 4.0F / 3.0F, 0.1F, 150.0F)
+            * glm::lookAt(glm::vec3(0.0F), glm::vec3(0.0F, 0.0F, -1.0F), glm::vec3(0.0F, 1.0F, 0.0F)));
 
-    return VAO;
+    std::vector<DrawElementsIndirectCommand> gpuVisible;
+    {
+        GpuFrustumCuller culler(cullProgramId, objectCount);
+        culler.setObjects(spheres.data(), commands.data(), objectCount);
+        culler.cull(frustum);
+        culler.readBackVisible(gpuVisible);
+    }
+    glDeleteProgram(cullProgramId);
+    std::vector<DrawElementsIndirectCommand> cpuVisible;
+    cullObjectsOnCpu(frustum, spheres.data(), commands.data(), objectCount, cpuVisible);
+
+    // survivors are appended in whatever order invocations finish, and baseInstance says which object each is
+    std::sort(gpuVisible.begin(), gpuVisible.end(), [](const DrawElementsIndirectCommand& a, const DrawElementsIndirectCommand& b){
+        return a.baseInstance < b.baseInstance;
+    });
+    bool matches = gpuVisible.size() == cpuVisible.size() && std::equal(gpuVisible.begin(), gpuVisible.end(),
+            cpuVisible.begin(), [](const DrawElementsIndirectCommand& a, const DrawElementsIndirectCommand& b){
+                return a.count == b.count && a.instanceCount == b.instanceCount && a.firstIndex == b.firstIndex
+                       && a.baseVertex == b.baseVertex && a.baseInstance == b.baseInstance;
+            });
+    if(!matches)
+    {
+        std::cerr << "frustum_cull kept " << gpuVisible.size() << " of " << objectCount << " objects where the CPU kept "
+        << cpuVisible.size() << ", or kept different ones" << std::endl;
+        return false;
+    }
+    std::cout << "frustum_cull matches the CPU reference: " << gpuVisible.size() << " of " << objectCount
+    << " objects visible" << std::endl;
+    return true;
 }
 
 /**
- * Performs the OpenGL Dance necessary to summon a vertex array object
- * describing usage of an element buffer object which in turn holds vertex data
- * for GL_TRIANGLE_STRIP primitive mode to form a ribbon trail effect.
- * @return the ID of the vertex array object that can be bound at a later time for rendering use
+ * Locations of the uniforms telling ribbontrail_fade.vert, or pulled_render.vert, where the trail's vertex
+ * pairs sit and which easing curve to fade them along
  */
-unsigned int generateRibbonTrailVAO()
+struct TrailFadeUniforms
 {
-    // Config Step 1: create vertex array object to track our config
-    unsigned int VAO;
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-
-    // Config Step 2: define and buffer data
-    // raw rect data, using device coords directly;
-    // these are only the unique vertices of the 6 triangles
-    // making up our three quadrilateral ribbon
-    float vertices[] = {
-        0.75, -0.75, 1.0,
-        0.65, 0.25, 1.0,
-        0.35, 0.65, 1.0,
-        0.45, -0.35, 1.0,
-        -0.25, 0.0, 1.0,
-        -0.35, 1.0, 1.0,
-        -0.95, 0.75, 1.0,
-        -0.85, -0.25, 1.0
-    };
-    unsigned int indices[] = {
-        0, 1,
-        3, 2,
-        4, 5,
-        7, 6
-    };
-
-    // configure animation via draw element count progression
-    g_maxDrawElements = sizeof(indices)/sizeof(indices[0]);
-    g_initDrawElements = 2;
-    g_stepDrawElements = 2;
-    g_numDrawElements = g_initDrawElements;
+    int newestPair = -1;
+    int pairSlots = -1;
+    int pairCount = -1;
+    int fadeCurve = -1;
+};
 
-    // todo: factor out the boilerplate EBO/VBO and common aPos vertex attribute config here into a single function,
-    //  which should take float** and unsigned int** for our verts and indices arrays
-    //  as well as an enum for the desired usage pattern of buffered data (static, dynamic...)
-
-    /// EBO, deals with indices above ///
-    // generate an element buffer object to manage our unique vertices in GPU memory
-    unsigned int EBO;
-    glGenBuffers(1, &EBO);
-
-    // bind our manager EBO to the appropriate type of GPU buffer,
-    // which for element buffer is GL_ELEMENT_ARRAY_BUFFER
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-
-    // upload vertex data to the GPU memory buffer we're working with,
-    // specifying its size in bytes, the data itself as float array, and
-    // finally a constant indicating how often we expect drawable data to change;
-    // since we're rendering a static tri-strip for now, static is fine.
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    /// VBO, deals with vertices defined above ///
-    // generate a vertex buffer object to manage our vertices in GPU memory
-    unsigned int VBO;
-    glGenBuffers(1, &VBO);
-
-    // bind our manager VBO to the appropriate type of GPU buffer,
-    // which for vertex buffer is GL_ARRAY_BUFFER
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-    // upload vertex data to the GPU memory buffer we're working with,
-    // specifying its size in bytes, the data itself as float array, and
-    // finally a constant indicating how often we expect drawable data to change;
-    // since we're rendering a static tri-mesh for now, static is fine.
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    // Config Step 3: configure vertex attribute pointers to tell OpenGL how to interpret buffered data
-    // 0 is the location we specified for our aPos attribute in basic_render.vert
-    glVertexAttribPointer(
-            0,
-            3,
-            GL_FLOAT,
-            GL_FALSE,
-            3 * sizeof(float),
-            (void*)nullptr
-    );
-    glEnableVertexAttribArray(0);
+/**
+ * Looks up the trail fade uniforms of a program
+ * @param programId linked program declaring them
+ * @return their locations, -1 for any the program lacks
+ */
+TrailFadeUniforms lookUpTrailFadeUniforms(unsigned int programId)
+{
+    TrailFadeUniforms uniforms;
+    uniforms.newestPair = glGetUniformLocation(programId, "trailNewestPair");
+    uniforms.pairSlots = glGetUniformLocation(programId, "trailPairSlots");
+    uniforms.pairCount = glGetUniformLocation(programId, "trailPairCount");
+    uniforms.fadeCurve = glGetUniformLocation(programId, "fadeCurve");
+    return uniforms;
+}
 
-    return VAO;
+/**
+ * Sets the trail fade uniforms of the program in use, for a trail whose pair p is vertices 2p and 2p + 1
+ * @param uniforms the program's uniform locations
+ * @param newestPair the pair slot holding the trail's newest pair
+ * @param pairSlots how many pair slots the trail's pairs wrap around in; pairCount for a trail stored oldest first
+ * @param pairCount how many pairs the trail has
+ */
+void setTrailFadeUniforms(const TrailFadeUniforms& uniforms, size_t newestPair, size_t pairSlots, size_t pairCount)
+{
+    glUniform1ui(uniforms.newestPair, static_cast<GLuint>(newestPair));
+    glUniform1ui(uniforms.pairSlots, static_cast<GLuint>(std::max<size_t>(pairSlots, 1)));
+    glUniform1ui(uniforms.pairCount, static_cast<GLuint>(pairCount));
+    glUniform1f(uniforms.fadeCurve, static_cast<float>(g_trailFadeCurve));
 }
 
 /**
@@ -642,56 +697,183 @@ int main()
         return -1;
     }
 
-    // tell OpenGL where to place data for the window and what size its dimensions will be
-    glViewport(0, 0, 800, 600);
+    // tell OpenGL where to place data for the window and what size its dimensions will be; on HiDPI
+    // displays the framebuffer has more pixels than the window has screen coordinates
+    int windowWidth, windowHeight, framebufferWidth, framebufferHeight;
+    glfwGetWindowSize(window, &windowWidth, &windowHeight);
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    glViewport(0, 0, framebufferWidth, framebufferHeight);
+    g_inputTransform.setWindowSize(windowWidth, windowHeight);
+    g_inputTransform.setFramebufferSize(framebufferWidth, framebufferHeight);
+    g_inputTransform.setViewport(0, 0, framebufferWidth, framebufferHeight);
 
     // configure OpenGL
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // stripified meshes separate their strips with the index type's all-ones value
+    glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
 
     // set GLFW callback for window resize events
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetWindowSizeCallback(window, window_size_callback);
+    glfwSetKeyCallback(window, key_callback);
+
+    // start the loader thread uploads and shader compiles are handed to, with a context sharing ours
+    std::unique_ptr<BackgroundLoader> backgroundLoader(new BackgroundLoader(window));
 
     // create our program object and load vertex and fragment shaders into it
     std::string shaderProgramName = "basic_render";
     unsigned int shaderProgramId = loadShaders(shaderProgramName);
     assert(shaderProgramId > 0);
+    // every mesh we draw with it uses PositionVertex, so make sure that's what the program expects
+    if(!validateVertexLayout<PositionVertex>(shaderProgramId, "PositionVertex"))
+    {
+        std::cerr << "vertex layout doesn't match shader program " << shaderProgramName << std::endl;
+        return -1;
+    }
 
-    // generate/configure our VAO
-    /*
-    unsigned int basicTriangleVAO = generateBasicTriangleVAO();
-    */
-    /*
-    unsigned int unqiueVertsRectangleVAO = generateUniqueVertsRectangleVAO();
-    */
-    /*
-    unsigned int tristripforceVAO = generateTriStripForceVAO();
-    */
+    // the ribbon trail gets a program of its own, which fades it out with age by looking g_trailFadeCurve up
+    // in the easing texture; it's drawn from PositionVertex, or PackedPositionVertex once uploaded
+    std::string trailProgramName = "ribbontrail_fade";
+    unsigned int trailProgramId = loadShaders(trailProgramName);
+    assert(trailProgramId > 0);
+    if(!validateVertexLayout<PositionVertex>(trailProgramId, "PositionVertex")
+       || !validateVertexLayout<PackedPositionVertex>(trailProgramId, "PackedPositionVertex"))
+    {
+        std::cerr << "vertex layout doesn't match shader program " << trailProgramName << std::endl;
+        return -1;
+    }
+    TrailFadeUniforms trailFadeUniforms = lookUpTrailFadeUniforms(trailProgramId);
+    unsigned int easingTexture = createEasingTexture();
+
+    // set up the vertex pulling path's program and shared buffers, which everything drawn through it goes into;
+    // always, since g_useVertexPulling can be switched on at any time
+    unsigned int pulledProgramId = loadShaders("pulled_render");
+    assert(pulledProgramId > 0);
+    TrailFadeUniforms pulledFadeUniforms = lookUpTrailFadeUniforms(pulledProgramId);
+    int pulledFadedMeshLocation = glGetUniformLocation(pulledProgramId, "fadedMesh");
+    std::unique_ptr<VertexPullingBuffers> vertexPulling(
+            new VertexPullingBuffers(g_pulledVertexBytes, g_pulledIndexCount, g_pulledMeshCount)
+    );
+
+    // upload the built-in meshes (triangle, rectangle, triforce, ribbon demo, circle, grid, strip)
+    // into their shared immutable buffers; bind builtinMeshes->getVAO() to draw any of them, or queue
+    // builtinMeshes->getPulledMesh() on vertexPulling
+    std::unique_ptr<BuiltinMeshLibrary> builtinMeshes(new BuiltinMeshLibrary(vertexPulling.get()));
     /*
-    unsigned int ribbonTrailVAO = generateRibbonTrailVAO();
+    // configure ribbon demo animation via draw element count progression
+    g_maxDrawElements = builtinMeshes->getRange(BuiltinMesh::ribbonDemo).indexCount;
+    g_initDrawElements = 2;
+    g_stepDrawElements = 2;
+    g_numDrawElements = g_initDrawElements;
     */
 
-    // set of vertices that will comprise the complete ribbon trail for debug;
-    // we'll add a pair of these in order every tick of the animation function
-    float debugRibbonVertices[] = {
-            0.75, -0.75, 1.0,
-            0.65, 0.25, 1.0,
-            0.35, 0.65, 1.0,
-            0.45, -0.35, 1.0,
-            -0.25, 0.0, 1.0,
-            -0.35, 1.0, 1.0,
-            -0.95, 0.75, 1.0,
-            -0.85, -0.25, 1.0,
-            -1.0, -0.5, 1.0,
-            -1.0, 0.5, 1.0,
-            -0.5, 0.9, 1.0,
-            -0.3, -0.9, 1.0
-    };
-    size_t debugVertsProcessed = 0;
+    // set up RibbonTrail, fed by an emitter that adapts emission to its motion
+    RibbonTrail ribbonTrail(64);
+    TrailEmitter trailEmitter;
+    // without the feedback cache, the trail's buffers are uploaded on the loader thread
+    std::unique_ptr<RibbonTrailUploader> ribbonTrailUploader(
+            new RibbonTrailUploader(*backgroundLoader, ribbonTrail.calculateMaxVertexCount())
+    );
+    // rebuilt every frame from the trail's segments for picking and proximity queries
+    SpatialHashGrid trailGrid(g_trailGridCellSize);
+
+    // with vertex pulling, the trail is a mesh of its own in the shared buffers, rewritten whenever it changes
+    size_t pulledTrailMesh = vertexPulling->addMesh(PulledVertexFormat::half4Position, sizeof(PackedPositionVertex),
+            nullptr, 0, nullptr, 0, GL_TRIANGLE_STRIP, ribbonTrail.calculateMaxVertexCount(),
+            ribbonTrail.calculateMaxVertexCount());
+    size_t pulledDemoMesh = builtinMeshes->getPulledMesh(BuiltinMesh::ribbonDemo);
+    // addMesh() has already said why if either didn't fit; the vertex arrays can still draw them both
+    if(pulledTrailMesh == SIZE_MAX || pulledDemoMesh == SIZE_MAX)
+    {
+        g_canUseVertexPulling = false;
+        g_useVertexPulling = false;
+    }
+    std::vector<PackedPositionVertex> pulledTrailStaging;
+    // the trail's pulled copy is only kept up to date while it's drawn, so switching to it refreshes it
+    bool wasUsingVertexPulling = false;
+
+    // set up the transform feedback cache holding the trail's processed vertices
+    unsigned int ribbonProcessProgramId = loadTransformFeedbackShader("ribbontrail_process", {"vProcessedPos"});
+    assert(ribbonProcessProgramId > 0);
+    if(!validateVertexLayout<PositionVertex>(ribbonProcessProgramId, "PositionVertex"))
+    {
+        std::cerr << "vertex layout doesn't match shader program ribbontrail_process" << std::endl;
+        return -1;
+    }
+    std::unique_ptr<RibbonTrailFeedbackCache> ribbonFeedbackCache(
+            new RibbonTrailFeedbackCache(ribbonProcessProgramId, ribbonTrail.calculateMaxVertexCount())
+    );
 
-    // set up RibbonTrail
-    RibbonTrail ribbonTrail(3);
-    unsigned int dynamicRibbonTrailVAO = ribbonTrail.generateRibbonTrailVAO();
+    // set up occlusion culling for the ribbon trail, whose bounds we refresh every frame
+    unsigned int occlusionProxyProgramId = loadShaders("occlusion_proxy");
+    assert(occlusionProxyProgramId > 0);
+    if(!validateVertexLayout<PositionVertex>(occlusionProxyProgramId, "PositionVertex"))
+    {
+        std::cerr << "vertex layout doesn't match shader program occlusion_proxy" << std::endl;
+        return -1;
+    }
+    std::unique_ptr<OcclusionCuller> occlusionCuller(new OcclusionCuller(occlusionProxyProgramId));
+    size_t ribbonOcclusionHandle = occlusionCuller->registerObject(glm::vec3(0.0F), glm::vec3(0.0F));
+
+    // make sure GPU culling keeps exactly what the CPU reference does before anything relies on it
+    if(g_checkGpuFrustumCulling)
+    {
+        checkGpuFrustumCulling(g_frustumCullCheckObjects);
+    }
+
+    // split the clustered grid into clusters, whose regrouped triangles replace the original list in its
+    // index buffer; the view never changes, so neither does the frustum they're culled against
+    IndexedVertexArray clusteredGrid;
+    MeshClusters gridClusters;
+    std::unique_ptr<ClusterDrawBuffer> clusterDrawBuffer;
+    std::vector<DrawElementsIndirectCommand> clusterCommands;
+    ClusterCullStatistics clusterStatistics;
+    const ViewFrustum deviceFrustum = extractViewFrustum(glm::mat4(1.0F));
+    if(g_drawClusteredGrid)
+    {
+        std::vector<PositionVertex> gridVertices;
+        std::vector<uint32_t> gridIndices;
+        makeClusteredGrid(g_clusteredGridQuads, g_clusteredGridQuads, g_clusteredGridMin, g_clusteredGridMax,
+                gridVertices, gridIndices);
+        gridClusters = buildMeshClusters(gridIndices.data(), gridIndices.size(), &gridVertices.data()->position.x,
+                sizeof(PositionVertex), gridVertices.size());
+        clusteredGrid = createIndexedPositionVertexArray(&gridVertices.data()->position.x,
+                static_cast<GLsizeiptr>(sizeof(PositionVertex) * gridVertices.size()), gridClusters.indices.data(),
+                static_cast<GLsizeiptr>(sizeof(uint32_t) * gridClusters.indices.size()), 0);
+        clusterDrawBuffer.reset(new ClusterDrawBuffer(gridClusters.size()));
+        std::cout << "clustered grid: " << gridIndices.size() / 3 << " triangles in " << gridClusters.size()
+        << " clusters" << std::endl;
+    }
+
+    // set up GPU instrumentation, which quietly does nothing on drivers lacking the needed queries
+    std::unique_ptr<GpuStatistics> gpuStatistics(new GpuStatistics());
+    double lastFrameReportTime = glfwGetTime();
+
+    // synthesize the ribbon texture on worker threads and stream it in over the first frames rather than
+    // uploading it all at once; its rows are generated straight into the staging ring as they're needed
+    ThreadPool workerPool;
+    std::unique_ptr<TextureStreamer> textureStreamer(new TextureStreamer(g_textureStagingRingSize, g_textureFrameBudget));
+    TextureDescription ribbonTextureDescription;
+    ribbonTextureDescription.width = g_ribbonTextureSize;
+    ribbonTextureDescription.height = g_ribbonTextureSize;
+    unsigned int ribbonTexture = textureStreamer->requestTexture(ribbonTextureDescription,
+            makeRibbonTextureSource(RibbonTextureParameters(), g_ribbonTextureSize, g_ribbonTextureSize, workerPool));
+    bool ribbonTextureReported = false;
+
+    // animated_render isn't drawn with yet, so there's no reason to hold up startup compiling it
+    unsigned int animatedProgramId = 0;
+    std::string animatedVertexSource, animatedFragmentSource;
+    if(readFile("../assets/shaders/animated_render.vert", animatedVertexSource)
+       && readFile("../assets/shaders/animated_render.frag", animatedFragmentSource))
+    {
+        backgroundLoader->compileProgram("animated_render", animatedVertexSource, animatedFragmentSource,
+                [&animatedProgramId](unsigned int programId){
+                    animatedProgramId = programId;
+                    std::cout << "animated_render " << (programId ? "compiled" : "failed to compile")
+                    << " in the background" << std::endl;
+                });
+    }
 
     /*
     // animated_render shader modifies vert pos and frag color by trig functions over given time
@@ -721,106 +903,266 @@ int main()
     std::random_device randDev;
     srand(randDev());
 
-    // advance the number of elements to draw by g_stepDrawElements (starting at g_initDrawElements)
-    //  until g_maxDrawElements is reached, then reset to g_initDrawElements so we get an
-    //  animated ribbon trail effect
-    start_animation(
-            [&]{
-                /*
-                if(ribbonTrail.getVertexCount() >= ribbonTrail.calculateMaxVertexCount())
-                {
-                    // reset
-                    ribbonTrail.resetRibbon();
-                }
-                */
-
-                // offset in the raw float array of our effective cursor into the
-                // vertex pairs therein
-                size_t currentVertexIdxOffset = debugVertsProcessed * 3;//ribbonTrail.getVertexCount() * 3;
-                size_t numDebugVertFloats = sizeof(debugRibbonVertices)/sizeof(debugRibbonVertices[0]);
-                if(currentVertexIdxOffset >= numDebugVertFloats)
-                {
-                    // reset debug vert traversal
-                    currentVertexIdxOffset = 0;
-                    debugVertsProcessed = 0;
-                }
+    // move the trail emitter around a Lissajous curve, resting a while after every few seconds of
+    //  motion so its trail collapses, and let it decide when to add pairs.  It's ticked at a fixed rate
+    //  from the render loop rather than an animation thread, since everything else reading and writing
+    //  the trail does so on this thread too
+    const double emitterTickSeconds = g_emitterTickMilliseconds / 1000.0;
+    double emitterTime = glfwGetTime();
+    double emitterMotionTime = 0.0;
+    // the emitter's pose as of its last two ticks; frames land between ticks, so each draws the emitter
+    //  interpolated between them at how far into the next tick it is
+    DualQuatSoA previousEmitterPose(1);
+    DualQuatSoA currentEmitterPose(1);
+    DualQuatSoA renderedEmitterPose(1);
+    currentEmitterPose.set(0, glm::quat(1.0F, 0.0F, 0.0F, 0.0F), glm::vec3(0.0F, 0.0F, 1.0F));
+    previousEmitterPose = currentEmitterPose;
+    const unsigned int emitterMarkerIndices[] = {0, 1, 2};
+    IndexedVertexArray emitterMarker = createIndexedPositionVertexArray(&g_emitterMarker[0].x,
+            sizeof(g_emitterMarker), emitterMarkerIndices, sizeof(emitterMarkerIndices), GL_DYNAMIC_STORAGE_BIT);
+    auto tickEmitter = [&]{
+        emitterTime += emitterTickSeconds;
+        double phase = std::fmod(emitterTime, g_emitterMoveSeconds + g_emitterRestSeconds);
+        if(phase < g_emitterMoveSeconds)
+        {
+            emitterMotionTime += emitterTickSeconds;
+        }
+        glm::vec3 emitterPosition(
+                0.75F * static_cast<float>(std::sin(1.3 * emitterMotionTime)),
+                0.75F * static_cast<float>(std::sin(2.1 * emitterMotionTime)),
+                1.0F
+        );
 
-                // add vertices drawn from appropriate places in the debug vert array
-                ribbonTrail.addVertexPair(
-                        glm::vec3(
-                            randModifiedDeviceCoord(debugRibbonVertices[currentVertexIdxOffset]),
-                            randModifiedDeviceCoord(debugRibbonVertices[currentVertexIdxOffset+1]),
-                            randModifiedDeviceCoord(debugRibbonVertices[currentVertexIdxOffset+2])
-                        ),
-                        glm::vec3(
-                            randModifiedDeviceCoord(debugRibbonVertices[currentVertexIdxOffset+3]),
-                            randModifiedDeviceCoord(debugRibbonVertices[currentVertexIdxOffset+4]),
-                            randModifiedDeviceCoord(debugRibbonVertices[currentVertexIdxOffset+5])
-                        )
-                );
-                debugVertsProcessed+=2;
-
-                // set our ribbon buffers invalid so we'll regenerate them
-                // in the render loop back on the thread that owns our
-                // current GL context
-                ribbonTrail.invalidateBuffers();
-            },
-            1000
-    );
+        if(trailEmitter.update(ribbonTrail, emitterPosition, emitterTime))
+        {
+            // set our ribbon buffers invalid so we'll regenerate them below
+            ribbonTrail.invalidateBuffers();
+        }
+        previousEmitterPose = currentEmitterPose;
+        currentEmitterPose.set(0, trailEmitter.getOrientation(), emitterPosition);
+    };
 
     // render loop
     while(!glfwWindowShouldClose(window))
     {
-        // handle any user input this frame
-        processInput(window, ribbonTrail);
+        // run every emitter tick that's come due since last frame
+        double frameTime = glfwGetTime();
+        emitterTime = std::max(emitterTime, frameTime - g_emitterMaxCatchUpTicks * emitterTickSeconds);
+        while(frameTime - emitterTime >= emitterTickSeconds)
+        {
+            tickEmitter();
+        }
+        float emitterAlpha = static_cast<float>((frameTime - emitterTime) / emitterTickSeconds);
+        batchDualQuatLerp(previousEmitterPose, currentEmitterPose, emitterAlpha, renderedEmitterPose);
+
+        // handle any user input this frame, against the trail as it stands now
+        trailGrid.clear();
+        trailGrid.insertTrailSegments(ribbonTrail);
+        trailGrid.build();
+        processInput(window, ribbonTrail, trailGrid);
 
         // check and call events
         glfwPollEvents();
 
+        // hand over whatever the loader thread has finished
+        backgroundLoader->processCompleted();
+
+        // stream in this frame's share of any pending texture uploads
+        textureStreamer->update();
+        if(!ribbonTextureReported && textureStreamer->isReady(ribbonTexture))
+        {
+            std::cout << "ribbon texture streamed in, " << textureStreamer->getTotalBytesUploaded()
+            << " bytes uploaded" << std::endl;
+            ribbonTextureReported = true;
+        }
+
         // rendering code
         // Render Step 1: clear screen
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
-        // Render Step 2: select shader program to use
-        glUseProgram(shaderProgramId);
+        // Render Step 2: process any new ribbon head pairs into the feedback cache;
+        // this binds the capture program, so it has to happen before we select ours
+        if(g_useRibbonFeedbackCache && !g_useVertexPulling)
+        {
+            ribbonFeedbackCache->update(ribbonTrail);
+        }
+        // Render Step 3: select shader program to use, and the easing tables the trail fades by
+        glUseProgram(g_useVertexPulling ? pulledProgramId : trailProgramId);
+        glBindTextureUnit(0, easingTexture);
         /*
         // set shader program variables
         glUniform1f(timeSpace, glfwGetTime());
         */
-        // Render Step 3: bind the configured VAO
-        if(ribbonTrail.areBuffersInvalid())
+        // Render Step 4: bind the configured VAO
+        if(g_useVertexPulling)
         {
-            dynamicRibbonTrailVAO = ribbonTrail.generateRibbonTrailVAO();
+            // nothing to bind, drawQueued() binds the one attribute-less VAO; just refresh the trail's copy
+            if(ribbonTrail.areBuffersInvalid() || !wasUsingVertexPulling)
+            {
+                std::vector<glm::vec3> trailVertices(ribbonTrail.getVertices().begin(), ribbonTrail.getVertices().end());
+                pulledTrailStaging.resize(trailVertices.size());
+                packHalf4(trailVertices.data(), 1.0F, &pulledTrailStaging.data()->position, trailVertices.size());
+                vertexPulling->updateVertices(pulledTrailMesh, 0, pulledTrailStaging.data(), pulledTrailStaging.size());
+                vertexPulling->updateIndices(pulledTrailMesh, ribbonTrail.getIndices().data(),
+                        ribbonTrail.getIndices().size());
+                ribbonTrail.validateBuffers();
+            }
+            size_t pulledTrailPairs = pulledTrailStaging.size() / 2;
+            setTrailFadeUniforms(pulledFadeUniforms, pulledTrailPairs ? pulledTrailPairs - 1 : 0, pulledTrailPairs,
+                    pulledTrailPairs);
+            glUniform1i(pulledFadedMeshLocation, static_cast<GLint>(pulledTrailMesh));
         }
-        glBindVertexArray(dynamicRibbonTrailVAO);
-        // Render Step 4: draw calls
+        else if(g_useRibbonFeedbackCache)
+        {
+            // the cache keeps pairs in a ring, so the trail's head can be in any slot
+            setTrailFadeUniforms(trailFadeUniforms, ribbonFeedbackCache->getNewestPairSlot(),
+                    ribbonFeedbackCache->getCapacityPairs(), ribbonFeedbackCache->getResidentPairCount());
+            glBindVertexArray(ribbonFeedbackCache->getRenderVAO());
+        }
+        else
+        {
+            // draws the last trail that finished uploading while any newer one is still on its way
+            ribbonTrailUploader->update(ribbonTrail);
+            size_t uploadedTrailPairs = static_cast<size_t>(ribbonTrailUploader->getIndexCount()) / 2;
+            setTrailFadeUniforms(trailFadeUniforms, uploadedTrailPairs ? uploadedTrailPairs - 1 : 0, uploadedTrailPairs,
+                    uploadedTrailPairs);
+            glBindVertexArray(ribbonTrailUploader->getVAO());
+        }
+        // Render Step 5: draw calls
         // specify primitive type triangles
-        /* this is for a basic vertex data config, where every vertex is given in the needed order
-           as opposed to just the unique vertices
+        /* built-in meshes, all drawn from the library VAO with their own primitive mode,
+           base vertex and index offset; e.g. the unique vert rectangle renders 6 vertices in
+           total (not just unique), given by its 6 indices
 
-         // and that we want to render vertices starting at index 0 and rendering a total count of 3 vertices
-         glDrawArrays(GL_TRIANGLES, 0, 3);
-        */
-        /* unique vert rectangle
-        // and that we want to render 6 vertices in total (not just unique), given by the 6 indices
-        // in our EBO which are of type unsigned int
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+        glBindVertexArray(builtinMeshes->getVAO());
+        builtinMeshes->draw(BuiltinMesh::rectangle);
         */
         /*
-        // and that we want to render 8 elements (vert indices)
-        glDrawElements(GL_TRIANGLE_STRIP, 8, GL_UNSIGNED_INT, nullptr);
+        // and that we want to render the first g_numDrawElements elements (vert indices) of the ribbon demo
+        glBindVertexArray(builtinMeshes->getVAO());
+        builtinMeshes->draw(BuiltinMesh::ribbonDemo, g_numDrawElements);
         */
 
-        glDrawElements(GL_TRIANGLE_STRIP, ribbonTrail.getVertexCount(), GL_UNSIGNED_INT, nullptr);
+        gpuStatistics->beginPass("ribbon");
+        if(g_useVertexPulling)
+        {
+            // the trail and the ribbon demo are both strips, so they go out as two commands of one multi-draw;
+            // that draw can't be conditional on the trail alone, so with vertex pulling nothing is occlusion culled
+            vertexPulling->queueDraw(pulledTrailMesh);
+            vertexPulling->queueDraw(pulledDemoMesh);
+            vertexPulling->drawQueued();
+        }
+        else
+        {
+            // the trail is skipped on the GPU if its bounds weren't visible at the end of last frame
+            occlusionCuller->drawConditional(ribbonOcclusionHandle, [&]{
+                if(g_useRibbonFeedbackCache)
+                {
+                    glDrawElements(GL_TRIANGLE_STRIP, ribbonFeedbackCache->getElementCount(), GL_UNSIGNED_INT, nullptr);
+                }
+                else if(ribbonTrailUploader->getIndexCount() > 0)
+                {
+                    glDrawElements(GL_TRIANGLE_STRIP, ribbonTrailUploader->getIndexCount(), GL_UNSIGNED_INT, nullptr);
+                }
+            });
+            // then the same ribbon demo mesh the pulled path draws, from the library's own VAO and unfaded
+            glUseProgram(shaderProgramId);
+            glBindVertexArray(builtinMeshes->getVAO());
+            builtinMeshes->draw(BuiltinMesh::ribbonDemo);
+        }
+        // the trail's other copies weren't kept up to date while it was pulled, so have them refreshed
+        if(wasUsingVertexPulling && !g_useVertexPulling)
+        {
+            ribbonTrail.invalidateBuffers();
+        }
+        wasUsingVertexPulling = g_useVertexPulling;
+        gpuStatistics->endPass();
+
+        // the clustered grid goes out as one multi-draw of whichever of its clusters survive culling
+        if(clusterDrawBuffer)
+        {
+            gpuStatistics->beginPass("clustered grid");
+            clusterStatistics = cullMeshClusters(gridClusters, deviceFrustum, g_clusterCameraPosition, clusterCommands);
+            glUseProgram(shaderProgramId);
+            glBindVertexArray(clusteredGrid.vao);
+            clusterDrawBuffer->draw(clusterCommands);
+            gpuStatistics->endPass();
+        }
+
+        // the emitter's arrowhead, at its pose interpolated between ticks so it moves smoothly at any frame rate
+        glm::dualquat emitterPose = renderedEmitterPose.get(0);
+        PositionVertex emitterMarkerVertices[3];
+        for(size_t vertexIdx = 0; vertexIdx < 3; vertexIdx++)
+        {
+            emitterMarkerVertices[vertexIdx].position = emitterPose * g_emitterMarker[vertexIdx];
+        }
+        updateBuffer(emitterMarker.vbo, 0, sizeof(emitterMarkerVertices), emitterMarkerVertices);
+        glUseProgram(shaderProgramId);
+        glBindVertexArray(emitterMarker.vao);
+        glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_INT, nullptr);
 #ifdef DEBUG
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 #endif
 
+        // Render Step 6: issue occlusion queries against this frame for next frame's conditional draws
+        glm::vec3 ribbonBoundsMin, ribbonBoundsMax;
+        if(ribbonTrail.calculateBounds(ribbonBoundsMin, ribbonBoundsMax))
+        {
+            occlusionCuller->updateBounds(ribbonOcclusionHandle, ribbonBoundsMin, ribbonBoundsMax);
+        }
+        gpuStatistics->beginPass("occlusion proxies");
+        occlusionCuller->issueQueries();
+        gpuStatistics->endPass();
+        gpuStatistics->endFrame();
+
+        // Render Step 7: periodic frame report
+        if(glfwGetTime() - lastFrameReportTime >= g_frameReportInterval)
+        {
+            const OcclusionStatistics& occlusionStats = occlusionCuller->getStatistics();
+            std::cout << "occlusion: " << occlusionStats.drawsSkipped << " of " << occlusionStats.draws
+            << " heavy draws skipped (" << occlusionStats.drawsVisible << " visible, "
+            << occlusionStats.drawsUnconditional << " unconditional, " << occlusionStats.drawsUnresolved
+            << " unresolved)" << std::endl;
+            occlusionCuller->resetStatistics();
+            if(clusterDrawBuffer)
+            {
+                std::cout << "clustered grid: " << clusterStatistics.visible << " of " << gridClusters.size()
+                << " clusters drawn (" << clusterStatistics.outsideFrustum << " outside the frustum, "
+                << clusterStatistics.backFacing << " back-facing)" << std::endl;
+            }
+            gpuStatistics->report(std::cout);
+            std::cout << "texture streaming: " << textureStreamer->getPendingTextureCount() << " pending, "
+            << textureStreamer->getBytesUploadedLastFrame() << " bytes last frame" << std::endl;
+            std::cout << "background loader: " << backgroundLoader->getPendingJobCount() << " jobs pending" << std::endl;
+            lastFrameReportTime = glfwGetTime();
+        }
+
         // render the back buffer to the window
         glfwSwapBuffers(window);
     }
 
-    // free GLFW resources
+    // free GL resources while we still have a context, then GLFW resources; the loader goes first, so
+    // nothing it was working on is handed over to objects that are gone
+    backgroundLoader.reset();
+    ribbonTrailUploader.reset();
+    glDeleteProgram(animatedProgramId);
+    ribbonFeedbackCache.reset();
+    builtinMeshes.reset();
+    vertexPulling.reset();
+    glDeleteProgram(pulledProgramId);
+    glDeleteProgram(trailProgramId);
+    glDeleteTextures(1, &easingTexture);
+    occlusionCuller.reset();
+    clusterDrawBuffer.reset();
+    unsigned int clusteredGridBuffers[] = {clusteredGrid.vbo, clusteredGrid.ebo};
+    glDeleteBuffers(2, clusteredGridBuffers);
+    glDeleteVertexArrays(1, &clusteredGrid.vao);
+    unsigned int emitterMarkerBuffers[] = {emitterMarker.vbo, emitterMarker.ebo};
+    glDeleteBuffers(2, emitterMarkerBuffers);
+    glDeleteVertexArrays(1, &emitterMarker.vao);
+    gpuStatistics.reset();
+    textureStreamer.reset();
+    glDeleteTextures(1, &ribbonTexture);
     glfwTerminate();
     return 0;
 }